@@ -0,0 +1,162 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_geometry.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_BEAM_GEOMETRY_H
+#define OMRON_OS32C_DRIVER_BEAM_GEOMETRY_H
+
+#include <math.h>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/// Number of beams in a full scan
+constexpr int BEAM_COUNT = 677;
+/// Angle of the first, most CCW beam, in radians CCW from straight ahead
+constexpr double BEAM_ANGLE_MAX = 135.2 * M_PI / 180;
+/// Angle of the last, most CW beam
+constexpr double BEAM_ANGLE_MIN = -135.2 * M_PI / 180;
+/// Angle between the centres of adjacent beams
+constexpr double BEAM_ANGLE_INC = 0.4 * M_PI / 180;
+/// Size of the beam selection mask, with one bit per beam
+constexpr int BEAM_MASK_BYTES = 88;
+
+/**
+ * Calculate the OS32C beam number for a given angle.
+ * @param angle Radians CCW from straight ahead
+ * @return OS32C beam number, with 0 the most CCW beam
+ */
+constexpr int beamNumber(double angle)
+{
+  return (BEAM_ANGLE_MAX - angle + BEAM_ANGLE_INC / 2) / BEAM_ANGLE_INC;
+}
+
+/**
+ * Calculate the angle of the centre of a beam.
+ * @param beam OS32C beam number, with 0 the most CCW beam
+ * @return Radians CCW from straight ahead
+ */
+constexpr double beamCentre(int beam)
+{
+  return BEAM_ANGLE_MAX - beam * BEAM_ANGLE_INC;
+}
+
+constexpr double sinSeries(double x2, double term, int n, double sum)
+{
+  return n > 20 ? sum : sinSeries(x2, -term * x2 / ((2 * n + 2) * (2 * n + 3)), n + 1, sum + term);
+}
+
+constexpr double cosSeries(double x2, double term, int n, double sum)
+{
+  return n > 20 ? sum : cosSeries(x2, -term * x2 / ((2 * n + 1) * (2 * n + 2)), n + 1, sum + term);
+}
+
+/**
+ * Sine that can be evaluated at compile time, by its Taylor series. Accurate
+ * to a few ULP for the angles of the beams, but not for large angles.
+ */
+constexpr double constexprSin(double x)
+{
+  return sinSeries(x * x, x, 0, 0);
+}
+
+/**
+ * Cosine that can be evaluated at compile time
+ * @see constexprSin
+ */
+constexpr double constexprCos(double x)
+{
+  return cosSeries(x * x, 1, 0, 0);
+}
+
+template <int... Beams>
+struct BeamIndices
+{
+};
+
+template <int N, int... Beams>
+struct MakeBeamIndices : MakeBeamIndices<N - 1, N - 1, Beams...>
+{
+};
+
+template <int... Beams>
+struct MakeBeamIndices<0, Beams...>
+{
+  typedef BeamIndices<Beams...> type;
+};
+
+template <typename Indices>
+struct BeamTables;
+
+/**
+ * Angle, sine and cosine of the centre of every beam, computed at compile
+ * time, so that projecting a scan or looking up the angle of a beam is a
+ * table read.
+ */
+template <int... Beams>
+struct BeamTables<BeamIndices<Beams...> >
+{
+  static constexpr double angles[sizeof...(Beams)] = { beamCentre(Beams)... };
+  static constexpr double sines[sizeof...(Beams)] = { constexprSin(beamCentre(Beams))... };
+  static constexpr double cosines[sizeof...(Beams)] = { constexprCos(beamCentre(Beams))... };
+};
+
+template <int... Beams>
+constexpr double BeamTables<BeamIndices<Beams...> >::angles[sizeof...(Beams)];
+template <int... Beams>
+constexpr double BeamTables<BeamIndices<Beams...> >::sines[sizeof...(Beams)];
+template <int... Beams>
+constexpr double BeamTables<BeamIndices<Beams...> >::cosines[sizeof...(Beams)];
+
+/**
+ * Geometry of every beam of the OS32C, e.g. BeamGeometry::sines[beam]
+ */
+typedef BeamTables<MakeBeamIndices<BEAM_COUNT>::type> BeamGeometry;
+
+/**
+ * Range of consecutive beams, inclusive of both ends
+ */
+struct BeamSector
+{
+  int first_beam;
+  int last_beam;
+};
+
+/**
+ * Build a beam selection mask selecting the beams of the given sectors.
+ * Works on 64-bit words rather than a bit or byte at a time.
+ * @param sectors Sectors of beams to select. May overlap.
+ * @param mask Mask to fill, BEAM_MASK_BYTES long, with bit n of byte m
+ *  selecting beam 8m + n
+ * @throw std::invalid_argument if a sector is empty or outside the scan
+ */
+void buildBeamMask(const vector<BeamSector>& sectors, EIP_BYTE mask[]);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_BEAM_GEOMETRY_H
@@ -0,0 +1,208 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_statistics.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_BEAM_STATISTICS_H
+#define OMRON_OS32C_DRIVER_BEAM_STATISTICS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_geometry.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Limits beyond which the statistics of a beam or sector are flagged. The
+ * reflectance and no return limits are relative to a baseline, since both
+ * depend on the surroundings as much as on the scanner.
+ */
+struct BeamStatisticsThresholds
+{
+  /// Fraction of samples reported as noisy (0x0001)
+  double noisy_rate;
+  /// Rise in the fraction of samples with no return (0xFFFF) over the baseline
+  double no_return_rise;
+  /// Fall in the mean reflectance, as a fraction of the baseline
+  double reflectance_drop;
+  /// Standard deviation of the range in mm, or zero not to flag on it
+  double range_stddev;
+
+  BeamStatisticsThresholds() : noisy_rate(0.05), no_return_rise(0.25), reflectance_drop(0.3),
+    range_stddev(0)
+  {
+  }
+};
+
+/**
+ * Statistics of a summary period, for the scan as a whole and by sector
+ */
+struct BeamStatisticsSummary
+{
+  /// Number of scans in the period
+  uint32_t scans;
+  /// Fraction of all samples reported as noisy, and with no return
+  float noisy_rate;
+  float no_return_rate;
+  /// Number of beams in each sector, with sector 0 starting at beam 0
+  int sector_beams;
+  /// Noisy and no return fraction of the samples in each sector
+  vector<float> sector_noisy_rate;
+  vector<float> sector_no_return_rate;
+  /// Mean of the range standard deviations of the beams in each sector, in mm
+  vector<float> sector_range_stddev;
+  /// Beams and sectors with any statistic beyond its threshold
+  vector<uint16_t> flagged_beams;
+  vector<uint16_t> flagged_sectors;
+};
+
+/**
+ * Running statistics of every beam, for early warning of a dirty window or a
+ * degrading scanner: the Welford mean and variance of range and reflectance
+ * over the valid samples, and the rates of noisy and no return samples.
+ *
+ * Each statistic is kept in its own array indexed by beam number, and updated
+ * for all the beams of a scan in a branch free loop, so that the compiler can
+ * vectorize it. Samples that are not valid are folded in with a weight of
+ * zero rather than skipped.
+ */
+class BeamStatistics
+{
+public:
+  /**
+   * Construct with all statistics empty
+   * @param sector_beams Number of beams in each sector of the summary
+   * @throw std::invalid_argument if the sector size is not positive
+   */
+  explicit BeamStatistics(int sector_beams = 16);
+
+  /**
+   * Add a scan to the statistics
+   * @param ranges Range of each beam in mm, as reported
+   * @param reflectance Reflectance of each beam, or NULL if the scan has none
+   * @param num_beams Number of beams in the scan
+   * @param first_beam Beam number of the first beam in the scan
+   * @throw std::invalid_argument if the scan runs past the last beam of the scanner
+   */
+  void update(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams,
+    int first_beam);
+
+  /**
+   * Summarize the period since the last summary and start a new one. The
+   * first period with samples becomes the baseline for the reflectance and
+   * no return thresholds.
+   * @param thresholds Limits to flag beams and sectors by
+   * @return Summary of the period
+   */
+  BeamStatisticsSummary summarize(const BeamStatisticsThresholds& thresholds);
+
+  /**
+   * Forget the baseline, so that the next period becomes the new one, such
+   * as after cleaning the window
+   */
+  void resetBaseline()
+  {
+    have_baseline_ = false;
+  }
+
+  uint32_t getScans() const
+  {
+    return scans_;
+  }
+
+  /// Number of samples of a beam in the period, valid or not
+  float getSamples(int beam) const
+  {
+    return samples_[beam];
+  }
+
+  float getRangeMean(int beam) const
+  {
+    return range_mean_[beam];
+  }
+
+  /// Sample variance of the range of a beam, or zero with fewer than two valid samples
+  float getRangeVariance(int beam) const
+  {
+    return valid_[beam] > 1 ? range_m2_[beam] / (valid_[beam] - 1) : 0;
+  }
+
+  float getReflectanceMean(int beam) const
+  {
+    return reflectance_mean_[beam];
+  }
+
+  float getReflectanceVariance(int beam) const
+  {
+    return valid_[beam] > 1 ? reflectance_m2_[beam] / (valid_[beam] - 1) : 0;
+  }
+
+  float getNoisyRate(int beam) const
+  {
+    return samples_[beam] ? noisy_[beam] / samples_[beam] : 0;
+  }
+
+  float getNoReturnRate(int beam) const
+  {
+    return samples_[beam] ? no_return_[beam] / samples_[beam] : 0;
+  }
+
+private:
+  // arrays padded to a whole number of vectors of 8 floats
+  static const int PADDED_BEAMS = (BEAM_COUNT + 7) / 8 * 8;
+
+  void clear();
+
+  int sector_beams_;
+  uint32_t scans_;
+  bool have_reflectance_;
+
+  // statistics of the current period, by beam. Counts are kept as float so
+  // that the update loop works in one type throughout.
+  float samples_[PADDED_BEAMS];
+  float valid_[PADDED_BEAMS];
+  float noisy_[PADDED_BEAMS];
+  float no_return_[PADDED_BEAMS];
+  float range_mean_[PADDED_BEAMS];
+  float range_m2_[PADDED_BEAMS];
+  float reflectance_mean_[PADDED_BEAMS];
+  float reflectance_m2_[PADDED_BEAMS];
+
+  // baseline the reflectance and no return rate are compared with
+  bool have_baseline_;
+  bool baseline_has_reflectance_;
+  float baseline_reflectance_[PADDED_BEAMS];
+  float baseline_no_return_[PADDED_BEAMS];
+  bool baseline_sampled_[PADDED_BEAMS];
+  // whether the beam had any valid return, and so a reflectance, in the baseline
+  bool baseline_valid_[PADDED_BEAMS];
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_BEAM_STATISTICS_H
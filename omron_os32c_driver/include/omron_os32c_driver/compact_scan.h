@@ -0,0 +1,89 @@
+/**
+Software License Agreement (BSD)
+
+\file      compact_scan.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_COMPACT_SCAN_H
+#define OMRON_OS32C_DRIVER_COMPACT_SCAN_H
+
+#include <cmath>
+#include <sensor_msgs/LaserScan.h>
+
+#include "omron_os32c_driver/CompactScan.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Convert a raw range value as reported by the OS32C to metres.
+ * @param range Range in mm, or one of the special values 0x0001 (noisy beam)
+ *  and 0xFFFF (no return)
+ * @param range_max Value to report for a beam without a return
+ * @return Range in metres
+ */
+inline float decodeRange(uint16_t range, float range_max)
+{
+  if (range == 0x0001)
+  {
+    // noisy beam detected
+    return 0;
+  }
+  else if (range == 0xFFFF)
+  {
+    // no return
+    return range_max;
+  }
+  return range / 1000.0;
+}
+
+/**
+ * Expand a CompactScan into a ROS LaserScan. The result is the same as the
+ * LaserScan the driver would have published for the same scan. This is
+ * header-only so that consumers of the compact topic need not link against
+ * the driver. LaserScan is passed as a pointer so that its vectors can be
+ * reused between scans.
+ * @param cs Compact scan to convert
+ * @param ls Laserscan message to populate.
+ */
+inline void convertToLaserScan(const CompactScan& cs, sensor_msgs::LaserScan* ls)
+{
+  ls->header = cs.header;
+  ls->angle_max = cs.angle_start;
+  ls->angle_min = cs.ranges.empty() ? cs.angle_start
+    : cs.angle_start + cs.angle_increment * (cs.ranges.size() - 1);
+  ls->angle_increment = std::fabs(cs.angle_increment);
+  ls->time_increment = cs.time_increment;
+  ls->scan_time = cs.scan_time;
+  ls->range_min = cs.range_min;
+  ls->range_max = cs.range_max;
+
+  ls->ranges.resize(cs.ranges.size());
+  for (size_t i = 0; i < cs.ranges.size(); ++i)
+  {
+    ls->ranges[i] = decodeRange(cs.ranges[i], cs.range_max);
+  }
+  ls->intensities.assign(cs.intensities.begin(), cs.intensities.end());
+}
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_COMPACT_SCAN_H
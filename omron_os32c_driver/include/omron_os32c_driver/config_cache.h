@@ -0,0 +1,211 @@
+/**
+Software License Agreement (BSD)
+
+\file      config_cache.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_CONFIG_CACHE_H
+#define OMRON_OS32C_DRIVER_CONFIG_CACHE_H
+
+#include <cstring>
+#include <string>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+
+using std::string;
+
+namespace omron_os32c_driver {
+
+/**
+ * Settings the driver writes to the scanner on startup
+ */
+struct ScannerConfig
+{
+  EIP_UINT range_format;
+  EIP_UINT reflectivity_format;
+  EIP_BYTE beam_mask[88];
+
+  ScannerConfig() : range_format(0), reflectivity_format(0)
+  {
+    memset(beam_mask, 0, sizeof(beam_mask));
+  }
+
+  bool operator==(const ScannerConfig& other) const
+  {
+    return range_format == other.range_format &&
+      reflectivity_format == other.reflectivity_format &&
+      !memcmp(beam_mask, other.beam_mask, sizeof(beam_mask));
+  }
+
+  bool operator!=(const ScannerConfig& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+/**
+ * On-disk record of the configuration last applied to a scanner, together
+ * with the config checksums the scanner reported while it was in effect.
+ * A change in the checksums shows that the configuration of the scanner was
+ * changed by something other than the driver. A valid cache lets the driver
+ * skip reading the settings back on connecting. Since the scanner does not
+ * keep them across a power cycle and the checksums may not cover them, the
+ * first report after that also has its formats and beam count checked.
+ *
+ * The checksums are only reported in measurement reports, so a newly applied
+ * configuration is not trusted until the checksums of the first report after
+ * it have been recorded with checkChecksums(). A change in the checksums
+ * invalidates the cache. Checking never touches the file, so that it can be
+ * done as each report is received; the owner saves the cache once it is dirty.
+ */
+class ConfigCache
+{
+public:
+  /**
+   * Construct a cache stored in the given file
+   * @param path Path of the cache file
+   * @param host Host of the scanner. Entries for other hosts are ignored.
+   */
+  ConfigCache(const string& path, const string& host);
+
+  /**
+   * Load the cache from its file.
+   * @return true if an entry for this host was loaded, false if the file is
+   *  missing, unreadable or for another scanner
+   */
+  bool load();
+
+  /**
+   * Write the cache to its file. The cache is no longer dirty afterwards,
+   * even if writing failed, so that a failing file is not retried on every
+   * report.
+   * @throw std::runtime_error if the file could not be written
+   */
+  void save();
+
+  /**
+   * Check that the cache file can be written, creating it if missing, so
+   * that a bad path is found on startup rather than on the first report
+   * @throw std::runtime_error if the file cannot be opened for writing
+   */
+  void checkWritable() const;
+
+  /**
+   * True if the cache changed since it was last loaded or saved
+   */
+  bool isDirty() const
+  {
+    return dirty_;
+  }
+
+  /**
+   * True if the cache holds a configuration and the checksums it was seen with
+   */
+  bool isValid() const
+  {
+    return has_config_ && has_checksums_;
+  }
+
+  /**
+   * Check whether the given configuration is known to be in effect on the scanner
+   * @param config Configuration to check for
+   * @return true if the cache is valid and holds the same configuration
+   */
+  bool matches(const ScannerConfig& config) const
+  {
+    return isValid() && config == config_;
+  }
+
+  /**
+   * Record that the cached configuration was taken to be in effect without
+   * reading it back, for the next report to verify
+   */
+  void setTrusted()
+  {
+    unverified_ = true;
+  }
+
+  /**
+   * True if the cached configuration was trusted and no report has verified
+   * it yet
+   */
+  bool isUnverified() const
+  {
+    return unverified_;
+  }
+
+  /**
+   * Record a configuration which has just been applied to the scanner. The
+   * checksums are left to be recorded from the next measurement report.
+   * @param config Configuration applied
+   */
+  void setApplied(const ScannerConfig& config);
+
+  /**
+   * Compare the config checksums in a measurement report against the cache.
+   * Records them if none have been recorded since the configuration was
+   * applied, and invalidates the cache if they differ, or if the report does
+   * not have the formats and beam count of a trusted configuration. Either
+   * marks the cache
+   * dirty, which only happens on the first report after the configuration is
+   * applied or after the configuration of the scanner changed.
+   * @param header Header of the measurement report received
+   * @return true if the checksums differed and the cache was invalidated
+   */
+  bool checkChecksums(const MeasurementReportHeader& header);
+
+  /**
+   * Forget the cached configuration
+   */
+  void invalidate();
+
+  EIP_UINT getNonSafetyConfigChecksum() const
+  {
+    return non_safety_config_checksum_;
+  }
+
+  EIP_UINT getSafetyConfigChecksum() const
+  {
+    return safety_config_checksum_;
+  }
+
+private:
+  string path_;
+  string host_;
+  bool has_config_;
+  bool has_checksums_;
+  bool dirty_;
+  bool unverified_;
+  ScannerConfig config_;
+  EIP_UINT non_safety_config_checksum_;
+  EIP_UINT safety_config_checksum_;
+
+  /**
+   * Number of beams selected by the beam mask of a configuration
+   */
+  static size_t countBeams(const ScannerConfig& config);
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_CONFIG_CACHE_H
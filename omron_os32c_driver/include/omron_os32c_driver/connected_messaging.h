@@ -0,0 +1,138 @@
+/**
+Software License Agreement (BSD)
+
+\file      connected_messaging.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_CONNECTED_MESSAGING_H
+#define OMRON_OS32C_DRIVER_CONNECTED_MESSAGING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/path.h"
+#include "odva_ethernetip/serialization/serializable.h"
+#include "omron_os32c_driver/multiple_service_packet.h"
+
+using eip::Path;
+using eip::serialization::Serializable;
+
+namespace omron_os32c_driver {
+
+/**
+ * Reply of the Message Router to an explicit request: the service, status
+ * and data, laid out as in a Multiple Service Packet reply
+ */
+typedef MultipleServiceResponse::Reply MessageRouterReply;
+
+/// Length of the encapsulation header ahead of every packet on the TCP session
+static const size_t ENCAPSULATION_HEADER_LENGTH = 24;
+
+/**
+ * Encode an explicit request to be sent on a Class 3 connection, as a
+ * SendUnitData encapsulation packet. Unlike SendRRData, the request goes
+ * straight to the Message Router of the connection, without the routing of
+ * an unconnected message.
+ * @param session_id Session handle of the TCP session
+ * @param connection_id O->T connection ID of the Class 3 connection
+ * @param sequence_count Sequence count of the request, echoed in the reply
+ * @param service Service code to request
+ * @param path Path to the object the request is for
+ * @param data Request data, or NULL for services without data
+ * @param buf Buffer to encode into
+ * @param size Size of the buffer
+ * @return number of bytes encoded
+ * @throw std::length_error if the buffer is too small
+ */
+size_t encodeSendUnitData(EIP_UDINT session_id, EIP_UDINT connection_id,
+  EIP_UINT sequence_count, EIP_USINT service, const Path& path, const Serializable* data,
+  EIP_BYTE* buf, size_t size);
+
+/**
+ * Encode an unconnected explicit request as a SendRRData encapsulation
+ * packet, carrying a sender context that the scanner echoes in the reply.
+ * Unlike the sequence count of a connection, the sender context lets
+ * several requests be in flight at once and matched to their replies.
+ * @param session_id Session handle of the TCP session
+ * @param sender_context Sender context of the request
+ * @param service Service code to request
+ * @param path Path to the object the request is for
+ * @param data Request data, or NULL for services without data
+ * @param buf Buffer to encode into
+ * @param size Size of the buffer
+ * @return number of bytes encoded
+ * @throw std::length_error if the buffer is too small
+ */
+size_t encodeSendRRData(EIP_UDINT session_id, uint64_t sender_context, EIP_USINT service,
+  const Path& path, const Serializable* data, EIP_BYTE* buf, size_t size);
+
+/**
+ * Get the length of the encapsulation packet at the start of a buffer, so
+ * that a reply split across several reads from the TCP socket can be put
+ * back together.
+ * @return length of the packet including its header, or zero if the buffer
+ *  does not yet hold the whole header
+ */
+size_t getEncapsulationLength(const EIP_BYTE* buf, size_t size);
+
+/**
+ * Decode the reply to a request sent with encodeSendUnitData()
+ * @param buf Buffer holding the whole encapsulation packet
+ * @param size Length of the packet
+ * @param connection_id T->O connection ID of the Class 3 connection
+ * @param sequence_count Sequence count of the request
+ * @return Reply of the Message Router, which may be an error status
+ * @throw std::runtime_error if the encapsulation status is an error
+ * @throw std::logic_error if the packet is not the reply to the request
+ * @throw std::length_error if the packet is truncated
+ */
+MessageRouterReply decodeSendUnitDataReply(const EIP_BYTE* buf, size_t size,
+  EIP_UDINT connection_id, EIP_UINT sequence_count);
+
+/**
+ * Decode the reply to any request on a Class 3 connection, for the caller to
+ * match to its request by sequence count
+ * @param sequence_count Set to the sequence count of the reply
+ * @throw std::logic_error if the packet is not a reply on the connection
+ * @see decodeSendUnitDataReply(const EIP_BYTE*, size_t, EIP_UDINT, EIP_UINT)
+ */
+MessageRouterReply decodeSendUnitDataReply(const EIP_BYTE* buf, size_t size,
+  EIP_UDINT connection_id, EIP_UINT* sequence_count);
+
+/**
+ * Decode the reply to a request sent with encodeSendRRData()
+ * @param buf Buffer holding the whole encapsulation packet
+ * @param size Length of the packet
+ * @param sender_context Set to the sender context of the reply, to match it
+ *  to its request
+ * @return Reply of the Message Router, which may be an error status
+ * @throw std::runtime_error if the encapsulation status is an error
+ * @throw std::logic_error if the packet is not a SendRRData reply
+ * @throw std::length_error if the packet is truncated
+ */
+MessageRouterReply decodeSendRRDataReply(const EIP_BYTE* buf, size_t size,
+  uint64_t& sender_context);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_CONNECTED_MESSAGING_H
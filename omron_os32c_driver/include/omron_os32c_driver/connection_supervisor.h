@@ -0,0 +1,338 @@
+/**
+Software License Agreement (BSD)
+
+\file      connection_supervisor.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_CONNECTION_SUPERVISOR_H
+#define OMRON_OS32C_DRIVER_CONNECTION_SUPERVISOR_H
+
+#include <stdint.h>
+#include <random>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "omron_os32c_driver/config_cache.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/scan_stream.h"
+#include "omron_os32c_driver/timed_tcp_socket.h"
+#include "omron_os32c_driver/udp_io_socket.h"
+
+using std::string;
+using boost::shared_ptr;
+
+namespace omron_os32c_driver {
+
+/**
+ * Exponential backoff with jitter, for spacing out reconnection attempts so
+ * that a fleet of drivers does not retry in lock step.
+ */
+class Backoff
+{
+public:
+  /**
+   * @param initial Delay before the first retry, in seconds
+   * @param max Longest delay between retries, in seconds
+   * @param jitter Fraction by which each delay is randomly varied, 0 to 1
+   * @param seed Seed for the jitter, or zero to seed from the system
+   * @throw std::invalid_argument if the parameters are out of range
+   */
+  Backoff(double initial, double max, double jitter, unsigned int seed = 0);
+
+  /**
+   * Get the delay before the next retry, and double it for the one after
+   */
+  double next();
+
+  /**
+   * Go back to the initial delay, after a successful attempt
+   */
+  void reset()
+  {
+    delay_ = initial_;
+  }
+
+private:
+  double initial_;
+  double max_;
+  double jitter_;
+  double delay_;
+  std::mt19937 rng_;
+};
+
+/**
+ * Keeps a scan stream from an OS32C running across link loss. Receives with a
+ * caller supplied deadline, and once no packet has arrived for the IO timeout
+ * derived from the RPI of the connection, or on a socket error, drops the
+ * connection and reconnects with exponential backoff.
+ * Reconnecting registers a new session, redoes the Forward Open and restores
+ * the configuration. A configuration taken from the config cache that the
+ * first report shows is not in effect also leads to reconnecting, this time
+ * reading it back. Input only and listen only connections leave the
+ * configuration to the owner of the scanner, and follow it instead.
+ */
+class ConnectionSupervisor
+{
+public:
+  typedef boost::function<void (UDPIOSocket&)> IOSocketHook;
+
+  /**
+   * @param io_service IO service for the sockets
+   * @param host Hostname or IP address of the scanner
+   * @param callback Function to call with each scan received
+   */
+  ConnectionSupervisor(boost::asio::io_service& io_service, const string& host,
+    const ScanStream::Callback& callback);
+
+  /**
+   * Set the configuration to apply on every connection.
+   * @param cache Cache of the last configuration applied, or NULL for none.
+   *  Must outlive the supervisor.
+   * @see OS32C::configure
+   */
+  void setConfiguration(EIP_UINT range_format, EIP_UINT reflectivity_format,
+    double start_angle, double end_angle, ConfigCache* cache = NULL);
+
+  /**
+   * Set a function to call on each new IO socket before it is used, to apply
+   * socket options
+   */
+  void setIOSocketHook(const IOSocketHook& hook)
+  {
+    io_socket_hook_ = hook;
+  }
+
+  /**
+   * Set the delays between reconnection attempts
+   * @see Backoff
+   */
+  void setBackoff(double initial, double max, double jitter);
+
+  /**
+   * Set the longest time connecting to the scanner, or waiting on any single
+   * explicit request while connecting, may take
+   * @param timeout Timeout in seconds
+   * @throw std::invalid_argument if the timeout is not positive
+   */
+  void setRequestTimeout(double timeout);
+
+  double getRequestTimeout() const
+  {
+    return request_timeout_;
+  }
+
+  /**
+   * Set the parameters to request in the Forward Open on every connection.
+   * If the scanner rejects them, connecting falls back to more conservative
+   * ones, and the keepalive and IO timeout follow whichever were accepted.
+   * @throw std::invalid_argument if the parameters are out of range
+   * @see getFallbackParams
+   */
+  void setIOConnectionParams(const IOConnectionParams& params);
+
+  /**
+   * Parameters requested in the Forward Open. Those accepted on the current
+   * connection are available from the scanner.
+   */
+  const IOConnectionParams& getIOConnectionParams() const
+  {
+    return io_params_;
+  }
+
+  /**
+   * Set the multicast group to join for a multicast T->O connection
+   * @param group Multicast address, or empty to ask the scanner which it uses
+   */
+  void setMulticastGroup(const string& group)
+  {
+    multicast_group_ = group;
+  }
+
+  /**
+   * Send the explicit requests that configure the scanner on every connection
+   * over a Class 3 connection, rather than unconnected. The Class 3
+   * connection is closed once the scanner is configured, as nothing would
+   * keep it alive while scans are streamed. If the scanner rejects the
+   * connection, explicit requests stay unconnected.
+   */
+  void setConnectedMessaging(bool enable)
+  {
+    connected_messaging_ = enable;
+  }
+
+  /**
+   * Connect to the scanner, configure it and start UDP IO.
+   * @throw std::invalid_argument if the configuration is invalid
+   * @throw std::runtime_error if the scanner cannot be reached or rejects the configuration
+   * @throw std::logic_error if the connection cannot be established
+   */
+  void connect();
+
+  /**
+   * Result of a call to spinOnce()
+   */
+  enum SpinResult
+  {
+    /// A scan was received and passed to the callback
+    SCAN_RECEIVED,
+    /// No scan arrived before the timeout, but the connection is still up
+    TIMED_OUT,
+    /// A packet arrived but was not a valid measurement report, and was dropped
+    MALFORMED_PACKET,
+    /// The connection is down, or was lost or could not be restored on this call
+    DISCONNECTED,
+  };
+
+  /**
+   * Receive a single scan and pass it to the callback, waiting no longer
+   * than the given timeout. If the connection is lost, waits out the backoff
+   * delay and makes a single attempt to reconnect instead. Never blocks for
+   * much longer than the timeout, or for a reconnection attempt, the request
+   * timeout for each of its few requests, so that the caller can handle
+   * shutdown and other events in between.
+   * @param timeout Longest time to wait for a scan, in seconds
+   * @return what happened on this call
+   */
+  SpinResult spinOnce(double timeout);
+
+  /**
+   * True while the connection is up
+   */
+  bool isConnected() const
+  {
+    return connected_;
+  }
+
+  /**
+   * Number of times the connection has been lost
+   */
+  int getDisconnects() const
+  {
+    return disconnects_;
+  }
+
+  /**
+   * Number of times the connection has been restored after being lost
+   */
+  int getReconnects() const
+  {
+    return reconnects_;
+  }
+
+  /**
+   * Number of calls to spinOnce() that timed out with the connection up
+   */
+  uint64_t getTimeouts() const
+  {
+    return timeouts_;
+  }
+
+  /**
+   * Reason the connection was last lost
+   */
+  const string& getLastError() const
+  {
+    return last_error_;
+  }
+
+  /**
+   * Time from the connection being restored to the first scan after it,
+   * for the last reconnection, in nanoseconds
+   */
+  uint64_t getLastRecoveryTime() const
+  {
+    return last_recovery_time_;
+  }
+
+  /**
+   * Time from the connection being lost to the first scan after it was
+   * restored, for the last reconnection, in nanoseconds
+   */
+  uint64_t getLastOutageTime() const
+  {
+    return last_outage_time_;
+  }
+
+  /**
+   * Scanner of the current connection. Only valid while connected.
+   */
+  OS32C& getOS32C()
+  {
+    return *os32c_;
+  }
+
+  /**
+   * IO socket of the current connection. Only valid while connected.
+   */
+  UDPIOSocket& getIOSocket()
+  {
+    return *io_socket_;
+  }
+
+  ScanStream& getStream()
+  {
+    return stream_;
+  }
+
+private:
+  boost::asio::io_service& io_service_;
+  string host_;
+  ScanStream::Callback callback_;
+  IOSocketHook io_socket_hook_;
+
+  EIP_UINT range_format_;
+  EIP_UINT reflectivity_format_;
+  double start_angle_;
+  double end_angle_;
+  ConfigCache* config_cache_;
+  IOConnectionParams io_params_;
+  string multicast_group_;
+  bool connected_messaging_;
+  double request_timeout_;
+
+  shared_ptr<UDPIOSocket> io_socket_;
+  shared_ptr<OS32C> os32c_;
+  ScanStream stream_;
+  Backoff backoff_;
+
+  bool connected_;
+  bool awaiting_first_scan_;
+  int disconnects_;
+  int reconnects_;
+  uint64_t timeouts_;
+  string last_error_;
+  uint64_t next_attempt_;
+  uint64_t lost_time_;
+  uint64_t last_packet_time_;
+  uint64_t restore_time_;
+  uint64_t last_recovery_time_;
+  uint64_t last_outage_time_;
+
+  void handleScan(const ScanView& scan);
+  void disconnect(const string& reason);
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_CONNECTION_SUPERVISOR_H
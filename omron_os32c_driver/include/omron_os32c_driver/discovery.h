@@ -0,0 +1,167 @@
+/**
+Software License Agreement (BSD)
+
+\file      discovery.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_DISCOVERY_H
+#define OMRON_OS32C_DRIVER_DISCOVERY_H
+
+#include <string>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "odva_ethernetip/serialization/serializable.h"
+
+using std::string;
+using std::vector;
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+/**
+ * CIP Identity item (type 0x0C) of a ListIdentity reply, as defined in the
+ * EtherNet/IP specification. Socket address fields are big endian on the wire,
+ * but are held here in host order.
+ */
+class CIPIdentity : public Serializable
+{
+public:
+  EIP_UINT encap_protocol_version;
+  EIP_UINT sin_family;
+  EIP_UINT sin_port;
+  EIP_UDINT sin_addr;
+  EIP_UINT vendor_id;
+  EIP_UINT device_type;
+  EIP_UINT product_code;
+  EIP_USINT revision_major;
+  EIP_USINT revision_minor;
+  EIP_WORD status;
+  EIP_UDINT serial_number;
+  string product_name;
+  EIP_USINT state;
+
+  /// Address the reply came from, not part of the item itself
+  string address;
+
+  CIPIdentity() : encap_protocol_version(1), sin_family(2), sin_port(44818), sin_addr(0),
+    vendor_id(0), device_type(0), product_code(0), revision_major(0), revision_minor(0),
+    status(0), serial_number(0), state(0)
+  {
+  }
+
+  /**
+   * True if the identity is that of an Omron OS32C
+   */
+  bool isOS32C() const;
+
+  virtual size_t getLength() const
+  {
+    return 34 + product_name.size();
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the item data
+   */
+  virtual Writer& serialize(Writer& writer) const;
+
+  /**
+   * Extra length information is not relevant in this context. Same as deserialize(reader)
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    return deserialize(reader);
+  }
+
+  /**
+   * Deserialize data from the given reader without length information
+   * @param reader Reader to use for deserialization
+   * @return the reader again
+   * @throw std::length_error if the buffer is overrun while deserializing
+   */
+  virtual Reader& deserialize(Reader& reader);
+};
+
+/**
+ * Default port for EtherNet/IP explicit messaging and ListIdentity
+ */
+static const unsigned short EIP_PORT = 44818;
+
+/**
+ * Send a ListIdentity request to each of the targets and collect the replies
+ * until the timeout expires. All of the requests go out back to back from a
+ * single socket before any reply is waited for, so probing a whole subnet
+ * takes barely longer than probing a single address.
+ * @param targets IPv4 addresses to send to, which may include broadcast addresses
+ * @param timeout Time to wait for replies, in seconds
+ * @param port Port to send to
+ * @return Identities of all OS32C scanners that replied, at most one per address
+ * @throw std::invalid_argument if a target is not a valid address
+ * @throw std::runtime_error if the discovery socket cannot be opened
+ */
+vector<CIPIdentity> discoverScanners(const vector<string>& targets, double timeout,
+  unsigned short port = EIP_PORT);
+
+/**
+ * Find the scanner with the given serial number among the targets. Returns
+ * as soon as it replies, rather than waiting for the whole timeout.
+ * @param serial_number Serial number of the scanner to find
+ * @param targets IPv4 addresses to send to, which may include broadcast addresses
+ * @param timeout Longest time to wait for the scanner to reply, in seconds
+ * @param port Port to send to
+ * @return Identity of the scanner, including the address it replied from
+ * @throw std::invalid_argument if a target is not a valid address
+ * @throw std::runtime_error if the scanner did not reply within the timeout
+ */
+CIPIdentity findScannerBySerialNumber(EIP_UDINT serial_number, const vector<string>& targets,
+  double timeout, unsigned short port = EIP_PORT);
+
+/**
+ * Parse a list of discovery targets such as "192.168.1.0/24,10.0.0.5". Subnets
+ * are expanded to each of their host addresses, leaving out the network and
+ * broadcast addresses. Subnets are limited to a /16, to keep discovery quick.
+ * Single addresses, including broadcast addresses, are passed through as they are.
+ * @param targets Addresses and subnets, separated by commas
+ * @return Addresses to send to
+ * @throw std::invalid_argument if the list cannot be parsed
+ */
+vector<string> parseDiscoveryTargets(const string& targets);
+
+/**
+ * Parse a serial number as printed by os32c_discover, in decimal, or in hex
+ * with a leading 0x. The whole UDINT range is accepted.
+ * @param text Serial number to parse
+ * @return Serial number
+ * @throw std::invalid_argument if the text is not a number from 0 to 0xFFFFFFFF
+ */
+EIP_UDINT parseSerialNumber(const string& text);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_DISCOVERY_H
@@ -0,0 +1,155 @@
+/**
+Software License Agreement (BSD)
+
+\file      fixed_vector.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_FIXED_VECTOR_H
+#define OMRON_OS32C_DRIVER_FIXED_VECTOR_H
+
+#include <stddef.h>
+#include <algorithm>
+#include <array>
+#include <stdexcept>
+
+namespace omron_os32c_driver {
+
+/**
+ * Vector with its elements stored inline, up to a fixed capacity. Has the
+ * parts of the std::vector interface used for beam data, but never allocates,
+ * so that decoding a scan into an existing object costs no heap traffic.
+ */
+template <typename T, size_t N>
+class FixedVector
+{
+public:
+  typedef T value_type;
+  typedef size_t size_type;
+  typedef T* iterator;
+  typedef const T* const_iterator;
+
+  FixedVector() : size_(0)
+  {
+  }
+
+  size_t size() const
+  {
+    return size_;
+  }
+
+  bool empty() const
+  {
+    return size_ == 0;
+  }
+
+  static size_t capacity()
+  {
+    return N;
+  }
+
+  /**
+   * Change the number of elements. New elements are value initialized, as
+   * with std::vector.
+   * @throw std::length_error if the size is more than the capacity
+   */
+  void resize(size_t n)
+  {
+    checkCapacity(n);
+    if (n > size_)
+    {
+      std::fill(begin() + size_, begin() + n, T());
+    }
+    size_ = n;
+  }
+
+  /**
+   * Replace the contents with n copies of the given value
+   * @throw std::length_error if n is more than the capacity
+   */
+  void assign(size_t n, const T& value)
+  {
+    checkCapacity(n);
+    std::fill(begin(), begin() + n, value);
+    size_ = n;
+  }
+
+  void clear()
+  {
+    size_ = 0;
+  }
+
+  T& operator[](size_t i)
+  {
+    return data_[i];
+  }
+
+  const T& operator[](size_t i) const
+  {
+    return data_[i];
+  }
+
+  T* data()
+  {
+    return data_.data();
+  }
+
+  const T* data() const
+  {
+    return data_.data();
+  }
+
+  iterator begin()
+  {
+    return data();
+  }
+
+  iterator end()
+  {
+    return data() + size_;
+  }
+
+  const_iterator begin() const
+  {
+    return data();
+  }
+
+  const_iterator end() const
+  {
+    return data() + size_;
+  }
+
+private:
+  std::array<T, N> data_;
+  size_t size_;
+
+  void checkCapacity(size_t n) const
+  {
+    if (n > N)
+    {
+      throw std::length_error("Size exceeds the fixed capacity");
+    }
+  }
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_FIXED_VECTOR_H
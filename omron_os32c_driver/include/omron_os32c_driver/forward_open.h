@@ -0,0 +1,399 @@
+/**
+Software License Agreement (BSD)
+
+\file      forward_open.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_FORWARD_OPEN_H
+#define OMRON_OS32C_DRIVER_FORWARD_OPEN_H
+
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "odva_ethernetip/serialization/serializable.h"
+
+using std::vector;
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+typedef enum
+{
+  CONNECTION_TYPE_NULL      = 0,
+  CONNECTION_TYPE_MULTICAST = 1,
+  CONNECTION_TYPE_P2P       = 2,
+} CONNECTION_TYPE;
+
+typedef enum
+{
+  CONNECTION_PRIORITY_LOW       = 0,
+  CONNECTION_PRIORITY_HIGH      = 1,
+  CONNECTION_PRIORITY_SCHEDULED = 2,
+  CONNECTION_PRIORITY_URGENT    = 3,
+} CONNECTION_PRIORITY;
+
+/**
+ * Build the connection path of an IO connection to an assembly: the
+ * configuration instance, then the O->T and T->O connection points, each as
+ * an 8-bit logical segment.
+ */
+inline vector<EIP_BYTE> getAssemblyConnectionPath(EIP_USINT config_instance,
+  EIP_USINT o_to_t_point, EIP_USINT t_to_o_point)
+{
+  EIP_BYTE path[] = { 0x20, 0x04, 0x24, config_instance, 0x2C, o_to_t_point,
+    0x2C, t_to_o_point };
+  return vector<EIP_BYTE>(path, path + sizeof(path));
+}
+
+/**
+ * Request data for the Large Forward Open service (0x5B) of the Connection
+ * Manager. odva_ethernetip opens the usual point to point connection itself,
+ * but does not expose the connection types, which are needed for a multicast
+ * T->O direction or a heartbeat O->T direction. The layout is that of the
+ * Forward Open, with 32 bit network connection parameters so that the T->O
+ * size can be that of a full measurement report.
+ */
+class LargeForwardOpenRequest : public Serializable
+{
+public:
+  EIP_BYTE timeout_tick_size;
+  EIP_USINT timeout_ticks;
+  EIP_UDINT o_to_t_connection_id;
+  EIP_UDINT t_to_o_connection_id;
+  EIP_UINT connection_sn;
+  EIP_UINT originator_vendor_id;
+  EIP_UDINT originator_sn;
+  EIP_USINT timeout_multiplier;
+  EIP_UDINT o_to_t_rpi;
+  EIP_DWORD o_to_t_conn_params;
+  EIP_UDINT t_to_o_rpi;
+  EIP_DWORD t_to_o_conn_params;
+  EIP_BYTE trigger;
+  vector<EIP_BYTE> path;
+
+  LargeForwardOpenRequest() : timeout_tick_size(6), timeout_ticks(80), o_to_t_connection_id(0),
+    t_to_o_connection_id(0), connection_sn(0), originator_vendor_id(0), originator_sn(0),
+    timeout_multiplier(0), o_to_t_rpi(0), o_to_t_conn_params(0), t_to_o_rpi(0),
+    t_to_o_conn_params(0), trigger(0x01)
+  {
+  }
+
+  /**
+   * Calculate the network connection parameters of one direction
+   * @param size Size of the data, including the sequence count
+   * @param variable True if the data size is variable, false if fixed
+   * @param priority Priority of the connection
+   * @param type Type of the connection
+   * @param redundant_owner True to allow redundant owners of the connection
+   */
+  static EIP_DWORD calcConnectionParams(EIP_UINT size, bool variable,
+    CONNECTION_PRIORITY priority, CONNECTION_TYPE type, bool redundant_owner)
+  {
+    return (redundant_owner ? 0x80000000 : 0) | ((type & 3) << 29)
+      | ((priority & 3) << 26) | (variable ? 0x02000000 : 0) | size;
+  }
+
+  virtual size_t getLength() const
+  {
+    return 40 + path.size();
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the request
+   * @throw std::logic_error if the path is not a whole number of words
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    if (path.size() % 2)
+    {
+      throw std::logic_error("Connection path must be a whole number of words");
+    }
+    EIP_BYTE reserved[3] = { 0, 0, 0 };
+    EIP_USINT path_size = path.size() / 2;
+    writer.write(timeout_tick_size);
+    writer.write(timeout_ticks);
+    writer.write(o_to_t_connection_id);
+    writer.write(t_to_o_connection_id);
+    writer.write(connection_sn);
+    writer.write(originator_vendor_id);
+    writer.write(originator_sn);
+    writer.write(timeout_multiplier);
+    writer.writeBytes(reserved, sizeof(reserved));
+    writer.write(o_to_t_rpi);
+    writer.write(o_to_t_conn_params);
+    writer.write(t_to_o_rpi);
+    writer.write(t_to_o_conn_params);
+    writer.write(trigger);
+    writer.write(path_size);
+    if (!path.empty())
+    {
+      writer.writeBytes(&path[0], path.size());
+    }
+    return writer;
+  }
+
+  /**
+   * Not implemented. Only ever sent by the driver.
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    throw std::logic_error("Not implemented");
+  }
+
+  /**
+   * Not implemented. Only ever sent by the driver.
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    throw std::logic_error("Not implemented");
+  }
+};
+
+/**
+ * Reply data for a successful Forward Open or Large Forward Open. The target
+ * chooses the O->T connection ID, and for a multicast connection the T->O
+ * connection ID too, so both must be taken from the reply.
+ */
+class ForwardOpenReply : public Serializable
+{
+public:
+  EIP_UDINT o_to_t_connection_id;
+  EIP_UDINT t_to_o_connection_id;
+  EIP_UINT connection_sn;
+  EIP_UINT originator_vendor_id;
+  EIP_UDINT originator_sn;
+  /// Actual packet interval of the O->T direction, in microseconds
+  EIP_UDINT o_to_t_api;
+  /// Actual packet interval of the T->O direction, in microseconds
+  EIP_UDINT t_to_o_api;
+  vector<EIP_BYTE> application_reply;
+
+  ForwardOpenReply() : o_to_t_connection_id(0), t_to_o_connection_id(0), connection_sn(0),
+    originator_vendor_id(0), originator_sn(0), o_to_t_api(0), t_to_o_api(0)
+  {
+  }
+
+  virtual size_t getLength() const
+  {
+    return 26 + application_reply.size();
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the reply
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    EIP_USINT reply_size = application_reply.size() / 2;
+    EIP_USINT reserved = 0;
+    writer.write(o_to_t_connection_id);
+    writer.write(t_to_o_connection_id);
+    writer.write(connection_sn);
+    writer.write(originator_vendor_id);
+    writer.write(originator_sn);
+    writer.write(o_to_t_api);
+    writer.write(t_to_o_api);
+    writer.write(reply_size);
+    writer.write(reserved);
+    if (!application_reply.empty())
+    {
+      writer.writeBytes(&application_reply[0], application_reply.size());
+    }
+    return writer;
+  }
+
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    return deserialize(reader);
+  }
+
+  /**
+   * Deserialize data from the given reader
+   * @param reader Reader to use for deserialization
+   * @return the reader again
+   * @throw std::length_error if the buffer is overrun while deserializing
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    EIP_USINT reply_size;
+    reader.read(o_to_t_connection_id);
+    reader.read(t_to_o_connection_id);
+    reader.read(connection_sn);
+    reader.read(originator_vendor_id);
+    reader.read(originator_sn);
+    reader.read(o_to_t_api);
+    reader.read(t_to_o_api);
+    reader.read(reply_size);
+    reader.skip(1);
+    application_reply.resize(reply_size * 2);
+    if (reply_size)
+    {
+      reader.readBytes(&application_reply[0], application_reply.size());
+    }
+    return reader;
+  }
+};
+
+/**
+ * Request data for the Forward Close service (0x4E) of the Connection
+ * Manager, for closing a connection opened with LargeForwardOpenRequest. The
+ * connection is identified by the serial numbers it was opened with.
+ */
+class ForwardCloseRequest : public Serializable
+{
+public:
+  EIP_BYTE timeout_tick_size;
+  EIP_USINT timeout_ticks;
+  EIP_UINT connection_sn;
+  EIP_UINT originator_vendor_id;
+  EIP_UDINT originator_sn;
+  vector<EIP_BYTE> path;
+
+  ForwardCloseRequest() : timeout_tick_size(6), timeout_ticks(80), connection_sn(0),
+    originator_vendor_id(0), originator_sn(0)
+  {
+  }
+
+  virtual size_t getLength() const
+  {
+    return 12 + path.size();
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the request
+   * @throw std::logic_error if the path is not a whole number of words
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    if (path.size() % 2)
+    {
+      throw std::logic_error("Connection path must be a whole number of words");
+    }
+    EIP_USINT path_size = path.size() / 2;
+    EIP_USINT reserved = 0;
+    writer.write(timeout_tick_size);
+    writer.write(timeout_ticks);
+    writer.write(connection_sn);
+    writer.write(originator_vendor_id);
+    writer.write(originator_sn);
+    writer.write(path_size);
+    writer.write(reserved);
+    if (!path.empty())
+    {
+      writer.writeBytes(&path[0], path.size());
+    }
+    return writer;
+  }
+
+  /**
+   * Not implemented. Only ever sent by the driver.
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    throw std::logic_error("Not implemented");
+  }
+
+  /**
+   * Not implemented. Only ever sent by the driver.
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    throw std::logic_error("Not implemented");
+  }
+};
+
+/**
+ * Multicast configuration of the TCP/IP Interface object (class 0xF5,
+ * attribute 9). Gives the block of multicast addresses the scanner sends
+ * multicast T->O connections to.
+ */
+class MulticastConfig : public Serializable
+{
+public:
+  EIP_USINT alloc_control;
+  EIP_UINT num_mcast;
+  /// First multicast address, in host byte order
+  EIP_UDINT mcast_start_addr;
+
+  MulticastConfig() : alloc_control(0), num_mcast(0), mcast_start_addr(0)
+  {
+  }
+
+  /**
+   * Get the first multicast address in dotted decimal form
+   */
+  std::string getStartAddress() const
+  {
+    char address[16];
+    snprintf(address, sizeof(address), "%u.%u.%u.%u", (mcast_start_addr >> 24) & 0xFF,
+      (mcast_start_addr >> 16) & 0xFF, (mcast_start_addr >> 8) & 0xFF, mcast_start_addr & 0xFF);
+    return address;
+  }
+
+  virtual size_t getLength() const
+  {
+    return 8;
+  }
+
+  virtual Writer& serialize(Writer& writer) const
+  {
+    EIP_USINT reserved = 0;
+    writer.write(alloc_control);
+    writer.write(reserved);
+    writer.write(num_mcast);
+    writer.write(mcast_start_addr);
+    return writer;
+  }
+
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    return deserialize(reader);
+  }
+
+  virtual Reader& deserialize(Reader& reader)
+  {
+    reader.read(alloc_control);
+    reader.skip(1);
+    reader.read(num_mcast);
+    reader.read(mcast_start_addr);
+    return reader;
+  }
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_FORWARD_OPEN_H
@@ -0,0 +1,158 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_connection_params.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_IO_CONNECTION_PARAMS_H
+#define OMRON_OS32C_DRIVER_IO_CONNECTION_PARAMS_H
+
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+typedef enum
+{
+  /// Owns the connection and sends the measurement report config as keepalive
+  IO_CONNECTION_OWNER       = 0,
+  /// Receives scans and sends only a heartbeat, without configuring the scanner
+  IO_CONNECTION_INPUT_ONLY  = 1,
+  /// As input only, but shares the multicast T->O of an owner and closes with it
+  IO_CONNECTION_LISTEN_ONLY = 2,
+} IO_CONNECTION_MODE;
+
+/**
+ * Parameters of the Forward Open for the UDP IO connection, along with the
+ * host side intervals derived from them. O->T is the host to scanner
+ * direction, which carries the measurement report config as a keepalive, and
+ * T->O is the scanner to host direction, which carries the scans.
+ */
+struct IOConnectionParams
+{
+  /// Shortest T->O RPI, in microseconds. The scanner measures a scan every 40 ms.
+  static const EIP_UDINT MIN_T_TO_O_RPI;
+  /// Longest RPI in either direction, in microseconds
+  static const EIP_UDINT MAX_RPI;
+  /// Largest T->O buffer, which holds a measurement report of every beam
+  static const EIP_UINT MAX_T_TO_O_BUFFER_SIZE;
+  /// O->T buffer of a heartbeat, which carries only the sequence count
+  static const EIP_UINT HEARTBEAT_BUFFER_SIZE;
+  /// Usual heartbeat connection points of input only and listen only
+  /// connections. Check them against the EDS of the scanner.
+  static const EIP_USINT INPUT_ONLY_HEARTBEAT_ID;
+  static const EIP_USINT LISTEN_ONLY_HEARTBEAT_ID;
+
+  /**
+   * Construct with the values the driver has always used, which the
+   * scanner accepts with its factory configuration
+   */
+  IOConnectionParams()
+    : o_to_t_rpi(0x00177FA0), t_to_o_rpi(0x00013070), o_to_t_buffer_size(0x006E),
+      t_to_o_buffer_size(0x0584), o_to_t_assembly_id(0x71), t_to_o_assembly_id(0x66),
+      config_assembly_id(0x01), timeout_multiplier(4), mode(IO_CONNECTION_OWNER),
+      t_to_o_multicast(false)
+  {
+  }
+
+  /// Requested interval between keepalives from the host, in microseconds
+  EIP_UDINT o_to_t_rpi;
+  /// Requested interval between scans from the scanner, in microseconds
+  EIP_UDINT t_to_o_rpi;
+  EIP_UINT o_to_t_buffer_size;
+  EIP_UINT t_to_o_buffer_size;
+  EIP_USINT o_to_t_assembly_id;
+  EIP_USINT t_to_o_assembly_id;
+  /// Configuration instance in the connection path, for connections other
+  /// than the point to point owner, which odva_ethernetip opens itself
+  EIP_USINT config_assembly_id;
+  /// Number of T->O RPIs without a scan before the connection is considered lost
+  int timeout_multiplier;
+  IO_CONNECTION_MODE mode;
+  /// Request a multicast T->O direction, so that other hosts can listen in
+  bool t_to_o_multicast;
+
+  /**
+   * Change the mode of the connection. Input only and listen only connections
+   * send a heartbeat to the usual heartbeat connection point, and listen only
+   * connections can only be multicast.
+   */
+  void setMode(IO_CONNECTION_MODE new_mode);
+
+  /**
+   * Check the parameters against the limits of the scanner and of the driver.
+   * @throw std::invalid_argument naming the first parameter out of range
+   */
+  void validate() const;
+
+  /**
+   * Time between scans, in seconds
+   */
+  double getScanPeriod() const
+  {
+    return t_to_o_rpi / 1e6;
+  }
+
+  /**
+   * Time without a scan after which the connection should be considered lost,
+   * in seconds
+   */
+  double getIOTimeout() const
+  {
+    return timeout_multiplier * getScanPeriod();
+  }
+
+  /**
+   * Time between keepalives in seconds, half the O->T RPI, so that a single
+   * lost keepalive does not time out the connection on the scanner
+   */
+  double getKeepaliveInterval() const
+  {
+    return o_to_t_rpi / 2e6;
+  }
+
+  bool operator==(const IOConnectionParams& other) const;
+
+  bool operator!=(const IOConnectionParams& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+/**
+ * Build the list of parameters to try in turn for a Forward Open: those
+ * requested, then those with the default RPIs, since the timing is what the
+ * scanner is most likely to reject, then for an owner the defaults. The mode
+ * and connection type are kept throughout, since falling back on them would
+ * take the scanner from its owner or cut off other listeners. Duplicates are
+ * left out.
+ * @param requested Parameters to try first
+ * @return Parameters to try, in order, starting with the requested
+ */
+vector<IOConnectionParams> getFallbackParams(const IOConnectionParams& requested);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_IO_CONNECTION_PARAMS_H
@@ -0,0 +1,103 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_packet.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_IO_PACKET_H
+#define OMRON_OS32C_DRIVER_IO_PACKET_H
+
+#include <stddef.h>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/measurement_report_config.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Outcome of decoding an IO packet. Everything but DECODE_OK means the packet
+ * was not a measurement report from the scanner, and should be dropped.
+ */
+typedef enum
+{
+  DECODE_OK                 = 0,
+  DECODE_TRUNCATED          = 1,
+  DECODE_WRONG_ITEM_COUNT   = 2,
+  DECODE_WRONG_ITEM_TYPE    = 3,
+  DECODE_TOO_MANY_BEAMS     = 4,
+  DECODE_LENGTH_MISMATCH    = 5,
+} DECODE_STATUS;
+
+/**
+ * Get a description of a decode status, for logging
+ */
+const char* decodeStatusString(DECODE_STATUS status);
+
+/**
+ * Decode a measurement report from a raw IO packet without throwing, so that
+ * bursts of corrupt or foreign traffic on the IO port are cheap to reject.
+ * Checks the item count and type, the number of beams against the most the
+ * scanner can report, and that the payload length matches the number of beams.
+ * @param data Packet as received from the IO socket
+ * @param size Number of bytes received
+ * @param report Report to decode into. Only valid if DECODE_OK is returned.
+ *  The beam data is stored inline, so decoding does not allocate.
+ * @return DECODE_OK if a measurement report was decoded, otherwise the
+ *  reason the packet was rejected
+ */
+DECODE_STATUS decodeMeasurementReport(const EIP_BYTE* data, size_t size,
+  MeasurementReport& report);
+
+/**
+ * Encode a measurement report config as an IO packet, the way the CPF classes
+ * of odva_ethernetip would, but straight into a buffer owned by the caller.
+ * Allows the keepalive to be sent without building any transient protocol
+ * objects on the heap.
+ * @param mrc Measurement report config to send
+ * @param connection_id O->T connection ID of the IO connection
+ * @param sequence_num Sequence number of the packet
+ * @param data Buffer to encode into
+ * @param size Size of the buffer
+ * @return number of bytes encoded
+ * @throw std::length_error if the buffer is too small
+ */
+size_t encodeMeasurementReportConfig(const MeasurementReportConfig& mrc,
+  EIP_UDINT connection_id, EIP_UDINT sequence_num, EIP_BYTE* data, size_t size);
+
+/**
+ * Encode the heartbeat of an input only or listen only connection as an IO
+ * packet. The connected data is nothing but the sequence count.
+ * @param connection_id O->T connection ID of the IO connection
+ * @param sequence_num Sequence number of the packet, which is also the
+ *  sequence count of the data
+ * @param data Buffer to encode into
+ * @param size Size of the buffer
+ * @return number of bytes encoded
+ * @throw std::length_error if the buffer is too small
+ */
+size_t encodeHeartbeat(EIP_UDINT connection_id, EIP_UDINT sequence_num, EIP_BYTE* data,
+  size_t size);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_IO_PACKET_H
@@ -0,0 +1,231 @@
+/**
+Software License Agreement (BSD)
+
+\file      laserscan_serialization.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_LASERSCAN_SERIALIZATION_H
+#define OMRON_OS32C_DRIVER_LASERSCAN_SERIALIZATION_H
+
+#include <cstring>
+#include <ros/message_traits.h>
+#include <ros/serialization.h>
+#include <sensor_msgs/LaserScan.h>
+#include <std_msgs/Header.h>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/compact_scan.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/reflectivity_calibration.h"
+#include "omron_os32c_driver/scan_stream.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * A LaserScan that is serialized straight from the data reported by the
+ * device. It does not hold any beam data itself, but refers to the raw range
+ * (and optionally reflectance) values of a measurement, which are converted
+ * to the LaserScan wire format while the message is being serialized. It is
+ * registered with roscpp as a sensor_msgs/LaserScan, so it can be published
+ * on a LaserScan topic and received by any LaserScan subscriber.
+ *
+ * The referenced measurement must stay valid until publish() returns.
+ */
+struct RawLaserScan
+{
+  std_msgs::Header header;
+  float angle_min;
+  float angle_max;
+  float angle_increment;
+  float time_increment;
+  float scan_time;
+  float range_min;
+  float range_max;
+
+  const EIP_UINT* ranges;
+  const EIP_UINT* intensities;
+  size_t num_beams;
+  /// Calibration to convert the intensities to reflectivity with, or NULL for none
+  const ReflectivityCalibration* calibration;
+
+  RawLaserScan() : angle_min(0), angle_max(0), angle_increment(0), time_increment(0),
+    scan_time(0), range_min(0), range_max(0), ranges(NULL), intensities(NULL), num_beams(0),
+    calibration(NULL)
+  {
+  }
+
+  /**
+   * Copy the unchanging parts of the scan from a LaserScan which has been populated
+   * with fillLaserScanStaticConfig.
+   * @param ls LaserScan to copy the header and static config from
+   */
+  void setStaticConfig(const sensor_msgs::LaserScan& ls)
+  {
+    header = ls.header;
+    angle_min = ls.angle_min;
+    angle_max = ls.angle_max;
+    angle_increment = ls.angle_increment;
+    range_min = ls.range_min;
+    range_max = ls.range_max;
+  }
+
+  /**
+   * Refer to the data of a Measurement Report. No beam data is copied.
+   * @param mr Measurement to refer to
+   * @throw std::invalid_argument if the number of beams does not match the data
+   */
+  void setMeasurement(const MeasurementReport& mr)
+  {
+    if (mr.measurement_data.size() != mr.header.num_beams)
+    {
+      throw std::invalid_argument("Number of beams does not match vector size");
+    }
+    setTiming(mr.header);
+    num_beams = mr.header.num_beams;
+    ranges = num_beams ? &mr.measurement_data[0] : NULL;
+    intensities = NULL;
+  }
+
+  /**
+   * Refer to the data of a Range and Reflectance Measurement. No beam data is copied.
+   * @param rr Measurement to refer to
+   * @throw std::invalid_argument if the number of beams does not match the data
+   */
+  void setMeasurement(const RangeAndReflectanceMeasurement& rr)
+  {
+    if (rr.range_data.size() != rr.header.num_beams ||
+      rr.reflectance_data.size() != rr.header.num_beams)
+    {
+      throw std::invalid_argument("Number of beams does not match vector size");
+    }
+    setTiming(rr.header);
+    num_beams = rr.header.num_beams;
+    ranges = num_beams ? &rr.range_data[0] : NULL;
+    intensities = num_beams ? &rr.reflectance_data[0] : NULL;
+  }
+
+  /**
+   * Refer to the data of a scan from a ScanStream. No beam data is copied, so the
+   * message must be published before the callback the scan was passed to returns.
+   * @param scan Scan to refer to
+   */
+  void setMeasurement(const ScanView& scan)
+  {
+    setTiming(*scan.header);
+    num_beams = scan.num_beams;
+    ranges = scan.ranges;
+    intensities = NULL;
+  }
+
+private:
+  void setTiming(const MeasurementReportHeader& header)
+  {
+    // Beam period is in ns.
+    time_increment = header.scan_beam_period / 1000000000.0;
+    // Scan period is in microseconds.
+    scan_time = header.scan_rate / 1000000.0;
+  }
+};
+
+} // namespace omron_os32c_driver
+
+namespace ros {
+namespace message_traits {
+
+template<>
+struct MD5Sum<omron_os32c_driver::RawLaserScan>
+{
+  static const char* value() { return MD5Sum<sensor_msgs::LaserScan>::value(); }
+  static const char* value(const omron_os32c_driver::RawLaserScan&) { return value(); }
+};
+
+template<>
+struct DataType<omron_os32c_driver::RawLaserScan>
+{
+  static const char* value() { return DataType<sensor_msgs::LaserScan>::value(); }
+  static const char* value(const omron_os32c_driver::RawLaserScan&) { return value(); }
+};
+
+template<>
+struct Definition<omron_os32c_driver::RawLaserScan>
+{
+  static const char* value() { return Definition<sensor_msgs::LaserScan>::value(); }
+  static const char* value(const omron_os32c_driver::RawLaserScan&) { return value(); }
+};
+
+} // namespace message_traits
+
+namespace serialization {
+
+/**
+ * Writes a RawLaserScan in the wire format of sensor_msgs/LaserScan, converting
+ * ranges and intensities directly into the outgoing buffer.
+ */
+template<>
+struct Serializer<omron_os32c_driver::RawLaserScan>
+{
+  template<typename Stream>
+  inline static void write(Stream& stream, const omron_os32c_driver::RawLaserScan& ls)
+  {
+    stream.next(ls.header);
+    stream.next(ls.angle_min);
+    stream.next(ls.angle_max);
+    stream.next(ls.angle_increment);
+    stream.next(ls.time_increment);
+    stream.next(ls.scan_time);
+    stream.next(ls.range_min);
+    stream.next(ls.range_max);
+
+    uint32_t num_beams = ls.num_beams;
+    stream.next(num_beams);
+    uint8_t* out = stream.advance(num_beams * sizeof(float));
+    for (uint32_t i = 0; i < num_beams; ++i)
+    {
+      float range = omron_os32c_driver::decodeRange(ls.ranges[i], ls.range_max);
+      memcpy(out + i * sizeof(float), &range, sizeof(float));
+    }
+
+    uint32_t num_intensities = ls.intensities ? num_beams : 0;
+    stream.next(num_intensities);
+    out = stream.advance(num_intensities * sizeof(float));
+    for (uint32_t i = 0; i < num_intensities; ++i)
+    {
+      float intensity = ls.calibration ? ls.calibration->calibrate(ls.ranges[i], ls.intensities[i])
+        : ls.intensities[i];
+      memcpy(out + i * sizeof(float), &intensity, sizeof(float));
+    }
+  }
+
+  inline static uint32_t serializedLength(const omron_os32c_driver::RawLaserScan& ls)
+  {
+    uint32_t num_intensities = ls.intensities ? ls.num_beams : 0;
+    return serializationLength(ls.header) + 7 * sizeof(float)
+      + sizeof(uint32_t) + ls.num_beams * sizeof(float)
+      + sizeof(uint32_t) + num_intensities * sizeof(float);
+  }
+};
+
+} // namespace serialization
+} // namespace ros
+
+#endif  // OMRON_OS32C_DRIVER_LASERSCAN_SERIALIZATION_H
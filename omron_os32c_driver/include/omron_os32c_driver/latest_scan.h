@@ -0,0 +1,258 @@
+/**
+Software License Agreement (BSD)
+
+\file      latest_scan.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_LATEST_SCAN_H
+#define OMRON_OS32C_DRIVER_LATEST_SCAN_H
+
+#include <stdint.h>
+#include <atomic>
+
+#include "omron_os32c_driver/measurement_report.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Slot holding the most recent scan, for consumers that want the freshest
+ * data on their own schedule rather than a queue of every scan. Written by
+ * a single thread and read by any number of threads without locks.
+ *
+ * Scans live in a fixed set of buffers (three by default). The writer fills
+ * a buffer that no reader is using and then publishes it, so handing over a
+ * scan never copies it. A reader takes a Handle, which keeps the buffer it
+ * refers to from being reused until the handle is released. Taking and
+ * releasing a handle is a single atomic operation each, so readers never
+ * wait for the writer or for each other.
+ *
+ * The latest buffer and the number of handles taken on it are kept in one
+ * atomic word. When a new buffer is published, the count is moved over to
+ * the per-buffer count of the old one, which handles decrement on release.
+ * Handles should be released promptly: while readers hold every buffer but
+ * the latest, the writer has nowhere to put new scans and drops them.
+ *
+ * @tparam T Type of scan to hold
+ * @tparam N Number of buffers, at least three
+ */
+template <typename T, size_t N = 3>
+class LatestScan
+{
+public:
+  /**
+   * Reference to a published scan. Keeps the scan from being overwritten for
+   * as long as it exists. Handles can be moved but not copied.
+   */
+  class Handle
+  {
+  public:
+    Handle() : owner_(NULL), index_(N) { }
+
+    Handle(Handle&& other) : owner_(other.owner_), index_(other.index_)
+    {
+      other.owner_ = NULL;
+    }
+
+    Handle& operator=(Handle&& other)
+    {
+      if (this != &other)
+      {
+        release();
+        owner_ = other.owner_;
+        index_ = other.index_;
+        other.owner_ = NULL;
+      }
+      return *this;
+    }
+
+    ~Handle()
+    {
+      release();
+    }
+
+    /**
+     * True if the handle refers to a scan. False if it was taken before the
+     * first scan was published.
+     */
+    bool valid() const
+    {
+      return owner_ && index_ < N;
+    }
+
+    /**
+     * Generation of the scan, starting at 1 for the first scan published.
+     * Zero if the handle is not valid.
+     */
+    uint64_t generation() const
+    {
+      return valid() ? owner_->buffers_[index_].generation : 0;
+    }
+
+    const T& operator*() const
+    {
+      return owner_->buffers_[index_].scan;
+    }
+
+    const T* operator->() const
+    {
+      return &owner_->buffers_[index_].scan;
+    }
+
+    /**
+     * Give up the reference to the scan early.
+     */
+    void release()
+    {
+      if (owner_)
+      {
+        owner_->buffers_[index_].readers.fetch_sub(1, std::memory_order_release);
+        owner_ = NULL;
+      }
+    }
+
+  private:
+    friend class LatestScan;
+
+    Handle(const LatestScan* owner, size_t index) : owner_(owner), index_(index) { }
+    Handle(const Handle&) = delete;
+    Handle& operator=(const Handle&) = delete;
+
+    const LatestScan* owner_;
+    size_t index_;
+  };
+
+  LatestScan() : latest_(pack(N, 0)), generation_(0), writing_(N)
+  {
+    static_assert(N >= 3 && N < 255, "LatestScan needs between 3 and 254 buffers");
+    for (size_t i = 0; i <= N; ++i)
+    {
+      buffers_[i].readers.store(0, std::memory_order_relaxed);
+      buffers_[i].generation = 0;
+    }
+  }
+
+  /**
+   * Get the latest scan. Wait-free.
+   * @return Handle to the latest scan, which is not valid if no scan has
+   *  been published yet.
+   */
+  Handle read() const
+  {
+    uint64_t latest = latest_.fetch_add(1, std::memory_order_acquire);
+    return Handle(this, index(latest));
+  }
+
+  /**
+   * Generation of the latest scan, or zero if there is none yet. Allows
+   * checking for a new scan without taking a handle.
+   */
+  uint64_t getGeneration() const
+  {
+    return generation_.load(std::memory_order_acquire);
+  }
+
+  /**
+   * Get a buffer to fill with the next scan. Only to be called from the
+   * writing thread. Calling it again before publish() returns the same buffer.
+   * @return Buffer to fill, or NULL if readers hold all buffers that could
+   *  be written to.
+   */
+  T* beginWrite()
+  {
+    if (writing_ < N)
+    {
+      return &buffers_[writing_].scan;
+    }
+
+    size_t latest = index(latest_.load(std::memory_order_relaxed));
+    for (size_t i = 0; i < N; ++i)
+    {
+      if (i != latest && buffers_[i].readers.load(std::memory_order_acquire) == 0)
+      {
+        writing_ = i;
+        return &buffers_[i].scan;
+      }
+    }
+    return NULL;
+  }
+
+  /**
+   * Publish the buffer returned by beginWrite() as the latest scan. Only to
+   * be called from the writing thread.
+   */
+  void publish()
+  {
+    if (writing_ >= N)
+    {
+      return;
+    }
+
+    uint64_t generation = generation_.load(std::memory_order_relaxed) + 1;
+    buffers_[writing_].generation = generation;
+    uint64_t old = latest_.exchange(pack(writing_, 0), std::memory_order_acq_rel);
+    generation_.store(generation, std::memory_order_release);
+
+    // move the handles taken on the old buffer over to its own count
+    buffers_[index(old)].readers.fetch_add(count(old), std::memory_order_relaxed);
+    writing_ = N;
+  }
+
+private:
+  struct Buffer
+  {
+    T scan;
+    uint64_t generation;
+    mutable std::atomic<int64_t> readers;
+  };
+
+  // index of the latest buffer in the upper 8, number of handles taken on it
+  // in the lower 56 bits. Index N means that nothing has been published yet.
+  mutable std::atomic<uint64_t> latest_;
+  std::atomic<uint64_t> generation_;
+  size_t writing_;
+  // one extra buffer to count handles taken before the first publish
+  Buffer buffers_[N + 1];
+
+  static uint64_t pack(size_t index, uint64_t count)
+  {
+    return (static_cast<uint64_t>(index) << 56) | count;
+  }
+
+  static size_t index(uint64_t latest)
+  {
+    return latest >> 56;
+  }
+
+  static uint64_t count(uint64_t latest)
+  {
+    return latest & 0x00FFFFFFFFFFFFFFULL;
+  }
+
+  LatestScan(const LatestScan&) = delete;
+  LatestScan& operator=(const LatestScan&) = delete;
+};
+
+typedef LatestScan<MeasurementReport> LatestMeasurementReport;
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_LATEST_SCAN_H
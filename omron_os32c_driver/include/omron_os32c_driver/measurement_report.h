@@ -51,7 +51,7 @@ class MeasurementReport : public Serializable
 {
 public:
   MeasurementReportHeader header;
-  vector<EIP_UINT> measurement_data;
+  BeamData measurement_data;
 
   /**
    * Size of this message including all measurement data
@@ -75,23 +75,38 @@ public:
   }
 
   /**
-   * Extra length information is not relevant in this context. Same as deserialize(reader)
+   * Deserialize data from the given reader, checking the number of beams
+   * against the length of the message before allocating storage for them
+   * @param reader Reader to use for deserialization
+   * @param length Length of the message
+   * @return the reader again
+   * @throw std::length_error if the number of beams is not plausible, or the
+   *  buffer is overrun while deserializing
    */
   virtual Reader& deserialize(Reader& reader, size_t length)
   {
-    deserialize(reader);
-    return reader;
+    header.deserialize(reader);
+    header.checkNumBeams(length, 1);
+    return deserializeBeams(reader);
   }
 
   /**
    * Deserialize data from the given reader without length information
    * @param reader Reader to use for deserialization
    * @return the reader again
-   * @throw std::length_error if the buffer is overrun while deserializing
+   * @throw std::length_error if the number of beams is more than the scanner
+   *  has, or the buffer is overrun while deserializing
    */
   virtual Reader& deserialize(Reader& reader)
   {
     header.deserialize(reader);
+    header.checkNumBeams(0, 1);
+    return deserializeBeams(reader);
+  }
+
+private:
+  Reader& deserializeBeams(Reader& reader)
+  {
     measurement_data.resize(header.num_beams);
     reader.readBytes(&measurement_data[0], measurement_data.size() * sizeof(EIP_UINT));
     return reader;
@@ -26,12 +26,14 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 #ifndef OMRON_OS32C_DRIVER_MEASUREMENT_REPORT_HEADER_H
 #define OMRON_OS32C_DRIVER_MEASUREMENT_REPORT_HEADER_H
 
+#include <stdexcept>
 #include <string>
 
 #include "odva_ethernetip/eip_types.h"
 #include "odva_ethernetip/serialization/reader.h"
 #include "odva_ethernetip/serialization/writer.h"
 #include "odva_ethernetip/serialization/serializable.h"
+#include "omron_os32c_driver/fixed_vector.h"
 
 using std::string;
 using eip::serialization::Serializable;
@@ -47,6 +49,9 @@ namespace omron_os32c_driver {
 class MeasurementReportHeader : public Serializable
 {
 public:
+  /// Most beams the scanner reports, for the full 270.4 degrees at 0.4 degrees each
+  static const EIP_UINT MAX_BEAMS = 677;
+
   EIP_UDINT scan_count;
   EIP_UDINT scan_rate;
   EIP_UDINT scan_timestamp;
@@ -73,6 +78,27 @@ public:
     return 56;
   }
 
+  /**
+   * Check that the number of beams is no more than the scanner can report
+   * and, when the length of the message is known, that the message holds
+   * that many beams. Called before allocating storage for the beams, so that
+   * a stray packet cannot cause an oversized allocation.
+   * @param length Length of the header and all beam data, or zero if unknown
+   * @param beam_arrays Number of arrays of beam data following the header
+   * @throw std::length_error if the number of beams is not plausible
+   */
+  void checkNumBeams(size_t length, size_t beam_arrays) const
+  {
+    if (num_beams > MAX_BEAMS)
+    {
+      throw std::length_error("Measurement report has more beams than the scanner has");
+    }
+    if (length && length < getLength() + beam_arrays * num_beams * sizeof(EIP_UINT))
+    {
+      throw std::length_error("Measurement report is too short for its number of beams");
+    }
+  }
+
   /**
    * Serialize data into the given buffer
    * @param writer Writer to use for serialization
@@ -149,6 +175,12 @@ public:
   }
 };
 
+/**
+ * Storage for the data of each beam of a scan, sized for the most beams the
+ * scanner reports
+ */
+typedef FixedVector<EIP_UINT, MeasurementReportHeader::MAX_BEAMS> BeamData;
+
 } // namespace omron_os32c_driver
 
 #endif  // OMRON_OS32C_DRIVER_MEASUREMENT_REPORT_HEADER_H
@@ -0,0 +1,323 @@
+/**
+Software License Agreement (BSD)
+
+\file      multiple_service_packet.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_PACKET_H
+#define OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_PACKET_H
+
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "odva_ethernetip/path.h"
+#include "odva_ethernetip/serialization/reader.h"
+#include "odva_ethernetip/serialization/writer.h"
+#include "odva_ethernetip/serialization/serializable.h"
+
+using std::vector;
+using boost::shared_ptr;
+using eip::Path;
+using eip::serialization::Serializable;
+using eip::serialization::Reader;
+using eip::serialization::Writer;
+
+namespace omron_os32c_driver {
+
+/// General status of a reply to a service the object does not support
+static const EIP_USINT SERVICE_NOT_SUPPORTED = 0x08;
+
+/// General status of a Multiple Service Packet reply when any request in it failed
+static const EIP_USINT EMBEDDED_SERVICE_ERROR = 0x1E;
+
+/**
+ * Request data for the CIP Multiple Service Packet service (0x0A) of the
+ * Message Router, which carries several explicit requests in one round trip.
+ * As defined in the CIP specification, the data is the number of requests,
+ * the offset of each request from the start of the data, and then each
+ * request as service code, path and request data.
+ */
+class MultipleServiceRequest : public Serializable
+{
+public:
+  /**
+   * Add a request to the packet
+   * @param service Service code to request
+   * @param path Path to the object the request is for
+   * @param data Request data. May be null for services without data.
+   */
+  void addRequest(EIP_USINT service, const Path& path,
+    shared_ptr<Serializable> data = shared_ptr<Serializable>())
+  {
+    Request req = { service, path, data };
+    requests_.push_back(req);
+  }
+
+  /**
+   * Get the number of requests in the packet
+   */
+  size_t getRequestCount() const
+  {
+    return requests_.size();
+  }
+
+  /**
+   * Length of the count and offset table, plus each request
+   */
+  virtual size_t getLength() const
+  {
+    size_t length = sizeof(EIP_UINT) * (1 + requests_.size());
+    for (size_t i = 0; i < requests_.size(); ++i)
+    {
+      length += getRequestLength(requests_[i]);
+    }
+    return length;
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the packet
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    EIP_UINT count = requests_.size();
+    writer.write(count);
+    EIP_UINT offset = sizeof(EIP_UINT) * (1 + requests_.size());
+    for (size_t i = 0; i < requests_.size(); ++i)
+    {
+      writer.write(offset);
+      offset += getRequestLength(requests_[i]);
+    }
+    for (size_t i = 0; i < requests_.size(); ++i)
+    {
+      writer.write(requests_[i].service);
+      requests_[i].path.serialize(writer);
+      if (requests_[i].data)
+      {
+        requests_[i].data->serialize(writer);
+      }
+    }
+    return writer;
+  }
+
+  /**
+   * Not implemented. Only ever sent by the driver.
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    throw std::logic_error("Not implemented");
+  }
+
+  /**
+   * Not implemented. Only ever sent by the driver.
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    throw std::logic_error("Not implemented");
+  }
+
+private:
+  struct Request
+  {
+    EIP_USINT service;
+    Path path;
+    shared_ptr<Serializable> data;
+  };
+
+  vector<Request> requests_;
+
+  static size_t getRequestLength(const Request& req)
+  {
+    return sizeof(EIP_USINT) + req.path.getLength() + (req.data ? req.data->getLength() : 0);
+  }
+};
+
+/**
+ * Response data for the CIP Multiple Service Packet service (0x0A). Holds
+ * the reply to each of the requests in the packet, in the order they were
+ * requested. Each reply carries its own status, so some requests can
+ * succeed while others fail.
+ */
+class MultipleServiceResponse : public Serializable
+{
+public:
+  /**
+   * Reply to a single request within the packet
+   */
+  struct Reply
+  {
+    EIP_USINT service;
+    EIP_USINT general_status;
+    vector<EIP_UINT> additional_status;
+    vector<EIP_BYTE> data;
+
+    /**
+     * Interpret the reply data as a primitive value, as returned by Get
+     * Single Attribute.
+     * @throw std::length_error if the reply data is too short
+     */
+    template <typename T>
+    T getDataAs() const
+    {
+      if (data.size() < sizeof(T))
+      {
+        throw std::length_error("Reply data is too short");
+      }
+      T value;
+      memcpy(&value, &data[0], sizeof(T));
+      return value;
+    }
+  };
+
+  vector<Reply> replies;
+
+  /**
+   * Length of the count and offset table, plus each reply
+   */
+  virtual size_t getLength() const
+  {
+    size_t length = sizeof(EIP_UINT) * (1 + replies.size());
+    for (size_t i = 0; i < replies.size(); ++i)
+    {
+      length += getReplyLength(replies[i]);
+    }
+    return length;
+  }
+
+  /**
+   * Serialize data into the given buffer
+   * @param writer Writer to use for serialization
+   * @return the writer again
+   * @throw std::length_error if the buffer is too small for the packet
+   */
+  virtual Writer& serialize(Writer& writer) const
+  {
+    EIP_UINT count = replies.size();
+    writer.write(count);
+    EIP_UINT offset = sizeof(EIP_UINT) * (1 + replies.size());
+    for (size_t i = 0; i < replies.size(); ++i)
+    {
+      writer.write(offset);
+      offset += getReplyLength(replies[i]);
+    }
+    for (size_t i = 0; i < replies.size(); ++i)
+    {
+      const Reply& reply = replies[i];
+      EIP_USINT reserved = 0;
+      EIP_USINT additional_status_size = reply.additional_status.size();
+      writer.write(reply.service);
+      writer.write(reserved);
+      writer.write(reply.general_status);
+      writer.write(additional_status_size);
+      for (size_t j = 0; j < reply.additional_status.size(); ++j)
+      {
+        writer.write(reply.additional_status[j]);
+      }
+      if (!reply.data.empty())
+      {
+        writer.writeBytes(&reply.data[0], reply.data.size());
+      }
+    }
+    return writer;
+  }
+
+  /**
+   * Deserialize data from the given reader. The length is needed to know
+   * where the data of the last reply ends.
+   * @param reader Reader to use for deserialization
+   * @param length Length of the response data
+   * @return the reader again
+   * @throw std::length_error if the buffer is overrun while deserializing
+   * @throw std::logic_error if the offsets in the packet are invalid
+   */
+  virtual Reader& deserialize(Reader& reader, size_t length)
+  {
+    size_t start = reader.getByteCount();
+    EIP_UINT count;
+    reader.read(count);
+    vector<EIP_UINT> offsets(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      reader.read(offsets[i]);
+    }
+
+    replies.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+      size_t pos = reader.getByteCount() - start;
+      size_t end = (i + 1 < count) ? offsets[i + 1] : length;
+      if (offsets[i] < pos || end < offsets[i] || end > length)
+      {
+        throw std::logic_error("Invalid reply offset in Multiple Service Packet response");
+      }
+      reader.skip(offsets[i] - pos);
+
+      Reply& reply = replies[i];
+      EIP_USINT additional_status_size;
+      reader.read(reply.service);
+      reader.skip(1);
+      reader.read(reply.general_status);
+      reader.read(additional_status_size);
+      reply.additional_status.resize(additional_status_size);
+      for (size_t j = 0; j < additional_status_size; ++j)
+      {
+        reader.read(reply.additional_status[j]);
+      }
+
+      pos = reader.getByteCount() - start;
+      if (pos > end)
+      {
+        throw std::logic_error("Reply overruns the next in Multiple Service Packet response");
+      }
+      reply.data.resize(end - pos);
+      if (!reply.data.empty())
+      {
+        reader.readBytes(&reply.data[0], reply.data.size());
+      }
+    }
+    return reader;
+  }
+
+  /**
+   * Not supported, since the length is needed to find the end of the last reply
+   * @throw std::logic_error always
+   */
+  virtual Reader& deserialize(Reader& reader)
+  {
+    throw std::logic_error("Multiple Service Packet response needs length to deserialize");
+  }
+
+private:
+  static size_t getReplyLength(const Reply& reply)
+  {
+    return 4 + reply.additional_status.size() * sizeof(EIP_UINT) + reply.data.size();
+  }
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_MULTIPLE_SERVICE_PACKET_H
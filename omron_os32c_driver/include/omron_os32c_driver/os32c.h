@@ -27,22 +27,32 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 #define OMRON_OS32C_DRIVER_OS32C_H
 
 #include <gtest/gtest_prod.h>
+#include <cmath>
 #include <string>
 #include <vector>
 #include <boost/shared_ptr.hpp>
-#include <sensor_msgs/LaserScan.h>
+
+#include "omron_os32c_driver/beam_geometry.h"
+#include "omron_os32c_driver/config_cache.h"
+#include "omron_os32c_driver/connected_messaging.h"
+#include "omron_os32c_driver/forward_open.h"
+#include "omron_os32c_driver/io_connection_params.h"
+#include "omron_os32c_driver/io_packet.h"
+#include "omron_os32c_driver/latest_scan.h"
 
 #include "odva_ethernetip/session.h"
 #include "odva_ethernetip/socket/socket.h"
+#include "odva_ethernetip/serialization/serializable_primitive.h"
 #include "omron_os32c_driver/measurement_report.h"
 #include "omron_os32c_driver/measurement_report_config.h"
+#include "omron_os32c_driver/multiple_service_packet.h"
 #include "omron_os32c_driver/range_and_reflectance_measurement.h"
 
 using std::vector;
 using boost::shared_ptr;
-using sensor_msgs::LaserScan;
 using eip::Session;
 using eip::socket::Socket;
+using eip::serialization::SerializablePrimitive;
 
 #define DEG2RAD(a) (a * M_PI / 180)
 #define RAD2DEG(a) (a * 180 / M_PI)
@@ -81,7 +91,13 @@ public:
    */
   OS32C(shared_ptr<Socket> socket, shared_ptr<Socket> io_socket)
     : Session(socket, io_socket), start_angle_(ANGLE_MAX), end_angle_(ANGLE_MIN),
-      connection_num_(-1), mrc_sequence_num_(1)
+      connection_num_(-1), o_to_t_connection_id_(0), own_connection_(false), connection_sn_(0),
+      originator_sn_(0), explicit_open_(false), explicit_o_to_t_id_(0), explicit_t_to_o_id_(0),
+      explicit_connection_sn_(0), explicit_sequence_(0), multiple_service_supported_(true),
+      mrc_sequence_num_(1),
+      explicit_socket_(socket), explicit_buffer_(EXPLICIT_BUFFER_SIZE),
+      pipeline_buffer_(PIPELINE_BUFFER_SIZE), pipeline_received_(0),
+      report_socket_(io_socket), io_buffer_(IO_BUFFER_SIZE), io_send_buffer_(IO_BUFFER_SIZE)
   {
   }
 
@@ -90,6 +106,7 @@ public:
   static const double ANGLE_INC;
   static const double DISTANCE_MIN;
   static const double DISTANCE_MAX;
+  static const EIP_UDINT EXPLICIT_RPI;
 
   /**
    * Get the range format code. Does a Get Single Attribute to the scanner
@@ -133,6 +150,77 @@ public:
    */
   void selectBeams(double start_angle, double end_angle);
 
+  /**
+   * Set the range and reflectivity formats and select the beams to measure,
+   * writing only the settings that are not already in effect. The current
+   * settings are read in one round trip and the changed ones written in
+   * another, each bundled into a CIP Multiple Service Packet. If the scanner
+   * does not support the packet, falls back to a separate request for each
+   * setting; any other failure is not retried. Nothing is read or written if
+   * the cache holds the same configuration with the checksums seen with it;
+   * the first report then verifies it, see ConfigCache::checkChecksums.
+   * @param range_format The range format code to set
+   * @param reflectivity_format The reflectivity format code to set
+   * @param start_angle Start angle in ROS conventions
+   * @param end_angle End angle in ROS conventions
+   * @param cache Cache of the last configuration applied, or NULL for none.
+   *  Updated with the configuration applied, or marked as trusted.
+   * @return Number of settings written to the scanner
+   * @throw std::invalid_argument if the angles are invalid
+   * @throw std::runtime_error if the scanner rejects any of the settings, or
+   *  the request fails
+   * @throw std::logic_error if a reply is malformed
+   * @see selectBeams
+   */
+  int configure(EIP_UINT range_format, EIP_UINT reflectivity_format,
+    double start_angle, double end_angle, ConfigCache* cache = NULL);
+
+  /**
+   * Read the current formats and beam selection from the scanner, in a single
+   * round trip using a CIP Multiple Service Packet.
+   * @return Configuration read
+   * @throw std::runtime_error if the scanner rejects any of the requests
+   */
+  ScannerConfig readConfig();
+
+  /**
+   * Take the formats and beam selection from the scanner rather than writing
+   * them, for an input only or listen only connection, where the scanner is
+   * configured by its owner. The start and end angles are those of the first
+   * and last beams selected.
+   * @throw std::runtime_error if the configuration cannot be read
+   * @throw std::logic_error if the scanner has no beams selected
+   */
+  void followConfiguration();
+
+  /**
+   * Read the first of the multicast addresses the scanner sends multicast
+   * T->O connections to, from its TCP/IP Interface object
+   * @return Multicast address in dotted decimal form
+   */
+  string getMulticastAddress();
+
+  /**
+   * Send several explicit requests in one round trip as a CIP Multiple Service
+   * Packet to the Message Router.
+   * @param req Requests to send
+   * @return Replies to each request, in the order requested
+   * @throw std::runtime_error if the request fails, or the scanner does not
+   *  support the Multiple Service Packet, which isMultipleServiceSupported()
+   *  then tells
+   * @throw std::logic_error if the number of replies does not match the requests
+   */
+  MultipleServiceResponse sendMultipleServiceRequest(shared_ptr<MultipleServiceRequest> req);
+
+  /**
+   * False once the scanner has rejected a Multiple Service Packet with the
+   * status of a service it does not support
+   */
+  bool isMultipleServiceSupported() const
+  {
+    return multiple_service_supported_;
+  }
+
   /**
    * Make an explicit request for a single Range and Reflectance scan
    * @return Range and reflectance data received
@@ -140,6 +228,33 @@ public:
    */
   RangeAndReflectanceMeasurement getSingleRRScan();
 
+  /**
+   * Send a request for a single Range and Reflectance scan without waiting
+   * for the reply, so that several requests can be in flight at once. The
+   * request goes over the Class 3 connection if open, otherwise unconnected.
+   * No other explicit requests may be made until all the replies are received,
+   * as they share the TCP session.
+   * @param sender_context Sender context to match the reply to the request,
+   *  if unconnected
+   * @return Key to match the reply to the request: the sender context, or
+   *  over the Class 3 connection, the sequence count of the request
+   * @see RRScanPipeline
+   */
+  uint64_t sendRRScanRequest(uint64_t sender_context);
+
+  /**
+   * Receive the reply to a request sent with sendRRScanRequest(). Several
+   * replies may arrive in one read from the TCP socket, in which case those
+   * after the first are kept for the following calls.
+   * @param sender_context Set to the key of the reply, as returned for its
+   *  request by sendRRScanRequest()
+   * @param rr Set to the scan received, if the request succeeded
+   * @return false if the scanner rejected the request
+   * @throw std::runtime_error if the socket fails
+   * @throw std::logic_error if the reply is malformed
+   */
+  bool receiveRRScan(uint64_t& sender_context, RangeAndReflectanceMeasurement& rr);
+
   /**
    * Calculate the beam number on the lidar for a given ROS angle. Note that
    * in ROS angles are given as radians CCW with zero being straight ahead,
@@ -153,65 +268,303 @@ public:
    */
   static inline int calcBeamNumber(double angle)
   {
-    return (ANGLE_MAX - angle + ANGLE_INC / 2) / ANGLE_INC;
+    return beamNumber(angle);
   }
 
   /**
    * Calculate the ROS angle for a beam given the OS32C beam number
    * @param beam_num Beam number, starting with 0 being the most CCW beam and
-   *  positive moving CW around the scan
+   *  positive moving CW around the scan. Must be less than BEAM_COUNT.
    * @return ROS Angle
    */
   static inline double calcBeamCentre(int beam_num)
   {
-    return ANGLE_MAX - beam_num * ANGLE_INC;
+    return BeamGeometry::angles[beam_num];
   }
 
   /**
-   * Populate the unchanging parts of a ROS LaserScan, including the start_angle and stop_angle,
-   * which are configured by the user but ultimately reported by the device.
-   * @param ls Laserscan message to populate.
+   * Get the angle of the first beam selected, in ROS conventions. This is the
+   * centre of the beam nearest the start angle given to selectBeams().
    */
-  void fillLaserScanStaticConfig(sensor_msgs::LaserScan* ls);
+  double getStartAngle() const
+  {
+    return start_angle_;
+  }
 
   /**
-   * Helper to convert a Range and Reflectance Measurement to a ROS LaserScan. LaserScan
-   * is passed as a pointer to avoid a bunch of memory allocation associated with resizing a vector
-   * on each scan.
-   * @param rr Measurement to convert
-   * @param ls Laserscan message to populate.
+   * Get the angle of the last beam selected, in ROS conventions. This is the
+   * centre of the beam nearest the end angle given to selectBeams().
    */
-  static void convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls);
+  double getEndAngle() const
+  {
+    return end_angle_;
+  }
+
+  void sendMeasurmentReportConfigUDP();
 
   /**
-   * Helper to convert a Measurement Report to a ROS LaserScan
-   * @param mr Measurement to convert
-   * @param ls Laserscan message to populate.
+   * Send the keepalive of the IO connection: the measurement report config
+   * for an owner, or a heartbeat for an input only or listen only connection
+   * @throw std::logic_error if UDP IO has not been started
    */
-  static void convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls);
-
-  void sendMeasurmentReportConfigUDP();
+  void sendKeepaliveUDP();
 
   MeasurementReport receiveMeasurementReportUDP();
 
-  void startUDPIO();
+  /**
+   * Receive a measurement report into a caller owned object, so that a
+   * receiving loop reusing the same object does no allocation.
+   * @param report Report to fill
+   * @throw std::runtime_error if there was a problem receiving the packet
+   * @throw std::logic_error if the packet is not a valid measurement report
+   */
+  void receiveMeasurementReportUDP(MeasurementReport& report);
+
+  /**
+   * Receive a measurement report and publish it as the latest scan in the given slot,
+   * for consumers that read the slot from other threads.
+   * @param latest Slot to publish the scan to
+   * @return false if the scan was dropped because readers held all buffers it could
+   *  have been written to
+   */
+  bool receiveMeasurementReportUDP(LatestMeasurementReport& latest);
+
+  /**
+   * Receive a measurement report without throwing on malformed packets, for
+   * receiving loops that must stay cheap under a burst of bad traffic.
+   * @param report Report to decode into. Only valid if DECODE_OK is returned.
+   * @return DECODE_OK if a report was received, otherwise why the packet was dropped
+   * @throw std::runtime_error if the socket fails, which is a problem with
+   *  the connection rather than with a packet
+   */
+  DECODE_STATUS tryReceiveMeasurementReportUDP(MeasurementReport& report);
+
+  /**
+   * Open the UDP IO connection with a Forward Open.
+   * @param params Parameters of the connection
+   * @throw std::invalid_argument if the parameters are out of range
+   * @throw std::runtime_error if the scanner rejects the parameters
+   */
+  void startUDPIO(const IOConnectionParams& params = IOConnectionParams());
+
+  /**
+   * Open the UDP IO connection, trying each set of parameters in turn until
+   * the scanner accepts one. All of them are validated before anything is sent.
+   * @param candidates Parameters to try, in order of preference
+   * @return index of the parameters accepted
+   * @throw std::invalid_argument if any of the parameters are out of range
+   * @throw std::runtime_error if the scanner rejects all of them, with the
+   *  error of the last attempt
+   * @see getFallbackParams
+   */
+  size_t startUDPIO(const vector<IOConnectionParams>& candidates);
+
+  /**
+   * Close the UDP IO connection with a Forward Close, if it is open. The
+   * connection counts as closed even if the Forward Close fails.
+   * @throw std::runtime_error if the Forward Close fails
+   */
+  void stopUDPIO();
+
+  /**
+   * Parameters of the open IO connection, or the defaults if there is none
+   */
+  const IOConnectionParams& getIOConnectionParams() const
+  {
+    return io_params_;
+  }
+
+  /**
+   * Time without a packet after which the IO connection should be considered
+   * lost, derived from the RPI of the connection.
+   * @return timeout in seconds
+   */
+  double getIOTimeout() const
+  {
+    return io_params_.getIOTimeout();
+  }
+
+  /**
+   * Open a Class 3 connection to the Message Router, over which all further
+   * explicit requests are sent as SendUnitData rather than as unconnected
+   * SendRRData. This saves the scanner routing each request through the
+   * Unconnected Send and lets it match each reply to its request by sequence
+   * count. If the connection fails, explicit requests fall back to unconnected.
+   * @param rpi Requested packet interval of the connection in us, which sets
+   *  how long the scanner keeps the connection open without a request
+   * @throw std::runtime_error if the scanner rejects the Forward Open
+   * @throw std::logic_error if the reply is malformed or for another connection
+   */
+  void openExplicitConnection(EIP_UDINT rpi = EXPLICIT_RPI);
+
+  /**
+   * Close the Class 3 connection with a Forward Close, if it is open. The
+   * connection counts as closed even if the Forward Close fails.
+   * @throw std::runtime_error if the Forward Close fails
+   */
+  void closeExplicitConnection();
+
+  /**
+   * Whether explicit requests are currently sent over a Class 3 connection
+   */
+  bool isExplicitConnectionOpen() const
+  {
+    return explicit_open_;
+  }
 
 private:
+  static const EIP_UINT ORIGINATOR_VENDOR_ID;
+  static const size_t EXPLICIT_CONNECTION_SIZE = 504;
+  static const size_t EXPLICIT_BUFFER_SIZE = 4096;
+  static const size_t PIPELINE_BUFFER_SIZE = 8192;
+
+  /**
+   * Open an IO connection with a Large Forward Open built by the driver, for
+   * the connection types odva_ethernetip cannot open
+   */
+  void openConnection(const IOConnectionParams& params);
+
+  /**
+   * Send a Large Forward Open, filling in the serial numbers and vendor
+   * @param req Request to send. Its connection serial number is set.
+   * @return Reply of the scanner
+   * @throw std::logic_error if the reply is for a different connection
+   */
+  ForwardOpenReply sendForwardOpen(shared_ptr<LargeForwardOpenRequest> req);
+
+  /**
+   * Send a Forward Close for a connection opened with sendForwardOpen
+   */
+  void sendForwardClose(EIP_UINT connection_sn, const vector<EIP_BYTE>& path);
+
+  /**
+   * Connection path of the Message Router, for a Class 3 connection
+   */
+  static vector<EIP_BYTE> getMessageRouterPath();
+
+  /**
+   * Send an explicit request over the Class 3 connection and wait for its reply.
+   * If the transport fails or the reply does not match, the connection is
+   * marked closed so that later requests go unconnected.
+   * @param service Service code of the request
+   * @param path Path of the object the request is for
+   * @param data Request data, or NULL for none
+   * @return Reply of the Message Router
+   * @throw std::runtime_error if the request failed
+   */
+  MessageRouterReply sendConnectedRequest(EIP_USINT service, const Path& path,
+    const Serializable* data = NULL);
+
+  /**
+   * Send an explicit request over the Class 3 connection if open, otherwise
+   * unconnected, and wait for its reply. Unlike the requests odva_ethernetip
+   * makes, the reply is returned whatever its status, for the caller to tell
+   * a rejected service from other failures.
+   * @return Reply of the Message Router
+   * @throw std::runtime_error if the socket fails
+   * @throw std::logic_error if the reply is malformed or not to the request
+   */
+  MessageRouterReply sendExplicitRequest(EIP_USINT service, const Path& path,
+    const Serializable* data = NULL);
+
+  /**
+   * Receive a whole encapsulation packet into the explicit buffer
+   * @return number of bytes received
+   * @throw std::length_error if the packet does not fit in the buffer
+   */
+  size_t receiveExplicitReply();
+
+  /**
+   * Get an attribute over the Class 3 connection if open, otherwise unconnected
+   */
+  void getAttributeSerializable(EIP_USINT class_id, EIP_USINT instance_id,
+    EIP_USINT attribute_id, Serializable& result);
+
+  /**
+   * Set an attribute over the Class 3 connection if open, otherwise unconnected
+   */
+  void setAttributeSerializable(EIP_USINT class_id, EIP_USINT instance_id,
+    EIP_USINT attribute_id, shared_ptr<Serializable> data);
+
+  template <typename T>
+  T getAttribute(EIP_USINT class_id, EIP_USINT instance_id, EIP_USINT attribute_id, T v)
+  {
+    if (!explicit_open_)
+    {
+      return getSingleAttribute(class_id, instance_id, attribute_id, v);
+    }
+    SerializablePrimitive<T> data;
+    getAttributeSerializable(class_id, instance_id, attribute_id, data);
+    return data.data;
+  }
+
+  template <typename T>
+  void setAttribute(EIP_USINT class_id, EIP_USINT instance_id, EIP_USINT attribute_id, T v)
+  {
+    if (!explicit_open_)
+    {
+      setSingleAttribute(class_id, instance_id, attribute_id, v);
+      return;
+    }
+    SerializablePrimitive<T> data(v);
+    sendConnectedRequest(0x10, Path(class_id, instance_id, attribute_id), &data);
+  }
+
   // allow unit tests to access the helpers below for direct testing
   FRIEND_TEST(OS32CTest, test_calc_beam_mask_all);
   FRIEND_TEST(OS32CTest, test_calc_beam_at_90);
   FRIEND_TEST(OS32CTest, test_calc_beam_boundaries);
   FRIEND_TEST(OS32CTest, test_calc_beam_invalid_args);
-  FRIEND_TEST(OS32CTest, test_convert_to_laserscan);
+  FRIEND_TEST(OS32CTest, test_connected_get_attribute);
+  FRIEND_TEST(OS32CTest, test_connected_reply_mismatch);
+  FRIEND_TEST(OS32CTest, test_close_explicit_connection);
+  FRIEND_TEST(OS32CTest, test_connected_rr_scan);
+  FRIEND_TEST(OS32CTest, test_configure_trusts_cache);
 
   double start_angle_;
   double end_angle_;
 
   // data for sending to lidar to keep UDP session alive
   int connection_num_;
+  EIP_UDINT o_to_t_connection_id_;
+  IOConnectionParams io_params_;
+
+  // identity of a connection opened by the driver itself rather than by
+  // odva_ethernetip, for closing it. The originator serial number is random,
+  // so that several hosts can hold connections to the same scanner.
+  bool own_connection_;
+  EIP_UINT connection_sn_;
+  EIP_UDINT originator_sn_;
+
+  // Class 3 connection for explicit requests. It shares the TCP socket of
+  // the session, but frames its own SendUnitData packets.
+  bool explicit_open_;
+  EIP_UDINT explicit_o_to_t_id_;
+  EIP_UDINT explicit_t_to_o_id_;
+  EIP_UINT explicit_connection_sn_;
+  EIP_UINT explicit_sequence_;
+
+  // cleared once the scanner rejects the Multiple Service Packet service
+  bool multiple_service_supported_;
   MeasurementReportConfig mrc_;
   EIP_UDINT mrc_sequence_num_;
 
+  // raw access to the TCP socket for the Class 3 connection and for
+  // pipelined requests, with the part of the TCP stream received but not
+  // yet decoded kept for the next pipelined reply
+  shared_ptr<Socket> explicit_socket_;
+  vector<EIP_BYTE> explicit_buffer_;
+  vector<EIP_BYTE> pipeline_buffer_;
+  size_t pipeline_received_;
+
+  // raw access to the IO socket and buffers for it, allocated once per
+  // connection, so that the IO path neither throws on bad packets nor
+  // builds transient protocol objects on the heap
+  static const size_t IO_BUFFER_SIZE = 2048;
+  shared_ptr<Socket> report_socket_;
+  vector<EIP_BYTE> io_buffer_;
+  vector<EIP_BYTE> io_send_buffer_;
+
   /**
    * Helper to calculate the mask for a given start and end beam angle
    * @param start_angle Angle of the first beam in the scan
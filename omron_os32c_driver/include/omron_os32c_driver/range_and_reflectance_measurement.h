@@ -51,8 +51,8 @@ class RangeAndReflectanceMeasurement : public Serializable
 {
 public:
   MeasurementReportHeader header;
-  vector<EIP_UINT> range_data;
-  vector<EIP_UINT> reflectance_data;
+  BeamData range_data;
+  BeamData reflectance_data;
 
   /**
    * Size of this message including all measurement data.
@@ -78,23 +78,38 @@ public:
   }
 
   /**
-   * Extra length information is not relevant in this context. Same as deserialize(reader)
+   * Deserialize data from the given reader, checking the number of beams
+   * against the length of the message before allocating storage for them
+   * @param reader Reader to use for deserialization
+   * @param length Length of the message
+   * @return the reader again
+   * @throw std::length_error if the number of beams is not plausible, or the
+   *  buffer is overrun while deserializing
    */
   virtual Reader& deserialize(Reader& reader, size_t length)
   {
-    deserialize(reader);
-    return reader;
+    header.deserialize(reader);
+    header.checkNumBeams(length, 2);
+    return deserializeBeams(reader);
   }
 
   /**
    * Deserialize data from the given reader without length information
    * @param reader Reader to use for deserialization
    * @return the reader again
-   * @throw std::length_error if the buffer is overrun while deserializing
+   * @throw std::length_error if the number of beams is more than the scanner
+   *  has, or the buffer is overrun while deserializing
    */
   virtual Reader& deserialize(Reader& reader)
   {
     header.deserialize(reader);
+    header.checkNumBeams(0, 2);
+    return deserializeBeams(reader);
+  }
+
+private:
+  Reader& deserializeBeams(Reader& reader)
+  {
     range_data.resize(header.num_beams);
     reflectance_data.resize(header.num_beams);
     reader.readBytes(&range_data[0], range_data.size() * sizeof(EIP_UINT));
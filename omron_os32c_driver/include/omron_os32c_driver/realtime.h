@@ -0,0 +1,160 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_REALTIME_H
+#define OMRON_OS32C_DRIVER_REALTIME_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Helpers to run the receive and conversion loop with real-time scheduling.
+ * All of these act on the calling thread or process and are opt-in, since
+ * they need privileges (CAP_SYS_NICE, CAP_IPC_LOCK or suitable rlimits) that
+ * the driver does not normally have.
+ */
+
+/**
+ * Switch the calling thread to SCHED_FIFO with the given priority.
+ * @param priority Real-time priority, within the range allowed for SCHED_FIFO
+ * @throw std::invalid_argument if the priority is out of range
+ * @throw std::runtime_error if the scheduler could not be changed
+ */
+void setRealtimePriority(int priority);
+
+/**
+ * Pin the calling thread to the given set of CPUs.
+ * @param cpus CPU numbers to allow the thread to run on
+ * @throw std::invalid_argument if the list is empty or contains an invalid CPU
+ * @throw std::runtime_error if the affinity could not be changed
+ */
+void setCpuAffinity(const vector<int>& cpus);
+
+/**
+ * Lock all current and future pages of the process into memory, and keep
+ * the allocator from handing freed memory back to the system, so that memory
+ * once touched is never paged out or faulted in again.
+ * @throw std::runtime_error if the memory could not be locked
+ */
+void lockMemory();
+
+/**
+ * Touch a region of the stack of the calling thread so that it is faulted
+ * in before entering the time-critical loop.
+ */
+void prefaultStack();
+
+/**
+ * Size a buffer to the given number of elements and touch every element, so
+ * that its memory is faulted in. The buffer is left empty, but keeps its
+ * capacity, so later resizes up to that size do not allocate.
+ * @param v Buffer to pre-fault, such as a std::vector or FixedVector
+ * @param n Number of elements to reserve
+ */
+template <typename Buffer>
+void prefault(Buffer& v, size_t n)
+{
+  v.assign(n, typename Buffer::value_type());
+  v.clear();
+}
+
+/**
+ * Parse a list of CPUs such as "1,3-5".
+ * @param cpus List of CPU numbers and ranges, separated by commas
+ * @return CPU numbers in the list
+ * @throw std::invalid_argument if the list cannot be parsed
+ */
+vector<int> parseCpuList(const string& cpus);
+
+/**
+ * Current time of the monotonic clock in nanoseconds.
+ */
+uint64_t monotonicNanoseconds();
+
+/**
+ * Running statistics of a latency, in nanoseconds.
+ */
+class LatencyStats
+{
+public:
+  LatencyStats()
+  {
+    reset();
+  }
+
+  /**
+   * Add a latency sample
+   * @param latency Latency in nanoseconds
+   */
+  void add(uint64_t latency)
+  {
+    if (latency > max_)
+    {
+      max_ = latency;
+    }
+    sum_ += latency;
+    ++count_;
+  }
+
+  /**
+   * Clear all samples
+   */
+  void reset()
+  {
+    max_ = 0;
+    sum_ = 0;
+    count_ = 0;
+  }
+
+  uint64_t getCount() const
+  {
+    return count_;
+  }
+
+  uint64_t getMax() const
+  {
+    return max_;
+  }
+
+  uint64_t getMean() const
+  {
+    return count_ ? sum_ / count_ : 0;
+  }
+
+private:
+  uint64_t max_;
+  uint64_t sum_;
+  uint64_t count_;
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_REALTIME_H
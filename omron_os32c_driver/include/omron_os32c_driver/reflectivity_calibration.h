@@ -0,0 +1,201 @@
+/**
+Software License Agreement (BSD)
+
+\file      reflectivity_calibration.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_REFLECTIVITY_CALIBRATION_H
+#define OMRON_OS32C_DRIVER_REFLECTIVITY_CALIBRATION_H
+
+#include <stddef.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+
+using std::string;
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Converts raw TOT reflectance to a calibrated reflectivity that does not
+ * depend on range, by bilinear interpolation of a table of reflectivity over
+ * range and TOT measured against known targets.
+ *
+ * The table may have any spacing, and every value in it is reproduced at its
+ * range and TOT. So that a lookup needs no search, each axis is divided into
+ * uniform cells that know the first interval of the table they overlap. A
+ * lookup is then an index computation, plus a step for each further value
+ * of the axis in the cell, of which there are none unless values are closer
+ * than a cell. Lookups outside the table take the value at its edge.
+ */
+class ReflectivityCalibration
+{
+public:
+  /// Most cells either axis is divided into
+  static const int MAX_AXIS_CELLS = 1024;
+
+  /**
+   * Load the table from a file of "key values..." lines, with # starting a
+   * comment: one "ranges" line of ranges in mm, one "tot" line of TOT
+   * values, then one "row" line per range of the reflectivity at each TOT.
+   * @param path File to load
+   * @throw std::runtime_error if the file cannot be read or is malformed
+   * @throw std::invalid_argument if the table is not valid
+   */
+  void load(const string& path);
+
+  /**
+   * Set the table, and divide its axes into cells
+   * @param ranges Ranges of the rows in mm, strictly increasing
+   * @param tots TOT values of the columns, strictly increasing
+   * @param values Reflectivity at each range and TOT, row by row
+   * @throw std::invalid_argument if an axis has fewer than two values or is
+   *  not increasing, or the number of values does not match the axes
+   */
+  void setTable(const vector<double>& ranges, const vector<double>& tots,
+    const vector<double>& values);
+
+  bool isLoaded() const
+  {
+    return !table_.empty();
+  }
+
+  /**
+   * Number of ranges in the table
+   */
+  int getRangePoints() const
+  {
+    return range_axis_.values.size();
+  }
+
+  /**
+   * Number of TOT values in the table
+   */
+  int getTotPoints() const
+  {
+    return tot_axis_.values.size();
+  }
+
+  /**
+   * Calibrated reflectivity of a single beam
+   * @param range Range in mm, as reported
+   * @param tot TOT reflectance, as reported
+   * @return Reflectivity, or zero for a noisy beam or one with no return
+   */
+  float calibrate(EIP_UINT range, EIP_UINT tot) const
+  {
+    if (range == 0x0001 || range == 0xFFFF)
+    {
+      return 0;
+    }
+    float fr, ft;
+    int i = range_axis_.findInterval(range, &fr);
+    int j = tot_axis_.findInterval(tot, &ft);
+    int columns = tot_axis_.values.size();
+    const float* near = &table_[i * columns + j];
+    const float* far = near + columns;
+    float a = near[0] + (near[1] - near[0]) * ft;
+    float b = far[0] + (far[1] - far[0]) * ft;
+    return a + (b - a) * fr;
+  }
+
+  /**
+   * Calibrated reflectivity of every beam of a scan
+   * @param ranges Range of each beam in mm, as reported
+   * @param tots TOT reflectance of each beam, as reported
+   * @param num_beams Number of beams in the scan
+   * @param reflectivity Set to the reflectivity of each beam
+   */
+  void calibrate(const EIP_UINT* ranges, const EIP_UINT* tots, size_t num_beams,
+    float* reflectivity) const
+  {
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+      reflectivity[i] = calibrate(ranges[i], tots[i]);
+    }
+  }
+
+private:
+  /**
+   * One axis of the table, divided into uniform cells to find the interval
+   * of the axis a value is in
+   */
+  struct Axis
+  {
+    Axis() : cell_scale(0), last_cell(0)
+    {
+    }
+
+    /**
+     * Set the values of the axis and divide it into cells
+     * @throw std::invalid_argument if there are fewer than two values or
+     *  they are not strictly increasing
+     */
+    void set(const vector<double>& axis, const string& name);
+
+    /**
+     * Index of the interval containing a value, clamped to the axis
+     * @param value Value to look up
+     * @param fraction Set to how far along the interval the value is
+     */
+    int findInterval(float value, float* fraction) const
+    {
+      value = std::min(std::max(value, values.front()), values.back());
+      int cell = std::min(static_cast<int>((value - values.front()) * cell_scale), last_cell);
+      int i = cell_interval[cell];
+      // the cell may hold more values of the axis, and rounding may put the
+      // value just short of the interval the cell starts in
+      int last_interval = values.size() - 2;
+      while (i < last_interval && value >= values[i + 1])
+      {
+        ++i;
+      }
+      while (i > 0 && value < values[i])
+      {
+        --i;
+      }
+      *fraction = (value - values[i]) * inverse_width[i];
+      return i;
+    }
+
+    vector<float> values;
+    /// Reciprocal of the width of each interval
+    vector<float> inverse_width;
+    /// First interval each cell overlaps
+    vector<int> cell_interval;
+    /// Cells per unit of the axis, and the index of the last cell
+    float cell_scale;
+    int last_cell;
+  };
+
+  Axis range_axis_;
+  Axis tot_axis_;
+  /// Reflectivity at each range and TOT of the table, row by row of range
+  vector<float> table_;
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_REFLECTIVITY_CALIBRATION_H
@@ -0,0 +1,131 @@
+/**
+Software License Agreement (BSD)
+
+\file      reflector_detector.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_REFLECTOR_DETECTOR_H
+#define OMRON_OS32C_DRIVER_REFLECTOR_DETECTOR_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_geometry.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Parameters of reflector detection. The TOT reflectance of a return falls
+ * with range, so it is scaled by (range / reference_range) ^ range_exponent
+ * before being compared to the threshold.
+ */
+struct ReflectorDetectorParams
+{
+  /// Range compensated reflectance a beam must reach to be part of a reflector
+  double threshold;
+  /// Range in mm at which the reflectance is taken as is
+  double reference_range;
+  /// Exponent of the range compensation, or zero for none
+  double range_exponent;
+  /// Largest difference in range in mm between adjacent beams of a reflector
+  double max_range_step;
+  /// Fewest beams a reflector may span
+  int min_beams;
+  /// Widest a reflector may be in mm, or zero for no limit
+  double max_width;
+
+  ReflectorDetectorParams() : threshold(3000), reference_range(1000), range_exponent(1),
+    max_range_step(100), min_beams(1), max_width(0)
+  {
+  }
+};
+
+/**
+ * Reflector found in a scan, in the frame of the scanner
+ */
+struct Reflector
+{
+  /// Centroid in mm, weighted by the compensated reflectance of each beam
+  double x;
+  double y;
+  /// Range in mm and bearing in radians of the centroid
+  double range;
+  double bearing;
+  /// Width in mm, from the outer edge of the first beam to that of the last
+  double width;
+  /// Highest compensated reflectance of any beam of the reflector
+  double intensity;
+  /// Indices in the scan of the first and last beams of the reflector
+  int first_beam;
+  int last_beam;
+};
+
+/**
+ * Finds retro-reflective landmarks in scans with range and reflectance, as
+ * runs of adjacent beams whose range compensated reflectance is over a
+ * threshold and whose ranges do not jump between beams.
+ */
+class ReflectorDetector
+{
+public:
+  /**
+   * Construct with the given parameters
+   * @throw std::invalid_argument if any parameter is out of range
+   */
+  explicit ReflectorDetector(const ReflectorDetectorParams& params = ReflectorDetectorParams());
+
+  /**
+   * Find the reflectors in a scan
+   * @param ranges Range of each beam in mm, as reported
+   * @param reflectance TOT reflectance of each beam
+   * @param num_beams Number of beams in the scan
+   * @param first_beam Beam number of the first beam in the scan
+   * @param reflectors Set to the reflectors found, in scan order. Passed in
+   *  so that its storage is reused from scan to scan.
+   * @throw std::invalid_argument if the scan runs past the last beam of the scanner
+   */
+  void detect(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams,
+    int first_beam, vector<Reflector>* reflectors);
+
+  const ReflectorDetectorParams& getParams() const
+  {
+    return params_;
+  }
+
+private:
+  /**
+   * Add the run of beams from first to last to the reflectors if it is one
+   */
+  void addReflector(const EIP_UINT* ranges, int first_beam, int first, int last,
+    vector<Reflector>* reflectors) const;
+
+  ReflectorDetectorParams params_;
+  /// Compensated reflectance of each beam of the last scan, or zero if below threshold
+  vector<double> compensated_;
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_REFLECTOR_DETECTOR_H
@@ -0,0 +1,139 @@
+/**
+Software License Agreement (BSD)
+
+\file      ros_conversions.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_ROS_CONVERSIONS_H
+#define OMRON_OS32C_DRIVER_ROS_CONVERSIONS_H
+
+#include <sensor_msgs/LaserScan.h>
+
+#include "omron_os32c_driver/BeamHealth.h"
+#include "omron_os32c_driver/CompactScan.h"
+#include "omron_os32c_driver/beam_statistics.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/Reflectors.h"
+#include "omron_os32c_driver/reflector_detector.h"
+#include "omron_os32c_driver/reflectivity_calibration.h"
+#include "omron_os32c_driver/SafetyState.h"
+#include "omron_os32c_driver/safety_state.h"
+#include "omron_os32c_driver/scan_stream.h"
+
+using sensor_msgs::LaserScan;
+
+namespace omron_os32c_driver {
+
+/**
+ * Conversions from the data of the ROS-independent core to ROS messages.
+ */
+
+/**
+ * Populate the unchanging parts of a ROS LaserScan, including the start_angle and stop_angle,
+ * which are configured by the user but ultimately reported by the device.
+ * @param os32c Scanner to take the configuration from
+ * @param ls Laserscan message to populate.
+ */
+void fillLaserScanStaticConfig(const OS32C& os32c, sensor_msgs::LaserScan* ls);
+
+/**
+ * Helper to convert a Range and Reflectance Measurement to a ROS LaserScan. LaserScan
+ * is passed as a pointer to avoid a bunch of memory allocation associated with resizing a vector
+ * on each scan.
+ * @param rr Measurement to convert
+ * @param ls Laserscan message to populate.
+ * @param calibration Calibration to convert the intensities to reflectivity with, or NULL
+ *  to leave them as reported
+ */
+void convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls,
+  const ReflectivityCalibration* calibration = NULL);
+
+/**
+ * Helper to convert a Measurement Report to a ROS LaserScan
+ * @param mr Measurement to convert
+ * @param ls Laserscan message to populate.
+ */
+void convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls);
+
+/**
+ * Populate the unchanging parts of a CompactScan, including the start angle and increment
+ * which are configured by the user but ultimately reported by the device.
+ * @param os32c Scanner to take the configuration from
+ * @param cs CompactScan message to populate.
+ */
+void fillCompactScanStaticConfig(const OS32C& os32c, CompactScan* cs);
+
+/**
+ * Helper to convert a Range and Reflectance Measurement to a CompactScan. Data is copied
+ * as reported by the device without any conversion.
+ * @param rr Measurement to convert
+ * @param cs CompactScan message to populate.
+ */
+void convertToCompactScan(const RangeAndReflectanceMeasurement& rr, CompactScan* cs);
+
+/**
+ * Helper to convert a Measurement Report to a CompactScan. Data is copied as reported by
+ * the device without any conversion.
+ * @param mr Measurement to convert
+ * @param cs CompactScan message to populate.
+ */
+void convertToCompactScan(const MeasurementReport& mr, CompactScan* cs);
+
+/**
+ * Helper to convert a scan from a ScanStream to a CompactScan. Data is copied as reported
+ * by the device without any conversion.
+ * @param scan Scan to convert
+ * @param cs CompactScan message to populate.
+ */
+void convertToCompactScan(const ScanView& scan, CompactScan* cs);
+
+/**
+ * Helper to convert the safety state of a scan to a SafetyState message. The header is
+ * left for the caller to stamp.
+ * @param state Safety state to convert
+ * @param scan_count Scan counter of the scan the state was taken from
+ * @param ss SafetyState message to populate.
+ */
+void convertToSafetyState(const ScannerSafetyState& state, EIP_UDINT scan_count,
+  SafetyState* ss);
+
+/**
+ * Helper to convert a summary of the beam statistics to a BeamHealth message, with ranges
+ * converted from mm to m. The header is left for the caller to stamp.
+ * @param summary Summary to convert
+ * @param bh BeamHealth message to populate.
+ */
+void convertToBeamHealth(const BeamStatisticsSummary& summary, BeamHealth* bh);
+
+/**
+ * Helper to convert the reflectors found in a scan to a Reflectors message, with ranges
+ * and widths converted from mm to m. The header is left for the caller to stamp.
+ * @param reflectors Reflectors to convert
+ * @param rm Reflectors message to populate.
+ */
+void convertToReflectors(const vector<Reflector>& reflectors, Reflectors* rm);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_ROS_CONVERSIONS_H
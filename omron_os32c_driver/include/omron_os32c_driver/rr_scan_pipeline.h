@@ -0,0 +1,136 @@
+/**
+Software License Agreement (BSD)
+
+\file      rr_scan_pipeline.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_RR_SCAN_PIPELINE_H
+#define OMRON_OS32C_DRIVER_RR_SCAN_PIPELINE_H
+
+#include <stdint.h>
+#include <deque>
+#include <map>
+
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Polls an OS32C for Range and Reflectance scans with explicit requests,
+ * keeping a window of requests in flight rather than waiting out the round
+ * trip of each one. Replies are matched to their requests by sender context,
+ * or over a Class 3 connection by sequence count, and handed out in the order
+ * requested. For scanners whose firmware only gives range and reflectance
+ * over explicit messaging.
+ */
+class RRScanPipeline
+{
+public:
+  /**
+   * Construct a new pipeline
+   * @param os32c Scanner to poll. No other explicit requests may be made to
+   *  it while requests are outstanding.
+   * @param window Maximum number of requests in flight
+   * @param rate Maximum rate to send requests at in Hz, or zero for as fast
+   *  as the window allows
+   * @throw std::invalid_argument if the window is zero or the rate negative
+   */
+  RRScanPipeline(OS32C& os32c, size_t window, double rate);
+
+  /**
+   * Send as many requests as the window and rate allow
+   * @param now Current time, from monotonicNanoseconds()
+   * @return Number of requests sent
+   */
+  size_t sendRequests(uint64_t now);
+
+  /**
+   * Set the longest time receiveScan() may take. It is checked between
+   * replies, so a single read is bounded by the timeout of the socket instead.
+   * @param timeout Timeout in seconds
+   * @throw std::invalid_argument if the timeout is not positive
+   */
+  void setReceiveTimeout(double timeout);
+
+  /**
+   * Receive the scan for the oldest request outstanding. Replies to later
+   * requests that arrive first are kept until their turn, and replies to no
+   * outstanding request are dropped.
+   * @param rr Set to the scan received
+   * @return false if the scanner rejected a request instead, which is then
+   *  no longer outstanding
+   * @throw std::logic_error if no requests are outstanding, or a reply is
+   *  malformed, in which case no requests are outstanding any longer
+   * @throw std::runtime_error if the socket fails or the receive times out,
+   *  in which case no requests are outstanding any longer
+   */
+  bool receiveScan(RangeAndReflectanceMeasurement& rr);
+
+  /**
+   * Number of requests sent whose scans have not yet been handed out
+   */
+  size_t getOutstanding() const
+  {
+    return outstanding_.size();
+  }
+
+  /**
+   * Earliest time the rate allows the next request to be sent
+   */
+  uint64_t getNextSendTime() const
+  {
+    return next_send_time_;
+  }
+
+  /**
+   * Number of replies dropped because they matched no outstanding request
+   */
+  uint64_t getStaleReplies() const
+  {
+    return stale_replies_;
+  }
+
+private:
+  OS32C& os32c_;
+  size_t window_;
+  uint64_t period_;
+  uint64_t next_send_time_;
+  uint64_t next_context_;
+  uint64_t stale_replies_;
+  /// Longest time to receive a scan in nanoseconds
+  uint64_t receive_timeout_;
+
+  // sender contexts of the requests outstanding, oldest first, and the
+  // scans of those answered out of order
+  std::deque<uint64_t> outstanding_;
+  std::map<uint64_t, RangeAndReflectanceMeasurement> early_;
+
+  /**
+   * Stop waiting for every request outstanding
+   */
+  void dropOutstanding();
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_RR_SCAN_PIPELINE_H
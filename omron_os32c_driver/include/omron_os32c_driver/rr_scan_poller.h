@@ -0,0 +1,253 @@
+/**
+Software License Agreement (BSD)
+
+\file      rr_scan_poller.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_RR_SCAN_POLLER_H
+#define OMRON_OS32C_DRIVER_RR_SCAN_POLLER_H
+
+#include <stdint.h>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/function.hpp>
+#include <boost/shared_ptr.hpp>
+
+#include "omron_os32c_driver/config_cache.h"
+#include "omron_os32c_driver/connection_supervisor.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/rr_scan_pipeline.h"
+
+using std::string;
+using boost::shared_ptr;
+
+namespace omron_os32c_driver {
+
+/**
+ * Keeps an OS32C polled for Range and Reflectance scans across link loss,
+ * as ConnectionSupervisor does for scans streamed over UDP IO. Once the
+ * session fails or a reply times out, drops the session and reconnects with
+ * exponential backoff, restoring the configuration. Also reconnects if the
+ * configuration was taken from the config cache and the first scan shows it
+ * is not in effect. No UDP IO is started, so no IO socket is bound.
+ */
+class RRScanPoller
+{
+public:
+  /**
+   * Function to call with each scan and the time it was received, from
+   * monotonicNanoseconds()
+   */
+  typedef boost::function<void (const RangeAndReflectanceMeasurement&, uint64_t)> Callback;
+
+  /**
+   * @param io_service IO service for the sockets
+   * @param host Hostname or IP address of the scanner
+   * @param callback Function to call with each scan received
+   */
+  RRScanPoller(boost::asio::io_service& io_service, const string& host,
+    const Callback& callback);
+
+  /**
+   * Set the beams to select on every connection.
+   * @param cache Cache of the last configuration applied, or NULL for none.
+   *  Must outlive the poller.
+   * @see OS32C::configure
+   */
+  void setConfiguration(double start_angle, double end_angle, ConfigCache* cache = NULL);
+
+  /**
+   * Set how requests are sent on every connection
+   * @param rate Maximum rate to send requests at in Hz, or zero for as fast
+   *  as the window allows
+   * @param window Maximum number of requests in flight
+   * @throw std::invalid_argument if the window is zero or the rate negative
+   * @see RRScanPipeline
+   */
+  void setPolling(double rate, size_t window);
+
+  /**
+   * Set the delays between reconnection attempts
+   * @see Backoff
+   */
+  void setBackoff(double initial, double max, double jitter);
+
+  /**
+   * Set the longest time connecting to the scanner, any single explicit
+   * request, or waiting for a scan may take
+   * @param timeout Timeout in seconds
+   * @throw std::invalid_argument if the timeout is not positive
+   */
+  void setRequestTimeout(double timeout);
+
+  double getRequestTimeout() const
+  {
+    return request_timeout_;
+  }
+
+  /**
+   * Poll over a Class 3 connection, kept open by the requests themselves,
+   * rather than unconnected. A Class 3 connection carries one request at a
+   * time, so the window is then a single request. If the scanner rejects the
+   * connection, requests stay unconnected and pipelined.
+   */
+  void setConnectedMessaging(bool enable)
+  {
+    connected_messaging_ = enable;
+  }
+
+  /**
+   * Connect to the scanner and configure it.
+   * @throw std::invalid_argument if the configuration is invalid
+   * @throw std::runtime_error if the scanner cannot be reached or rejects the configuration
+   */
+  void connect();
+
+  /**
+   * Close the Class 3 connection, if open, and the session, if connected
+   * @throw std::runtime_error if the scanner cannot be reached
+   */
+  void close();
+
+  /**
+   * Size the scan buffer for the largest possible scan, so that polling
+   * allocates nothing once running
+   */
+  void prefaultBuffers();
+
+  /**
+   * Result of a call to spinOnce()
+   */
+  enum SpinResult
+  {
+    /// A scan was received and passed to the callback
+    SCAN_RECEIVED,
+    /// The rate allowed no request before the timeout
+    TIMED_OUT,
+    /// The scanner rejected the request for a scan
+    REQUEST_REJECTED,
+    /// A reply could not be decoded, and the requests outstanding were dropped
+    MALFORMED_REPLY,
+    /// The connection is down, or was lost or could not be restored on this call
+    DISCONNECTED,
+  };
+
+  /**
+   * Send the requests due and receive a single scan, passing it to the
+   * callback. Waits no longer than the given timeout for a request to fall
+   * due, and no longer than the request timeout for its reply. If the
+   * connection is lost, waits out the backoff delay and makes a single
+   * attempt to reconnect instead.
+   * @param timeout Longest time to wait for a request to fall due, in seconds
+   * @return what happened on this call
+   */
+  SpinResult spinOnce(double timeout);
+
+  /**
+   * True while the connection is up
+   */
+  bool isConnected() const
+  {
+    return connected_;
+  }
+
+  /**
+   * Number of times the connection has been lost
+   */
+  int getDisconnects() const
+  {
+    return disconnects_;
+  }
+
+  /**
+   * Number of times the connection has been restored after being lost
+   */
+  int getReconnects() const
+  {
+    return reconnects_;
+  }
+
+  /**
+   * Number of times the config checksums of the scanner changed, or the
+   * configuration taken from the config cache was not in effect
+   */
+  int getConfigChanges() const
+  {
+    return config_changes_;
+  }
+
+  /**
+   * Reason the connection was last lost, or the last reply dropped
+   */
+  const string& getLastError() const
+  {
+    return last_error_;
+  }
+
+  /**
+   * Scanner of the current connection. Only valid while connected.
+   */
+  OS32C& getOS32C()
+  {
+    return *os32c_;
+  }
+
+  /**
+   * Requests of the current connection. Only valid while connected.
+   */
+  RRScanPipeline& getPipeline()
+  {
+    return *pipeline_;
+  }
+
+private:
+  boost::asio::io_service& io_service_;
+  string host_;
+  Callback callback_;
+
+  double start_angle_;
+  double end_angle_;
+  ConfigCache* config_cache_;
+  double rate_;
+  size_t window_;
+  double request_timeout_;
+  bool connected_messaging_;
+
+  shared_ptr<OS32C> os32c_;
+  shared_ptr<RRScanPipeline> pipeline_;
+  RangeAndReflectanceMeasurement rr_;
+  Backoff backoff_;
+
+  bool connected_;
+  int disconnects_;
+  int reconnects_;
+  int config_changes_;
+  string last_error_;
+  uint64_t next_attempt_;
+
+  void disconnect(const string& reason);
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_RR_SCAN_POLLER_H
@@ -0,0 +1,132 @@
+/**
+Software License Agreement (BSD)
+
+\file      safety_state.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SAFETY_STATE_H
+#define OMRON_OS32C_DRIVER_SAFETY_STATE_H
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * Safety related fields of a measurement report header: the state of the
+ * safety state machine, the zones and the safety IO
+ */
+struct ScannerSafetyState
+{
+  EIP_UINT machine_state;
+  EIP_UINT machine_stop_reasons;
+  EIP_UINT active_zone_set;
+  EIP_WORD zone_inputs;
+  EIP_WORD detection_zone_status;
+  EIP_WORD output_status;
+  EIP_WORD input_status;
+
+  ScannerSafetyState() : machine_state(0), machine_stop_reasons(0), active_zone_set(0),
+    zone_inputs(0), detection_zone_status(0), output_status(0), input_status(0)
+  {
+  }
+
+  /**
+   * Take the safety state from a measurement report header
+   */
+  explicit ScannerSafetyState(const MeasurementReportHeader& header)
+    : machine_state(header.machine_state), machine_stop_reasons(header.machine_stop_reasons),
+      active_zone_set(header.active_zone_set), zone_inputs(header.zone_inputs),
+      detection_zone_status(header.detection_zone_status), output_status(header.output_status),
+      input_status(header.input_status)
+  {
+  }
+
+  bool operator==(const ScannerSafetyState& other) const
+  {
+    return machine_state == other.machine_state &&
+      machine_stop_reasons == other.machine_stop_reasons &&
+      active_zone_set == other.active_zone_set &&
+      zone_inputs == other.zone_inputs &&
+      detection_zone_status == other.detection_zone_status &&
+      output_status == other.output_status &&
+      input_status == other.input_status;
+  }
+
+  bool operator!=(const ScannerSafetyState& other) const
+  {
+    return !(*this == other);
+  }
+};
+
+/**
+ * Watches the safety state of each scan for changes, so that they can be
+ * reported as events rather than with every scan. Has no dependency on ROS.
+ */
+class SafetyStateMonitor
+{
+public:
+  SafetyStateMonitor() : known_(false), changes_(0)
+  {
+  }
+
+  /**
+   * Check the safety state of a scan against the last one seen
+   * @param header Header of the scan
+   * @return true if the state changed, or this is the first scan seen
+   */
+  bool update(const MeasurementReportHeader& header);
+
+  /**
+   * Forget the last state seen, so that the next scan is reported as a
+   * change, such as after reconnecting to the scanner
+   */
+  void reset()
+  {
+    known_ = false;
+  }
+
+  /**
+   * Last state seen. Only valid after the first call to update().
+   */
+  const ScannerSafetyState& getState() const
+  {
+    return state_;
+  }
+
+  /**
+   * Number of changes seen, not counting the first scan
+   */
+  int getChanges() const
+  {
+    return changes_;
+  }
+
+private:
+  ScannerSafetyState state_;
+  bool known_;
+  int changes_;
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SAFETY_STATE_H
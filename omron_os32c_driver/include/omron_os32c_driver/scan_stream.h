@@ -0,0 +1,224 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_stream.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SCAN_STREAM_H
+#define OMRON_OS32C_DRIVER_SCAN_STREAM_H
+
+#include <stdint.h>
+#include <atomic>
+#include <boost/function.hpp>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/config_cache.h"
+#include "omron_os32c_driver/io_packet.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/os32c.h"
+
+namespace omron_os32c_driver {
+
+/**
+ * View of a scan as decoded from a measurement report. Refers to the data of
+ * the report without copying it, so it is only valid for the duration of the
+ * callback it is passed to.
+ */
+struct ScanView
+{
+  /// Header of the measurement report
+  const MeasurementReportHeader* header;
+  /// Range of each beam in mm, or 0x0001 for a noisy beam and 0xFFFF for no return
+  const EIP_UINT* ranges;
+  /// Number of beams in the scan
+  size_t num_beams;
+  /// Angle of the first beam, in radians CCW from straight ahead
+  double start_angle;
+  /// Angle between successive beams. Negative, since the scan runs CW.
+  double angle_increment;
+  /// Time the report was received, from monotonicNanoseconds()
+  uint64_t receive_time;
+
+  /**
+   * Angle of the given beam, in radians CCW from straight ahead.
+   */
+  double angle(size_t beam) const
+  {
+    return start_angle + beam * angle_increment;
+  }
+};
+
+/**
+ * Stream of scans from an OS32C with an established UDP IO connection. Receives
+ * measurement reports, hands each to a callback as a ScanView and keeps the
+ * connection alive. Has no dependency on ROS, so it can be used on its own;
+ * the ROS node is a thin layer that publishes from the callback.
+ */
+class ScanStream
+{
+public:
+  typedef boost::function<void (const ScanView&)> Callback;
+
+  /**
+   * Construct a new stream. The scanner must have had its beams selected and
+   * its UDP IO started before scans are received.
+   * @param os32c Scanner to receive from
+   * @param callback Function to call with each scan received
+   */
+  ScanStream(OS32C& os32c, const Callback& callback);
+
+  /**
+   * Construct a new stream with no scanner yet. setScanner() must be called
+   * before scans are received.
+   * @param callback Function to call with each scan received
+   */
+  explicit ScanStream(const Callback& callback);
+
+  /**
+   * Switch the stream to a new scanner, such as after reconnecting. Scan
+   * counting starts over with the new connection, and the next keepalive is
+   * due a whole interval after the call, since one is sent on connecting.
+   * @param os32c Scanner to receive from. Must outlive the stream, or the
+   *  next call to setScanner().
+   */
+  void setScanner(OS32C& os32c);
+
+  /**
+   * Set how often the keepalive is sent to the scanner. The next keepalive
+   * is due a whole interval from now.
+   * @param interval Time between keepalives in seconds
+   * @throw std::invalid_argument if the interval is not positive
+   * @see IOConnectionParams::getKeepaliveInterval
+   */
+  void setKeepaliveInterval(double interval);
+
+  /**
+   * Send the keepalive if it is due. Called after each scan, and by a caller
+   * that waits for scans with a timeout whenever the wait ends without one,
+   * so that keepalives keep to their interval whether or not scans arrive.
+   * @param now Monotonic time in nanoseconds
+   * @return true if a keepalive was sent
+   * @throw std::runtime_error if the keepalive could not be sent
+   */
+  bool sendKeepaliveIfDue(uint64_t now);
+
+  /**
+   * Monotonic time in nanoseconds at which the next keepalive is due
+   */
+  uint64_t getNextKeepaliveTime() const
+  {
+    return next_keepalive_time_;
+  }
+
+  /**
+   * Check the config checksums of each scan against a cache, so that the
+   * cache is invalidated as soon as the configuration of the scanner changes.
+   * @param cache Cache to check against, or NULL for none. Must outlive the stream.
+   */
+  void setConfigCache(ConfigCache* cache)
+  {
+    config_cache_ = cache;
+  }
+
+  /**
+   * Size the receive buffer for the largest possible scan and touch it, so
+   * that receiving does not allocate or fault in memory.
+   */
+  void prefaultBuffers();
+
+  /**
+   * Receive a single packet and, if it is a measurement report, pass it to
+   * the callback, then send the keepalive if it is due. Blocks until a packet
+   * is received. Malformed packets are counted and dropped without throwing.
+   * @return true if a scan was passed to the callback, false if the packet was dropped
+   * @throw std::runtime_error if there was a problem receiving the packet
+   * @throw std::logic_error if there is no scanner
+   */
+  bool spinOnce();
+
+  /**
+   * Receive scans until stop() is called. Exceptions from receiving or from
+   * the callback end the loop and are passed on to the caller.
+   */
+  void run();
+
+  /**
+   * Make run() return after the scan it is waiting for. Can be called from
+   * any thread, including from the callback.
+   */
+  void stop();
+
+  /**
+   * Number of scans lost since the stream started, going by gaps in the
+   * scan count reported by the device.
+   */
+  uint64_t getLostScans() const
+  {
+    return lost_scans_;
+  }
+
+  /**
+   * Number of times the config checksums reported by the scanner changed
+   * since the stream started. Only counted with a config cache set.
+   */
+  int getConfigChanges() const
+  {
+    return config_changes_;
+  }
+
+  /**
+   * Number of packets dropped since the stream started because they were not
+   * valid measurement reports
+   */
+  uint64_t getMalformedPackets() const
+  {
+    return malformed_packets_;
+  }
+
+  /**
+   * Why the last packet dropped was rejected
+   */
+  DECODE_STATUS getLastDecodeStatus() const
+  {
+    return last_decode_status_;
+  }
+
+private:
+  OS32C* os32c_;
+  Callback callback_;
+  MeasurementReport report_;
+  /// Time between keepalives in nanoseconds
+  uint64_t keepalive_interval_;
+  uint64_t next_keepalive_time_;
+  uint64_t lost_scans_;
+  EIP_UDINT last_scan_count_;
+  bool have_scan_count_;
+  ConfigCache* config_cache_;
+  int config_changes_;
+  uint64_t malformed_packets_;
+  DECODE_STATUS last_decode_status_;
+  std::atomic<bool> running_;
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SCAN_STREAM_H
@@ -0,0 +1,73 @@
+/**
+Software License Agreement (BSD)
+
+\file      sector_minima.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_SECTOR_MINIMA_H
+#define OMRON_OS32C_DRIVER_SECTOR_MINIMA_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "odva_ethernetip/eip_types.h"
+#include "omron_os32c_driver/beam_geometry.h"
+
+using std::vector;
+
+namespace omron_os32c_driver {
+
+/**
+ * Nearest valid return in a sector of a scan
+ */
+struct SectorMinimum
+{
+  /// Range in mm, or 0xFFFF if the sector has no valid return
+  EIP_UINT range;
+  /// Index in the scan of the beam with the nearest return, or -1 if none
+  int beam;
+};
+
+/**
+ * Split the beams of a scan into sectors of as near equal size as possible
+ * @param num_beams Number of beams in the scan
+ * @param count Number of sectors
+ * @return Sectors, as indices of beams in the scan
+ * @throw std::invalid_argument if there are no sectors, or more than beams
+ */
+vector<BeamSector> splitSectors(size_t num_beams, int count);
+
+/**
+ * Find the nearest valid return in each sector of a scan. Noisy beams (0x0001)
+ * are masked out as if they had no return, so that the minimum over each
+ * sector is a plain reduction the compiler can vectorize.
+ * @param ranges Range of each beam of the scan in mm, as reported
+ * @param sectors Sectors to search, as indices of beams in the scan
+ * @param minima Set to the nearest return in each sector. Must have room
+ *  for one per sector.
+ */
+void findSectorMinima(const EIP_UINT* ranges, const vector<BeamSector>& sectors,
+  SectorMinimum* minima);
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_SECTOR_MINIMA_H
@@ -0,0 +1,114 @@
+/**
+Software License Agreement (BSD)
+
+\file      timed_tcp_socket.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_TIMED_TCP_SOCKET_H
+#define OMRON_OS32C_DRIVER_TIMED_TCP_SOCKET_H
+
+#include <string>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/socket/socket.h"
+
+using std::string;
+using boost::asio::ip::tcp;
+using eip::socket::Socket;
+
+namespace omron_os32c_driver {
+
+/**
+ * TCP socket for the explicit messaging session, with a deadline on every
+ * operation. Behaves like the TCP socket from odva_ethernetip, but connecting,
+ * sending and receiving each give up after the timeout rather than blocking
+ * for as long as the kernel allows, which for a scanner that is unreachable
+ * or half booted can be minutes or forever.
+ */
+class TimedTCPSocket : public Socket
+{
+public:
+  /// Timeout if none is given, long enough for any explicit request
+  static constexpr double DEFAULT_TIMEOUT = 2.0;
+
+  /**
+   * @param io_service IO service to use
+   * @param timeout Longest time each operation may take, in seconds
+   * @throw std::invalid_argument if the timeout is not positive
+   */
+  TimedTCPSocket(boost::asio::io_service& io_service, double timeout = DEFAULT_TIMEOUT);
+
+  /**
+   * Connect to the remote device, trying each address the hostname resolves to
+   * @param hostname Hostname or IP address of the remote device
+   * @param port Port on the remote device
+   * @throw std::runtime_error if no address could be connected to within the timeout
+   */
+  virtual void open(string hostname, string port);
+
+  virtual void close();
+
+  /**
+   * Send all of the data given
+   * @param buf Data to send
+   * @return number of bytes sent
+   * @throw std::runtime_error if sending fails or times out
+   */
+  virtual size_t send(const boost::asio::const_buffer& buf);
+
+  /**
+   * Receive whatever data is available, waiting for some if there is none
+   * @param buf Buffer to receive into
+   * @return number of bytes received
+   * @throw std::runtime_error if receiving fails or times out, or the remote
+   *  device closed the connection
+   */
+  virtual size_t receive(const boost::asio::mutable_buffer& buf);
+
+  double getTimeout() const
+  {
+    return timeout_;
+  }
+
+  /**
+   * Local address of the connection, which is that of the interface the
+   * remote device is reached through
+   * @return address in dotted decimal form
+   * @throw std::runtime_error if the socket is not connected
+   */
+  string getLocalAddress() const;
+
+private:
+  boost::asio::io_service& io_service_;
+  tcp::socket socket_;
+  double timeout_;
+
+  /**
+   * Connect to a single address within the timeout
+   * @return zero on success, or the error number
+   */
+  int connectTo(const tcp::endpoint& endpoint);
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_TIMED_TCP_SOCKET_H
@@ -0,0 +1,178 @@
+/**
+Software License Agreement (BSD)
+
+\file      udp_io_socket.h
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#ifndef OMRON_OS32C_DRIVER_UDP_IO_SOCKET_H
+#define OMRON_OS32C_DRIVER_UDP_IO_SOCKET_H
+
+#include <stdint.h>
+#include <string>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/socket/socket.h"
+
+using std::string;
+using boost::asio::ip::udp;
+using eip::socket::Socket;
+
+namespace omron_os32c_driver {
+
+/**
+ * UDP socket for the implicit IO connection that allows tuning the kernel
+ * socket options relevant to scan latency and loss. Behaves like the UDP
+ * socket from odva_ethernetip, but receives with recvmsg() so that datagrams
+ * dropped by the kernel can be counted.
+ */
+class UDPIOSocket : public Socket
+{
+public:
+  /**
+   * Create a socket bound to the given local port
+   * @param io_service IO service to use
+   * @param local_port Local port to receive on
+   * @throw boost::system::system_error if the socket cannot be opened or bound
+   */
+  UDPIOSocket(boost::asio::io_service& io_service, unsigned short local_port);
+
+  /**
+   * Create a socket that is neither opened nor bound, for a session that
+   * never starts UDP IO but needs an IO socket regardless
+   * @param io_service IO service to use
+   */
+  explicit UDPIOSocket(boost::asio::io_service& io_service);
+
+  /**
+   * Set the remote endpoint to send to
+   * @param hostname Hostname or IP address of the remote device
+   * @param port Port on the remote device
+   */
+  virtual void open(string hostname, string port);
+
+  virtual void close();
+
+  /**
+   * Send a datagram to the remote endpoint
+   * @param buf Data to send
+   * @return number of bytes sent
+   */
+  virtual size_t send(const boost::asio::const_buffer& buf);
+
+  /**
+   * Receive a datagram from any sender, updating the kernel drop count
+   * @param buf Buffer to receive into
+   * @return number of bytes received
+   * @throw std::runtime_error if receiving fails or times out
+   */
+  virtual size_t receive(const boost::asio::mutable_buffer& buf);
+
+  /**
+   * Set how long receive() waits for a datagram before giving up
+   * @param timeout Time to wait in seconds, or zero to wait forever
+   * @throw std::invalid_argument if the timeout is negative
+   * @throw std::runtime_error if the option cannot be set
+   */
+  void setReceiveTimeout(double timeout);
+
+  /**
+   * Wait for a datagram to be ready to receive, so that the caller can bound
+   * how long it blocks without treating a quiet link as an error.
+   * @param timeout Longest time to wait in seconds, rounded up to a millisecond
+   * @return true if a datagram is ready, false if the timeout expired or the
+   *  wait was interrupted by a signal
+   * @throw std::runtime_error if the socket cannot be waited on
+   */
+  bool waitReadable(double timeout);
+
+  /**
+   * Set the size of the kernel receive buffer. Tries to exceed the system
+   * limit (net.core.rmem_max) first, which needs CAP_NET_ADMIN.
+   * @param size Requested size in bytes
+   * @return The size actually set, as reported by the kernel
+   * @throw std::runtime_error if the option cannot be set
+   */
+  int setReceiveBufferSize(int size);
+
+  /**
+   * Enable busy polling of the device queue on blocking receives
+   * @param usec Time to busy poll for, in microseconds
+   * @throw std::runtime_error if the option cannot be set
+   */
+  void setBusyPoll(int usec);
+
+  /**
+   * Set the priority of sent packets, used to select the device queue
+   * @param priority Socket priority, 0-6 without CAP_NET_ADMIN
+   * @throw std::runtime_error if the option cannot be set
+   */
+  void setPriority(int priority);
+
+  /**
+   * Set the DSCP marking of sent packets
+   * @param dscp Differentiated services code point, 0-63
+   * @throw std::invalid_argument if the code point is out of range
+   * @throw std::runtime_error if the option cannot be set
+   */
+  void setDSCP(int dscp);
+
+  /**
+   * Join a multicast group to receive a multicast T->O connection. Left when
+   * the socket is closed. Membership is per interface, so this should be the
+   * interface the scanner is reached through; the kernel otherwise picks the
+   * one for the default route, which on a robot is rarely the sensor network.
+   * @param group Multicast address in dotted decimal form
+   * @param interface_address Address of the local interface to join on, in
+   *  dotted decimal form, or empty to let the kernel choose
+   * @throw std::invalid_argument if either address is not valid
+   * @throw std::runtime_error if the group cannot be joined
+   */
+  void joinMulticastGroup(const string& group, const string& interface_address = "");
+
+  /**
+   * Ask the kernel to report the number of datagrams dropped because the
+   * receive buffer was full. See getKernelDrops().
+   * @throw std::runtime_error if the option cannot be set
+   */
+  void enableDropCounting();
+
+  /**
+   * Number of datagrams dropped by the kernel on this socket, as of the last
+   * receive. Only counted once enableDropCounting() has been called.
+   */
+  uint32_t getKernelDrops() const
+  {
+    return kernel_drops_;
+  }
+
+private:
+  boost::asio::io_service& io_service_;
+  udp::socket socket_;
+  udp::endpoint remote_endpoint_;
+  uint32_t kernel_drops_;
+
+  void setOption(int level, int name, int value, const char* description);
+};
+
+} // namespace omron_os32c_driver
+
+#endif  // OMRON_OS32C_DRIVER_UDP_IO_SOCKET_H
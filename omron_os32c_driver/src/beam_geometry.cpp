@@ -0,0 +1,72 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_geometry.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdint.h>
+#include <stdexcept>
+
+#include "omron_os32c_driver/beam_geometry.h"
+
+namespace omron_os32c_driver {
+
+static const int MASK_WORDS = (BEAM_MASK_BYTES + 7) / 8;
+
+void buildBeamMask(const vector<BeamSector>& sectors, EIP_BYTE mask[])
+{
+  uint64_t words[MASK_WORDS] = { 0 };
+  for (size_t i = 0; i < sectors.size(); ++i)
+  {
+    int first = sectors[i].first_beam;
+    int last = sectors[i].last_beam;
+    if (first < 0 || last >= BEAM_COUNT || first > last)
+    {
+      throw std::invalid_argument("Beam sector is empty or outside the scan");
+    }
+
+    // ones from the first beam up in its word, and up to the last beam in its word
+    int first_word = first / 64;
+    int last_word = last / 64;
+    uint64_t first_bits = ~0ULL << (first % 64);
+    uint64_t last_bits = ~0ULL >> (63 - last % 64);
+    if (first_word == last_word)
+    {
+      words[first_word] |= first_bits & last_bits;
+      continue;
+    }
+    words[first_word] |= first_bits;
+    for (int w = first_word + 1; w < last_word; ++w)
+    {
+      words[w] = ~0ULL;
+    }
+    words[last_word] |= last_bits;
+  }
+
+  // the mask is little endian, whatever the host is
+  for (int i = 0; i < BEAM_MASK_BYTES; ++i)
+  {
+    mask[i] = words[i / 8] >> (8 * (i % 8));
+  }
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,214 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_statistics.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "omron_os32c_driver/beam_statistics.h"
+
+namespace omron_os32c_driver {
+
+BeamStatistics::BeamStatistics(int sector_beams)
+  : sector_beams_(sector_beams), have_baseline_(false), baseline_has_reflectance_(false)
+{
+  if (sector_beams < 1)
+  {
+    throw std::invalid_argument("Sectors must have at least one beam");
+  }
+  clear();
+}
+
+void BeamStatistics::clear()
+{
+  scans_ = 0;
+  have_reflectance_ = false;
+  memset(samples_, 0, sizeof(samples_));
+  memset(valid_, 0, sizeof(valid_));
+  memset(noisy_, 0, sizeof(noisy_));
+  memset(no_return_, 0, sizeof(no_return_));
+  memset(range_mean_, 0, sizeof(range_mean_));
+  memset(range_m2_, 0, sizeof(range_m2_));
+  memset(reflectance_mean_, 0, sizeof(reflectance_mean_));
+  memset(reflectance_m2_, 0, sizeof(reflectance_m2_));
+}
+
+void BeamStatistics::update(const EIP_UINT* ranges, const EIP_UINT* reflectance,
+  size_t num_beams, int first_beam)
+{
+  if (first_beam < 0 || first_beam + num_beams > static_cast<size_t>(BEAM_COUNT))
+  {
+    throw std::invalid_argument("Scan runs past the last beam");
+  }
+
+  float* samples = samples_ + first_beam;
+  float* valid = valid_ + first_beam;
+  float* noisy = noisy_ + first_beam;
+  float* no_return = no_return_ + first_beam;
+  float* range_mean = range_mean_ + first_beam;
+  float* range_m2 = range_m2_ + first_beam;
+
+  // Welford's update, with invalid samples given a weight of zero so that
+  // every beam takes the same path. The divisor is only ever the count of
+  // valid samples for a valid sample, and is one otherwise, to avoid 0 / 0.
+  for (size_t i = 0; i < num_beams; ++i)
+  {
+    float is_noisy = ranges[i] == 0x0001;
+    float is_no_return = ranges[i] == 0xFFFF;
+    float weight = 1 - is_noisy - is_no_return;
+    samples[i] += 1;
+    noisy[i] += is_noisy;
+    no_return[i] += is_no_return;
+    valid[i] += weight;
+
+    float x = ranges[i];
+    float delta = x - range_mean[i];
+    range_mean[i] += delta * weight / (valid[i] + 1 - weight);
+    range_m2[i] += weight * delta * (x - range_mean[i]);
+  }
+
+  if (reflectance)
+  {
+    float* reflectance_mean = reflectance_mean_ + first_beam;
+    float* reflectance_m2 = reflectance_m2_ + first_beam;
+    for (size_t i = 0; i < num_beams; ++i)
+    {
+      float weight = 1 - (ranges[i] == 0x0001) - (ranges[i] == 0xFFFF);
+      float x = reflectance[i];
+      float delta = x - reflectance_mean[i];
+      reflectance_mean[i] += delta * weight / (valid[i] + 1 - weight);
+      reflectance_m2[i] += weight * delta * (x - reflectance_mean[i]);
+    }
+    have_reflectance_ = true;
+  }
+  ++scans_;
+}
+
+BeamStatisticsSummary BeamStatistics::summarize(const BeamStatisticsThresholds& thresholds)
+{
+  int num_sectors = (BEAM_COUNT + sector_beams_ - 1) / sector_beams_;
+  bool compare_reflectance = have_baseline_ && have_reflectance_ && baseline_has_reflectance_;
+
+  BeamStatisticsSummary summary;
+  summary.scans = scans_;
+  summary.sector_beams = sector_beams_;
+  summary.sector_noisy_rate.assign(num_sectors, 0);
+  summary.sector_no_return_rate.assign(num_sectors, 0);
+  summary.sector_range_stddev.assign(num_sectors, 0);
+
+  double total_samples = 0, total_noisy = 0, total_no_return = 0;
+  for (int sector = 0; sector < num_sectors; ++sector)
+  {
+    int first = sector * sector_beams_;
+    int last = std::min(first + sector_beams_, BEAM_COUNT);
+    double samples = 0, noisy = 0, no_return = 0;
+    double stddev_sum = 0, reflectance_sum = 0, baseline_reflectance_sum = 0;
+    double baseline_no_return_sum = 0;
+    int beams = 0, baseline_beams = 0, reflectance_beams = 0;
+
+    for (int beam = first; beam < last; ++beam)
+    {
+      if (!samples_[beam])
+      {
+        continue;
+      }
+      float stddev = std::sqrt(getRangeVariance(beam));
+      bool flagged = getNoisyRate(beam) > thresholds.noisy_rate
+        || (thresholds.range_stddev > 0 && stddev > thresholds.range_stddev);
+      if (have_baseline_ && baseline_sampled_[beam])
+      {
+        // a beam without a valid return in either period has no reflectance to compare
+        bool compare_beam = compare_reflectance && valid_[beam] > 0 && baseline_valid_[beam];
+        flagged = flagged
+          || getNoReturnRate(beam) - baseline_no_return_[beam] > thresholds.no_return_rise
+          || (compare_beam && reflectance_mean_[beam]
+            < baseline_reflectance_[beam] * (1 - thresholds.reflectance_drop));
+        if (compare_beam)
+        {
+          reflectance_sum += reflectance_mean_[beam];
+          baseline_reflectance_sum += baseline_reflectance_[beam];
+          ++reflectance_beams;
+        }
+        baseline_no_return_sum += baseline_no_return_[beam];
+        ++baseline_beams;
+      }
+      if (flagged)
+      {
+        summary.flagged_beams.push_back(beam);
+      }
+
+      samples += samples_[beam];
+      noisy += noisy_[beam];
+      no_return += no_return_[beam];
+      stddev_sum += stddev;
+      ++beams;
+    }
+    if (!beams)
+    {
+      continue;
+    }
+
+    summary.sector_noisy_rate[sector] = noisy / samples;
+    summary.sector_no_return_rate[sector] = no_return / samples;
+    summary.sector_range_stddev[sector] = stddev_sum / beams;
+    bool flagged = noisy / samples > thresholds.noisy_rate
+      || (thresholds.range_stddev > 0 && stddev_sum / beams > thresholds.range_stddev);
+    if (baseline_beams)
+    {
+      flagged = flagged
+        || no_return / samples - baseline_no_return_sum / baseline_beams > thresholds.no_return_rise
+        || (reflectance_beams && reflectance_sum
+          < baseline_reflectance_sum * (1 - thresholds.reflectance_drop));
+    }
+    if (flagged)
+    {
+      summary.flagged_sectors.push_back(sector);
+    }
+
+    total_samples += samples;
+    total_noisy += noisy;
+    total_no_return += no_return;
+  }
+  summary.noisy_rate = total_samples ? total_noisy / total_samples : 0;
+  summary.no_return_rate = total_samples ? total_no_return / total_samples : 0;
+
+  if (!have_baseline_ && total_samples)
+  {
+    for (int beam = 0; beam < BEAM_COUNT; ++beam)
+    {
+      baseline_sampled_[beam] = samples_[beam] > 0;
+      baseline_no_return_[beam] = getNoReturnRate(beam);
+      baseline_reflectance_[beam] = reflectance_mean_[beam];
+      baseline_valid_[beam] = valid_[beam] > 0;
+    }
+    baseline_has_reflectance_ = have_reflectance_;
+    have_baseline_ = true;
+  }
+  clear();
+  return summary;
+}
+
+} // namespace omron_os32c_driver
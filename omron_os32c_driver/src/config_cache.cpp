@@ -0,0 +1,229 @@
+/**
+Software License Agreement (BSD)
+
+\file      config_cache.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+#include "omron_os32c_driver/config_cache.h"
+
+namespace omron_os32c_driver {
+
+ConfigCache::ConfigCache(const string& path, const string& host)
+  : path_(path), host_(host), has_config_(false), has_checksums_(false), dirty_(false),
+    unverified_(false),
+    non_safety_config_checksum_(0), safety_config_checksum_(0)
+{
+}
+
+bool ConfigCache::load()
+{
+  invalidate();
+  dirty_ = false;
+  std::ifstream file(path_.c_str());
+  if (!file)
+  {
+    return false;
+  }
+
+  // one "key value" pair per line, as written by save()
+  string host, mask;
+  ScannerConfig config;
+  unsigned int range_format = 0, reflectivity_format = 0, non_safety = 0, safety = 0;
+  bool has_range = false, has_reflectivity = false, has_non_safety = false, has_safety = false;
+  string line;
+  while (std::getline(file, line))
+  {
+    std::istringstream in(line);
+    string key;
+    in >> key;
+    if (key == "host")
+    {
+      in >> host;
+    }
+    else if (key == "range_format")
+    {
+      has_range = bool(in >> range_format);
+    }
+    else if (key == "reflectivity_format")
+    {
+      has_reflectivity = bool(in >> reflectivity_format);
+    }
+    else if (key == "beam_mask")
+    {
+      in >> mask;
+    }
+    else if (key == "non_safety_config_checksum")
+    {
+      has_non_safety = bool(in >> std::hex >> non_safety);
+    }
+    else if (key == "safety_config_checksum")
+    {
+      has_safety = bool(in >> std::hex >> safety);
+    }
+  }
+
+  if (host != host_ || !has_range || !has_reflectivity || mask.size() != 2 * sizeof(config.beam_mask))
+  {
+    return false;
+  }
+  for (size_t i = 0; i < sizeof(config.beam_mask); ++i)
+  {
+    unsigned int byte;
+    if (sscanf(mask.c_str() + 2 * i, "%2x", &byte) != 1)
+    {
+      return false;
+    }
+    config.beam_mask[i] = byte;
+  }
+  config.range_format = range_format;
+  config.reflectivity_format = reflectivity_format;
+
+  config_ = config;
+  has_config_ = true;
+  if (has_non_safety && has_safety)
+  {
+    non_safety_config_checksum_ = non_safety;
+    safety_config_checksum_ = safety;
+    has_checksums_ = true;
+  }
+  return true;
+}
+
+void ConfigCache::save()
+{
+  dirty_ = false;
+  std::ofstream file(path_.c_str());
+  if (!file)
+  {
+    throw std::runtime_error("Could not open config cache " + path_ + " for writing");
+  }
+
+  file << "host " << host_ << std::endl;
+  if (has_config_)
+  {
+    file << "range_format " << config_.range_format << std::endl;
+    file << "reflectivity_format " << config_.reflectivity_format << std::endl;
+    file << "beam_mask " << std::hex << std::setfill('0');
+    for (size_t i = 0; i < sizeof(config_.beam_mask); ++i)
+    {
+      file << std::setw(2) << (unsigned int)config_.beam_mask[i];
+    }
+    file << std::endl;
+  }
+  if (has_checksums_)
+  {
+    file << "non_safety_config_checksum " << std::hex << non_safety_config_checksum_ << std::endl;
+    file << "safety_config_checksum " << std::hex << safety_config_checksum_ << std::endl;
+  }
+
+  if (!file)
+  {
+    throw std::runtime_error("Could not write config cache " + path_);
+  }
+}
+
+void ConfigCache::checkWritable() const
+{
+  // appending leaves an existing cache as it is
+  std::ofstream file(path_.c_str(), std::ios::app);
+  if (!file)
+  {
+    throw std::runtime_error("Could not open config cache " + path_ + " for writing");
+  }
+}
+
+void ConfigCache::setApplied(const ScannerConfig& config)
+{
+  config_ = config;
+  has_config_ = true;
+  has_checksums_ = false;
+  dirty_ = true;
+  unverified_ = false;
+}
+
+bool ConfigCache::checkChecksums(const MeasurementReportHeader& header)
+{
+  if (!has_config_)
+  {
+    return false;
+  }
+
+  // a trusted configuration that did not survive a power cycle shows in
+  // the report itself, whatever the checksums
+  if (unverified_)
+  {
+    unverified_ = false;
+    if (header.range_report_format != config_.range_format ||
+      header.num_beams != countBeams(config_))
+    {
+      invalidate();
+      return true;
+    }
+  }
+
+  if (!has_checksums_)
+  {
+    non_safety_config_checksum_ = header.non_safety_config_checksum;
+    safety_config_checksum_ = header.safety_config_checksum;
+    has_checksums_ = true;
+    dirty_ = true;
+    return false;
+  }
+
+  if (header.non_safety_config_checksum == non_safety_config_checksum_ &&
+    header.safety_config_checksum == safety_config_checksum_)
+  {
+    return false;
+  }
+
+  invalidate();
+  return true;
+}
+
+void ConfigCache::invalidate()
+{
+  has_config_ = false;
+  has_checksums_ = false;
+  dirty_ = true;
+  unverified_ = false;
+}
+
+size_t ConfigCache::countBeams(const ScannerConfig& config)
+{
+  size_t count = 0;
+  for (size_t i = 0; i < sizeof(config.beam_mask); ++i)
+  {
+    for (EIP_BYTE bits = config.beam_mask[i]; bits; bits &= bits - 1)
+    {
+      ++count;
+    }
+  }
+  return count;
+}
+
+} // namespace omron_os32c_driver
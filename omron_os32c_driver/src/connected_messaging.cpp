@@ -0,0 +1,281 @@
+/**
+Software License Agreement (BSD)
+
+\file      connected_messaging.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "omron_os32c_driver/connected_messaging.h"
+
+using eip::serialization::BufferReader;
+using eip::serialization::BufferWriter;
+using std::string;
+
+namespace omron_os32c_driver {
+
+// encapsulation commands for unconnected and connected explicit messages
+static const EIP_UINT SEND_RR_DATA = 0x006F;
+static const EIP_UINT SEND_UNIT_DATA = 0x0070;
+// CPF item types of the addresses and data of explicit messages
+static const EIP_UINT NULL_ADDRESS_ITEM = 0x0000;
+static const EIP_UINT CONNECTED_ADDRESS_ITEM = 0x00A1;
+static const EIP_UINT CONNECTED_DATA_ITEM = 0x00B1;
+static const EIP_UINT UNCONNECTED_DATA_ITEM = 0x00B2;
+// interface handle, timeout, item count, and the header and data of the address item
+static const size_t SEND_UNIT_DATA_OVERHEAD = 16;
+// data item header and the sequence count, ahead of the Message Router request
+static const size_t CONNECTED_DATA_OVERHEAD = 6;
+// interface handle, timeout, item count, and the null address item
+static const size_t SEND_RR_DATA_OVERHEAD = 12;
+// header of the unconnected data item
+static const size_t UNCONNECTED_DATA_OVERHEAD = 4;
+// service, reserved byte, general status and additional status size
+static const size_t MESSAGE_ROUTER_REPLY_OVERHEAD = 4;
+
+/**
+ * Write the encapsulation header of an explicit message
+ */
+static void writeEncapsulationHeader(BufferWriter& writer, EIP_UINT command, size_t length,
+  EIP_UDINT session_id, uint64_t sender_context)
+{
+  writer.write(command);
+  writer.write((EIP_UINT)length);
+  writer.write(session_id);
+  writer.write((EIP_UDINT)0);
+  for (int i = 0; i < 8; ++i)
+  {
+    writer.write((EIP_USINT)(sender_context >> (8 * i)));
+  }
+  writer.write((EIP_UDINT)0);
+}
+
+/**
+ * Write a Message Router request
+ */
+static void writeMessageRouterRequest(BufferWriter& writer, EIP_USINT service, const Path& path,
+  const Serializable* data)
+{
+  writer.write(service);
+  path.serialize(writer);
+  if (data)
+  {
+    data->serialize(writer);
+  }
+}
+
+/**
+ * Read the encapsulation header of a reply to an explicit message, checking
+ * its command, status and length
+ * @return sender context of the reply
+ */
+static uint64_t readEncapsulationHeader(BufferReader& reader, size_t size, EIP_UINT expected,
+  const char* name)
+{
+  EIP_UINT command, length;
+  EIP_UDINT status;
+  reader.read(command);
+  reader.read(length);
+  reader.skip(4);
+  reader.read(status);
+  uint64_t sender_context = 0;
+  for (int i = 0; i < 8; ++i)
+  {
+    EIP_USINT b;
+    reader.read(b);
+    sender_context |= (uint64_t)b << (8 * i);
+  }
+  reader.skip(4);
+  if (status)
+  {
+    std::ostringstream msg;
+    msg << name << " failed with encapsulation status 0x" << std::hex << status;
+    throw std::runtime_error(msg.str());
+  }
+  if (command != expected)
+  {
+    throw std::logic_error(string("Reply is not to a ") + name + " request");
+  }
+  if (ENCAPSULATION_HEADER_LENGTH + length > size)
+  {
+    throw std::length_error(string("Reply to a ") + name + " request is truncated");
+  }
+  return sender_context;
+}
+
+/**
+ * Read a Message Router reply of the given length
+ */
+static MessageRouterReply readMessageRouterReply(BufferReader& reader, size_t length)
+{
+  MessageRouterReply reply;
+  EIP_USINT additional_status_size;
+  reader.read(reply.service);
+  reader.skip(1);
+  reader.read(reply.general_status);
+  reader.read(additional_status_size);
+  size_t data_length = length - MESSAGE_ROUTER_REPLY_OVERHEAD;
+  if (additional_status_size * sizeof(EIP_UINT) > data_length)
+  {
+    throw std::length_error("Additional status overruns the reply");
+  }
+  reply.additional_status.resize(additional_status_size);
+  for (size_t i = 0; i < additional_status_size; ++i)
+  {
+    reader.read(reply.additional_status[i]);
+  }
+  reply.data.resize(data_length - additional_status_size * sizeof(EIP_UINT));
+  if (!reply.data.empty())
+  {
+    reader.readBytes(&reply.data[0], reply.data.size());
+  }
+  return reply;
+}
+
+size_t encodeSendUnitData(EIP_UDINT session_id, EIP_UDINT connection_id,
+  EIP_UINT sequence_count, EIP_USINT service, const Path& path, const Serializable* data,
+  EIP_BYTE* buf, size_t size)
+{
+  EIP_UINT request_length = sizeof(service) + path.getLength() + (data ? data->getLength() : 0);
+
+  BufferWriter writer(boost::asio::buffer(buf, size));
+  writeEncapsulationHeader(writer, SEND_UNIT_DATA,
+    SEND_UNIT_DATA_OVERHEAD + CONNECTED_DATA_OVERHEAD + request_length, session_id, 0);
+
+  // interface handle and timeout are both zero for CIP
+  writer.write((EIP_UDINT)0);
+  writer.write((EIP_UINT)0);
+  writer.write((EIP_UINT)2);
+  writer.write(CONNECTED_ADDRESS_ITEM);
+  writer.write((EIP_UINT)sizeof(connection_id));
+  writer.write(connection_id);
+  writer.write(CONNECTED_DATA_ITEM);
+  writer.write((EIP_UINT)(sizeof(sequence_count) + request_length));
+  writer.write(sequence_count);
+  writeMessageRouterRequest(writer, service, path, data);
+  return writer.getByteCount();
+}
+
+size_t encodeSendRRData(EIP_UDINT session_id, uint64_t sender_context, EIP_USINT service,
+  const Path& path, const Serializable* data, EIP_BYTE* buf, size_t size)
+{
+  EIP_UINT request_length = sizeof(service) + path.getLength() + (data ? data->getLength() : 0);
+
+  BufferWriter writer(boost::asio::buffer(buf, size));
+  writeEncapsulationHeader(writer, SEND_RR_DATA,
+    SEND_RR_DATA_OVERHEAD + UNCONNECTED_DATA_OVERHEAD + request_length, session_id,
+    sender_context);
+
+  writer.write((EIP_UDINT)0);
+  writer.write((EIP_UINT)0);
+  writer.write((EIP_UINT)2);
+  writer.write(NULL_ADDRESS_ITEM);
+  writer.write((EIP_UINT)0);
+  writer.write(UNCONNECTED_DATA_ITEM);
+  writer.write(request_length);
+  writeMessageRouterRequest(writer, service, path, data);
+  return writer.getByteCount();
+}
+
+size_t getEncapsulationLength(const EIP_BYTE* buf, size_t size)
+{
+  if (size < ENCAPSULATION_HEADER_LENGTH)
+  {
+    return 0;
+  }
+  return ENCAPSULATION_HEADER_LENGTH + (buf[2] | (buf[3] << 8));
+}
+
+MessageRouterReply decodeSendUnitDataReply(const EIP_BYTE* buf, size_t size,
+  EIP_UDINT connection_id, EIP_UINT* sequence_count)
+{
+  BufferReader reader(boost::asio::buffer(const_cast<EIP_BYTE*>(buf), size));
+  readEncapsulationHeader(reader, size, SEND_UNIT_DATA, "SendUnitData");
+
+  EIP_UINT item_count, item_type, item_length;
+  EIP_UDINT reply_connection_id;
+  reader.skip(6);
+  reader.read(item_count);
+  reader.read(item_type);
+  reader.read(item_length);
+  if (item_count != 2 || item_type != CONNECTED_ADDRESS_ITEM || item_length != sizeof(EIP_UDINT))
+  {
+    throw std::logic_error("Reply to a SendUnitData request has no connected address");
+  }
+  reader.read(reply_connection_id);
+  if (reply_connection_id != connection_id)
+  {
+    throw std::logic_error("Reply is for a different connection");
+  }
+  reader.read(item_type);
+  reader.read(item_length);
+  if (item_type != CONNECTED_DATA_ITEM
+    || item_length < sizeof(EIP_UINT) + MESSAGE_ROUTER_REPLY_OVERHEAD)
+  {
+    throw std::logic_error("Reply to a SendUnitData request has no connected data");
+  }
+  reader.read(*sequence_count);
+  return readMessageRouterReply(reader, item_length - sizeof(EIP_UINT));
+}
+
+MessageRouterReply decodeSendUnitDataReply(const EIP_BYTE* buf, size_t size,
+  EIP_UDINT connection_id, EIP_UINT sequence_count)
+{
+  EIP_UINT reply_sequence;
+  MessageRouterReply reply = decodeSendUnitDataReply(buf, size, connection_id, &reply_sequence);
+  if (reply_sequence != sequence_count)
+  {
+    throw std::logic_error("Reply is to a different request");
+  }
+  return reply;
+}
+
+MessageRouterReply decodeSendRRDataReply(const EIP_BYTE* buf, size_t size,
+  uint64_t& sender_context)
+{
+  BufferReader reader(boost::asio::buffer(const_cast<EIP_BYTE*>(buf), size));
+  sender_context = readEncapsulationHeader(reader, size, SEND_RR_DATA, "SendRRData");
+
+  EIP_UINT item_count, item_type, item_length;
+  reader.skip(6);
+  reader.read(item_count);
+  reader.read(item_type);
+  reader.read(item_length);
+  if (item_count != 2 || item_type != NULL_ADDRESS_ITEM || item_length)
+  {
+    throw std::logic_error("Reply to a SendRRData request has no null address");
+  }
+  reader.read(item_type);
+  reader.read(item_length);
+  if (item_type != UNCONNECTED_DATA_ITEM || item_length < MESSAGE_ROUTER_REPLY_OVERHEAD)
+  {
+    throw std::logic_error("Reply to a SendRRData request has no unconnected data");
+  }
+  return readMessageRouterReply(reader, item_length);
+}
+
+} // namespace omron_os32c_driver
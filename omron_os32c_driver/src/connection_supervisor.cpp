@@ -0,0 +1,290 @@
+/**
+Software License Agreement (BSD)
+
+\file      connection_supervisor.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <boost/bind.hpp>
+
+#include "omron_os32c_driver/connection_supervisor.h"
+#include "omron_os32c_driver/realtime.h"
+
+namespace omron_os32c_driver {
+
+Backoff::Backoff(double initial, double max, double jitter, unsigned int seed)
+  : initial_(initial), max_(max), jitter_(jitter), delay_(initial),
+    rng_(seed ? seed : std::random_device()())
+{
+  if (initial <= 0 || max < initial)
+  {
+    throw std::invalid_argument("Backoff delays must be positive, with the maximum at least the initial");
+  }
+  if (jitter < 0 || jitter > 1)
+  {
+    throw std::invalid_argument("Backoff jitter must be between 0 and 1");
+  }
+}
+
+double Backoff::next()
+{
+  std::uniform_real_distribution<double> dist(-jitter_, jitter_);
+  double delay = delay_ * (1 + dist(rng_));
+  delay_ = std::min(delay_ * 2, max_);
+  return delay;
+}
+
+ConnectionSupervisor::ConnectionSupervisor(boost::asio::io_service& io_service,
+  const string& host, const ScanStream::Callback& callback)
+  : io_service_(io_service), host_(host), callback_(callback),
+    range_format_(RANGE_MEASURE_50M), reflectivity_format_(REFLECTIVITY_MEASURE_TOT_4PS),
+    start_angle_(OS32C::ANGLE_MAX), end_angle_(OS32C::ANGLE_MIN), config_cache_(NULL),
+    connected_messaging_(false), request_timeout_(TimedTCPSocket::DEFAULT_TIMEOUT),
+    stream_(boost::bind(&ConnectionSupervisor::handleScan, this, _1)),
+    backoff_(0.1, 5, 0.2), connected_(false), awaiting_first_scan_(false), disconnects_(0),
+    reconnects_(0), timeouts_(0), next_attempt_(0), lost_time_(0), last_packet_time_(0),
+    restore_time_(0), last_recovery_time_(0),
+    last_outage_time_(0)
+{
+}
+
+void ConnectionSupervisor::setConfiguration(EIP_UINT range_format, EIP_UINT reflectivity_format,
+  double start_angle, double end_angle, ConfigCache* cache)
+{
+  range_format_ = range_format;
+  reflectivity_format_ = reflectivity_format;
+  start_angle_ = start_angle;
+  end_angle_ = end_angle;
+  config_cache_ = cache;
+  stream_.setConfigCache(cache);
+}
+
+void ConnectionSupervisor::setBackoff(double initial, double max, double jitter)
+{
+  backoff_ = Backoff(initial, max, jitter);
+}
+
+void ConnectionSupervisor::setRequestTimeout(double timeout)
+{
+  if (timeout <= 0)
+  {
+    throw std::invalid_argument("Request timeout must be positive");
+  }
+  request_timeout_ = timeout;
+}
+
+void ConnectionSupervisor::setIOConnectionParams(const IOConnectionParams& params)
+{
+  params.validate();
+  io_params_ = params;
+}
+
+void ConnectionSupervisor::connect()
+{
+  // drop the old scanner before its IO socket, so that port can be bound again
+  os32c_.reset();
+  io_socket_.reset();
+
+  // an unreachable or half booted scanner must not hold up the attempt for long
+  shared_ptr<TimedTCPSocket> socket(new TimedTCPSocket(io_service_, request_timeout_));
+  io_socket_ = shared_ptr<UDPIOSocket>(new UDPIOSocket(io_service_, 2222));
+  if (io_socket_hook_)
+  {
+    io_socket_hook_(*io_socket_);
+  }
+  os32c_ = shared_ptr<OS32C>(new OS32C(socket, io_socket_));
+
+  os32c_->open(host_);
+  if (connected_messaging_)
+  {
+    try
+    {
+      os32c_->openExplicitConnection();
+    }
+    catch (std::exception& ex)
+    {
+      // not every firmware takes a Class 3 connection, and unconnected requests still work
+    }
+  }
+  if (io_params_.mode == IO_CONNECTION_OWNER)
+  {
+    os32c_->configure(range_format_, reflectivity_format_, start_angle_, end_angle_,
+      config_cache_);
+  }
+  else
+  {
+    os32c_->followConfiguration();
+  }
+  os32c_->startUDPIO(getFallbackParams(io_params_));
+  os32c_->sendKeepaliveUDP();
+
+  // the intervals follow the parameters accepted, which may be a fallback
+  const IOConnectionParams& accepted = os32c_->getIOConnectionParams();
+  if (accepted.t_to_o_multicast)
+  {
+    // on the interface the session reaches the scanner through
+    io_socket_->joinMulticastGroup(multicast_group_.empty() ?
+      os32c_->getMulticastAddress() : multicast_group_, socket->getLocalAddress());
+  }
+  io_socket_->setReceiveTimeout(accepted.getIOTimeout());
+
+  // Nothing is sent over the Class 3 connection once the scanner is
+  // configured, so it would time out after four RPIs and be closed by the
+  // scanner. Close it now rather than leave a dead connection to close later.
+  try
+  {
+    os32c_->closeExplicitConnection();
+  }
+  catch (std::runtime_error& ex)
+  {
+    // the scanner times it out regardless
+  }
+  stream_.setScanner(*os32c_);
+  stream_.setKeepaliveInterval(accepted.getKeepaliveInterval());
+  connected_ = true;
+  restore_time_ = monotonicNanoseconds();
+  last_packet_time_ = restore_time_;
+}
+
+ConnectionSupervisor::SpinResult ConnectionSupervisor::spinOnce(double timeout)
+{
+  uint64_t now = monotonicNanoseconds();
+  uint64_t deadline = now + static_cast<uint64_t>(timeout * 1e9);
+
+  if (!connected_)
+  {
+    if (deadline < next_attempt_)
+    {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+      return DISCONNECTED;
+    }
+    if (now < next_attempt_)
+    {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(next_attempt_ - now));
+    }
+    try
+    {
+      connect();
+      ++reconnects_;
+      awaiting_first_scan_ = true;
+      backoff_.reset();
+    }
+    catch (std::exception& ex)
+    {
+      disconnect(ex.what());
+    }
+    return DISCONNECTED;
+  }
+
+  try
+  {
+    // wait no longer than the caller's deadline or the IO timeout, waking
+    // for each keepalive that falls due in the meantime
+    uint64_t io_deadline = last_packet_time_
+      + static_cast<uint64_t>(os32c_->getIOTimeout() * 1e9);
+    uint64_t wait_until = std::min(deadline, io_deadline);
+    for (;;)
+    {
+      uint64_t wake = std::min(wait_until, stream_.getNextKeepaliveTime());
+      if (io_socket_->waitReadable(wake > now ? (wake - now) / 1e9 : 0))
+      {
+        break;
+      }
+      now = monotonicNanoseconds();
+      if (now >= io_deadline)
+      {
+        disconnect("Timed out waiting for IO packet");
+        return DISCONNECTED;
+      }
+      stream_.sendKeepaliveIfDue(now);
+      if (now >= wait_until)
+      {
+        ++timeouts_;
+        return TIMED_OUT;
+      }
+    }
+    bool verifying = config_cache_ && config_cache_->isUnverified();
+    if (!stream_.spinOnce())
+    {
+      // foreign or corrupt traffic does not show that the scanner is alive
+      return MALFORMED_PACKET;
+    }
+    last_packet_time_ = monotonicNanoseconds();
+    if (verifying && !config_cache_->isValid())
+    {
+      // The configuration was taken from the cache but is not in effect, so
+      // connect again to read it back and restore it. The link is up, so the
+      // connection is closed rather than left for the scanner to time out.
+      try
+      {
+        os32c_->stopUDPIO();
+        os32c_->close();
+      }
+      catch (std::exception& ex)
+      {
+        // the scanner times it out regardless
+      }
+      disconnect("Sensor configuration no longer matches the config cache");
+      return DISCONNECTED;
+    }
+  }
+  catch (std::runtime_error& ex)
+  {
+    disconnect(ex.what());
+    return DISCONNECTED;
+  }
+  return SCAN_RECEIVED;
+}
+
+void ConnectionSupervisor::handleScan(const ScanView& scan)
+{
+  if (awaiting_first_scan_)
+  {
+    last_recovery_time_ = scan.receive_time - restore_time_;
+    last_outage_time_ = scan.receive_time - lost_time_;
+    awaiting_first_scan_ = false;
+  }
+  callback_(scan);
+}
+
+void ConnectionSupervisor::disconnect(const string& reason)
+{
+  if (connected_)
+  {
+    ++disconnects_;
+    lost_time_ = monotonicNanoseconds();
+    connected_ = false;
+  }
+  last_error_ = reason;
+
+  // The link is presumed dead, so the IO connection is not closed with a
+  // Forward Close, which would block waiting for a reply. The scanner drops
+  // it by itself once it stops receiving keepalives.
+  os32c_.reset();
+  io_socket_.reset();
+  next_attempt_ = monotonicNanoseconds() + static_cast<uint64_t>(backoff_.next() * 1e9);
+}
+
+} // namespace omron_os32c_driver
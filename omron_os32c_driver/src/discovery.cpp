@@ -0,0 +1,386 @@
+/**
+Software License Agreement (BSD)
+
+\file      discovery.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <arpa/inet.h>
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <boost/asio.hpp>
+#include <boost/bind.hpp>
+#include <boost/date_time/posix_time/posix_time_types.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "omron_os32c_driver/discovery.h"
+
+using boost::asio::ip::udp;
+using boost::asio::ip::address_v4;
+using eip::serialization::BufferReader;
+
+namespace omron_os32c_driver {
+
+// Omron vendor ID, as assigned by ODVA
+static const EIP_UINT OMRON_VENDOR_ID = 47;
+
+static const EIP_UINT LIST_IDENTITY_COMMAND = 0x0063;
+static const EIP_UINT CIP_IDENTITY_ITEM = 0x000C;
+static const size_t ENCAP_HEADER_LENGTH = 24;
+
+bool CIPIdentity::isOS32C() const
+{
+  return vendor_id == OMRON_VENDOR_ID && product_name.find("OS32C") != string::npos;
+}
+
+Writer& CIPIdentity::serialize(Writer& writer) const
+{
+  EIP_USINT name_length = product_name.size();
+  EIP_UINT be_family = htons(sin_family);
+  EIP_UINT be_port = htons(sin_port);
+  EIP_UDINT be_addr = htonl(sin_addr);
+  EIP_BYTE sin_zero[8] = { 0 };
+  writer.write(encap_protocol_version);
+  writer.write(be_family);
+  writer.write(be_port);
+  writer.write(be_addr);
+  writer.writeBytes(sin_zero, sizeof(sin_zero));
+  writer.write(vendor_id);
+  writer.write(device_type);
+  writer.write(product_code);
+  writer.write(revision_major);
+  writer.write(revision_minor);
+  writer.write(status);
+  writer.write(serial_number);
+  writer.write(name_length);
+  writer.writeBytes(product_name.data(), name_length);
+  writer.write(state);
+  return writer;
+}
+
+Reader& CIPIdentity::deserialize(Reader& reader)
+{
+  reader.read(encap_protocol_version);
+  reader.read(sin_family);
+  reader.read(sin_port);
+  reader.read(sin_addr);
+  sin_family = ntohs(sin_family);
+  sin_port = ntohs(sin_port);
+  sin_addr = ntohl(sin_addr);
+  reader.skip(8);
+  reader.read(vendor_id);
+  reader.read(device_type);
+  reader.read(product_code);
+  reader.read(revision_major);
+  reader.read(revision_minor);
+  reader.read(status);
+  reader.read(serial_number);
+  EIP_USINT name_length;
+  reader.read(name_length);
+  product_name.resize(name_length);
+  if (name_length)
+  {
+    reader.readBytes(&product_name[0], name_length);
+  }
+  reader.read(state);
+  return reader;
+}
+
+/**
+ * Parse a ListIdentity reply, as received on the discovery socket
+ * @param data Reply data
+ * @param length Length of the reply
+ * @param identity Identity to fill in from the reply
+ * @return true if the reply held an identity item
+ */
+static bool parseListIdentityReply(EIP_BYTE* data, size_t length, CIPIdentity& identity)
+{
+  try
+  {
+    BufferReader reader(boost::asio::buffer(data, length));
+    EIP_UINT command, item_count;
+    EIP_UDINT status;
+    reader.read(command);
+    reader.skip(2 + 4);
+    reader.read(status);
+    reader.skip(ENCAP_HEADER_LENGTH - 12);
+    if (command != LIST_IDENTITY_COMMAND || status != 0)
+    {
+      return false;
+    }
+
+    reader.read(item_count);
+    for (size_t i = 0; i < item_count; ++i)
+    {
+      EIP_UINT item_type, item_length;
+      reader.read(item_type);
+      reader.read(item_length);
+      if (item_type == CIP_IDENTITY_ITEM)
+      {
+        identity.deserialize(reader, item_length);
+        return true;
+      }
+      reader.skip(item_length);
+    }
+  }
+  catch (std::length_error& ex)
+  {
+    // truncated reply, so not from a device we can talk to
+  }
+  return false;
+}
+
+/**
+ * Collects ListIdentity replies on a socket until a timeout, or until the
+ * reply being looked for arrives.
+ */
+class ListIdentityCollector
+{
+public:
+  ListIdentityCollector(boost::asio::io_service& io_service, udp::socket& socket,
+      EIP_UDINT serial_number, bool stop_on_serial)
+    : socket_(socket), timer_(io_service), serial_number_(serial_number),
+      stop_on_serial_(stop_on_serial), found_(false)
+  {
+  }
+
+  void start(double timeout)
+  {
+    timer_.expires_from_now(boost::posix_time::microseconds(static_cast<int64_t>(timeout * 1000000)));
+    timer_.async_wait(boost::bind(&ListIdentityCollector::handleTimeout, this,
+      boost::asio::placeholders::error));
+    receive();
+  }
+
+  const vector<CIPIdentity>& getIdentities() const
+  {
+    return identities_;
+  }
+
+  bool found() const
+  {
+    return found_;
+  }
+
+private:
+  udp::socket& socket_;
+  boost::asio::deadline_timer timer_;
+  EIP_UDINT serial_number_;
+  bool stop_on_serial_;
+  bool found_;
+  EIP_BYTE buffer_[512];
+  udp::endpoint sender_;
+  std::set<string> addresses_;
+  vector<CIPIdentity> identities_;
+
+  void receive()
+  {
+    socket_.async_receive_from(boost::asio::buffer(buffer_), sender_,
+      boost::bind(&ListIdentityCollector::handleReceive, this,
+        boost::asio::placeholders::error, boost::asio::placeholders::bytes_transferred));
+  }
+
+  void handleReceive(const boost::system::error_code& ec, size_t length)
+  {
+    if (ec == boost::asio::error::operation_aborted)
+    {
+      return;
+    }
+
+    CIPIdentity identity;
+    if (!ec && parseListIdentityReply(buffer_, length, identity) && identity.isOS32C())
+    {
+      identity.address = sender_.address().to_string();
+      // a scanner can reply more than once, to both a broadcast and its own address
+      if (addresses_.insert(identity.address).second)
+      {
+        identities_.push_back(identity);
+      }
+      if (stop_on_serial_ && identity.serial_number == serial_number_)
+      {
+        found_ = true;
+        timer_.cancel();
+        return;
+      }
+    }
+    receive();
+  }
+
+  void handleTimeout(const boost::system::error_code& ec)
+  {
+    if (ec != boost::asio::error::operation_aborted)
+    {
+      socket_.cancel();
+    }
+  }
+};
+
+/**
+ * Send ListIdentity to all targets and collect the replies
+ */
+static vector<CIPIdentity> listIdentity(const vector<string>& targets, double timeout,
+  unsigned short port, EIP_UDINT serial_number, bool stop_on_serial)
+{
+  vector<udp::endpoint> endpoints;
+  for (size_t i = 0; i < targets.size(); ++i)
+  {
+    boost::system::error_code ec;
+    address_v4 addr = address_v4::from_string(targets[i], ec);
+    if (ec)
+    {
+      throw std::invalid_argument("Invalid discovery target: " + targets[i]);
+    }
+    endpoints.push_back(udp::endpoint(addr, port));
+  }
+
+  boost::asio::io_service io_service;
+  udp::socket socket(io_service);
+  try
+  {
+    socket.open(udp::v4());
+    socket.set_option(boost::asio::socket_base::broadcast(true));
+  }
+  catch (boost::system::system_error& ex)
+  {
+    throw std::runtime_error(string("Could not open discovery socket: ") + ex.what());
+  }
+
+  // encapsulation header only: command, then zero length, session, status,
+  // sender context and options
+  EIP_BYTE request[ENCAP_HEADER_LENGTH] = { 0 };
+  request[0] = LIST_IDENTITY_COMMAND & 0xFF;
+  request[1] = LIST_IDENTITY_COMMAND >> 8;
+  for (size_t i = 0; i < endpoints.size(); ++i)
+  {
+    // unreachable targets are just left out
+    boost::system::error_code ec;
+    socket.send_to(boost::asio::buffer(request), endpoints[i], 0, ec);
+  }
+
+  ListIdentityCollector collector(io_service, socket, serial_number, stop_on_serial);
+  collector.start(timeout);
+  io_service.run();
+  if (stop_on_serial && !collector.found())
+  {
+    return vector<CIPIdentity>();
+  }
+  return collector.getIdentities();
+}
+
+vector<CIPIdentity> discoverScanners(const vector<string>& targets, double timeout,
+  unsigned short port)
+{
+  return listIdentity(targets, timeout, port, 0, false);
+}
+
+CIPIdentity findScannerBySerialNumber(EIP_UDINT serial_number, const vector<string>& targets,
+  double timeout, unsigned short port)
+{
+  vector<CIPIdentity> identities = listIdentity(targets, timeout, port, serial_number, true);
+  for (size_t i = 0; i < identities.size(); ++i)
+  {
+    if (identities[i].serial_number == serial_number)
+    {
+      return identities[i];
+    }
+  }
+  std::ostringstream msg;
+  msg << "No OS32C with serial number " << serial_number << " replied";
+  throw std::runtime_error(msg.str());
+}
+
+vector<string> parseDiscoveryTargets(const string& targets)
+{
+  vector<string> addresses;
+  std::istringstream in(targets);
+  string item;
+  while (std::getline(in, item, ','))
+  {
+    size_t slash = item.find('/');
+    boost::system::error_code ec;
+    address_v4 addr = address_v4::from_string(item.substr(0, slash), ec);
+    if (ec)
+    {
+      throw std::invalid_argument("Invalid address in discovery targets: " + item);
+    }
+    if (slash == string::npos)
+    {
+      addresses.push_back(addr.to_string());
+      continue;
+    }
+
+    int prefix;
+    std::istringstream prefix_in(item.substr(slash + 1));
+    if (!(prefix_in >> prefix) || !prefix_in.eof() || prefix < 16 || prefix > 32)
+    {
+      throw std::invalid_argument("Invalid subnet in discovery targets, prefix must be 16 to 32: "
+        + item);
+    }
+    uint32_t mask = ~0U << (32 - prefix);
+    uint32_t network = addr.to_ulong() & mask;
+    uint32_t broadcast = network | ~mask;
+    if (prefix >= 31)
+    {
+      // no network or broadcast address to leave out
+      for (uint64_t a = network; a <= broadcast; ++a)
+      {
+        addresses.push_back(address_v4(a).to_string());
+      }
+    }
+    else
+    {
+      for (uint32_t a = network + 1; a < broadcast; ++a)
+      {
+        addresses.push_back(address_v4(a).to_string());
+      }
+    }
+  }
+  if (addresses.empty())
+  {
+    throw std::invalid_argument("No discovery targets given");
+  }
+  return addresses;
+}
+
+EIP_UDINT parseSerialNumber(const string& text)
+{
+  // strtoull would take a sign, and wrap a negative number around
+  if (text.empty() || !isdigit(static_cast<unsigned char>(text[0])))
+  {
+    throw std::invalid_argument("Invalid serial number: " + text);
+  }
+  // base 0 would read a leading zero as octal
+  bool hex = text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X');
+  errno = 0;
+  char* end;
+  unsigned long long value = strtoull(text.c_str(), &end, hex ? 16 : 10);
+  if (*end || errno || value > 0xFFFFFFFFULL)
+  {
+    throw std::invalid_argument("Invalid serial number, must be 0 to 4294967295: " + text);
+  }
+  return value;
+}
+
+} // namespace omron_os32c_driver
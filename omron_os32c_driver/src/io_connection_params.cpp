@@ -0,0 +1,130 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_connection_params.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdexcept>
+
+#include "omron_os32c_driver/io_connection_params.h"
+#include "omron_os32c_driver/measurement_report_config.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+
+namespace omron_os32c_driver {
+
+const EIP_UDINT IOConnectionParams::MIN_T_TO_O_RPI = 40000;
+const EIP_UDINT IOConnectionParams::MAX_RPI = 10000000;
+const EIP_UINT IOConnectionParams::MAX_T_TO_O_BUFFER_SIZE = 0x0584;
+const EIP_UINT IOConnectionParams::HEARTBEAT_BUFFER_SIZE = sizeof(EIP_UINT);
+const EIP_USINT IOConnectionParams::INPUT_ONLY_HEARTBEAT_ID = 0xC6;
+const EIP_USINT IOConnectionParams::LISTEN_ONLY_HEARTBEAT_ID = 0xC7;
+
+void IOConnectionParams::setMode(IO_CONNECTION_MODE new_mode)
+{
+  IOConnectionParams defaults;
+  mode = new_mode;
+  switch (mode)
+  {
+    case IO_CONNECTION_OWNER:
+      o_to_t_assembly_id = defaults.o_to_t_assembly_id;
+      o_to_t_buffer_size = defaults.o_to_t_buffer_size;
+      break;
+    case IO_CONNECTION_INPUT_ONLY:
+      o_to_t_assembly_id = INPUT_ONLY_HEARTBEAT_ID;
+      o_to_t_buffer_size = HEARTBEAT_BUFFER_SIZE;
+      break;
+    case IO_CONNECTION_LISTEN_ONLY:
+      o_to_t_assembly_id = LISTEN_ONLY_HEARTBEAT_ID;
+      o_to_t_buffer_size = HEARTBEAT_BUFFER_SIZE;
+      t_to_o_multicast = true;
+      break;
+  }
+}
+
+void IOConnectionParams::validate() const
+{
+  if (t_to_o_rpi < MIN_T_TO_O_RPI || t_to_o_rpi > MAX_RPI)
+  {
+    throw std::invalid_argument("T->O RPI is out of range");
+  }
+  // keepalives more often than the scans would only add traffic
+  if (o_to_t_rpi < t_to_o_rpi || o_to_t_rpi > MAX_RPI)
+  {
+    throw std::invalid_argument("O->T RPI must be between the T->O RPI and the maximum");
+  }
+  if (mode == IO_CONNECTION_OWNER && o_to_t_buffer_size < MeasurementReportConfig().getLength())
+  {
+    throw std::invalid_argument("O->T buffer is too small for the measurement report config");
+  }
+  if (mode != IO_CONNECTION_OWNER && o_to_t_buffer_size != HEARTBEAT_BUFFER_SIZE)
+  {
+    throw std::invalid_argument("O->T buffer must be the size of a heartbeat");
+  }
+  if (mode == IO_CONNECTION_LISTEN_ONLY && !t_to_o_multicast)
+  {
+    throw std::invalid_argument("Listen only connections must be multicast");
+  }
+  if (t_to_o_buffer_size < MeasurementReportHeader().getLength()
+    || t_to_o_buffer_size > MAX_T_TO_O_BUFFER_SIZE)
+  {
+    throw std::invalid_argument("T->O buffer size is out of range");
+  }
+  if (timeout_multiplier < 1)
+  {
+    throw std::invalid_argument("IO timeout multiplier must be positive");
+  }
+}
+
+bool IOConnectionParams::operator==(const IOConnectionParams& other) const
+{
+  return o_to_t_rpi == other.o_to_t_rpi && t_to_o_rpi == other.t_to_o_rpi
+    && o_to_t_buffer_size == other.o_to_t_buffer_size
+    && t_to_o_buffer_size == other.t_to_o_buffer_size
+    && o_to_t_assembly_id == other.o_to_t_assembly_id
+    && t_to_o_assembly_id == other.t_to_o_assembly_id
+    && config_assembly_id == other.config_assembly_id
+    && timeout_multiplier == other.timeout_multiplier && mode == other.mode
+    && t_to_o_multicast == other.t_to_o_multicast;
+}
+
+vector<IOConnectionParams> getFallbackParams(const IOConnectionParams& requested)
+{
+  IOConnectionParams defaults;
+  defaults.t_to_o_multicast = requested.t_to_o_multicast;
+  IOConnectionParams default_timing(requested);
+  default_timing.o_to_t_rpi = defaults.o_to_t_rpi;
+  default_timing.t_to_o_rpi = defaults.t_to_o_rpi;
+
+  vector<IOConnectionParams> params(1, requested);
+  if (default_timing != requested)
+  {
+    params.push_back(default_timing);
+  }
+  if (requested.mode == IO_CONNECTION_OWNER && defaults != requested
+    && defaults != default_timing)
+  {
+    params.push_back(defaults);
+  }
+  return params;
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,164 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_packet.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <string.h>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "omron_os32c_driver/io_packet.h"
+
+using eip::serialization::BufferReader;
+using eip::serialization::BufferWriter;
+
+namespace omron_os32c_driver {
+
+const EIP_UINT MeasurementReportHeader::MAX_BEAMS;
+
+// CPF item type of the sequenced address, which carries the connection ID
+static const EIP_UINT SEQUENCED_ADDRESS_ITEM = 0x8002;
+// CPF item type of connected data, which carries the measurement report
+static const EIP_UINT CONNECTED_DATA_ITEM = 0x00B1;
+// item type and length ahead of the data of each CPF item
+static const size_t ITEM_HEADER_LENGTH = 4;
+// sequence count ahead of the measurement report in the connected data
+static const size_t SEQUENCE_LENGTH = 2;
+
+static inline EIP_UINT readUINT(const EIP_BYTE* p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+const char* decodeStatusString(DECODE_STATUS status)
+{
+  switch (status)
+  {
+    case DECODE_OK:               return "OK";
+    case DECODE_TRUNCATED:        return "IO packet truncated";
+    case DECODE_WRONG_ITEM_COUNT: return "IO packet received with wrong number of items";
+    case DECODE_WRONG_ITEM_TYPE:  return "IO packet received with wrong data type";
+    case DECODE_TOO_MANY_BEAMS:   return "Measurement report has more beams than the scanner has";
+    case DECODE_LENGTH_MISMATCH:  return "Number of beams does not match data received";
+  }
+  return "Unknown decode status";
+}
+
+DECODE_STATUS decodeMeasurementReport(const EIP_BYTE* data, size_t size,
+  MeasurementReport& report)
+{
+  if (size < sizeof(EIP_UINT))
+  {
+    return DECODE_TRUNCATED;
+  }
+  if (readUINT(data) != 2)
+  {
+    return DECODE_WRONG_ITEM_COUNT;
+  }
+  const EIP_BYTE* p = data + sizeof(EIP_UINT);
+  const EIP_BYTE* end = data + size;
+
+  // skip the address item
+  if (end - p < (ptrdiff_t)ITEM_HEADER_LENGTH)
+  {
+    return DECODE_TRUNCATED;
+  }
+  EIP_UINT address_length = readUINT(p + 2);
+  p += ITEM_HEADER_LENGTH;
+  if (end - p < (ptrdiff_t)address_length)
+  {
+    return DECODE_TRUNCATED;
+  }
+  p += address_length;
+
+  if (end - p < (ptrdiff_t)ITEM_HEADER_LENGTH)
+  {
+    return DECODE_TRUNCATED;
+  }
+  if (readUINT(p) != CONNECTED_DATA_ITEM)
+  {
+    return DECODE_WRONG_ITEM_TYPE;
+  }
+  size_t data_length = readUINT(p + 2);
+  p += ITEM_HEADER_LENGTH;
+  if (end - p < (ptrdiff_t)data_length
+    || data_length < SEQUENCE_LENGTH + report.header.getLength())
+  {
+    return DECODE_TRUNCATED;
+  }
+  p += SEQUENCE_LENGTH;
+
+  // the length was checked above, so this cannot overrun the buffer
+  BufferReader reader(boost::asio::buffer(const_cast<EIP_BYTE*>(p), report.header.getLength()));
+  report.header.deserialize(reader);
+  p += report.header.getLength();
+
+  if (report.header.num_beams > MeasurementReportHeader::MAX_BEAMS)
+  {
+    return DECODE_TOO_MANY_BEAMS;
+  }
+  if (data_length != SEQUENCE_LENGTH + report.header.getLength()
+    + report.header.num_beams * sizeof(EIP_UINT))
+  {
+    return DECODE_LENGTH_MISMATCH;
+  }
+  report.measurement_data.resize(report.header.num_beams);
+  if (report.header.num_beams)
+  {
+    memcpy(&report.measurement_data[0], p, report.header.num_beams * sizeof(EIP_UINT));
+  }
+  return DECODE_OK;
+}
+
+size_t encodeMeasurementReportConfig(const MeasurementReportConfig& mrc,
+  EIP_UDINT connection_id, EIP_UDINT sequence_num, EIP_BYTE* data, size_t size)
+{
+  BufferWriter writer(boost::asio::buffer(data, size));
+  writer.write((EIP_UINT)2);
+  writer.write(SEQUENCED_ADDRESS_ITEM);
+  writer.write((EIP_UINT)(sizeof(connection_id) + sizeof(sequence_num)));
+  writer.write(connection_id);
+  writer.write(sequence_num);
+  writer.write(CONNECTED_DATA_ITEM);
+  writer.write((EIP_UINT)mrc.getLength());
+  mrc.serialize(writer);
+  return writer.getByteCount();
+}
+
+size_t encodeHeartbeat(EIP_UDINT connection_id, EIP_UDINT sequence_num, EIP_BYTE* data,
+  size_t size)
+{
+  BufferWriter writer(boost::asio::buffer(data, size));
+  writer.write((EIP_UINT)2);
+  writer.write(SEQUENCED_ADDRESS_ITEM);
+  writer.write((EIP_UINT)(sizeof(connection_id) + sizeof(sequence_num)));
+  writer.write(connection_id);
+  writer.write(sequence_num);
+  writer.write(CONNECTED_DATA_ITEM);
+  writer.write((EIP_UINT)SEQUENCE_LENGTH);
+  writer.write((EIP_UINT)sequence_num);
+  return writer.getByteCount();
+}
+
+} // namespace omron_os32c_driver
@@ -24,61 +24,68 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 */
 
 
-#include <ros/ros.h>
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <stdexcept>
 #include <boost/shared_ptr.hpp>
 #include <boost/make_shared.hpp>
 #include <boost/asio.hpp>
 
 #include "omron_os32c_driver/os32c.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
 #include "odva_ethernetip/serialization/serializable_buffer.h"
+#include "odva_ethernetip/serialization/serializable_primitive.h"
 #include "odva_ethernetip/cpf_packet.h"
 #include "odva_ethernetip/cpf_item.h"
-#include "odva_ethernetip/sequenced_address_item.h"
 #include "odva_ethernetip/sequenced_data_item.h"
 
-using std::cout;
-using std::endl;
 using boost::shared_ptr;
 using boost::make_shared;
 using boost::asio::buffer;
+using eip::Path;
 using eip::Session;
+using eip::serialization::BufferReader;
 using eip::serialization::SerializableBuffer;
+using eip::serialization::SerializablePrimitive;
 using eip::RRDataResponse;
 using eip::CPFItem;
 using eip::CPFPacket;
-using eip::SequencedAddressItem;
 using eip::SequencedDataItem;
 using omron_os32c_driver::RangeAndReflectanceMeasurement;
 
 namespace omron_os32c_driver {
 
-const double OS32C::ANGLE_MIN = DEG2RAD(-135.2);
-const double OS32C::ANGLE_MAX = DEG2RAD( 135.2);
-const double OS32C::ANGLE_INC = DEG2RAD(0.4);
+const double OS32C::ANGLE_MIN = BEAM_ANGLE_MIN;
+const double OS32C::ANGLE_MAX = BEAM_ANGLE_MAX;
+const double OS32C::ANGLE_INC = BEAM_ANGLE_INC;
 const double OS32C::DISTANCE_MIN = 0.002;
 const double OS32C::DISTANCE_MAX = 50;
+const EIP_UDINT OS32C::EXPLICIT_RPI = 10000000;
+const EIP_UINT OS32C::ORIGINATOR_VENDOR_ID = 0x0001;
 
 EIP_UINT OS32C::getRangeFormat()
 {
-  mrc_.range_report_format = getSingleAttribute(0x73, 1, 4, (EIP_UINT)0);
+  mrc_.range_report_format = getAttribute(0x73, 1, 4, (EIP_UINT)0);
   return mrc_.range_report_format;
 }
 
 void OS32C::setRangeFormat(EIP_UINT format)
 {
-  setSingleAttribute(0x73, 1, 4, format);
+  setAttribute(0x73, 1, 4, format);
   mrc_.range_report_format = format;
 }
 
 EIP_UINT OS32C::getReflectivityFormat()
 {
-  mrc_.reflectivity_report_format = getSingleAttribute(0x73, 1, 5, (EIP_UINT)0);
+  mrc_.reflectivity_report_format = getAttribute(0x73, 1, 5, (EIP_UINT)0);
   return mrc_.reflectivity_report_format;
 }
 
 void OS32C::setReflectivityFormat(EIP_UINT format)
 {
-  setSingleAttribute(0x73, 1, 5, format);
+  setAttribute(0x73, 1, 5, format);
   mrc_.reflectivity_report_format = format;
 }
 
@@ -97,42 +104,14 @@ void OS32C::calcBeamMask(double start_angle, double end_angle, EIP_BYTE mask[])
     throw std::invalid_argument("Starting angle is less than ending angle");
   }
 
-  int start_beam = calcBeamNumber(start_angle);
-  int end_beam = calcBeamNumber(end_angle);
+  // half a beam past the last one still rounds to a beam past the end
+  int start_beam = std::max(calcBeamNumber(start_angle), 0);
+  int end_beam = std::min(calcBeamNumber(end_angle), BEAM_COUNT - 1);
   start_angle_ = calcBeamCentre(start_beam);
   end_angle_ = calcBeamCentre(end_beam);
 
-  // figure out where we're starting and ending in the array
-  int start_byte = start_beam / 8;
-  int start_bit = start_beam - start_byte * 8;
-  int end_byte = end_beam / 8;
-  int end_bit = end_beam - end_byte * 8;
-
-  // clear out all of the whole bytes that need to be set in one shot
-  if (start_byte > 0)
-  {
-    memset(mask, 0, start_byte);
-  }
-
-  // if we're starting in the middle of the byte, then we need to do some bit math
-  if (start_bit)
-  {
-    // clear out the bits at the start of the byte, while making the higher bits 1
-    mask[start_byte] = ~((1 << start_bit) - 1);
-  }
-  else
-  {
-    --start_byte;
-  }
-
-  // mark all of the whole bytes
-  memset(mask + start_byte + 1, 0xFF, end_byte - start_byte - 1);
-
-  // clear out the bits above the end beam
-  mask[end_byte] = (1 << (end_bit + 1)) - 1;
-
-  // zero out everything after the end
-  memset(mask + end_byte + 1, 0, 87 - end_byte);
+  BeamSector sector = { start_beam, end_beam };
+  buildBeamMask(vector<BeamSector>(1, sector), mask);
 }
 
 void OS32C::selectBeams(double start_angle, double end_angle)
@@ -140,108 +119,276 @@ void OS32C::selectBeams(double start_angle, double end_angle)
   calcBeamMask(start_angle, end_angle, mrc_.beam_selection_mask);
   shared_ptr<SerializableBuffer> sb = make_shared<SerializableBuffer>(
     buffer(mrc_.beam_selection_mask));
-  setSingleAttributeSerializable(0x73, 1, 12, sb);
+  setAttributeSerializable(0x73, 1, 12, sb);
 }
 
-RangeAndReflectanceMeasurement OS32C::getSingleRRScan()
+/**
+ * Check the status of each reply to a Multiple Service Packet
+ * @throw std::runtime_error if any request failed
+ */
+static void checkReplies(const MultipleServiceResponse& resp)
 {
-  RangeAndReflectanceMeasurement rr;
-  getSingleAttributeSerializable(0x75, 1, 3, rr);
-  return rr;
+  for (size_t i = 0; i < resp.replies.size(); ++i)
+  {
+    if (resp.replies[i].general_status)
+    {
+      std::ostringstream msg;
+      msg << "Configuration request " << i << " failed with status 0x" << std::hex
+        << (int)resp.replies[i].general_status;
+      throw std::runtime_error(msg.str());
+    }
+  }
 }
 
-void OS32C::fillLaserScanStaticConfig(sensor_msgs::LaserScan* ls)
+int OS32C::configure(EIP_UINT range_format, EIP_UINT reflectivity_format,
+  double start_angle, double end_angle, ConfigCache* cache)
 {
-  ls->angle_max = start_angle_;
-  ls->angle_min = end_angle_;
-  ls->angle_increment = ANGLE_INC;
-  ls->range_min = DISTANCE_MIN;
-  ls->range_max = DISTANCE_MAX;
-}
+  // also checks the angles before anything is sent
+  calcBeamMask(start_angle, end_angle, mrc_.beam_selection_mask);
+  mrc_.range_report_format = range_format;
+  mrc_.reflectivity_report_format = reflectivity_format;
 
-void OS32C::convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls)
-{
-  if (rr.range_data.size() != rr.header.num_beams ||
-    rr.reflectance_data.size() != rr.header.num_beams)
+  ScannerConfig desired;
+  desired.range_format = range_format;
+  desired.reflectivity_format = reflectivity_format;
+  memcpy(desired.beam_mask, mrc_.beam_selection_mask, sizeof(desired.beam_mask));
+
+  // left for the first report to verify, as the scanner does not keep the
+  // settings across a power cycle
+  if (cache && cache->matches(desired))
   {
-    throw std::invalid_argument("Number of beams does not match vector size");
+    cache->setTrusted();
+    return 0;
   }
 
-  // Beam period is in ns
-  ls->time_increment = rr.header.scan_beam_period / 1000000000.0;
-  // Scan period is in microseconds.
-  ls->scan_time = rr.header.scan_rate / 1000000.0;
-
-  // TODO: this currently makes assumptions of the report format. Should likely
-  // accomodate all of them, or at least anything reasonable.
-  ls->ranges.resize(rr.header.num_beams);
-  ls->intensities.resize(rr.header.num_beams);
-  for (int i = 0; i < rr.header.num_beams; ++i)
+  int written = 0;
+  try
   {
-    if (rr.range_data[i] == 0x0001)
+    if (multiple_service_supported_)
     {
-      // noisy beam detected
-      ls->ranges[i] = 0;
+      ScannerConfig current = readConfig();
+      shared_ptr<MultipleServiceRequest> req = make_shared<MultipleServiceRequest>();
+      if (current.range_format != range_format)
+      {
+        req->addRequest(0x10, Path(0x73, 1, 4),
+          make_shared<SerializablePrimitive<EIP_UINT> >(range_format));
+      }
+      if (current.reflectivity_format != reflectivity_format)
+      {
+        req->addRequest(0x10, Path(0x73, 1, 5),
+          make_shared<SerializablePrimitive<EIP_UINT> >(reflectivity_format));
+      }
+      if (memcmp(current.beam_mask, desired.beam_mask, sizeof(desired.beam_mask)))
+      {
+        req->addRequest(0x10, Path(0x73, 1, 12), make_shared<SerializableBuffer>(
+          buffer(mrc_.beam_selection_mask)));
+      }
+      if (req->getRequestCount())
+      {
+        checkReplies(sendMultipleServiceRequest(req));
+      }
+      written = req->getRequestCount();
     }
-    else if (rr.range_data[i] == 0xFFFF)
+  }
+  catch (std::runtime_error& ex)
+  {
+    // only a scanner that rejects the Multiple Service Packet itself is
+    // configured the slow way, and every other failure is its own to report
+    if (multiple_service_supported_)
     {
-      // no return
-      ls->ranges[i] = DISTANCE_MAX;
+      throw;
     }
-    else
+  }
+  if (!multiple_service_supported_)
+  {
+    setRangeFormat(range_format);
+    setReflectivityFormat(reflectivity_format);
+    selectBeams(start_angle, end_angle);
+    written = 3;
+  }
+
+  if (cache)
+  {
+    cache->setApplied(desired);
+  }
+  return written;
+}
+
+ScannerConfig OS32C::readConfig()
+{
+  shared_ptr<MultipleServiceRequest> req = make_shared<MultipleServiceRequest>();
+  req->addRequest(0x0E, Path(0x73, 1, 4));
+  req->addRequest(0x0E, Path(0x73, 1, 5));
+  req->addRequest(0x0E, Path(0x73, 1, 12));
+  MultipleServiceResponse resp = sendMultipleServiceRequest(req);
+  checkReplies(resp);
+
+  ScannerConfig config;
+  config.range_format = resp.replies[0].getDataAs<EIP_UINT>();
+  config.reflectivity_format = resp.replies[1].getDataAs<EIP_UINT>();
+  if (resp.replies[2].data.size() != sizeof(config.beam_mask))
+  {
+    throw std::length_error("Beam selection mask read has the wrong length");
+  }
+  memcpy(config.beam_mask, &resp.replies[2].data[0], sizeof(config.beam_mask));
+  return config;
+}
+
+void OS32C::followConfiguration()
+{
+  ScannerConfig config = readConfig();
+  int first = -1;
+  int last = -1;
+  for (int beam = 0; beam < BEAM_COUNT; ++beam)
+  {
+    if (config.beam_mask[beam / 8] & (1 << (beam % 8)))
     {
-      ls->ranges[i] = rr.range_data[i] / 1000.0;
+      first = first < 0 ? beam : first;
+      last = beam;
     }
-    ls->intensities[i] = rr.reflectance_data[i];
   }
+  if (first < 0)
+  {
+    throw std::logic_error("Scanner has no beams selected");
+  }
+
+  mrc_.range_report_format = config.range_format;
+  mrc_.reflectivity_report_format = config.reflectivity_format;
+  memcpy(mrc_.beam_selection_mask, config.beam_mask, sizeof(mrc_.beam_selection_mask));
+  start_angle_ = calcBeamCentre(first);
+  end_angle_ = calcBeamCentre(last);
+}
+
+string OS32C::getMulticastAddress()
+{
+  MulticastConfig config;
+  getAttributeSerializable(0xF5, 1, 9, config);
+  return config.getStartAddress();
 }
 
-void OS32C::convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls)
+MultipleServiceResponse OS32C::sendMultipleServiceRequest(shared_ptr<MultipleServiceRequest> req)
 {
-  if (mr.measurement_data.size() != mr.header.num_beams)
+  MessageRouterReply reply = sendExplicitRequest(0x0A, Path(0x02, 1), req.get());
+  if (reply.general_status == SERVICE_NOT_SUPPORTED)
   {
-    throw std::invalid_argument("Number of beams does not match vector size");
+    multiple_service_supported_ = false;
+    throw std::runtime_error("Scanner does not support the Multiple Service Packet");
   }
+  // a failure of any embedded request is left to the caller to find in its reply
+  if (reply.general_status && reply.general_status != EMBEDDED_SERVICE_ERROR)
+  {
+    std::ostringstream msg;
+    msg << "Multiple Service Packet failed with status 0x" << std::hex
+      << (int)reply.general_status;
+    throw std::runtime_error(msg.str());
+  }
+  MultipleServiceResponse resp;
+  BufferReader reader(buffer(reply.data));
+  resp.deserialize(reader, reply.data.size());
+  if (resp.replies.size() != req->getRequestCount())
+  {
+    throw std::logic_error("Number of replies does not match the number of requests");
+  }
+  return resp;
+}
+
+RangeAndReflectanceMeasurement OS32C::getSingleRRScan()
+{
+  RangeAndReflectanceMeasurement rr;
+  getAttributeSerializable(0x75, 1, 3, rr);
+  return rr;
+}
 
-  // Beam period is in ns.
-  ls->time_increment = mr.header.scan_beam_period / 1000000000.0;
-  // Scan period is in microseconds.
-  ls->scan_time = mr.header.scan_rate / 1000000.0;
+uint64_t OS32C::sendRRScanRequest(uint64_t sender_context)
+{
+  EIP_BYTE buf[64];
+  if (explicit_open_)
+  {
+    EIP_UINT sequence_count = ++explicit_sequence_;
+    size_t size = encodeSendUnitData(getSessionID(), explicit_o_to_t_id_, sequence_count, 0x0E,
+      Path(0x75, 1, 3), NULL, buf, sizeof(buf));
+    explicit_socket_->send(buffer(buf, size));
+    return sequence_count;
+  }
+  size_t size = encodeSendRRData(getSessionID(), sender_context, 0x0E, Path(0x75, 1, 3), NULL,
+    buf, sizeof(buf));
+  explicit_socket_->send(buffer(buf, size));
+  return sender_context;
+}
 
-  // TODO: this currently makes assumptions of the report format. Should likely
-  // accomodate all of them, or at least anything reasonable.
-  ls->ranges.resize(mr.header.num_beams);
-  for (int i = 0; i < mr.header.num_beams; ++i)
+bool OS32C::receiveRRScan(uint64_t& sender_context, RangeAndReflectanceMeasurement& rr)
+{
+  size_t length = getEncapsulationLength(&pipeline_buffer_[0], pipeline_received_);
+  while (!length || pipeline_received_ < length)
   {
-    if (mr.measurement_data[i] == 0x0001)
+    if (length > pipeline_buffer_.size())
     {
-      // noisy beam detected
-      ls->ranges[i] = 0;
+      throw std::length_error("Reply to a pipelined request is too long");
     }
-    else if (mr.measurement_data[i] == 0xFFFF)
+    pipeline_received_ += explicit_socket_->receive(buffer(&pipeline_buffer_[pipeline_received_],
+      pipeline_buffer_.size() - pipeline_received_));
+    length = getEncapsulationLength(&pipeline_buffer_[0], pipeline_received_);
+  }
+
+  // the packet is consumed even if it cannot be decoded, to stay in step with the stream
+  MessageRouterReply reply;
+  try
+  {
+    if (explicit_open_)
     {
-      // no return
-      ls->ranges[i] = DISTANCE_MAX;
+      EIP_UINT sequence_count;
+      reply = decodeSendUnitDataReply(&pipeline_buffer_[0], length, explicit_t_to_o_id_,
+        &sequence_count);
+      sender_context = sequence_count;
     }
     else
     {
-      ls->ranges[i] = mr.measurement_data[i] / 1000.0;
+      reply = decodeSendRRDataReply(&pipeline_buffer_[0], length, sender_context);
     }
   }
+  catch (std::exception& ex)
+  {
+    pipeline_received_ -= length;
+    memmove(&pipeline_buffer_[0], &pipeline_buffer_[length], pipeline_received_);
+    throw;
+  }
+  pipeline_received_ -= length;
+  memmove(&pipeline_buffer_[0], &pipeline_buffer_[length], pipeline_received_);
+
+  if (reply.general_status)
+  {
+    return false;
+  }
+  BufferReader reader(buffer(reply.data));
+  rr.deserialize(reader, reply.data.size());
+  return true;
 }
 
 void OS32C::sendMeasurmentReportConfigUDP()
 {
-  // TODO: check that connection is valid
-  CPFPacket pkt;
-  shared_ptr<SequencedAddressItem> address =
-    make_shared<SequencedAddressItem>(
-      getConnection(connection_num_).o_to_t_connection_id, mrc_sequence_num_++);
-  shared_ptr<MeasurementReportConfig> data = make_shared<MeasurementReportConfig>();
-  *data = mrc_;
-  pkt.getItems().push_back(CPFItem(0x8002, address));
-  pkt.getItems().push_back(CPFItem(0x00B1, data));
-  sendIOPacket(pkt);
+  if (connection_num_ < 0)
+  {
+    throw std::logic_error("UDP IO has not been started");
+  }
+  size_t size = encodeMeasurementReportConfig(mrc_, o_to_t_connection_id_, mrc_sequence_num_++,
+    &io_send_buffer_[0], io_send_buffer_.size());
+  report_socket_->send(buffer(&io_send_buffer_[0], size));
+}
+
+void OS32C::sendKeepaliveUDP()
+{
+  if (io_params_.mode == IO_CONNECTION_OWNER)
+  {
+    sendMeasurmentReportConfigUDP();
+    return;
+  }
+  if (connection_num_ < 0)
+  {
+    throw std::logic_error("UDP IO has not been started");
+  }
+  size_t size = encodeHeartbeat(o_to_t_connection_id_, mrc_sequence_num_++,
+    &io_send_buffer_[0], io_send_buffer_.size());
+  report_socket_->send(buffer(&io_send_buffer_[0], size));
 }
 
 MeasurementReport OS32C::receiveMeasurementReportUDP()
@@ -261,17 +408,287 @@ MeasurementReport OS32C::receiveMeasurementReportUDP()
   return data;
 }
 
-void OS32C::startUDPIO()
+void OS32C::receiveMeasurementReportUDP(MeasurementReport& report)
+{
+  DECODE_STATUS status = tryReceiveMeasurementReportUDP(report);
+  if (status != DECODE_OK)
+  {
+    throw std::logic_error(decodeStatusString(status));
+  }
+}
+
+bool OS32C::receiveMeasurementReportUDP(LatestMeasurementReport& latest)
 {
-  EIP_CONNECTION_INFO_T o_to_t, t_to_o;
-  o_to_t.assembly_id = 0x71;
-  o_to_t.buffer_size = 0x006E;
-  o_to_t.rpi = 0x00177FA0;
-  t_to_o.assembly_id = 0x66;
-  t_to_o.buffer_size = 0x0584;
-  t_to_o.rpi = 0x00013070;
+  MeasurementReport* slot = latest.beginWrite();
+  if (!slot)
+  {
+    // still take the packet off the socket, without keeping it
+    MeasurementReport dropped;
+    receiveMeasurementReportUDP(dropped);
+    return false;
+  }
+  // decodes straight into the slot, which is only published once it is complete
+  receiveMeasurementReportUDP(*slot);
+  latest.publish();
+  return true;
+}
+
+DECODE_STATUS OS32C::tryReceiveMeasurementReportUDP(MeasurementReport& report)
+{
+  size_t size = report_socket_->receive(buffer(io_buffer_));
+  return decodeMeasurementReport(&io_buffer_[0], size, report);
+}
+
+void OS32C::startUDPIO(const IOConnectionParams& params)
+{
+  startUDPIO(vector<IOConnectionParams>(1, params));
+}
+
+size_t OS32C::startUDPIO(const vector<IOConnectionParams>& candidates)
+{
+  if (candidates.empty())
+  {
+    throw std::invalid_argument("No IO connection parameters to try");
+  }
+  for (size_t i = 0; i < candidates.size(); ++i)
+  {
+    candidates[i].validate();
+  }
+
+  for (size_t i = 0; ; ++i)
+  {
+    const IOConnectionParams& params = candidates[i];
+    EIP_CONNECTION_INFO_T o_to_t, t_to_o;
+    o_to_t.assembly_id = params.o_to_t_assembly_id;
+    o_to_t.buffer_size = params.o_to_t_buffer_size;
+    o_to_t.rpi = params.o_to_t_rpi;
+    t_to_o.assembly_id = params.t_to_o_assembly_id;
+    t_to_o.buffer_size = params.t_to_o_buffer_size;
+    t_to_o.rpi = params.t_to_o_rpi;
+
+    try
+    {
+      if (params.mode == IO_CONNECTION_OWNER && !params.t_to_o_multicast)
+      {
+        connection_num_ = createConnection(o_to_t, t_to_o);
+        o_to_t_connection_id_ = getConnection(connection_num_).o_to_t_connection_id;
+        own_connection_ = false;
+      }
+      else
+      {
+        openConnection(params);
+      }
+    }
+    catch (std::runtime_error& ex)
+    {
+      // rejected by the scanner, so fall back to the next if there is one
+      if (i + 1 == candidates.size())
+      {
+        throw;
+      }
+      continue;
+    }
+    io_params_ = params;
+    return i;
+  }
+}
+
+ForwardOpenReply OS32C::sendForwardOpen(shared_ptr<LargeForwardOpenRequest> req)
+{
+  std::random_device rng;
+  if (!originator_sn_)
+  {
+    originator_sn_ = rng() | 1;
+  }
+  req->connection_sn = rng();
+  req->originator_vendor_id = ORIGINATOR_VENDOR_ID;
+  req->originator_sn = originator_sn_;
+
+  RRDataResponse resp_data = sendRRDataCommand(0x5B, Path(0x06, 1), req);
+  ForwardOpenReply reply;
+  resp_data.getResponseDataAs(reply);
+  if (reply.connection_sn != req->connection_sn || reply.originator_sn != originator_sn_)
+  {
+    throw std::logic_error("Forward Open reply is for a different connection");
+  }
+  return reply;
+}
+
+void OS32C::sendForwardClose(EIP_UINT connection_sn, const vector<EIP_BYTE>& path)
+{
+  shared_ptr<ForwardCloseRequest> req = make_shared<ForwardCloseRequest>();
+  req->connection_sn = connection_sn;
+  req->originator_vendor_id = ORIGINATOR_VENDOR_ID;
+  req->originator_sn = originator_sn_;
+  req->path = path;
+  sendRRDataCommand(0x4E, Path(0x06, 1), req);
+}
 
-  connection_num_ = createConnection(o_to_t, t_to_o);
+void OS32C::openConnection(const IOConnectionParams& params)
+{
+  shared_ptr<LargeForwardOpenRequest> req = make_shared<LargeForwardOpenRequest>();
+  // the target chooses the ID of a multicast T->O, the originator that of a point to point one
+  req->t_to_o_connection_id = params.t_to_o_multicast ? 0 : std::random_device()() | 1;
+  req->o_to_t_rpi = params.o_to_t_rpi;
+  req->o_to_t_conn_params = LargeForwardOpenRequest::calcConnectionParams(
+    params.o_to_t_buffer_size, false, CONNECTION_PRIORITY_SCHEDULED, CONNECTION_TYPE_P2P, false);
+  req->t_to_o_rpi = params.t_to_o_rpi;
+  req->t_to_o_conn_params = LargeForwardOpenRequest::calcConnectionParams(
+    params.t_to_o_buffer_size, false, CONNECTION_PRIORITY_SCHEDULED,
+    params.t_to_o_multicast ? CONNECTION_TYPE_MULTICAST : CONNECTION_TYPE_P2P, false);
+  req->path = getAssemblyConnectionPath(params.config_assembly_id, params.o_to_t_assembly_id,
+    params.t_to_o_assembly_id);
+
+  ForwardOpenReply reply = sendForwardOpen(req);
+  o_to_t_connection_id_ = reply.o_to_t_connection_id;
+  connection_sn_ = req->connection_sn;
+  own_connection_ = true;
+  // only marks UDP IO as started, as the session does not know of the connection
+  connection_num_ = 0;
+}
+
+void OS32C::stopUDPIO()
+{
+  if (connection_num_ < 0)
+  {
+    return;
+  }
+  // stopped first, so that a failed close is not retried on a dead session
+  int connection_num = connection_num_;
+  bool own_connection = own_connection_;
+  connection_num_ = -1;
+  own_connection_ = false;
+  if (own_connection)
+  {
+    sendForwardClose(connection_sn_, getAssemblyConnectionPath(io_params_.config_assembly_id,
+      io_params_.o_to_t_assembly_id, io_params_.t_to_o_assembly_id));
+  }
+  else
+  {
+    closeConnection(connection_num);
+  }
+}
+
+void OS32C::openExplicitConnection(EIP_UDINT rpi)
+{
+  shared_ptr<LargeForwardOpenRequest> req = make_shared<LargeForwardOpenRequest>();
+  req->t_to_o_connection_id = std::random_device()() | 1;
+  req->o_to_t_rpi = rpi;
+  req->o_to_t_conn_params = LargeForwardOpenRequest::calcConnectionParams(
+    EXPLICIT_CONNECTION_SIZE, true, CONNECTION_PRIORITY_LOW, CONNECTION_TYPE_P2P, false);
+  req->t_to_o_rpi = rpi;
+  req->t_to_o_conn_params = req->o_to_t_conn_params;
+  // server, application object triggered, Class 3
+  req->trigger = 0xA3;
+  req->path = getMessageRouterPath();
+
+  ForwardOpenReply reply = sendForwardOpen(req);
+  explicit_o_to_t_id_ = reply.o_to_t_connection_id;
+  explicit_t_to_o_id_ = req->t_to_o_connection_id;
+  explicit_connection_sn_ = req->connection_sn;
+  explicit_sequence_ = 0;
+  explicit_open_ = true;
+}
+
+void OS32C::closeExplicitConnection()
+{
+  if (!explicit_open_)
+  {
+    return;
+  }
+  // closed first, so that the Forward Close goes unconnected even if it fails
+  explicit_open_ = false;
+  sendForwardClose(explicit_connection_sn_, getMessageRouterPath());
+}
+
+vector<EIP_BYTE> OS32C::getMessageRouterPath()
+{
+  EIP_BYTE path[] = { 0x20, 0x02, 0x24, 0x01 };
+  return vector<EIP_BYTE>(path, path + sizeof(path));
+}
+
+size_t OS32C::receiveExplicitReply()
+{
+  // the reply may arrive in more than one read from the TCP stream
+  size_t received = 0;
+  size_t length = 0;
+  while (!length || received < length)
+  {
+    if (received == explicit_buffer_.size())
+    {
+      throw std::length_error("Reply to an explicit request is too long");
+    }
+    received += explicit_socket_->receive(buffer(&explicit_buffer_[received],
+      explicit_buffer_.size() - received));
+    length = getEncapsulationLength(&explicit_buffer_[0], received);
+  }
+  return received;
+}
+
+MessageRouterReply OS32C::sendExplicitRequest(EIP_USINT service, const Path& path,
+  const Serializable* data)
+{
+  if (!explicit_open_)
+  {
+    size_t size = encodeSendRRData(getSessionID(), 0, service, path, data,
+      &explicit_buffer_[0], explicit_buffer_.size());
+    explicit_socket_->send(buffer(&explicit_buffer_[0], size));
+    uint64_t sender_context;
+    return decodeSendRRDataReply(&explicit_buffer_[0], receiveExplicitReply(), sender_context);
+  }
+
+  EIP_UINT sequence_count = ++explicit_sequence_;
+  try
+  {
+    size_t size = encodeSendUnitData(getSessionID(), explicit_o_to_t_id_, sequence_count,
+      service, path, data, &explicit_buffer_[0], explicit_buffer_.size());
+    explicit_socket_->send(buffer(&explicit_buffer_[0], size));
+    return decodeSendUnitDataReply(&explicit_buffer_[0], receiveExplicitReply(),
+      explicit_t_to_o_id_, sequence_count);
+  }
+  catch (std::exception& ex)
+  {
+    // the connection can no longer be trusted, so go back to unconnected requests
+    explicit_open_ = false;
+    throw;
+  }
+}
+
+MessageRouterReply OS32C::sendConnectedRequest(EIP_USINT service, const Path& path,
+  const Serializable* data)
+{
+  MessageRouterReply reply = sendExplicitRequest(service, path, data);
+  if (reply.general_status)
+  {
+    std::ostringstream msg;
+    msg << "Connected request failed with status 0x" << std::hex << (int)reply.general_status;
+    throw std::runtime_error(msg.str());
+  }
+  return reply;
+}
+
+void OS32C::getAttributeSerializable(EIP_USINT class_id, EIP_USINT instance_id,
+  EIP_USINT attribute_id, Serializable& result)
+{
+  if (!explicit_open_)
+  {
+    getSingleAttributeSerializable(class_id, instance_id, attribute_id, result);
+    return;
+  }
+  MessageRouterReply reply = sendConnectedRequest(0x0E, Path(class_id, instance_id, attribute_id));
+  BufferReader reader(buffer(reply.data));
+  result.deserialize(reader, reply.data.size());
+}
+
+void OS32C::setAttributeSerializable(EIP_USINT class_id, EIP_USINT instance_id,
+  EIP_USINT attribute_id, shared_ptr<Serializable> data)
+{
+  if (!explicit_open_)
+  {
+    setSingleAttributeSerializable(class_id, instance_id, attribute_id, data);
+    return;
+  }
+  sendConnectedRequest(0x10, Path(class_id, instance_id, attribute_id), data.get());
 }
 
 } // namespace os32c
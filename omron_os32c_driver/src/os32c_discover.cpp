@@ -0,0 +1,81 @@
+/**
+Software License Agreement (BSD)
+
+\file      os32c_discover.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <cstdlib>
+#include <iostream>
+#include <stdexcept>
+
+#include "omron_os32c_driver/discovery.h"
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using namespace omron_os32c_driver;
+
+/**
+ * Command line tool to list the OS32C scanners on a network, for finding
+ * their addresses and serial numbers when commissioning.
+ * Usage: os32c_discover [targets] [timeout]
+ * Targets are addresses and subnets separated by commas, by default the
+ * local broadcast address. Timeout is in seconds.
+ */
+int main(int argc, char *argv[])
+{
+  string targets = argc > 1 ? argv[1] : "255.255.255.255";
+  double timeout = argc > 2 ? atof(argv[2]) : 0.5;
+  if (argc > 3 || timeout <= 0)
+  {
+    cerr << "Usage: " << argv[0] << " [targets] [timeout]" << endl;
+    cerr << "  targets: addresses and subnets separated by commas, "
+      << "e.g. 192.168.1.0/24 (default 255.255.255.255)" << endl;
+    cerr << "  timeout: time to wait for replies in seconds (default 0.5)" << endl;
+    return 1;
+  }
+
+  vector<CIPIdentity> scanners;
+  try
+  {
+    scanners = discoverScanners(parseDiscoveryTargets(targets), timeout);
+  }
+  catch (std::exception& ex)
+  {
+    cerr << "Discovery failed: " << ex.what() << endl;
+    return 1;
+  }
+
+  for (size_t i = 0; i < scanners.size(); ++i)
+  {
+    cout << scanners[i].address << "\tserial " << scanners[i].serial_number
+      << "\t" << scanners[i].product_name
+      << "\trevision " << (int)scanners[i].revision_major << "." << (int)scanners[i].revision_minor
+      << endl;
+  }
+  if (scanners.empty())
+  {
+    cerr << "No OS32C scanners found" << endl;
+    return 1;
+  }
+  return 0;
+}
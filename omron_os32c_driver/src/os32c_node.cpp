@@ -24,23 +24,640 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 */
 
 
+#include <iomanip>
+#include <limits>
+#include <sstream>
 #include <ros/ros.h>
+#include <boost/bind.hpp>
 #include <boost/shared_ptr.hpp>
 #include <sensor_msgs/LaserScan.h>
 
-#include "odva_ethernetip/socket/tcp_socket.h"
-#include "odva_ethernetip/socket/udp_socket.h"
+#include "omron_os32c_driver/beam_statistics.h"
+#include "omron_os32c_driver/config_cache.h"
+#include "omron_os32c_driver/connection_supervisor.h"
+#include "omron_os32c_driver/discovery.h"
 #include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/BeamHealth.h"
+#include "omron_os32c_driver/CompactScan.h"
+#include "omron_os32c_driver/Reflectors.h"
+#include "omron_os32c_driver/SafetyState.h"
+#include "omron_os32c_driver/SectorRanges.h"
+#include "omron_os32c_driver/laserscan_serialization.h"
 #include "omron_os32c_driver/range_and_reflectance_measurement.h"
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/reflector_detector.h"
+#include "omron_os32c_driver/reflectivity_calibration.h"
+#include "omron_os32c_driver/ros_conversions.h"
+#include "omron_os32c_driver/rr_scan_poller.h"
+#include "omron_os32c_driver/safety_state.h"
+#include "omron_os32c_driver/sector_minima.h"
+#include "omron_os32c_driver/scan_stream.h"
+#include "omron_os32c_driver/timed_tcp_socket.h"
+#include "omron_os32c_driver/udp_io_socket.h"
 
 using std::cout;
 using std::endl;
 using boost::shared_ptr;
 using sensor_msgs::LaserScan;
-using eip::socket::TCPSocket;
-using eip::socket::UDPSocket;
 using namespace omron_os32c_driver;
 
+/**
+ * Apply the opt-in real-time settings to the calling thread and process,
+ * reporting the outcome of each. Failures are reported but not fatal, so
+ * the driver still runs with whatever could be applied.
+ */
+static void configureRealtime(int priority, const string& cpu_affinity, bool lock_memory)
+{
+  if (lock_memory)
+  {
+    try
+    {
+      lockMemory();
+      ROS_INFO_STREAM("Real-time: locked process memory");
+    }
+    catch (std::runtime_error& ex)
+    {
+      ROS_ERROR_STREAM("Real-time: " << ex.what());
+    }
+  }
+
+  if (!cpu_affinity.empty())
+  {
+    try
+    {
+      setCpuAffinity(parseCpuList(cpu_affinity));
+      ROS_INFO_STREAM("Real-time: pinned driver thread to CPUs " << cpu_affinity);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_STREAM("Real-time: " << ex.what());
+    }
+  }
+
+  if (priority > 0)
+  {
+    try
+    {
+      setRealtimePriority(priority);
+      ROS_INFO_STREAM("Real-time: running driver thread with SCHED_FIFO priority " << priority);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_STREAM("Real-time: " << ex.what());
+    }
+  }
+}
+
+/**
+ * Apply the optional socket options for the IO connection, reporting the
+ * outcome of each. Kernel drop counting is always enabled. Failures are
+ * reported but not fatal.
+ */
+static void configureIOSocket(UDPIOSocket& io_socket, int receive_buffer_size, int busy_poll,
+  int priority, int dscp)
+{
+  try
+  {
+    io_socket.enableDropCounting();
+  }
+  catch (std::runtime_error& ex)
+  {
+    ROS_WARN_STREAM("IO socket: " << ex.what());
+  }
+
+  if (receive_buffer_size > 0)
+  {
+    try
+    {
+      int actual = io_socket.setReceiveBufferSize(receive_buffer_size);
+      ROS_INFO_STREAM("IO socket: receive buffer is " << actual << " bytes");
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_STREAM("IO socket: " << ex.what());
+    }
+  }
+
+  if (busy_poll > 0)
+  {
+    try
+    {
+      io_socket.setBusyPoll(busy_poll);
+      ROS_INFO_STREAM("IO socket: busy polling for " << busy_poll << " us");
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_STREAM("IO socket: " << ex.what());
+    }
+  }
+
+  if (priority >= 0)
+  {
+    try
+    {
+      io_socket.setPriority(priority);
+      ROS_INFO_STREAM("IO socket: sending with priority " << priority);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_STREAM("IO socket: " << ex.what());
+    }
+  }
+
+  if (dscp >= 0)
+  {
+    try
+    {
+      io_socket.setDSCP(dscp);
+      ROS_INFO_STREAM("IO socket: sending with DSCP " << dscp);
+    }
+    catch (std::exception& ex)
+    {
+      ROS_ERROR_STREAM("IO socket: " << ex.what());
+    }
+  }
+}
+
+/**
+ * Save the config cache if it changed. Done between scans rather than as
+ * each one is received, so that a cache that cannot be written is reported
+ * without dropping the connection.
+ */
+static void saveConfigCache(ConfigCache* cache)
+{
+  if (!cache || !cache->isDirty())
+  {
+    return;
+  }
+  try
+  {
+    cache->save();
+  }
+  catch (std::runtime_error& ex)
+  {
+    ROS_WARN_STREAM("Could not save config cache: " << ex.what());
+  }
+}
+
+/**
+ * Keeps per-beam statistics of the scans received and publishes a summary of
+ * them every interval, warning of any beams or sectors flagged
+ */
+class BeamHealthReporter
+{
+public:
+  BeamHealthReporter(ros::NodeHandle& nh, double interval, int sector_beams,
+    const BeamStatisticsThresholds& thresholds, const string& frame_id)
+    : interval_(interval), stats_(sector_beams), thresholds_(thresholds),
+      last_summary_(ros::WallTime::now())
+  {
+    if (interval_ > 0)
+    {
+      pub_ = nh.advertise<BeamHealth>("beam_health", 1, true);
+    }
+    msg_.header.frame_id = frame_id;
+  }
+
+  /**
+   * Add a scan to the statistics, publishing the summary if it is due
+   */
+  void add(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams,
+    double start_angle)
+  {
+    if (interval_ <= 0)
+    {
+      return;
+    }
+    stats_.update(ranges, reflectance, num_beams, OS32C::calcBeamNumber(start_angle));
+
+    ros::WallTime now = ros::WallTime::now();
+    if ((now - last_summary_).toSec() < interval_)
+    {
+      return;
+    }
+    last_summary_ = now;
+    BeamStatisticsSummary summary = stats_.summarize(thresholds_);
+    convertToBeamHealth(summary, &msg_);
+    msg_.header.stamp = ros::Time::now();
+    msg_.header.seq++;
+    pub_.publish(msg_);
+    if (!summary.flagged_beams.empty())
+    {
+      ROS_WARN_STREAM("Beam statistics over " << summary.scans << " scans flagged "
+        << summary.flagged_beams.size() << " beams and " << summary.flagged_sectors.size()
+        << " sectors, check the window for contamination");
+    }
+  }
+
+private:
+  double interval_;
+  BeamStatistics stats_;
+  BeamStatisticsThresholds thresholds_;
+  ros::WallTime last_summary_;
+  ros::Publisher pub_;
+  BeamHealth msg_;
+};
+
+/**
+ * Publishes the nearest return in each of a few near equal sectors of every
+ * scan, as a message far smaller than the scan itself
+ */
+class SectorRangesPublisher
+{
+public:
+  SectorRangesPublisher(ros::NodeHandle& nh, int count, const string& frame_id)
+    : count_(count), num_beams_(0)
+  {
+    if (count_ > 0)
+    {
+      pub_ = nh.advertise<SectorRanges>("sector_ranges", 1);
+      minima_.resize(count_);
+      msg_.angle_starts.resize(count_);
+      msg_.ranges.resize(count_);
+      msg_.bearings.resize(count_);
+    }
+    msg_.header.frame_id = frame_id;
+  }
+
+  /**
+   * Publish the nearest returns of a scan
+   */
+  void publish(const EIP_UINT* ranges, size_t num_beams, double start_angle,
+    double angle_increment, const ros::Time& stamp)
+  {
+    if (count_ <= 0)
+    {
+      return;
+    }
+    if (num_beams < static_cast<size_t>(count_))
+    {
+      ROS_WARN_STREAM_THROTTLE(1, "Scan has fewer beams than the " << count_
+        << " sectors to find the nearest return in");
+      return;
+    }
+    // the sectors only change with the beam selection
+    if (num_beams != num_beams_)
+    {
+      sectors_ = splitSectors(num_beams, count_);
+      num_beams_ = num_beams;
+    }
+    findSectorMinima(ranges, sectors_, &minima_[0]);
+
+    // the edges fall between the beams that split the sectors
+    for (int i = 0; i < count_; ++i)
+    {
+      msg_.angle_starts[i] = start_angle + (sectors_[i].first_beam - 0.5) * angle_increment;
+    }
+    msg_.angle_end = start_angle + (num_beams - 0.5) * angle_increment;
+    for (int i = 0; i < count_; ++i)
+    {
+      if (minima_[i].beam < 0)
+      {
+        msg_.ranges[i] = std::numeric_limits<float>::infinity();
+        msg_.bearings[i] = std::numeric_limits<float>::quiet_NaN();
+        continue;
+      }
+      msg_.ranges[i] = minima_[i].range / 1000.0;
+      msg_.bearings[i] = start_angle + minima_[i].beam * angle_increment;
+    }
+    msg_.header.stamp = stamp;
+    msg_.header.seq++;
+    pub_.publish(msg_);
+  }
+
+private:
+  int count_;
+  size_t num_beams_;
+  vector<BeamSector> sectors_;
+  vector<SectorMinimum> minima_;
+  ros::Publisher pub_;
+  SectorRanges msg_;
+};
+
+/**
+ * Publishes the retro-reflective landmarks found in every scan with
+ * reflectance
+ */
+class ReflectorPublisher
+{
+public:
+  /**
+   * @throw std::invalid_argument if the detection parameters are out of range
+   */
+  ReflectorPublisher(ros::NodeHandle& nh, bool enabled, const ReflectorDetectorParams& params,
+    const string& frame_id)
+    : enabled_(enabled), detector_(params)
+  {
+    if (enabled_)
+    {
+      pub_ = nh.advertise<Reflectors>("reflectors", 1);
+      reflectors_.reserve(BEAM_COUNT);
+    }
+    msg_.header.frame_id = frame_id;
+  }
+
+  /**
+   * Find and publish the reflectors in a scan
+   */
+  void publish(const EIP_UINT* ranges, const EIP_UINT* reflectance, size_t num_beams,
+    double start_angle, const ros::Time& stamp)
+  {
+    if (!enabled_)
+    {
+      return;
+    }
+    detector_.detect(ranges, reflectance, num_beams, OS32C::calcBeamNumber(start_angle),
+      &reflectors_);
+    convertToReflectors(reflectors_, &msg_);
+    msg_.header.stamp = stamp;
+    msg_.header.seq++;
+    pub_.publish(msg_);
+  }
+
+private:
+  bool enabled_;
+  ReflectorDetector detector_;
+  vector<Reflector> reflectors_;
+  ros::Publisher pub_;
+  Reflectors msg_;
+};
+
+/**
+ * Settings for polling scans with pipelined explicit requests
+ */
+struct PollOptions
+{
+  string host;
+  double start_angle;
+  double end_angle;
+  ConfigCache* config_cache;
+  double rate;
+  int window;
+  double request_timeout;
+  bool connected_messaging;
+  double reconnect_backoff_initial;
+  double reconnect_backoff_max;
+  int realtime_priority;
+  string cpu_affinity;
+  bool lock_memory;
+  bool prefault_buffers;
+  double stats_report_interval;
+};
+
+/**
+ * Where polled scans, and everything derived from them, are published
+ */
+struct ScanOutputs
+{
+  string frame_id;
+  const ReflectivityCalibration* calibration;
+  ros::Publisher laserscan_pub;
+  bool publish_compact;
+  ros::Publisher compact_pub;
+  ros::Publisher safety_pub;
+  BeamHealthReporter* beam_health;
+  SectorRangesPublisher* sector_ranges;
+  ReflectorPublisher* reflectors;
+};
+
+/**
+ * Publish scans polled with pipelined explicit requests rather than received
+ * over UDP IO, for scanners whose firmware only gives range and reflectance
+ * over explicit messaging. Runs until shutdown.
+ * @return exit code of the node
+ */
+static int pollRRScans(const PollOptions& options, ScanOutputs& outputs)
+{
+  sensor_msgs::LaserScan laserscan_msg;
+  CompactScan compact_msg;
+  SafetyState safety_msg;
+  safety_msg.header.frame_id = outputs.frame_id;
+  SafetyStateMonitor safety_monitor;
+
+  // worst case time between receiving a scan and finishing its publication
+  LatencyStats latency;
+
+  boost::asio::io_service io_service;
+  RRScanPoller poller(io_service, options.host,
+    [&](const RangeAndReflectanceMeasurement& rr, uint64_t receive_time_ns)
+  {
+    ros::Time receive_time = ros::Time::now()
+      - ros::Duration((monotonicNanoseconds() - receive_time_ns) / 1e9);
+    double start_angle = poller.getOS32C().getStartAngle();
+
+    if (safety_monitor.update(rr.header))
+    {
+      convertToSafetyState(safety_monitor.getState(), rr.header.scan_count, &safety_msg);
+      safety_msg.header.stamp = receive_time;
+      safety_msg.header.seq++;
+      outputs.safety_pub.publish(safety_msg);
+    }
+
+    outputs.sector_ranges->publish(&rr.range_data[0], rr.header.num_beams, start_angle,
+      -OS32C::ANGLE_INC, receive_time);
+    outputs.reflectors->publish(&rr.range_data[0], &rr.reflectance_data[0], rr.header.num_beams,
+      start_angle, receive_time);
+
+    convertToLaserScan(rr, &laserscan_msg, outputs.calibration);
+    laserscan_msg.header.stamp = receive_time;
+    laserscan_msg.header.seq++;
+    outputs.laserscan_pub.publish(laserscan_msg);
+    if (outputs.publish_compact)
+    {
+      convertToCompactScan(rr, &compact_msg);
+      compact_msg.header.stamp = laserscan_msg.header.stamp;
+      compact_msg.header.seq = laserscan_msg.header.seq;
+      outputs.compact_pub.publish(compact_msg);
+    }
+    latency.add(monotonicNanoseconds() - receive_time_ns);
+    outputs.beam_health->add(&rr.range_data[0], &rr.reflectance_data[0], rr.header.num_beams,
+      start_angle);
+  });
+
+  try
+  {
+    poller.setConfiguration(options.start_angle, options.end_angle, options.config_cache);
+    poller.setPolling(options.rate, std::max(options.window, 0));
+    poller.setBackoff(options.reconnect_backoff_initial, options.reconnect_backoff_max, 0.2);
+    poller.setRequestTimeout(options.request_timeout);
+    poller.setConnectedMessaging(options.connected_messaging);
+    poller.connect();
+    if (poller.getOS32C().isExplicitConnectionOpen())
+    {
+      ROS_INFO_STREAM("Sensor configured, polling scans over a Class 3 connection");
+    }
+    else
+    {
+      ROS_INFO_STREAM("Sensor configured, polling scans with up to " << options.window
+        << " requests in flight");
+    }
+  }
+  catch (std::invalid_argument ex)
+  {
+    ROS_FATAL_STREAM("Invalid arguments in sensor configuration: " << ex.what());
+    return -1;
+  }
+  catch (std::runtime_error ex)
+  {
+    ROS_FATAL_STREAM("Could not configure sensor: " << ex.what());
+    return -1;
+  }
+
+  auto updateStaticConfig = [&]()
+  {
+    OS32C& os32c = poller.getOS32C();
+    fillLaserScanStaticConfig(os32c, &laserscan_msg);
+    laserscan_msg.header.frame_id = outputs.frame_id;
+    fillCompactScanStaticConfig(os32c, &compact_msg);
+    compact_msg.header.frame_id = outputs.frame_id;
+  };
+  updateStaticConfig();
+  int reconnects = 0;
+  int config_changes = 0;
+
+  configureRealtime(options.realtime_priority, options.cpu_affinity, options.lock_memory);
+  if (options.prefault_buffers)
+  {
+    // size everything touched per scan for the largest possible scan
+    int max_beams = OS32C::calcBeamNumber(OS32C::ANGLE_MIN) + 1;
+    poller.prefaultBuffers();
+    prefault(laserscan_msg.ranges, max_beams);
+    prefault(laserscan_msg.intensities, max_beams);
+    prefault(compact_msg.ranges, max_beams);
+    prefaultStack();
+    ROS_INFO_STREAM("Real-time: pre-faulted scan buffers for " << max_beams << " beams");
+  }
+
+  ros::WallTime last_stats_report = ros::WallTime::now();
+
+  while (ros::ok())
+  {
+    try
+    {
+      // wait no longer than this for a request to fall due, so that ROS
+      // callbacks and shutdown are serviced between slow polls
+      RRScanPoller::SpinResult result = poller.spinOnce(0.1);
+      saveConfigCache(options.config_cache);
+      if (poller.getReconnects() != reconnects && poller.isConnected())
+      {
+        // before the first scan of the new connection is published
+        reconnects = poller.getReconnects();
+        updateStaticConfig();
+        ROS_INFO_STREAM("Reconnected to sensor, polling scans again");
+      }
+      if (poller.getConfigChanges() != config_changes)
+      {
+        ROS_WARN_STREAM("Sensor config checksums changed, config cache invalidated");
+        config_changes = poller.getConfigChanges();
+      }
+      if (result == RRScanPoller::REQUEST_REJECTED)
+      {
+        ROS_WARN_STREAM_THROTTLE(1, "Sensor rejected the request for a range and reflectance scan");
+      }
+      else if (result == RRScanPoller::MALFORMED_REPLY)
+      {
+        ROS_ERROR_STREAM("Problem parsing return data: " << poller.getLastError());
+      }
+      else if (result == RRScanPoller::DISCONNECTED)
+      {
+        ROS_WARN_STREAM_THROTTLE(1, "Lost connection to sensor, reconnecting: "
+          << poller.getLastError());
+      }
+      else if (result == RRScanPoller::SCAN_RECEIVED && options.stats_report_interval > 0 &&
+        (ros::WallTime::now() - last_stats_report).toSec() > options.stats_report_interval)
+      {
+        ROS_INFO_STREAM("Receive to publish latency over " << latency.getCount() << " scans: mean "
+          << latency.getMean() / 1000 << " us, max " << latency.getMax() / 1000 << " us; "
+          << poller.getPipeline().getStaleReplies() << " stale replies dropped since connecting, "
+          << poller.getReconnects() << " reconnects");
+        latency.reset();
+        last_stats_report = ros::WallTime::now();
+      }
+    }
+    catch (std::runtime_error ex)
+    {
+      ROS_ERROR_STREAM("Exception caught publishing scan data: " << ex.what());
+    }
+    catch (std::logic_error ex)
+    {
+      ROS_ERROR_STREAM("Problem parsing return data: " << ex.what());
+    }
+
+    ros::spinOnce();
+  }
+
+  try
+  {
+    poller.close();
+  }
+  catch (std::exception& ex)
+  {
+    ROS_WARN_STREAM("Could not close the session: " << ex.what());
+  }
+  return 0;
+}
+
+/**
+ * Read the parameters of the Forward Open, defaulting to those the driver has
+ * always used. The RPIs are in microseconds, as in the Forward Open itself.
+ * @throw std::invalid_argument if a parameter does not fit its field
+ */
+static IOConnectionParams readIOConnectionParams()
+{
+  IOConnectionParams params;
+  string mode;
+  ros::param::param<std::string>("~io_connection_mode", mode, "owner");
+  if (mode == "input_only")
+  {
+    params.setMode(IO_CONNECTION_INPUT_ONLY);
+  }
+  else if (mode == "listen_only")
+  {
+    params.setMode(IO_CONNECTION_LISTEN_ONLY);
+  }
+  else if (mode != "owner")
+  {
+    throw std::invalid_argument("IO connection mode must be owner, input_only or listen_only");
+  }
+
+  int o_to_t_rpi, t_to_o_rpi, o_to_t_buffer_size, t_to_o_buffer_size;
+  int o_to_t_assembly_id, t_to_o_assembly_id, config_assembly_id;
+  ros::param::param<int>("~o_to_t_rpi_us", o_to_t_rpi, params.o_to_t_rpi);
+  ros::param::param<int>("~t_to_o_rpi_us", t_to_o_rpi, params.t_to_o_rpi);
+  ros::param::param<int>("~o_to_t_buffer_size", o_to_t_buffer_size, params.o_to_t_buffer_size);
+  ros::param::param<int>("~t_to_o_buffer_size", t_to_o_buffer_size, params.t_to_o_buffer_size);
+  ros::param::param<int>("~o_to_t_assembly_id", o_to_t_assembly_id, params.o_to_t_assembly_id);
+  ros::param::param<int>("~t_to_o_assembly_id", t_to_o_assembly_id, params.t_to_o_assembly_id);
+  ros::param::param<int>("~config_assembly_id", config_assembly_id, params.config_assembly_id);
+  ros::param::param<int>("~io_timeout_multiplier", params.timeout_multiplier,
+    params.timeout_multiplier);
+  ros::param::param<bool>("~t_to_o_multicast", params.t_to_o_multicast, params.t_to_o_multicast);
+
+  if (o_to_t_rpi < 0 || t_to_o_rpi < 0)
+  {
+    throw std::invalid_argument("RPIs must not be negative");
+  }
+  if (o_to_t_buffer_size < 0 || o_to_t_buffer_size > 0xFFFF
+    || t_to_o_buffer_size < 0 || t_to_o_buffer_size > 0xFFFF)
+  {
+    throw std::invalid_argument("IO buffer sizes must fit in 16 bits");
+  }
+  if (o_to_t_assembly_id < 0 || o_to_t_assembly_id > 0xFF
+    || t_to_o_assembly_id < 0 || t_to_o_assembly_id > 0xFF
+    || config_assembly_id < 0 || config_assembly_id > 0xFF)
+  {
+    throw std::invalid_argument("Assembly IDs must fit in 8 bits");
+  }
+  params.o_to_t_rpi = o_to_t_rpi;
+  params.t_to_o_rpi = t_to_o_rpi;
+  params.o_to_t_buffer_size = o_to_t_buffer_size;
+  params.t_to_o_buffer_size = t_to_o_buffer_size;
+  params.o_to_t_assembly_id = o_to_t_assembly_id;
+  params.t_to_o_assembly_id = t_to_o_assembly_id;
+  params.config_assembly_id = config_assembly_id;
+  return params;
+}
+
 int main(int argc, char *argv[])
 {
   ros::init(argc, argv, "os32c");
@@ -49,45 +666,330 @@ int main(int argc, char *argv[])
   // get sensor config from params
   string host, frame_id;
   double start_angle, end_angle;
+  bool publish_compact;
+  int realtime_priority;
+  string cpu_affinity;
+  bool lock_memory, prefault_buffers;
+  double stats_report_interval;
+  int io_receive_buffer_size, io_busy_poll, io_priority, io_dscp;
+  string config_cache_path;
+  EIP_UDINT serial_number = 0;
+  string discovery_targets;
+  double discovery_timeout;
+  double reconnect_backoff_initial, reconnect_backoff_max;
+  double request_timeout;
+  string multicast_group;
+  bool connected_messaging;
+  double rr_poll_rate;
+  int rr_poll_window;
+  double beam_health_interval;
+  int beam_health_sector_beams;
+  int sector_ranges_count;
+  bool publish_reflectors;
+  string reflectivity_calibration_path;
+  ReflectorDetectorParams reflector_params;
+  BeamStatisticsThresholds beam_health_thresholds;
   ros::param::param<std::string>("~host", host, "192.168.1.1");
   ros::param::param<std::string>("~frame_id", frame_id, "laser");
   ros::param::param<double>("~start_angle", start_angle, OS32C::ANGLE_MAX);
   ros::param::param<double>("~end_angle", end_angle, OS32C::ANGLE_MIN);
+  ros::param::param<bool>("~publish_compact", publish_compact, false);
+  ros::param::param<int>("~realtime_priority", realtime_priority, 0);
+  ros::param::param<std::string>("~cpu_affinity", cpu_affinity, "");
+  ros::param::param<bool>("~lock_memory", lock_memory, false);
+  ros::param::param<bool>("~prefault_buffers", prefault_buffers, false);
+  ros::param::param<double>("~stats_report_interval", stats_report_interval, 0);
+  ros::param::param<int>("~io_receive_buffer_size", io_receive_buffer_size, 0);
+  ros::param::param<int>("~io_busy_poll", io_busy_poll, 0);
+  ros::param::param<int>("~io_priority", io_priority, -1);
+  ros::param::param<int>("~io_dscp", io_dscp, -1);
+  ros::param::param<std::string>("~config_cache", config_cache_path, "");
+  // a UDINT, which does not fit in an int parameter, so it may also be given as a string
+  string serial_number_text;
+  double serial_number_value;
+  if (!ros::param::get("~serial_number", serial_number_text)
+    && ros::param::get("~serial_number", serial_number_value))
+  {
+    std::ostringstream text;
+    text << std::setprecision(17) << serial_number_value;
+    serial_number_text = text.str();
+  }
+  if (!serial_number_text.empty())
+  {
+    try
+    {
+      serial_number = parseSerialNumber(serial_number_text);
+    }
+    catch (std::invalid_argument& ex)
+    {
+      ROS_FATAL_STREAM(ex.what());
+      return -1;
+    }
+  }
+  ros::param::param<std::string>("~discovery_targets", discovery_targets, "255.255.255.255");
+  ros::param::param<double>("~discovery_timeout", discovery_timeout, 0.5);
+  ros::param::param<double>("~reconnect_backoff_initial", reconnect_backoff_initial, 0.1);
+  ros::param::param<double>("~reconnect_backoff_max", reconnect_backoff_max, 5);
+  ros::param::param<double>("~request_timeout", request_timeout,
+    TimedTCPSocket::DEFAULT_TIMEOUT);
+  ros::param::param<std::string>("~multicast_group", multicast_group, "");
+  ros::param::param<bool>("~connected_messaging", connected_messaging, false);
+  ros::param::param<double>("~rr_poll_rate", rr_poll_rate, 0);
+  ros::param::param<int>("~rr_poll_window", rr_poll_window, 4);
+  ros::param::param<double>("~beam_health_interval", beam_health_interval, 0);
+  ros::param::param<int>("~beam_health_sector_beams", beam_health_sector_beams, 16);
+  ros::param::param<double>("~beam_health_noisy_rate", beam_health_thresholds.noisy_rate,
+    beam_health_thresholds.noisy_rate);
+  ros::param::param<double>("~beam_health_no_return_rise", beam_health_thresholds.no_return_rise,
+    beam_health_thresholds.no_return_rise);
+  ros::param::param<double>("~beam_health_reflectance_drop",
+    beam_health_thresholds.reflectance_drop, beam_health_thresholds.reflectance_drop);
+  // in m, as elsewhere in ROS, while the statistics are in mm as reported
+  double range_stddev;
+  ros::param::param<double>("~beam_health_range_stddev", range_stddev, 0);
+  beam_health_thresholds.range_stddev = range_stddev * 1000;
+  ros::param::param<int>("~sector_ranges_count", sector_ranges_count, 0);
+  ros::param::param<bool>("~publish_reflectors", publish_reflectors, false);
+  ros::param::param<std::string>("~reflectivity_calibration", reflectivity_calibration_path, "");
+  ros::param::param<double>("~reflector_threshold", reflector_params.threshold,
+    reflector_params.threshold);
+  ros::param::param<double>("~reflector_range_exponent", reflector_params.range_exponent,
+    reflector_params.range_exponent);
+  ros::param::param<int>("~reflector_min_beams", reflector_params.min_beams,
+    reflector_params.min_beams);
+  // in m, while detection is in mm as reported
+  double reflector_reference_range, reflector_max_range_step, reflector_max_width;
+  ros::param::param<double>("~reflector_reference_range", reflector_reference_range, 1);
+  ros::param::param<double>("~reflector_max_range_step", reflector_max_range_step, 0.1);
+  ros::param::param<double>("~reflector_max_width", reflector_max_width, 0);
+  reflector_params.reference_range = reflector_reference_range * 1000;
+  reflector_params.max_range_step = reflector_max_range_step * 1000;
+  reflector_params.max_width = reflector_max_width * 1000;
+
+  if (request_timeout <= 0)
+  {
+    ROS_FATAL_STREAM("Request timeout must be positive");
+    return -1;
+  }
+
+  // find the scanner by serial number rather than by a fixed address if asked to
+  if (serial_number)
+  {
+    try
+    {
+      CIPIdentity identity = findScannerBySerialNumber(serial_number,
+        parseDiscoveryTargets(discovery_targets), discovery_timeout);
+      host = identity.address;
+      ROS_INFO_STREAM("Found OS32C with serial number " << serial_number << " at " << host);
+    }
+    catch (std::invalid_argument ex)
+    {
+      ROS_FATAL_STREAM("Invalid discovery targets: " << ex.what());
+      return -1;
+    }
+    catch (std::runtime_error ex)
+    {
+      ROS_FATAL_STREAM("Could not find sensor: " << ex.what());
+      return -1;
+    }
+  }
 
   // publisher for laserscans
   ros::Publisher laserscan_pub = nh.advertise<LaserScan>("scan", 1);
 
-  boost::asio::io_service io_service;
-  shared_ptr<TCPSocket> socket = shared_ptr<TCPSocket>(new TCPSocket(io_service));
-  shared_ptr<UDPSocket> io_socket = shared_ptr<UDPSocket>(new UDPSocket(io_service, 2222));
-  OS32C os32c(socket, io_socket);
+  // optional publisher for compact scans, for consumers on constrained links
+  ros::Publisher compact_pub;
+  if (publish_compact)
+  {
+    compact_pub = nh.advertise<CompactScan>("scan_compact", 1);
+  }
+
+  // safety state, published only when it changes and latched for late subscribers
+  ros::Publisher safety_pub = nh.advertise<SafetyState>("safety_state", 1, true);
 
+  // optional periodic summary of the per-beam statistics
+  if (beam_health_sector_beams < 1)
+  {
+    ROS_FATAL_STREAM("Beam health sectors must have at least one beam");
+    return -1;
+  }
+  BeamHealthReporter beam_health(nh, beam_health_interval, beam_health_sector_beams,
+    beam_health_thresholds, frame_id);
+
+  // optional nearest return in each sector, published ahead of each scan
+  SectorRangesPublisher sector_ranges(nh, sector_ranges_count, frame_id);
+
+  // optional reflector landmarks, which need the reflectance only polled scans have
+  if (publish_reflectors && rr_poll_rate <= 0)
+  {
+    ROS_WARN_STREAM("Reflectors are only published for scans polled with ~rr_poll_rate");
+  }
+  shared_ptr<ReflectorPublisher> reflectors;
   try
   {
-    os32c.open(host);
+    reflectors = shared_ptr<ReflectorPublisher>(new ReflectorPublisher(nh,
+      publish_reflectors && rr_poll_rate > 0, reflector_params, frame_id));
   }
-  catch (std::runtime_error ex)
+  catch (std::invalid_argument ex)
   {
-    ROS_FATAL_STREAM("Exception caught opening session: " << ex.what());
+    ROS_FATAL_STREAM("Invalid reflector parameters: " << ex.what());
     return -1;
   }
 
+  // optional cache of the last configuration applied, to notice it being changed
+  shared_ptr<ConfigCache> config_cache;
+  if (!config_cache_path.empty())
+  {
+    config_cache = shared_ptr<ConfigCache>(new ConfigCache(config_cache_path, host));
+    try
+    {
+      config_cache->checkWritable();
+    }
+    catch (std::runtime_error ex)
+    {
+      ROS_FATAL_STREAM(ex.what());
+      return -1;
+    }
+    if (config_cache->load())
+    {
+      ROS_INFO_STREAM("Loaded config cache from " << config_cache_path);
+    }
+  }
+
+  // optional calibration of the intensities of polled scans to reflectivity
+  shared_ptr<ReflectivityCalibration> calibration;
+  if (!reflectivity_calibration_path.empty())
+  {
+    if (rr_poll_rate <= 0)
+    {
+      ROS_WARN_STREAM("Intensities are only calibrated for scans polled with ~rr_poll_rate");
+    }
+    calibration = shared_ptr<ReflectivityCalibration>(new ReflectivityCalibration());
+    try
+    {
+      calibration->load(reflectivity_calibration_path);
+      ROS_INFO_STREAM("Loaded reflectivity calibration from " << reflectivity_calibration_path
+        << ", a table of " << calibration->getRangePoints() << " ranges by "
+        << calibration->getTotPoints() << " TOT values");
+    }
+    catch (std::invalid_argument ex)
+    {
+      ROS_FATAL_STREAM("Invalid reflectivity calibration: " << ex.what());
+      return -1;
+    }
+    catch (std::runtime_error ex)
+    {
+      ROS_FATAL_STREAM("Could not load reflectivity calibration: " << ex.what());
+      return -1;
+    }
+  }
+
+  if (rr_poll_rate > 0)
+  {
+    PollOptions options;
+    options.host = host;
+    options.start_angle = start_angle;
+    options.end_angle = end_angle;
+    options.config_cache = config_cache.get();
+    options.rate = rr_poll_rate;
+    options.window = rr_poll_window;
+    options.request_timeout = request_timeout;
+    options.connected_messaging = connected_messaging;
+    options.reconnect_backoff_initial = reconnect_backoff_initial;
+    options.reconnect_backoff_max = reconnect_backoff_max;
+    options.realtime_priority = realtime_priority;
+    options.cpu_affinity = cpu_affinity;
+    options.lock_memory = lock_memory;
+    options.prefault_buffers = prefault_buffers;
+    options.stats_report_interval = stats_report_interval;
+
+    ScanOutputs outputs;
+    outputs.frame_id = frame_id;
+    outputs.calibration = calibration.get();
+    outputs.laserscan_pub = laserscan_pub;
+    outputs.publish_compact = publish_compact;
+    outputs.compact_pub = compact_pub;
+    outputs.safety_pub = safety_pub;
+    outputs.beam_health = &beam_health;
+    outputs.sector_ranges = &sector_ranges;
+    outputs.reflectors = reflectors.get();
+    return pollRRScans(options, outputs);
+  }
+
+  sensor_msgs::LaserScan laserscan_msg;
+  RawLaserScan raw_scan;
+  CompactScan compact_msg;
+  SafetyState safety_msg;
+  safety_msg.header.frame_id = frame_id;
+  SafetyStateMonitor safety_monitor;
+
+  // worst case time between receiving a report and finishing its publication
+  LatencyStats latency;
+
+  // Publish each scan as it is received. Conversion to the ROS message format
+  // happens while the message is serialized by publish().
+  boost::asio::io_service io_service;
+  ConnectionSupervisor supervisor(io_service, host, [&](const ScanView& scan)
+  {
+    // every message derived from the scan carries the time it was received
+    ros::Time stamp = ros::Time::now()
+      - ros::Duration((monotonicNanoseconds() - scan.receive_time) / 1e9);
+
+    // a change in the safety state goes out ahead of the scan that carried it
+    if (safety_monitor.update(*scan.header))
+    {
+      convertToSafetyState(safety_monitor.getState(), scan.header->scan_count, &safety_msg);
+      safety_msg.header.stamp = stamp;
+      safety_msg.header.seq++;
+      safety_pub.publish(safety_msg);
+    }
+
+    sector_ranges.publish(scan.ranges, scan.num_beams, scan.start_angle, scan.angle_increment,
+      stamp);
+
+    raw_scan.setMeasurement(scan);
+
+    // Stamp and publish message.
+    raw_scan.header.stamp = stamp;
+    raw_scan.header.seq++;
+    laserscan_pub.publish(raw_scan);
+
+    if (publish_compact)
+    {
+      convertToCompactScan(scan, &compact_msg);
+      compact_msg.header.stamp = raw_scan.header.stamp;
+      compact_msg.header.seq = raw_scan.header.seq;
+      compact_pub.publish(compact_msg);
+    }
+    latency.add(monotonicNanoseconds() - scan.receive_time);
+
+    // after publishing, so as not to delay the scan
+    beam_health.add(scan.ranges, NULL, scan.num_beams, scan.start_angle);
+  });
+  supervisor.setIOSocketHook(boost::bind(&configureIOSocket, _1, io_receive_buffer_size,
+    io_busy_poll, io_priority, io_dscp));
+  supervisor.setConfiguration(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS,
+    start_angle, end_angle, config_cache.get());
+
   try
   {
-    os32c.setRangeFormat(RANGE_MEASURE_50M);
-    os32c.setReflectivityFormat(REFLECTIVITY_MEASURE_TOT_4PS);
-    os32c.selectBeams(start_angle, end_angle);
+    supervisor.setBackoff(reconnect_backoff_initial, reconnect_backoff_max, 0.2);
+    supervisor.setRequestTimeout(request_timeout);
+    supervisor.setIOConnectionParams(readIOConnectionParams());
+    supervisor.setMulticastGroup(multicast_group);
+    supervisor.setConnectedMessaging(connected_messaging);
+    supervisor.connect();
+    ROS_INFO_STREAM("Sensor configured, UDP IO started");
   }
   catch (std::invalid_argument ex)
   {
     ROS_FATAL_STREAM("Invalid arguments in sensor configuration: " << ex.what());
     return -1;
   }
-
-  try
+  catch (std::runtime_error ex)
   {
-    os32c.startUDPIO();
-    os32c.sendMeasurmentReportConfigUDP();
+    ROS_FATAL_STREAM("Could not configure sensor: " << ex.what());
+    return -1;
   }
   catch (std::logic_error ex)
   {
@@ -95,30 +997,109 @@ int main(int argc, char *argv[])
     return -1;
   }
 
-  int ctr = 10;
-  sensor_msgs::LaserScan laserscan_msg;
-  os32c.fillLaserScanStaticConfig(&laserscan_msg);
-  laserscan_msg.header.frame_id = frame_id;
+  // Without owning the sensor the beams are whatever its owner configured,
+  // read anew on every connection, so the static config follows each one.
+  auto updateStaticConfig = [&]()
+  {
+    OS32C& os32c = supervisor.getOS32C();
+    fillLaserScanStaticConfig(os32c, &laserscan_msg);
+    laserscan_msg.header.frame_id = frame_id;
+    laserscan_msg.header.seq = raw_scan.header.seq;
+    raw_scan.setStaticConfig(laserscan_msg);
+    fillCompactScanStaticConfig(os32c, &compact_msg);
+    compact_msg.header.frame_id = frame_id;
+  };
+  updateStaticConfig();
+
+  IOConnectionParams io_params = supervisor.getOS32C().getIOConnectionParams();
+  if (io_params != supervisor.getIOConnectionParams())
+  {
+    ROS_WARN_STREAM("Sensor rejected the requested IO connection parameters, fell back to RPIs of "
+      << io_params.o_to_t_rpi << " us O->T and " << io_params.t_to_o_rpi << " us T->O");
+  }
+  if (io_params.mode != IO_CONNECTION_OWNER)
+  {
+    ROS_INFO_STREAM("Receiving scans without owning the sensor, with the configuration of its owner");
+  }
+
+  ScanStream& stream = supervisor.getStream();
+  int config_changes = 0;
+  int reconnects = 0;
+  int config_reconnects = 0;
+  double scan_period = io_params.getScanPeriod();
+
+  configureRealtime(realtime_priority, cpu_affinity, lock_memory);
+  if (prefault_buffers)
+  {
+    // size everything touched per scan for the largest possible scan
+    int max_beams = OS32C::calcBeamNumber(OS32C::ANGLE_MIN) + 1;
+    stream.prefaultBuffers();
+    prefault(compact_msg.ranges, max_beams);
+    prefaultStack();
+    ROS_INFO_STREAM("Real-time: pre-faulted scan buffers for " << max_beams << " beams");
+  }
+
+  ros::WallTime last_stats_report = ros::WallTime::now();
 
   while (ros::ok())
   {
     try
     {
-      // Collect measurement from device, convert to ROS message format.
-      MeasurementReport report = os32c.receiveMeasurementReportUDP();
-      OS32C::convertToLaserScan(report, &laserscan_msg);
+      // wait no longer than one scan period, so that a stalled sensor is
+      // noticed and ROS callbacks and shutdown are serviced regardless
+      ConnectionSupervisor::SpinResult result = supervisor.spinOnce(scan_period);
+      saveConfigCache(config_cache.get());
+      if (supervisor.getReconnects() != config_reconnects && supervisor.isConnected())
+      {
+        // before the first scan of the new connection is published
+        config_reconnects = supervisor.getReconnects();
+        updateStaticConfig();
+      }
+      if (result == ConnectionSupervisor::TIMED_OUT)
+      {
+        ROS_WARN_STREAM_THROTTLE(1, "No scan received from sensor within " << scan_period * 1000
+          << " ms");
+        ros::spinOnce();
+        continue;
+      }
+      if (result == ConnectionSupervisor::MALFORMED_PACKET)
+      {
+        ROS_WARN_STREAM_THROTTLE(1, "Dropped malformed IO packet: "
+          << decodeStatusString(stream.getLastDecodeStatus()));
+        ros::spinOnce();
+        continue;
+      }
+      if (result == ConnectionSupervisor::DISCONNECTED)
+      {
+        ROS_WARN_STREAM_THROTTLE(1, "Lost connection to sensor, reconnecting: "
+          << supervisor.getLastError());
+        ros::spinOnce();
+        continue;
+      }
 
-      // Stamp and publish message.
-      laserscan_msg.header.stamp = ros::Time::now();
-      laserscan_msg.header.seq++;
-      laserscan_pub.publish(laserscan_msg);
+      if (supervisor.getReconnects() != reconnects)
+      {
+        reconnects = supervisor.getReconnects();
+        ROS_INFO_STREAM("Reconnected to sensor, first scan "
+          << supervisor.getLastRecoveryTime() / 1000000 << " ms after reconnecting, "
+          << supervisor.getLastOutageTime() / 1000000 << " ms after the connection was lost");
+      }
 
-      // Every tenth message received, send the keepalive message in response.
-      // TODO: Make this time-based instead of message-count based.
-      if (++ctr > 10)
+      if (stream.getConfigChanges() != config_changes)
       {
-        os32c.sendMeasurmentReportConfigUDP();
-        ctr = 0;
+        ROS_WARN_STREAM("Sensor config checksums changed, config cache invalidated");
+        config_changes = stream.getConfigChanges();
+      }
+
+      if (stats_report_interval > 0 &&
+        (ros::WallTime::now() - last_stats_report).toSec() > stats_report_interval)
+      {
+        ROS_INFO_STREAM("Receive to publish latency over " << latency.getCount() << " scans: mean "
+          << latency.getMean() / 1000 << " us, max " << latency.getMax() / 1000 << " us; "
+          << stream.getLostScans() << " scans lost in total, " << supervisor.getIOSocket().getKernelDrops()
+          << " dropped by the kernel, " << stream.getMalformedPackets() << " malformed packets dropped");
+        latency.reset();
+        last_stats_report = ros::WallTime::now();
       }
     }
     catch (std::runtime_error ex)
@@ -133,7 +1114,25 @@ int main(int argc, char *argv[])
     ros::spinOnce();
   }
 
-  os32c.closeConnection(0);
-  os32c.close();
+  if (supervisor.isConnected())
+  {
+    // the session is closed even if the scanner no longer answers the Forward Close
+    try
+    {
+      supervisor.getOS32C().stopUDPIO();
+    }
+    catch (std::exception& ex)
+    {
+      ROS_WARN_STREAM("Could not close the IO connection: " << ex.what());
+    }
+    try
+    {
+      supervisor.getOS32C().close();
+    }
+    catch (std::exception& ex)
+    {
+      ROS_WARN_STREAM("Could not close the session: " << ex.what());
+    }
+  }
   return 0;
 }
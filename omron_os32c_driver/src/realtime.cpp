@@ -0,0 +1,151 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <errno.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <sstream>
+#include <stdexcept>
+
+#include "omron_os32c_driver/realtime.h"
+
+namespace omron_os32c_driver {
+
+// amount of stack to touch in prefaultStack()
+static const size_t PREFAULT_STACK_SIZE = 64 * 1024;
+
+void setRealtimePriority(int priority)
+{
+  int min = sched_get_priority_min(SCHED_FIFO);
+  int max = sched_get_priority_max(SCHED_FIFO);
+  if (priority < min || priority > max)
+  {
+    std::ostringstream msg;
+    msg << "Real-time priority " << priority << " is outside of the range " << min << " to " << max;
+    throw std::invalid_argument(msg.str());
+  }
+
+  sched_param param;
+  memset(&param, 0, sizeof(param));
+  param.sched_priority = priority;
+  int ret = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+  if (ret)
+  {
+    throw std::runtime_error(string("Could not set SCHED_FIFO priority: ") + strerror(ret));
+  }
+}
+
+void setCpuAffinity(const vector<int>& cpus)
+{
+  if (cpus.empty())
+  {
+    throw std::invalid_argument("No CPUs given for affinity");
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t i = 0; i < cpus.size(); ++i)
+  {
+    if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE)
+    {
+      throw std::invalid_argument("Invalid CPU number for affinity");
+    }
+    CPU_SET(cpus[i], &set);
+  }
+
+  int ret = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  if (ret)
+  {
+    throw std::runtime_error(string("Could not set CPU affinity: ") + strerror(ret));
+  }
+}
+
+void lockMemory()
+{
+  if (mlockall(MCL_CURRENT | MCL_FUTURE))
+  {
+    throw std::runtime_error(string("Could not lock memory: ") + strerror(errno));
+  }
+
+  // keep freed memory within the process, where it stays locked, and serve
+  // all allocations from the heap rather than from fresh mmaps
+  mallopt(M_TRIM_THRESHOLD, -1);
+  mallopt(M_MMAP_MAX, 0);
+}
+
+void prefaultStack()
+{
+  volatile unsigned char stack[PREFAULT_STACK_SIZE];
+  for (size_t i = 0; i < sizeof(stack); i += 1024)
+  {
+    stack[i] = 0;
+  }
+}
+
+vector<int> parseCpuList(const string& cpus)
+{
+  vector<int> result;
+  std::istringstream list(cpus);
+  string item;
+  while (std::getline(list, item, ','))
+  {
+    int first, last;
+    char dash;
+    std::istringstream range(item);
+    if (!(range >> first))
+    {
+      throw std::invalid_argument("Could not parse CPU list: " + cpus);
+    }
+    last = first;
+    if (range >> dash && (dash != '-' || !(range >> last)))
+    {
+      throw std::invalid_argument("Could not parse CPU list: " + cpus);
+    }
+    range >> std::ws;
+    if (!range.eof() || first < 0 || last < first)
+    {
+      throw std::invalid_argument("Could not parse CPU list: " + cpus);
+    }
+    for (int cpu = first; cpu <= last; ++cpu)
+    {
+      result.push_back(cpu);
+    }
+  }
+  return result;
+}
+
+uint64_t monotonicNanoseconds()
+{
+  timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,152 @@
+/**
+Software License Agreement (BSD)
+
+\file      reflectivity_calibration.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "omron_os32c_driver/reflectivity_calibration.h"
+
+namespace omron_os32c_driver {
+
+const int ReflectivityCalibration::MAX_AXIS_CELLS;
+
+void ReflectivityCalibration::Axis::set(const vector<double>& axis, const string& name)
+{
+  if (axis.size() < 2)
+  {
+    throw std::invalid_argument("Calibration " + name + " must have at least two values");
+  }
+  double step = axis[1] - axis[0];
+  for (size_t i = 1; i < axis.size(); ++i)
+  {
+    if (!(axis[i] > axis[i - 1]))
+    {
+      throw std::invalid_argument("Calibration " + name + " must be strictly increasing");
+    }
+    step = std::min(step, axis[i] - axis[i - 1]);
+  }
+
+  values.assign(axis.begin(), axis.end());
+  inverse_width.resize(axis.size() - 1);
+  for (size_t i = 0; i + 1 < axis.size(); ++i)
+  {
+    inverse_width[i] = 1 / (values[i + 1] - values[i]);
+  }
+
+  // cells no wider than the smallest interval, so that no cell holds more
+  // than one value of the axis, within the limit on their number
+  double span = axis.back() - axis.front();
+  int cells = std::min(ceil(span / step), static_cast<double>(MAX_AXIS_CELLS));
+  cell_scale = cells / span;
+  last_cell = cells - 1;
+  cell_interval.resize(cells);
+  for (int cell = 0; cell < cells; ++cell)
+  {
+    double start = axis.front() + cell / (double)cell_scale;
+    size_t i = std::upper_bound(axis.begin(), axis.end() - 1, start) - axis.begin();
+    cell_interval[cell] = std::max<size_t>(i, 1) - 1;
+  }
+}
+
+void ReflectivityCalibration::load(const string& path)
+{
+  std::ifstream file(path.c_str());
+  if (!file)
+  {
+    throw std::runtime_error("Could not open reflectivity calibration " + path);
+  }
+
+  vector<double> ranges, tots, values;
+  string line;
+  int line_number = 0;
+  while (std::getline(file, line))
+  {
+    ++line_number;
+    std::istringstream in(line.substr(0, line.find('#')));
+    string key;
+    if (!(in >> key))
+    {
+      continue;
+    }
+
+    vector<double> numbers;
+    double number;
+    while (in >> number)
+    {
+      numbers.push_back(number);
+    }
+    std::ostringstream where;
+    where << path << " line " << line_number;
+    if (!in.eof())
+    {
+      throw std::runtime_error("Malformed number in reflectivity calibration " + where.str());
+    }
+
+    if (key == "ranges")
+    {
+      ranges = numbers;
+    }
+    else if (key == "tot")
+    {
+      tots = numbers;
+    }
+    else if (key == "row")
+    {
+      if (numbers.size() != tots.size())
+      {
+        throw std::runtime_error("Row does not have a value for each TOT in reflectivity "
+          "calibration " + where.str());
+      }
+      values.insert(values.end(), numbers.begin(), numbers.end());
+    }
+    else
+    {
+      throw std::runtime_error("Unknown key " + key + " in reflectivity calibration "
+        + where.str());
+    }
+  }
+
+  setTable(ranges, tots, values);
+}
+
+void ReflectivityCalibration::setTable(const vector<double>& ranges, const vector<double>& tots,
+  const vector<double>& values)
+{
+  Axis range_axis, tot_axis;
+  range_axis.set(ranges, "ranges");
+  tot_axis.set(tots, "TOT values");
+  if (values.size() != ranges.size() * tots.size())
+  {
+    throw std::invalid_argument("Calibration must have a value for each range and TOT");
+  }
+
+  range_axis_ = range_axis;
+  tot_axis_ = tot_axis;
+  table_.assign(values.begin(), values.end());
+}
+
+} // namespace omron_os32c_driver
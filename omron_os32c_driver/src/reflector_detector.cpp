@@ -0,0 +1,148 @@
+/**
+Software License Agreement (BSD)
+
+\file      reflector_detector.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <math.h>
+#include <algorithm>
+#include <stdexcept>
+
+#include "omron_os32c_driver/reflector_detector.h"
+
+namespace omron_os32c_driver {
+
+ReflectorDetector::ReflectorDetector(const ReflectorDetectorParams& params)
+  : params_(params), compensated_(BEAM_COUNT)
+{
+  if (params.threshold <= 0 || params.reference_range <= 0)
+  {
+    throw std::invalid_argument("Reflector threshold and reference range must be positive");
+  }
+  if (params.max_range_step < 0 || params.max_width < 0)
+  {
+    throw std::invalid_argument("Reflector range step and width must not be negative");
+  }
+  if (params.min_beams < 1)
+  {
+    throw std::invalid_argument("Reflectors must span at least one beam");
+  }
+}
+
+void ReflectorDetector::detect(const EIP_UINT* ranges, const EIP_UINT* reflectance,
+  size_t num_beams, int first_beam, vector<Reflector>* reflectors)
+{
+  if (first_beam < 0 || first_beam + num_beams > static_cast<size_t>(BEAM_COUNT))
+  {
+    throw std::invalid_argument("Scan runs past the last beam of the scanner");
+  }
+  reflectors->clear();
+
+  for (size_t i = 0; i < num_beams; ++i)
+  {
+    // noisy beams and beams with no return have no meaningful reflectance
+    if (ranges[i] == 0x0001 || ranges[i] == 0xFFFF)
+    {
+      compensated_[i] = 0;
+      continue;
+    }
+    double c = reflectance[i];
+    if (params_.range_exponent != 0)
+    {
+      c *= pow(ranges[i] / params_.reference_range, params_.range_exponent);
+    }
+    compensated_[i] = c >= params_.threshold ? c : 0;
+  }
+
+  // a reflector is a run of beams over the threshold, split where the range jumps
+  int start = -1;
+  for (size_t i = 0; i < num_beams; ++i)
+  {
+    if (!compensated_[i])
+    {
+      if (start >= 0)
+      {
+        addReflector(ranges, first_beam, start, i - 1, reflectors);
+        start = -1;
+      }
+    }
+    else if (start < 0)
+    {
+      start = i;
+    }
+    else if (fabs(static_cast<double>(ranges[i]) - ranges[i - 1]) > params_.max_range_step)
+    {
+      addReflector(ranges, first_beam, start, i - 1, reflectors);
+      start = i;
+    }
+  }
+  if (start >= 0)
+  {
+    addReflector(ranges, first_beam, start, num_beams - 1, reflectors);
+  }
+}
+
+void ReflectorDetector::addReflector(const EIP_UINT* ranges, int first_beam, int first, int last,
+  vector<Reflector>* reflectors) const
+{
+  if (last - first + 1 < params_.min_beams)
+  {
+    return;
+  }
+
+  // each beam covers one beam increment, so the outer edges are half of one
+  // beyond the centres of the first and last beams
+  const double* cosines = BeamGeometry::cosines + first_beam;
+  const double* sines = BeamGeometry::sines + first_beam;
+  double dx = ranges[last] * cosines[last] - ranges[first] * cosines[first];
+  double dy = ranges[last] * sines[last] - ranges[first] * sines[first];
+  double width = sqrt(dx * dx + dy * dy)
+    + (static_cast<double>(ranges[first]) + ranges[last]) / 2 * BEAM_ANGLE_INC;
+  if (params_.max_width > 0 && width > params_.max_width)
+  {
+    return;
+  }
+
+  Reflector r;
+  double weight = 0;
+  r.x = 0;
+  r.y = 0;
+  r.intensity = 0;
+  for (int i = first; i <= last; ++i)
+  {
+    double w = compensated_[i];
+    r.x += w * ranges[i] * cosines[i];
+    r.y += w * ranges[i] * sines[i];
+    r.intensity = std::max(r.intensity, w);
+    weight += w;
+  }
+  r.x /= weight;
+  r.y /= weight;
+  r.range = sqrt(r.x * r.x + r.y * r.y);
+  r.bearing = atan2(r.y, r.x);
+  r.width = width;
+  r.first_beam = first;
+  r.last_beam = last;
+  reflectors->push_back(r);
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,215 @@
+/**
+Software License Agreement (BSD)
+
+\file      ros_conversions.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdexcept>
+
+#include "omron_os32c_driver/ros_conversions.h"
+
+namespace omron_os32c_driver {
+
+void fillLaserScanStaticConfig(const OS32C& os32c, sensor_msgs::LaserScan* ls)
+{
+  ls->angle_max = os32c.getStartAngle();
+  ls->angle_min = os32c.getEndAngle();
+  ls->angle_increment = OS32C::ANGLE_INC;
+  ls->range_min = OS32C::DISTANCE_MIN;
+  ls->range_max = OS32C::DISTANCE_MAX;
+}
+
+void convertToLaserScan(const RangeAndReflectanceMeasurement& rr, sensor_msgs::LaserScan* ls,
+  const ReflectivityCalibration* calibration)
+{
+  if (rr.range_data.size() != rr.header.num_beams ||
+    rr.reflectance_data.size() != rr.header.num_beams)
+  {
+    throw std::invalid_argument("Number of beams does not match vector size");
+  }
+
+  // Beam period is in ns
+  ls->time_increment = rr.header.scan_beam_period / 1000000000.0;
+  // Scan period is in microseconds.
+  ls->scan_time = rr.header.scan_rate / 1000000.0;
+
+  // TODO: this currently makes assumptions of the report format. Should likely
+  // accomodate all of them, or at least anything reasonable.
+  ls->ranges.resize(rr.header.num_beams);
+  ls->intensities.resize(rr.header.num_beams);
+  for (int i = 0; i < rr.header.num_beams; ++i)
+  {
+    if (rr.range_data[i] == 0x0001)
+    {
+      // noisy beam detected
+      ls->ranges[i] = 0;
+    }
+    else if (rr.range_data[i] == 0xFFFF)
+    {
+      // no return
+      ls->ranges[i] = OS32C::DISTANCE_MAX;
+    }
+    else
+    {
+      ls->ranges[i] = rr.range_data[i] / 1000.0;
+    }
+    ls->intensities[i] = rr.reflectance_data[i];
+  }
+  if (calibration && rr.header.num_beams)
+  {
+    calibration->calibrate(&rr.range_data[0], &rr.reflectance_data[0], rr.header.num_beams,
+      &ls->intensities[0]);
+  }
+}
+
+void convertToLaserScan(const MeasurementReport& mr, sensor_msgs::LaserScan* ls)
+{
+  if (mr.measurement_data.size() != mr.header.num_beams)
+  {
+    throw std::invalid_argument("Number of beams does not match vector size");
+  }
+
+  // Beam period is in ns.
+  ls->time_increment = mr.header.scan_beam_period / 1000000000.0;
+  // Scan period is in microseconds.
+  ls->scan_time = mr.header.scan_rate / 1000000.0;
+
+  // TODO: this currently makes assumptions of the report format. Should likely
+  // accomodate all of them, or at least anything reasonable.
+  ls->ranges.resize(mr.header.num_beams);
+  for (int i = 0; i < mr.header.num_beams; ++i)
+  {
+    if (mr.measurement_data[i] == 0x0001)
+    {
+      // noisy beam detected
+      ls->ranges[i] = 0;
+    }
+    else if (mr.measurement_data[i] == 0xFFFF)
+    {
+      // no return
+      ls->ranges[i] = OS32C::DISTANCE_MAX;
+    }
+    else
+    {
+      ls->ranges[i] = mr.measurement_data[i] / 1000.0;
+    }
+  }
+}
+
+void fillCompactScanStaticConfig(const OS32C& os32c, CompactScan* cs)
+{
+  cs->angle_start = os32c.getStartAngle();
+  cs->angle_increment = -OS32C::ANGLE_INC;
+  cs->range_min = OS32C::DISTANCE_MIN;
+  cs->range_max = OS32C::DISTANCE_MAX;
+}
+
+void convertToCompactScan(const RangeAndReflectanceMeasurement& rr, CompactScan* cs)
+{
+  if (rr.range_data.size() != rr.header.num_beams ||
+    rr.reflectance_data.size() != rr.header.num_beams)
+  {
+    throw std::invalid_argument("Number of beams does not match vector size");
+  }
+
+  // Beam period is in ns
+  cs->time_increment = rr.header.scan_beam_period / 1000000000.0;
+  // Scan period is in microseconds.
+  cs->scan_time = rr.header.scan_rate / 1000000.0;
+  cs->scan_count = rr.header.scan_count;
+  cs->ranges.assign(rr.range_data.begin(), rr.range_data.end());
+  cs->intensities.assign(rr.reflectance_data.begin(), rr.reflectance_data.end());
+}
+
+void convertToCompactScan(const MeasurementReport& mr, CompactScan* cs)
+{
+  if (mr.measurement_data.size() != mr.header.num_beams)
+  {
+    throw std::invalid_argument("Number of beams does not match vector size");
+  }
+
+  // Beam period is in ns
+  cs->time_increment = mr.header.scan_beam_period / 1000000000.0;
+  // Scan period is in microseconds.
+  cs->scan_time = mr.header.scan_rate / 1000000.0;
+  cs->scan_count = mr.header.scan_count;
+  cs->ranges.assign(mr.measurement_data.begin(), mr.measurement_data.end());
+  cs->intensities.clear();
+}
+
+void convertToCompactScan(const ScanView& scan, CompactScan* cs)
+{
+  // Beam period is in ns
+  cs->time_increment = scan.header->scan_beam_period / 1000000000.0;
+  // Scan period is in microseconds.
+  cs->scan_time = scan.header->scan_rate / 1000000.0;
+  cs->scan_count = scan.header->scan_count;
+  cs->ranges.assign(scan.ranges, scan.ranges + scan.num_beams);
+  cs->intensities.clear();
+}
+
+void convertToSafetyState(const ScannerSafetyState& state, EIP_UDINT scan_count,
+  SafetyState* ss)
+{
+  ss->scan_count = scan_count;
+  ss->machine_state = state.machine_state;
+  ss->machine_stop_reasons = state.machine_stop_reasons;
+  ss->active_zone_set = state.active_zone_set;
+  ss->zone_inputs = state.zone_inputs;
+  ss->detection_zone_status = state.detection_zone_status;
+  ss->output_status = state.output_status;
+  ss->input_status = state.input_status;
+}
+
+void convertToBeamHealth(const BeamStatisticsSummary& summary, BeamHealth* bh)
+{
+  bh->scans = summary.scans;
+  bh->noisy_rate = summary.noisy_rate;
+  bh->no_return_rate = summary.no_return_rate;
+  bh->sector_beams = summary.sector_beams;
+  bh->sector_noisy_rate = summary.sector_noisy_rate;
+  bh->sector_no_return_rate = summary.sector_no_return_rate;
+  bh->sector_range_stddev.resize(summary.sector_range_stddev.size());
+  for (size_t i = 0; i < summary.sector_range_stddev.size(); ++i)
+  {
+    bh->sector_range_stddev[i] = summary.sector_range_stddev[i] / 1000.0;
+  }
+  bh->flagged_beams = summary.flagged_beams;
+  bh->flagged_sectors = summary.flagged_sectors;
+}
+
+void convertToReflectors(const vector<Reflector>& reflectors, Reflectors* rm)
+{
+  rm->ranges.resize(reflectors.size());
+  rm->bearings.resize(reflectors.size());
+  rm->widths.resize(reflectors.size());
+  rm->intensities.resize(reflectors.size());
+  for (size_t i = 0; i < reflectors.size(); ++i)
+  {
+    rm->ranges[i] = reflectors[i].range / 1000.0;
+    rm->bearings[i] = reflectors[i].bearing;
+    rm->widths[i] = reflectors[i].width / 1000.0;
+    rm->intensities[i] = reflectors[i].intensity;
+  }
+}
+
+} // namespace omron_os32c_driver
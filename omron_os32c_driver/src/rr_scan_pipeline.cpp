@@ -0,0 +1,146 @@
+/**
+Software License Agreement (BSD)
+
+\file      rr_scan_pipeline.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/rr_scan_pipeline.h"
+#include "omron_os32c_driver/timed_tcp_socket.h"
+
+namespace omron_os32c_driver {
+
+RRScanPipeline::RRScanPipeline(OS32C& os32c, size_t window, double rate)
+  : os32c_(os32c), window_(window), period_(0), next_send_time_(0), next_context_(1),
+    stale_replies_(0), receive_timeout_(TimedTCPSocket::DEFAULT_TIMEOUT * 1e9)
+{
+  if (!window)
+  {
+    throw std::invalid_argument("Pipeline window must be at least one request");
+  }
+  if (rate < 0)
+  {
+    throw std::invalid_argument("Pipeline rate must not be negative");
+  }
+  if (rate > 0)
+  {
+    period_ = static_cast<uint64_t>(1e9 / rate);
+  }
+}
+
+size_t RRScanPipeline::sendRequests(uint64_t now)
+{
+  size_t sent = 0;
+  while (outstanding_.size() < window_ && now >= next_send_time_)
+  {
+    outstanding_.push_back(os32c_.sendRRScanRequest(next_context_++));
+    ++sent;
+    // after a stall, carry on at the rate from now rather than catching up in a burst
+    next_send_time_ += period_;
+    if (period_ && next_send_time_ <= now)
+    {
+      next_send_time_ = now + period_;
+    }
+  }
+  return sent;
+}
+
+void RRScanPipeline::setReceiveTimeout(double timeout)
+{
+  if (!(timeout > 0))
+  {
+    throw std::invalid_argument("Receive timeout must be positive");
+  }
+  receive_timeout_ = timeout * 1e9;
+}
+
+void RRScanPipeline::dropOutstanding()
+{
+  outstanding_.clear();
+  early_.clear();
+}
+
+bool RRScanPipeline::receiveScan(RangeAndReflectanceMeasurement& rr)
+{
+  if (outstanding_.empty())
+  {
+    throw std::logic_error("No requests outstanding");
+  }
+
+  uint64_t deadline = monotonicNanoseconds() + receive_timeout_;
+  while (true)
+  {
+    uint64_t oldest = outstanding_.front();
+    std::map<uint64_t, RangeAndReflectanceMeasurement>::iterator it = early_.find(oldest);
+    if (it != early_.end())
+    {
+      rr = it->second;
+      early_.erase(it);
+      outstanding_.pop_front();
+      return true;
+    }
+
+    if (monotonicNanoseconds() > deadline)
+    {
+      dropOutstanding();
+      throw std::runtime_error("Timed out waiting for a range and reflectance scan");
+    }
+
+    uint64_t context;
+    bool ok;
+    try
+    {
+      ok = os32c_.receiveRRScan(context, rr);
+    }
+    catch (std::exception& ex)
+    {
+      // A reply that cannot be decoded may be to any request, and after a
+      // socket error none are coming, so none can be waited for. Replies that
+      // do arrive later are dropped as stale.
+      dropOutstanding();
+      throw;
+    }
+    std::deque<uint64_t>::iterator req = std::find(outstanding_.begin(), outstanding_.end(),
+      context);
+    if (req == outstanding_.end())
+    {
+      ++stale_replies_;
+      continue;
+    }
+    if (!ok)
+    {
+      outstanding_.erase(req);
+      return false;
+    }
+    if (context == oldest)
+    {
+      outstanding_.pop_front();
+      return true;
+    }
+    early_[context] = rr;
+  }
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,256 @@
+/**
+Software License Agreement (BSD)
+
+\file      rr_scan_poller.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/rr_scan_poller.h"
+#include "omron_os32c_driver/timed_tcp_socket.h"
+#include "omron_os32c_driver/udp_io_socket.h"
+
+namespace omron_os32c_driver {
+
+RRScanPoller::RRScanPoller(boost::asio::io_service& io_service, const string& host,
+  const Callback& callback)
+  : io_service_(io_service), host_(host), callback_(callback),
+    start_angle_(OS32C::ANGLE_MAX), end_angle_(OS32C::ANGLE_MIN), config_cache_(NULL),
+    rate_(0), window_(4), request_timeout_(TimedTCPSocket::DEFAULT_TIMEOUT),
+    connected_messaging_(false),
+    backoff_(0.1, 5, 0.2), connected_(false), disconnects_(0), reconnects_(0),
+    config_changes_(0), next_attempt_(0)
+{
+}
+
+void RRScanPoller::setConfiguration(double start_angle, double end_angle, ConfigCache* cache)
+{
+  start_angle_ = start_angle;
+  end_angle_ = end_angle;
+  config_cache_ = cache;
+}
+
+void RRScanPoller::setPolling(double rate, size_t window)
+{
+  if (!window)
+  {
+    throw std::invalid_argument("Window must allow at least one request in flight");
+  }
+  if (rate < 0)
+  {
+    throw std::invalid_argument("Request rate must not be negative");
+  }
+  rate_ = rate;
+  window_ = window;
+}
+
+void RRScanPoller::setBackoff(double initial, double max, double jitter)
+{
+  backoff_ = Backoff(initial, max, jitter);
+}
+
+void RRScanPoller::setRequestTimeout(double timeout)
+{
+  if (timeout <= 0)
+  {
+    throw std::invalid_argument("Request timeout must be positive");
+  }
+  request_timeout_ = timeout;
+}
+
+void RRScanPoller::connect()
+{
+  pipeline_.reset();
+  os32c_.reset();
+
+  shared_ptr<TimedTCPSocket> socket(new TimedTCPSocket(io_service_, request_timeout_));
+  // the session needs an IO socket, but without UDP IO it is never opened
+  shared_ptr<UDPIOSocket> io_socket(new UDPIOSocket(io_service_));
+  os32c_ = shared_ptr<OS32C>(new OS32C(socket, io_socket));
+
+  os32c_->open(host_);
+  if (connected_messaging_)
+  {
+    // the requests keep the connection open, however slowly they are sent
+    EIP_UDINT rpi = OS32C::EXPLICIT_RPI;
+    if (rate_ > 0)
+    {
+      rpi = std::max(rpi, static_cast<EIP_UDINT>(1e6 / rate_));
+    }
+    try
+    {
+      os32c_->openExplicitConnection(rpi);
+    }
+    catch (std::exception& ex)
+    {
+      // not every firmware takes a Class 3 connection, and unconnected requests still work
+    }
+  }
+  os32c_->configure(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS, start_angle_, end_angle_,
+    config_cache_);
+  size_t window = os32c_->isExplicitConnectionOpen() ? 1 : window_;
+  pipeline_ = shared_ptr<RRScanPipeline>(new RRScanPipeline(*os32c_, window, rate_));
+  pipeline_->setReceiveTimeout(request_timeout_);
+  connected_ = true;
+}
+
+void RRScanPoller::close()
+{
+  if (connected_)
+  {
+    connected_ = false;
+    try
+    {
+      os32c_->closeExplicitConnection();
+    }
+    catch (std::runtime_error& ex)
+    {
+      // the scanner times it out regardless
+    }
+    os32c_->close();
+  }
+}
+
+void RRScanPoller::prefaultBuffers()
+{
+  int max_beams = OS32C::calcBeamNumber(OS32C::ANGLE_MIN) + 1;
+  prefault(rr_.range_data, max_beams);
+  prefault(rr_.reflectance_data, max_beams);
+}
+
+RRScanPoller::SpinResult RRScanPoller::spinOnce(double timeout)
+{
+  uint64_t now = monotonicNanoseconds();
+  uint64_t deadline = now + static_cast<uint64_t>(timeout * 1e9);
+
+  if (!connected_)
+  {
+    if (deadline < next_attempt_)
+    {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+      return DISCONNECTED;
+    }
+    if (now < next_attempt_)
+    {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(next_attempt_ - now));
+    }
+    try
+    {
+      connect();
+      ++reconnects_;
+      backoff_.reset();
+    }
+    catch (std::exception& ex)
+    {
+      disconnect(ex.what());
+    }
+    return DISCONNECTED;
+  }
+
+  uint64_t receive_time;
+  try
+  {
+    pipeline_->sendRequests(now);
+    if (!pipeline_->getOutstanding())
+    {
+      // wait for the rate to allow the next request, if it does in time
+      uint64_t next_send_time = pipeline_->getNextSendTime();
+      if (deadline < next_send_time)
+      {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(deadline - now));
+        return TIMED_OUT;
+      }
+      if (now < next_send_time)
+      {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(next_send_time - now));
+      }
+      if (!pipeline_->sendRequests(monotonicNanoseconds()))
+      {
+        return TIMED_OUT;
+      }
+    }
+    if (!pipeline_->receiveScan(rr_))
+    {
+      return REQUEST_REJECTED;
+    }
+    receive_time = monotonicNanoseconds();
+  }
+  catch (std::runtime_error& ex)
+  {
+    // the session failed or timed out, so no replies are coming on it
+    disconnect(ex.what());
+    return DISCONNECTED;
+  }
+  catch (std::length_error& ex)
+  {
+    // the rest of the stream cannot be framed, so start over on a new session
+    disconnect(ex.what());
+    return DISCONNECTED;
+  }
+  catch (std::logic_error& ex)
+  {
+    last_error_ = ex.what();
+    return MALFORMED_REPLY;
+  }
+  bool verifying = config_cache_ && config_cache_->isUnverified();
+  if (config_cache_ && config_cache_->checkChecksums(rr_.header))
+  {
+    ++config_changes_;
+  }
+  callback_(rr_, receive_time);
+  if (verifying && !config_cache_->isValid())
+  {
+    // connect again to read the configuration back and restore it
+    disconnect("Sensor configuration no longer matches the config cache");
+    return DISCONNECTED;
+  }
+  return SCAN_RECEIVED;
+}
+
+void RRScanPoller::disconnect(const string& reason)
+{
+  if (connected_)
+  {
+    ++disconnects_;
+    connected_ = false;
+    // A single reply timing out leaves the link up, so the session is
+    // unregistered if the scanner still answers, rather than left to expire.
+    try
+    {
+      os32c_->close();
+    }
+    catch (std::exception& ex)
+    {
+      // the session is presumed dead already
+    }
+  }
+  last_error_ = reason;
+  pipeline_.reset();
+  os32c_.reset();
+  next_attempt_ = monotonicNanoseconds() + static_cast<uint64_t>(backoff_.next() * 1e9);
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,144 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_stream.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <stdexcept>
+
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/scan_stream.h"
+
+namespace omron_os32c_driver {
+
+ScanStream::ScanStream(OS32C& os32c, const Callback& callback)
+  : os32c_(&os32c), callback_(callback),
+    keepalive_interval_(IOConnectionParams().getKeepaliveInterval() * 1e9),
+    next_keepalive_time_(monotonicNanoseconds() + keepalive_interval_),
+    lost_scans_(0), last_scan_count_(0), have_scan_count_(false), config_cache_(NULL),
+    config_changes_(0), malformed_packets_(0), last_decode_status_(DECODE_OK), running_(false)
+{
+}
+
+ScanStream::ScanStream(const Callback& callback)
+  : os32c_(NULL), callback_(callback),
+    keepalive_interval_(IOConnectionParams().getKeepaliveInterval() * 1e9),
+    next_keepalive_time_(monotonicNanoseconds() + keepalive_interval_),
+    lost_scans_(0), last_scan_count_(0), have_scan_count_(false), config_cache_(NULL),
+    config_changes_(0), malformed_packets_(0), last_decode_status_(DECODE_OK), running_(false)
+{
+}
+
+void ScanStream::setScanner(OS32C& os32c)
+{
+  os32c_ = &os32c;
+  next_keepalive_time_ = monotonicNanoseconds() + keepalive_interval_;
+  have_scan_count_ = false;
+}
+
+void ScanStream::setKeepaliveInterval(double interval)
+{
+  if (!(interval > 0))
+  {
+    throw std::invalid_argument("Keepalive interval must be positive");
+  }
+  keepalive_interval_ = interval * 1e9;
+  next_keepalive_time_ = monotonicNanoseconds() + keepalive_interval_;
+}
+
+bool ScanStream::sendKeepaliveIfDue(uint64_t now)
+{
+  if (now < next_keepalive_time_)
+  {
+    return false;
+  }
+  if (!os32c_)
+  {
+    throw std::logic_error("No scanner to send the keepalive to");
+  }
+  os32c_->sendKeepaliveUDP();
+  // keep to the schedule, unless so far behind it that keepalives would bunch up
+  next_keepalive_time_ += keepalive_interval_;
+  if (next_keepalive_time_ <= now)
+  {
+    next_keepalive_time_ = now + keepalive_interval_;
+  }
+  return true;
+}
+
+void ScanStream::prefaultBuffers()
+{
+  prefault(report_.measurement_data, OS32C::calcBeamNumber(OS32C::ANGLE_MIN) + 1);
+}
+
+bool ScanStream::spinOnce()
+{
+  if (!os32c_)
+  {
+    throw std::logic_error("No scanner to receive from");
+  }
+  DECODE_STATUS status = os32c_->tryReceiveMeasurementReportUDP(report_);
+  ScanView view;
+  view.receive_time = monotonicNanoseconds();
+  if (status != DECODE_OK)
+  {
+    ++malformed_packets_;
+    last_decode_status_ = status;
+    return false;
+  }
+  if (have_scan_count_ && report_.header.scan_count > last_scan_count_)
+  {
+    lost_scans_ += report_.header.scan_count - last_scan_count_ - 1;
+  }
+  last_scan_count_ = report_.header.scan_count;
+  have_scan_count_ = true;
+  if (config_cache_ && config_cache_->checkChecksums(report_.header))
+  {
+    ++config_changes_;
+  }
+
+  view.header = &report_.header;
+  view.num_beams = report_.header.num_beams;
+  view.ranges = view.num_beams ? &report_.measurement_data[0] : NULL;
+  view.start_angle = os32c_->getStartAngle();
+  view.angle_increment = -OS32C::ANGLE_INC;
+  callback_(view);
+
+  sendKeepaliveIfDue(monotonicNanoseconds());
+  return true;
+}
+
+void ScanStream::run()
+{
+  running_ = true;
+  while (running_)
+  {
+    spinOnce();
+  }
+}
+
+void ScanStream::stop()
+{
+  running_ = false;
+}
+
+} // namespace omron_os32c_driver
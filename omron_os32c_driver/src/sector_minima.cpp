@@ -0,0 +1,69 @@
+/**
+Software License Agreement (BSD)
+
+\file      sector_minima.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "omron_os32c_driver/sector_minima.h"
+
+namespace omron_os32c_driver {
+
+vector<BeamSector> splitSectors(size_t num_beams, int count)
+{
+  if (count < 1 || static_cast<size_t>(count) > num_beams)
+  {
+    throw std::invalid_argument("Number of sectors must be between one and the number of beams");
+  }
+  vector<BeamSector> sectors(count);
+  for (int i = 0; i < count; ++i)
+  {
+    sectors[i].first_beam = i * num_beams / count;
+    sectors[i].last_beam = (i + 1) * num_beams / count - 1;
+  }
+  return sectors;
+}
+
+void findSectorMinima(const EIP_UINT* ranges, const vector<BeamSector>& sectors,
+  SectorMinimum* minima)
+{
+  for (size_t s = 0; s < sectors.size(); ++s)
+  {
+    const EIP_UINT* first = ranges + sectors[s].first_beam;
+    const EIP_UINT* last = ranges + sectors[s].last_beam + 1;
+
+    // a noisy beam (0x0001) becomes 0xFFFF, the same as no return
+    EIP_UINT nearest = 0xFFFF;
+    for (const EIP_UINT* r = first; r < last; ++r)
+    {
+      EIP_UINT masked = *r | -static_cast<EIP_UINT>(*r == 0x0001);
+      nearest = std::min(nearest, masked);
+    }
+
+    minima[s].range = nearest;
+    minima[s].beam = nearest == 0xFFFF ? -1 : std::find(first, last, nearest) - ranges;
+  }
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,211 @@
+/**
+Software License Agreement (BSD)
+
+\file      timed_tcp_socket.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <cmath>
+#include <stdexcept>
+
+#include "omron_os32c_driver/timed_tcp_socket.h"
+
+using boost::asio::buffer_cast;
+using boost::asio::buffer_size;
+
+namespace omron_os32c_driver {
+
+constexpr double TimedTCPSocket::DEFAULT_TIMEOUT;
+
+TimedTCPSocket::TimedTCPSocket(boost::asio::io_service& io_service, double timeout)
+  : io_service_(io_service), socket_(io_service), timeout_(timeout)
+{
+  if (timeout <= 0)
+  {
+    throw std::invalid_argument("TCP timeout must be positive");
+  }
+}
+
+void TimedTCPSocket::open(string hostname, string port)
+{
+  tcp::resolver resolver(io_service_);
+  tcp::resolver::query query(hostname, port);
+  boost::system::error_code ec;
+  tcp::resolver::iterator it = resolver.resolve(query, ec);
+  if (ec)
+  {
+    throw std::runtime_error("Could not resolve " + hostname + ": " + ec.message());
+  }
+
+  int error = EHOSTUNREACH;
+  for (; it != tcp::resolver::iterator(); ++it)
+  {
+    error = connectTo(*it);
+    if (!error)
+    {
+      break;
+    }
+  }
+  if (error)
+  {
+    throw std::runtime_error("Could not connect to " + hostname + ": " + strerror(error));
+  }
+
+  // connecting took the socket out of blocking mode, which sends and
+  // receives rely on for their timeouts
+  timeval tv;
+  tv.tv_sec = timeout_;
+  tv.tv_usec = (timeout_ - tv.tv_sec) * 1000000;
+  if (setsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv))
+    || setsockopt(socket_.native_handle(), SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)))
+  {
+    error = errno;
+    socket_.close();
+    throw std::runtime_error(string("Could not set TCP timeouts: ") + strerror(error));
+  }
+}
+
+int TimedTCPSocket::connectTo(const tcp::endpoint& endpoint)
+{
+  boost::system::error_code ec;
+  socket_.close(ec);
+  socket_.open(endpoint.protocol(), ec);
+  if (ec)
+  {
+    return ec.value();
+  }
+
+  // connect without blocking, then wait for it to finish or the timeout
+  socket_.non_blocking(true, ec);
+  int error = 0;
+  if (::connect(socket_.native_handle(), endpoint.data(), endpoint.size()) && errno != EINPROGRESS)
+  {
+    error = errno;
+  }
+  else
+  {
+    pollfd fd;
+    fd.fd = socket_.native_handle();
+    fd.events = POLLOUT;
+    fd.revents = 0;
+    int ret;
+    do
+    {
+      ret = poll(&fd, 1, static_cast<int>(ceil(timeout_ * 1000)));
+    } while (ret < 0 && errno == EINTR);
+    socklen_t len = sizeof(error);
+    if (ret < 0)
+    {
+      error = errno;
+    }
+    else if (ret == 0)
+    {
+      error = ETIMEDOUT;
+    }
+    else if (getsockopt(socket_.native_handle(), SOL_SOCKET, SO_ERROR, &error, &len))
+    {
+      error = errno;
+    }
+  }
+
+  if (!error)
+  {
+    socket_.non_blocking(false, ec);
+    error = ec.value();
+  }
+  if (error)
+  {
+    socket_.close(ec);
+  }
+  return error;
+}
+
+void TimedTCPSocket::close()
+{
+  boost::system::error_code ec;
+  socket_.close(ec);
+}
+
+size_t TimedTCPSocket::send(const boost::asio::const_buffer& buf)
+{
+  const char* data = buffer_cast<const char*>(buf);
+  size_t size = buffer_size(buf);
+  size_t sent = 0;
+  while (sent < size)
+  {
+    ssize_t n = ::send(socket_.native_handle(), data + sent, size - sent, MSG_NOSIGNAL);
+    if (n < 0 && errno == EINTR)
+    {
+      continue;
+    }
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      throw std::runtime_error("Timed out sending explicit request");
+    }
+    if (n < 0)
+    {
+      throw std::runtime_error(string("Error sending explicit request: ") + strerror(errno));
+    }
+    sent += n;
+  }
+  return sent;
+}
+
+size_t TimedTCPSocket::receive(const boost::asio::mutable_buffer& buf)
+{
+  ssize_t n;
+  do
+  {
+    n = recv(socket_.native_handle(), buffer_cast<void*>(buf), buffer_size(buf), 0);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+  {
+    throw std::runtime_error("Timed out waiting for reply to explicit request");
+  }
+  if (n < 0)
+  {
+    throw std::runtime_error(string("Error receiving reply to explicit request: ")
+      + strerror(errno));
+  }
+  if (n == 0 && buffer_size(buf))
+  {
+    throw std::runtime_error("Scanner closed the explicit messaging connection");
+  }
+  return n;
+}
+
+string TimedTCPSocket::getLocalAddress() const
+{
+  boost::system::error_code ec;
+  tcp::endpoint endpoint = socket_.local_endpoint(ec);
+  if (ec)
+  {
+    throw std::runtime_error("No local address for explicit messaging: " + ec.message());
+  }
+  return endpoint.address().to_string();
+}
+
+} // namespace omron_os32c_driver
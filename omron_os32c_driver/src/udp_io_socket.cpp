@@ -0,0 +1,214 @@
+/**
+Software License Agreement (BSD)
+
+\file      udp_io_socket.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <cmath>
+#include <stdexcept>
+
+#include "omron_os32c_driver/udp_io_socket.h"
+
+using boost::asio::buffer_cast;
+using boost::asio::buffer_size;
+
+namespace omron_os32c_driver {
+
+UDPIOSocket::UDPIOSocket(boost::asio::io_service& io_service, unsigned short local_port)
+  : io_service_(io_service), socket_(io_service, udp::endpoint(udp::v4(), local_port)),
+    kernel_drops_(0)
+{
+}
+
+UDPIOSocket::UDPIOSocket(boost::asio::io_service& io_service)
+  : io_service_(io_service), socket_(io_service), kernel_drops_(0)
+{
+}
+
+void UDPIOSocket::open(string hostname, string port)
+{
+  udp::resolver resolver(io_service_);
+  udp::resolver::query query(udp::v4(), hostname, port);
+  remote_endpoint_ = *resolver.resolve(query);
+}
+
+void UDPIOSocket::close()
+{
+  socket_.close();
+}
+
+size_t UDPIOSocket::send(const boost::asio::const_buffer& buf)
+{
+  return socket_.send_to(boost::asio::buffer(buf), remote_endpoint_);
+}
+
+size_t UDPIOSocket::receive(const boost::asio::mutable_buffer& buf)
+{
+  iovec iov;
+  iov.iov_base = buffer_cast<void*>(buf);
+  iov.iov_len = buffer_size(buf);
+  char control[CMSG_SPACE(sizeof(uint32_t))];
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+
+  ssize_t n;
+  do
+  {
+    n = recvmsg(socket_.native_handle(), &msg, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+  {
+    throw std::runtime_error("Timed out receiving IO packet");
+  }
+  if (n < 0)
+  {
+    throw std::runtime_error(string("Error receiving IO packet: ") + strerror(errno));
+  }
+
+  for (cmsghdr* cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+  {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+    {
+      memcpy(&kernel_drops_, CMSG_DATA(cmsg), sizeof(kernel_drops_));
+    }
+  }
+  return n;
+}
+
+void UDPIOSocket::setReceiveTimeout(double timeout)
+{
+  if (timeout < 0)
+  {
+    throw std::invalid_argument("Receive timeout must not be negative");
+  }
+  timeval tv;
+  tv.tv_sec = timeout;
+  tv.tv_usec = (timeout - tv.tv_sec) * 1000000;
+  if (setsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)))
+  {
+    throw std::runtime_error(string("Could not set receive timeout: ") + strerror(errno));
+  }
+}
+
+bool UDPIOSocket::waitReadable(double timeout)
+{
+  pollfd fd;
+  fd.fd = socket_.native_handle();
+  fd.events = POLLIN;
+  fd.revents = 0;
+  int ret = poll(&fd, 1, timeout > 0 ? static_cast<int>(ceil(timeout * 1000)) : 0);
+  if (ret < 0 && errno != EINTR)
+  {
+    throw std::runtime_error(string("Could not wait for IO packet: ") + strerror(errno));
+  }
+  return ret > 0;
+}
+
+void UDPIOSocket::setOption(int level, int name, int value, const char* description)
+{
+  if (setsockopt(socket_.native_handle(), level, name, &value, sizeof(value)))
+  {
+    throw std::runtime_error(string("Could not set ") + description + ": " + strerror(errno));
+  }
+}
+
+int UDPIOSocket::setReceiveBufferSize(int size)
+{
+  // the kernel doubles the requested size to account for its overhead, and
+  // reports the doubled value back
+  if (setsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)))
+  {
+    setOption(SOL_SOCKET, SO_RCVBUF, size, "receive buffer size");
+  }
+
+  int actual = 0;
+  socklen_t len = sizeof(actual);
+  getsockopt(socket_.native_handle(), SOL_SOCKET, SO_RCVBUF, &actual, &len);
+  return actual;
+}
+
+void UDPIOSocket::setBusyPoll(int usec)
+{
+#ifdef SO_BUSY_POLL
+  setOption(SOL_SOCKET, SO_BUSY_POLL, usec, "busy poll time");
+#else
+  throw std::runtime_error("Busy polling is not supported on this system");
+#endif
+}
+
+void UDPIOSocket::setPriority(int priority)
+{
+  setOption(SOL_SOCKET, SO_PRIORITY, priority, "socket priority");
+}
+
+void UDPIOSocket::setDSCP(int dscp)
+{
+  if (dscp < 0 || dscp > 63)
+  {
+    throw std::invalid_argument("DSCP must be between 0 and 63");
+  }
+  // DSCP is the upper six bits of the TOS byte
+  setOption(IPPROTO_IP, IP_TOS, dscp << 2, "DSCP");
+}
+
+void UDPIOSocket::joinMulticastGroup(const string& group, const string& interface_address)
+{
+  ip_mreq mreq;
+  memset(&mreq, 0, sizeof(mreq));
+  if (inet_pton(AF_INET, group.c_str(), &mreq.imr_multiaddr) != 1
+    || !IN_MULTICAST(ntohl(mreq.imr_multiaddr.s_addr)))
+  {
+    throw std::invalid_argument("Not a multicast address: " + group);
+  }
+  if (interface_address.empty())
+  {
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+  }
+  else if (inet_pton(AF_INET, interface_address.c_str(), &mreq.imr_interface) != 1)
+  {
+    throw std::invalid_argument("Not an interface address: " + interface_address);
+  }
+  if (setsockopt(socket_.native_handle(), IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)))
+  {
+    throw std::runtime_error("Could not join multicast group " + group + ": " + strerror(errno));
+  }
+}
+
+void UDPIOSocket::enableDropCounting()
+{
+  setOption(SOL_SOCKET, SO_RXQ_OVFL, 1, "drop counting");
+}
+
+} // namespace omron_os32c_driver
@@ -0,0 +1,206 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_geometry_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstring>
+
+#include "omron_os32c_driver/beam_geometry.h"
+#include "omron_os32c_driver/os32c.h"
+
+using namespace omron_os32c_driver;
+
+class BeamGeometryTest : public :: testing :: Test
+{
+protected:
+  // the arithmetic the driver used before the tables, as the reference
+  static int legacyBeamNumber(double angle)
+  {
+    return (DEG2RAD(135.2) - angle + DEG2RAD(0.4) / 2) / DEG2RAD(0.4);
+  }
+
+  static double legacyBeamCentre(int beam)
+  {
+    return DEG2RAD(135.2) - beam * DEG2RAD(0.4);
+  }
+
+  // byte at a time mask construction the driver used before buildBeamMask,
+  // only valid if the beams start on a byte boundary or span more than one byte
+  static void legacyBeamMask(int start_beam, int end_beam, EIP_BYTE mask[])
+  {
+    int start_byte = start_beam / 8;
+    int start_bit = start_beam - start_byte * 8;
+    int end_byte = end_beam / 8;
+    int end_bit = end_beam - end_byte * 8;
+    if (start_byte > 0)
+    {
+      memset(mask, 0, start_byte);
+    }
+    if (start_bit)
+    {
+      mask[start_byte] = ~((1 << start_bit) - 1);
+    }
+    else
+    {
+      --start_byte;
+    }
+    memset(mask + start_byte + 1, 0xFF, end_byte - start_byte - 1);
+    mask[end_byte] = (1 << (end_bit + 1)) - 1;
+    memset(mask + end_byte + 1, 0, 87 - end_byte);
+  }
+
+  static void referenceBeamMask(int start_beam, int end_beam, EIP_BYTE mask[])
+  {
+    memset(mask, 0, BEAM_MASK_BYTES);
+    for (int b = start_beam; b <= end_beam; ++b)
+    {
+      mask[b / 8] |= 1 << (b % 8);
+    }
+  }
+};
+
+TEST_F(BeamGeometryTest, test_constants)
+{
+  EXPECT_EQ(DEG2RAD(135.2), BEAM_ANGLE_MAX);
+  EXPECT_EQ(DEG2RAD(-135.2), BEAM_ANGLE_MIN);
+  EXPECT_EQ(DEG2RAD(0.4), BEAM_ANGLE_INC);
+  EXPECT_EQ(BEAM_COUNT - 1, beamNumber(BEAM_ANGLE_MIN));
+  EXPECT_EQ(BEAM_MASK_BYTES * 8 - 27, BEAM_COUNT);
+  EXPECT_EQ(OS32C::ANGLE_MAX, BEAM_ANGLE_MAX);
+  EXPECT_EQ(OS32C::ANGLE_MIN, BEAM_ANGLE_MIN);
+  EXPECT_EQ(OS32C::ANGLE_INC, BEAM_ANGLE_INC);
+}
+
+TEST_F(BeamGeometryTest, test_compile_time)
+{
+  static_assert(beamNumber(0) == 338, "beam straight ahead");
+  static_assert(BeamGeometry::angles[0] == BEAM_ANGLE_MAX, "first beam angle");
+  static_assert(BeamGeometry::cosines[338] > 0.9999, "beam straight ahead");
+  static_assert(sizeof(BeamGeometry::sines) == BEAM_COUNT * sizeof(double), "table size");
+}
+
+TEST_F(BeamGeometryTest, test_beam_number_sweep)
+{
+  // every hundredth of a beam across the scan and half a beam past each end
+  for (int i = -50; i <= (BEAM_COUNT - 1) * 100 + 50; ++i)
+  {
+    double angle = BEAM_ANGLE_MAX - i * BEAM_ANGLE_INC / 100;
+    ASSERT_EQ(legacyBeamNumber(angle), beamNumber(angle)) << "angle " << angle;
+    ASSERT_EQ(legacyBeamNumber(angle), OS32C::calcBeamNumber(angle)) << "angle " << angle;
+  }
+}
+
+TEST_F(BeamGeometryTest, test_angles)
+{
+  for (int b = 0; b < BEAM_COUNT; ++b)
+  {
+    ASSERT_EQ(legacyBeamCentre(b), BeamGeometry::angles[b]) << "beam " << b;
+    ASSERT_EQ(legacyBeamCentre(b), beamCentre(b)) << "beam " << b;
+    ASSERT_EQ(legacyBeamCentre(b), OS32C::calcBeamCentre(b)) << "beam " << b;
+    ASSERT_EQ(b, beamNumber(BeamGeometry::angles[b])) << "beam " << b;
+  }
+}
+
+TEST_F(BeamGeometryTest, test_sines_and_cosines)
+{
+  for (int b = 0; b < BEAM_COUNT; ++b)
+  {
+    double angle = legacyBeamCentre(b);
+    ASSERT_NEAR(std::sin(angle), BeamGeometry::sines[b], 1e-14) << "beam " << b;
+    ASSERT_NEAR(std::cos(angle), BeamGeometry::cosines[b], 1e-14) << "beam " << b;
+  }
+  // the scan is symmetric about straight ahead
+  EXPECT_NEAR(0, BeamGeometry::sines[338], 1e-14);
+  EXPECT_NEAR(1, BeamGeometry::cosines[338], 1e-14);
+  EXPECT_NEAR(-BeamGeometry::sines[0], BeamGeometry::sines[BEAM_COUNT - 1], 1e-14);
+  EXPECT_NEAR(BeamGeometry::cosines[0], BeamGeometry::cosines[BEAM_COUNT - 1], 1e-14);
+}
+
+TEST_F(BeamGeometryTest, test_mask_all_sectors)
+{
+  EIP_BYTE mask[BEAM_MASK_BYTES];
+  EIP_BYTE expected[BEAM_MASK_BYTES];
+  EIP_BYTE legacy[BEAM_MASK_BYTES];
+  for (int start = 0; start < BEAM_COUNT; ++start)
+  {
+    for (int end = start; end < BEAM_COUNT; ++end)
+    {
+      memset(mask, 0xAA, sizeof(mask));
+      buildBeamMask(vector<BeamSector>(1, BeamSector{start, end}), mask);
+      referenceBeamMask(start, end, expected);
+      ASSERT_EQ(0, memcmp(expected, mask, sizeof(mask))) << start << " to " << end;
+      if (start % 8 == 0 || start / 8 < end / 8)
+      {
+        legacyBeamMask(start, end, legacy);
+        ASSERT_EQ(0, memcmp(legacy, mask, sizeof(mask))) << start << " to " << end;
+      }
+    }
+  }
+}
+
+TEST_F(BeamGeometryTest, test_mask_multiple_sectors)
+{
+  vector<BeamSector> sectors;
+  sectors.push_back(BeamSector{0, 2});
+  sectors.push_back(BeamSector{60, 70});
+  sectors.push_back(BeamSector{65, 130});
+  sectors.push_back(BeamSector{676, 676});
+
+  EIP_BYTE mask[BEAM_MASK_BYTES];
+  buildBeamMask(sectors, mask);
+  EIP_BYTE expected[BEAM_MASK_BYTES];
+  EIP_BYTE part[BEAM_MASK_BYTES];
+  memset(expected, 0, sizeof(expected));
+  for (size_t i = 0; i < sectors.size(); ++i)
+  {
+    referenceBeamMask(sectors[i].first_beam, sectors[i].last_beam, part);
+    for (int j = 0; j < BEAM_MASK_BYTES; ++j)
+    {
+      expected[j] |= part[j];
+    }
+  }
+  EXPECT_EQ(0, memcmp(expected, mask, sizeof(mask)));
+  EXPECT_EQ(0x07, mask[0]);
+  EXPECT_EQ(0x10, mask[84]);
+  EXPECT_EQ(0, mask[85]);
+
+  // no sectors selects nothing
+  buildBeamMask(vector<BeamSector>(), mask);
+  for (int j = 0; j < BEAM_MASK_BYTES; ++j)
+  {
+    EXPECT_EQ(0, mask[j]);
+  }
+}
+
+TEST_F(BeamGeometryTest, test_mask_invalid_sectors)
+{
+  EIP_BYTE mask[BEAM_MASK_BYTES];
+  EXPECT_THROW(buildBeamMask(vector<BeamSector>(1, BeamSector{-1, 10}), mask),
+    std::invalid_argument);
+  EXPECT_THROW(buildBeamMask(vector<BeamSector>(1, BeamSector{10, BEAM_COUNT}), mask),
+    std::invalid_argument);
+  EXPECT_THROW(buildBeamMask(vector<BeamSector>(1, BeamSector{11, 10}), mask),
+    std::invalid_argument);
+}
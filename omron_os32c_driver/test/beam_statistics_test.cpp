@@ -0,0 +1,215 @@
+/**
+Software License Agreement (BSD)
+
+\file      beam_statistics_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+
+#include "omron_os32c_driver/beam_statistics.h"
+
+using namespace omron_os32c_driver;
+
+class BeamStatisticsTest : public :: testing :: Test
+{
+protected:
+  BeamStatistics stats;
+  BeamStatisticsThresholds thresholds;
+};
+
+TEST_F(BeamStatisticsTest, test_mean_and_variance)
+{
+  EIP_UINT values[] = { 1000, 1010, 990, 1004, 996 };
+  for (int i = 0; i < 5; ++i)
+  {
+    EIP_UINT ranges[] = { values[i], 2000 };
+    EIP_UINT reflectance[] = { (EIP_UINT)(values[i] / 10), 300 };
+    stats.update(ranges, reflectance, 2, 100);
+  }
+
+  EXPECT_EQ(5, stats.getScans());
+  EXPECT_EQ(5, stats.getSamples(100));
+  EXPECT_EQ(0, stats.getSamples(99));
+  EXPECT_FLOAT_EQ(1000, stats.getRangeMean(100));
+  // sample variance of 0, 10, -10, 4, -4
+  EXPECT_FLOAT_EQ(58, stats.getRangeVariance(100));
+  EXPECT_FLOAT_EQ(2000, stats.getRangeMean(101));
+  EXPECT_FLOAT_EQ(0, stats.getRangeVariance(101));
+  EXPECT_FLOAT_EQ(300, stats.getReflectanceMean(101));
+}
+
+TEST_F(BeamStatisticsTest, test_invalid_samples)
+{
+  EIP_UINT scans[][3] = {
+    { 1000, 0x0001, 0xFFFF },
+    { 1002, 0xFFFF, 0xFFFF },
+    { 0x0001, 500, 0xFFFF },
+    { 1004, 0x0001, 0xFFFF },
+  };
+  for (int i = 0; i < 4; ++i)
+  {
+    stats.update(scans[i], NULL, 3, 0);
+  }
+
+  // invalid samples count towards the rates, but not the mean
+  EXPECT_FLOAT_EQ(1002, stats.getRangeMean(0));
+  EXPECT_FLOAT_EQ(4, stats.getRangeVariance(0));
+  EXPECT_FLOAT_EQ(0.25, stats.getNoisyRate(0));
+  EXPECT_FLOAT_EQ(500, stats.getRangeMean(1));
+  EXPECT_FLOAT_EQ(0, stats.getRangeVariance(1));
+  EXPECT_FLOAT_EQ(0.5, stats.getNoisyRate(1));
+  EXPECT_FLOAT_EQ(0.25, stats.getNoReturnRate(1));
+  EXPECT_FLOAT_EQ(0, stats.getRangeMean(2));
+  EXPECT_FLOAT_EQ(1, stats.getNoReturnRate(2));
+}
+
+TEST_F(BeamStatisticsTest, test_out_of_range)
+{
+  EIP_UINT ranges[BEAM_COUNT + 1] = { 0 };
+  EXPECT_NO_THROW(stats.update(ranges, NULL, BEAM_COUNT, 0));
+  EXPECT_NO_THROW(stats.update(ranges, NULL, 1, BEAM_COUNT - 1));
+  EXPECT_THROW(stats.update(ranges, NULL, BEAM_COUNT + 1, 0), std::invalid_argument);
+  EXPECT_THROW(stats.update(ranges, NULL, 2, BEAM_COUNT - 1), std::invalid_argument);
+  EXPECT_THROW(stats.update(ranges, NULL, 1, -1), std::invalid_argument);
+  EXPECT_THROW(BeamStatistics(0), std::invalid_argument);
+}
+
+TEST_F(BeamStatisticsTest, test_summary_flags_noisy)
+{
+  EIP_UINT ranges[BEAM_COUNT];
+  for (int scan = 0; scan < 10; ++scan)
+  {
+    for (int i = 0; i < BEAM_COUNT; ++i)
+    {
+      ranges[i] = 1000;
+    }
+    // beam 20 is noisy in every other scan
+    ranges[20] = scan % 2 ? 0x0001 : 1000;
+    stats.update(ranges, NULL, BEAM_COUNT, 0);
+  }
+
+  BeamStatisticsSummary summary = stats.summarize(thresholds);
+  EXPECT_EQ(10, summary.scans);
+  EXPECT_EQ(16, summary.sector_beams);
+  ASSERT_EQ(43, summary.sector_noisy_rate.size());
+  EXPECT_FLOAT_EQ(5.0 / (10 * BEAM_COUNT), summary.noisy_rate);
+  EXPECT_FLOAT_EQ(0, summary.no_return_rate);
+  EXPECT_FLOAT_EQ(5.0 / 160, summary.sector_noisy_rate[1]);
+  EXPECT_FLOAT_EQ(0, summary.sector_noisy_rate[0]);
+  ASSERT_EQ(1, summary.flagged_beams.size());
+  EXPECT_EQ(20, summary.flagged_beams[0]);
+  EXPECT_EQ(0, summary.flagged_sectors.size());
+
+  // the summary starts a new period
+  EXPECT_EQ(0, stats.getScans());
+  EXPECT_EQ(0, stats.getSamples(20));
+}
+
+TEST_F(BeamStatisticsTest, test_summary_drift_from_baseline)
+{
+  EIP_UINT ranges[32];
+  EIP_UINT reflectance[32];
+  for (int i = 0; i < 32; ++i)
+  {
+    ranges[i] = 1000;
+    reflectance[i] = 400;
+  }
+  stats.update(ranges, reflectance, 32, 0);
+  BeamStatisticsSummary summary = stats.summarize(thresholds);
+  EXPECT_EQ(0, summary.flagged_beams.size());
+
+  // reflectance of the first sector falls by half, and beam 20 loses its return
+  for (int i = 0; i < 16; ++i)
+  {
+    reflectance[i] = 200;
+  }
+  ranges[20] = 0xFFFF;
+  stats.update(ranges, reflectance, 32, 0);
+  summary = stats.summarize(thresholds);
+  ASSERT_EQ(17, summary.flagged_beams.size());
+  EXPECT_EQ(0, summary.flagged_beams[0]);
+  EXPECT_EQ(20, summary.flagged_beams[16]);
+  ASSERT_EQ(1, summary.flagged_sectors.size());
+  EXPECT_EQ(0, summary.flagged_sectors[0]);
+
+  // with a new baseline, the same scan is not flagged
+  stats.resetBaseline();
+  stats.update(ranges, reflectance, 32, 0);
+  stats.summarize(thresholds);
+  stats.update(ranges, reflectance, 32, 0);
+  summary = stats.summarize(thresholds);
+  EXPECT_EQ(0, summary.flagged_beams.size());
+  EXPECT_EQ(0, summary.flagged_sectors.size());
+}
+
+TEST_F(BeamStatisticsTest, test_summary_reflectance_of_valid_beams)
+{
+  // only the change in reflectance is of interest here
+  thresholds.no_return_rise = 1;
+  EIP_UINT ranges[16];
+  EIP_UINT reflectance[16];
+  for (int i = 0; i < 16; ++i)
+  {
+    ranges[i] = 1000;
+    reflectance[i] = 400;
+  }
+  stats.update(ranges, reflectance, 16, 0);
+  stats.summarize(thresholds);
+
+  // half the beams lose their return, which says nothing of the reflectance
+  for (int i = 0; i < 8; ++i)
+  {
+    ranges[i] = 0xFFFF;
+    reflectance[i] = 0;
+  }
+  stats.update(ranges, reflectance, 16, 0);
+  BeamStatisticsSummary summary = stats.summarize(thresholds);
+  EXPECT_EQ(0, summary.flagged_beams.size());
+  EXPECT_EQ(0, summary.flagged_sectors.size());
+
+  // while a fall over the beams that still return is flagged
+  for (int i = 8; i < 16; ++i)
+  {
+    reflectance[i] = 200;
+  }
+  stats.update(ranges, reflectance, 16, 0);
+  summary = stats.summarize(thresholds);
+  EXPECT_EQ(8, summary.flagged_beams.size());
+  ASSERT_EQ(1, summary.flagged_sectors.size());
+  EXPECT_EQ(0, summary.flagged_sectors[0]);
+}
+
+TEST_F(BeamStatisticsTest, test_summary_range_stddev)
+{
+  thresholds.range_stddev = 10;
+  EIP_UINT first[] = { 1000, 1000 };
+  EIP_UINT second[] = { 1002, 1040 };
+  stats.update(first, NULL, 2, 0);
+  stats.update(second, NULL, 2, 0);
+  BeamStatisticsSummary summary = stats.summarize(thresholds);
+  ASSERT_EQ(1, summary.flagged_beams.size());
+  EXPECT_EQ(1, summary.flagged_beams[0]);
+  EXPECT_FLOAT_EQ((std::sqrt(2.0) + std::sqrt(800.0)) / 2, summary.sector_range_stddev[0]);
+  ASSERT_EQ(1, summary.flagged_sectors.size());
+}
@@ -0,0 +1,166 @@
+/**
+Software License Agreement (BSD)
+
+\file      compact_scan_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/compact_scan.h"
+#include "omron_os32c_driver/ros_conversions.h"
+
+using namespace omron_os32c_driver;
+
+class CompactScanTest : public :: testing :: Test
+{
+
+};
+
+static void fillHeader(MeasurementReportHeader& mrh, EIP_UINT num_beams)
+{
+  mrh.scan_count = 0xDEADBEEF;
+  mrh.scan_rate = 38609;
+  mrh.scan_timestamp = 140420933;
+  mrh.scan_beam_period = 42898;
+  mrh.machine_state = 3;
+  mrh.machine_stop_reasons = 7;
+  mrh.active_zone_set = 0;
+  mrh.zone_inputs = 0;
+  mrh.detection_zone_status = 0;
+  mrh.output_status = 0;
+  mrh.input_status = 0;
+  mrh.display_status = 0x1B1B;
+  mrh.range_report_format = RANGE_MEASURE_50M;
+  mrh.refletivity_report_format = REFLECTIVITY_MEASURE_TOT_4PS;
+  mrh.num_beams = num_beams;
+}
+
+TEST_F(CompactScanTest, test_decode_range)
+{
+  EXPECT_FLOAT_EQ( 0.0  , decodeRange(0x0001, 50));
+  EXPECT_FLOAT_EQ(50.0  , decodeRange(0xFFFF, 50));
+  EXPECT_FLOAT_EQ( 1.253, decodeRange(1253, 50));
+  EXPECT_FLOAT_EQ(65.534, decodeRange(0xFFFE, 50));
+}
+
+TEST_F(CompactScanTest, test_convert_measurement_report)
+{
+  MeasurementReport mr;
+  fillHeader(mr.header, 5);
+  mr.measurement_data.resize(5);
+  mr.measurement_data[0] = 1000;
+  mr.measurement_data[1] = 1;
+  mr.measurement_data[2] = 48750;
+  mr.measurement_data[3] = 65535;
+  mr.measurement_data[4] = 1253;
+
+  CompactScan cs;
+  convertToCompactScan(mr, &cs);
+  EXPECT_FLOAT_EQ(42898E-9, cs.time_increment);
+  EXPECT_FLOAT_EQ(0.038609, cs.scan_time);
+  EXPECT_EQ(0xDEADBEEF, cs.scan_count);
+  ASSERT_EQ(5, cs.ranges.size());
+  EXPECT_EQ(1000, cs.ranges[0]);
+  EXPECT_EQ(1, cs.ranges[1]);
+  EXPECT_EQ(48750, cs.ranges[2]);
+  EXPECT_EQ(65535, cs.ranges[3]);
+  EXPECT_EQ(1253, cs.ranges[4]);
+  EXPECT_EQ(0, cs.intensities.size());
+
+  // expanding the compact scan must give the same result as direct conversion
+  cs.range_max = OS32C::DISTANCE_MAX;
+  sensor_msgs::LaserScan direct, expanded;
+  convertToLaserScan(mr, &direct);
+  convertToLaserScan(cs, &expanded);
+  EXPECT_FLOAT_EQ(direct.time_increment, expanded.time_increment);
+  EXPECT_FLOAT_EQ(direct.scan_time, expanded.scan_time);
+  ASSERT_EQ(direct.ranges.size(), expanded.ranges.size());
+  for (size_t i = 0; i < direct.ranges.size(); ++i)
+  {
+    EXPECT_FLOAT_EQ(direct.ranges[i], expanded.ranges[i]);
+  }
+  EXPECT_EQ(0, expanded.intensities.size());
+}
+
+TEST_F(CompactScanTest, test_convert_range_and_reflectance)
+{
+  RangeAndReflectanceMeasurement rr;
+  fillHeader(rr.header, 4);
+  rr.range_data.resize(4);
+  rr.reflectance_data.resize(4);
+  rr.range_data[0] = 1000;
+  rr.range_data[1] = 1;
+  rr.range_data[2] = 65535;
+  rr.range_data[3] = 49999;
+  rr.reflectance_data[0] = 44000;
+  rr.reflectance_data[1] = 0;
+  rr.reflectance_data[2] = 65535;
+  rr.reflectance_data[3] = 1013;
+
+  CompactScan cs;
+  convertToCompactScan(rr, &cs);
+  ASSERT_EQ(4, cs.ranges.size());
+  ASSERT_EQ(4, cs.intensities.size());
+  EXPECT_EQ(49999, cs.ranges[3]);
+  EXPECT_EQ(44000, cs.intensities[0]);
+  EXPECT_EQ(1013, cs.intensities[3]);
+
+  cs.range_max = OS32C::DISTANCE_MAX;
+  sensor_msgs::LaserScan direct, expanded;
+  convertToLaserScan(rr, &direct);
+  convertToLaserScan(cs, &expanded);
+  ASSERT_EQ(direct.ranges.size(), expanded.ranges.size());
+  ASSERT_EQ(direct.intensities.size(), expanded.intensities.size());
+  for (size_t i = 0; i < direct.ranges.size(); ++i)
+  {
+    EXPECT_FLOAT_EQ(direct.ranges[i], expanded.ranges[i]);
+    EXPECT_FLOAT_EQ(direct.intensities[i], expanded.intensities[i]);
+  }
+}
+
+TEST_F(CompactScanTest, test_convert_size_mismatch)
+{
+  MeasurementReport mr;
+  fillHeader(mr.header, 5);
+  mr.measurement_data.resize(4);
+  CompactScan cs;
+  EXPECT_THROW(convertToCompactScan(mr, &cs), std::invalid_argument);
+}
+
+TEST_F(CompactScanTest, test_static_angles)
+{
+  CompactScan cs;
+  cs.angle_start = 0.6911503837897546;
+  cs.angle_increment = -OS32C::ANGLE_INC;
+  cs.range_min = OS32C::DISTANCE_MIN;
+  cs.range_max = OS32C::DISTANCE_MAX;
+  cs.ranges.resize(201, 1000);
+
+  sensor_msgs::LaserScan ls;
+  convertToLaserScan(cs, &ls);
+  EXPECT_FLOAT_EQ(0.6911503837897546, ls.angle_max);
+  EXPECT_NEAR(-0.70511301780570967, ls.angle_min, 1e-6);
+  EXPECT_FLOAT_EQ(OS32C::ANGLE_INC, ls.angle_increment);
+  EXPECT_FLOAT_EQ(OS32C::DISTANCE_MIN, ls.range_min);
+  EXPECT_FLOAT_EQ(OS32C::DISTANCE_MAX, ls.range_max);
+}
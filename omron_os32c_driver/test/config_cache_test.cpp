@@ -0,0 +1,215 @@
+/**
+Software License Agreement (BSD)
+
+\file      config_cache_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <string>
+
+#include "omron_os32c_driver/config_cache.h"
+
+using std::string;
+using namespace omron_os32c_driver;
+
+class ConfigCacheTest : public :: testing :: Test
+{
+protected:
+  virtual void SetUp()
+  {
+    char name[] = "/tmp/os32c_config_cache_XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    unlink(name);
+    path = name;
+
+    config.range_format = 1;
+    config.reflectivity_format = 2;
+    config.beam_mask[0] = 0xFF;
+    config.beam_mask[42] = 0x0F;
+    config.beam_mask[87] = 0x1F;
+
+    header.non_safety_config_checksum = 0x3388;
+    header.safety_config_checksum = 0x31AE;
+  }
+
+  virtual void TearDown()
+  {
+    unlink(path.c_str());
+  }
+
+  string path;
+  ScannerConfig config;
+  MeasurementReportHeader header;
+};
+
+TEST_F(ConfigCacheTest, test_missing_file)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  EXPECT_FALSE(cache.load());
+  EXPECT_FALSE(cache.isValid());
+  EXPECT_FALSE(cache.matches(config));
+}
+
+TEST_F(ConfigCacheTest, test_not_trusted_until_checksums_seen)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  cache.setApplied(config);
+  EXPECT_FALSE(cache.isValid());
+  EXPECT_FALSE(cache.matches(config));
+
+  EXPECT_FALSE(cache.checkChecksums(header));
+  EXPECT_TRUE(cache.isValid());
+  EXPECT_TRUE(cache.matches(config));
+  EXPECT_EQ(0x3388, cache.getNonSafetyConfigChecksum());
+  EXPECT_EQ(0x31AE, cache.getSafetyConfigChecksum());
+
+  ScannerConfig other = config;
+  other.beam_mask[10] = 0x01;
+  EXPECT_FALSE(cache.matches(other));
+}
+
+TEST_F(ConfigCacheTest, test_save_and_load)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  cache.setApplied(config);
+  cache.checkChecksums(header);
+  // recording the checksums leaves saving to the owner
+  EXPECT_TRUE(cache.isDirty());
+  cache.save();
+  EXPECT_FALSE(cache.isDirty());
+
+  ConfigCache loaded(path, "192.168.1.1");
+  ASSERT_TRUE(loaded.load());
+  EXPECT_TRUE(loaded.isValid());
+  EXPECT_TRUE(loaded.matches(config));
+  EXPECT_EQ(0x3388, loaded.getNonSafetyConfigChecksum());
+  EXPECT_EQ(0x31AE, loaded.getSafetyConfigChecksum());
+}
+
+TEST_F(ConfigCacheTest, test_other_host_ignored)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  cache.setApplied(config);
+  cache.checkChecksums(header);
+  cache.save();
+
+  ConfigCache other(path, "192.168.1.2");
+  EXPECT_FALSE(other.load());
+  EXPECT_FALSE(other.matches(config));
+}
+
+TEST_F(ConfigCacheTest, test_checksum_change_invalidates)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  cache.setApplied(config);
+  cache.checkChecksums(header);
+  cache.save();
+  EXPECT_FALSE(cache.checkChecksums(header));
+  EXPECT_TRUE(cache.isValid());
+  EXPECT_FALSE(cache.isDirty());
+
+  header.safety_config_checksum = 0x1234;
+  EXPECT_TRUE(cache.checkChecksums(header));
+  EXPECT_FALSE(cache.isValid());
+  EXPECT_FALSE(cache.matches(config));
+  // only reported once
+  EXPECT_FALSE(cache.checkChecksums(header));
+
+  // and the invalidation is left to be saved
+  EXPECT_TRUE(cache.isDirty());
+  cache.save();
+  ConfigCache loaded(path, "192.168.1.1");
+  loaded.load();
+  EXPECT_FALSE(loaded.isValid());
+}
+
+TEST_F(ConfigCacheTest, test_trusted_config_verified)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  cache.setApplied(config);
+  cache.checkChecksums(header);
+
+  // the first report after trusting the cache has the formats and beam count
+  // of the configuration, 8 + 4 + 5 beams
+  header.range_report_format = 1;
+  header.num_beams = 17;
+  cache.setTrusted();
+  EXPECT_TRUE(cache.isUnverified());
+  EXPECT_FALSE(cache.checkChecksums(header));
+  EXPECT_FALSE(cache.isUnverified());
+  EXPECT_TRUE(cache.matches(config));
+
+  // later reports are only checked for changed checksums
+  header.num_beams = 16;
+  EXPECT_FALSE(cache.checkChecksums(header));
+  cache.setTrusted();
+  EXPECT_TRUE(cache.checkChecksums(header));
+  EXPECT_FALSE(cache.isValid());
+}
+
+TEST_F(ConfigCacheTest, test_corrupt_file)
+{
+  std::ofstream file(path.c_str());
+  file << "host 192.168.1.1" << std::endl;
+  file << "range_format 1" << std::endl;
+  file << "reflectivity_format 2" << std::endl;
+  file << "beam_mask 00ff" << std::endl;
+  file << "non_safety_config_checksum 3388" << std::endl;
+  file << "safety_config_checksum 31ae" << std::endl;
+  file.close();
+
+  ConfigCache cache(path, "192.168.1.1");
+  EXPECT_FALSE(cache.load());
+  EXPECT_FALSE(cache.isValid());
+}
+
+TEST_F(ConfigCacheTest, test_save_failure)
+{
+  ConfigCache cache("/nonexistent/dir/cache", "192.168.1.1");
+  EXPECT_THROW(cache.checkWritable(), std::runtime_error);
+
+  // checking a report never fails on the file
+  cache.setApplied(config);
+  EXPECT_NO_THROW(cache.checkChecksums(header));
+  EXPECT_THROW(cache.save(), std::runtime_error);
+  EXPECT_FALSE(cache.isDirty());
+}
+
+TEST_F(ConfigCacheTest, test_check_writable)
+{
+  ConfigCache cache(path, "192.168.1.1");
+  cache.setApplied(config);
+  cache.checkChecksums(header);
+  cache.save();
+
+  // an existing cache is left as it is
+  EXPECT_NO_THROW(cache.checkWritable());
+  ConfigCache loaded(path, "192.168.1.1");
+  EXPECT_TRUE(loaded.load());
+  EXPECT_TRUE(loaded.matches(config));
+}
@@ -0,0 +1,208 @@
+/**
+Software License Agreement (BSD)
+
+\file      connected_messaging_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <stdexcept>
+
+#include "omron_os32c_driver/connected_messaging.h"
+#include "odva_ethernetip/serialization/serializable_primitive.h"
+
+using namespace omron_os32c_driver;
+using namespace eip;
+using namespace eip::serialization;
+
+class ConnectedMessagingTest : public :: testing :: Test
+{
+
+};
+
+// reply of the Message Router to a Get Attribute Single of the range format,
+// on connection 0x11223344 with sequence count 5
+static EIP_BYTE REPLY[] = {
+  0x70, 0x00, 0x1C, 0x00, 0x78, 0x56, 0x34, 0x12,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+  0xA1, 0x00, 0x04, 0x00, 0x44, 0x33, 0x22, 0x11,
+  0xB1, 0x00, 0x08, 0x00, 0x05, 0x00, 0x8E, 0x00,
+  0x00, 0x00, 0x03, 0x00,
+};
+
+TEST_F(ConnectedMessagingTest, test_encode_send_unit_data)
+{
+  EIP_BYTE buf[128];
+  SerializablePrimitive<EIP_UINT> data(3);
+  size_t size = encodeSendUnitData(0x12345678, 0xAABBCCDD, 0x0102, 0x10, Path(0x73, 1, 4),
+    &data, buf, sizeof(buf));
+
+  EIP_BYTE expected[] = {
+    0x70, 0x00, 0x20, 0x00, 0x78, 0x56, 0x34, 0x12,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0xA1, 0x00, 0x04, 0x00, 0xDD, 0xCC, 0xBB, 0xAA,
+    0xB1, 0x00, 0x0C, 0x00, 0x02, 0x01, 0x10, 0x03,
+    0x20, 0x73, 0x24, 0x01, 0x30, 0x04, 0x03, 0x00,
+  };
+  ASSERT_EQ(sizeof(expected), size);
+  for (size_t i = 0; i < sizeof(expected); ++i)
+  {
+    EXPECT_EQ(expected[i], buf[i]) << "at byte " << i;
+  }
+  EXPECT_EQ(size, getEncapsulationLength(buf, size));
+}
+
+TEST_F(ConnectedMessagingTest, test_encode_without_data)
+{
+  EIP_BYTE buf[128];
+  size_t size = encodeSendUnitData(1, 2, 3, 0x0E, Path(0x73, 1, 4), NULL, buf, sizeof(buf));
+  EXPECT_EQ(54, size);
+  EXPECT_EQ(0x1E, buf[2]);
+  EXPECT_EQ(0x0A, buf[42]);
+}
+
+TEST_F(ConnectedMessagingTest, test_encode_buffer_too_small)
+{
+  EIP_BYTE buf[40];
+  EXPECT_THROW(encodeSendUnitData(1, 2, 3, 0x0E, Path(0x73, 1, 4), NULL, buf, sizeof(buf)),
+    std::length_error);
+}
+
+TEST_F(ConnectedMessagingTest, test_encapsulation_length)
+{
+  EXPECT_EQ(0, getEncapsulationLength(REPLY, 23));
+  EXPECT_EQ(sizeof(REPLY), getEncapsulationLength(REPLY, 24));
+  EXPECT_EQ(sizeof(REPLY), getEncapsulationLength(REPLY, sizeof(REPLY)));
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_reply)
+{
+  MessageRouterReply reply = decodeSendUnitDataReply(REPLY, sizeof(REPLY), 0x11223344, 5);
+  EXPECT_EQ(0x8E, reply.service);
+  EXPECT_EQ(0, reply.general_status);
+  EXPECT_EQ(0, reply.additional_status.size());
+  ASSERT_EQ(2, reply.data.size());
+  EXPECT_EQ(3, reply.data[0]);
+  EXPECT_EQ(0, reply.data[1]);
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_any_reply)
+{
+  EIP_UINT sequence_count = 0;
+  MessageRouterReply reply = decodeSendUnitDataReply(REPLY, sizeof(REPLY), 0x11223344,
+    &sequence_count);
+  EXPECT_EQ(5, sequence_count);
+  EXPECT_EQ(0x8E, reply.service);
+  EXPECT_EQ(2, reply.data.size());
+  EXPECT_THROW(decodeSendUnitDataReply(REPLY, sizeof(REPLY), 0x11223345, &sequence_count),
+    std::logic_error);
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_error_status)
+{
+  EIP_BYTE buf[] = {
+    0x70, 0x00, 0x1C, 0x00, 0x78, 0x56, 0x34, 0x12,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0xA1, 0x00, 0x04, 0x00, 0x44, 0x33, 0x22, 0x11,
+    0xB1, 0x00, 0x08, 0x00, 0x05, 0x00, 0x8E, 0x00,
+    0x1F, 0x01, 0x05, 0x01,
+  };
+  MessageRouterReply reply = decodeSendUnitDataReply(buf, sizeof(buf), 0x11223344, 5);
+  EXPECT_EQ(0x1F, reply.general_status);
+  ASSERT_EQ(1, reply.additional_status.size());
+  EXPECT_EQ(0x0105, reply.additional_status[0]);
+  EXPECT_EQ(0, reply.data.size());
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_encapsulation_error)
+{
+  EIP_BYTE buf[sizeof(REPLY)];
+  memcpy(buf, REPLY, sizeof(REPLY));
+  buf[8] = 0x64;
+  EXPECT_THROW(decodeSendUnitDataReply(buf, sizeof(buf), 0x11223344, 5), std::runtime_error);
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_mismatch)
+{
+  EXPECT_THROW(decodeSendUnitDataReply(REPLY, sizeof(REPLY), 0x11223345, 5), std::logic_error);
+  EXPECT_THROW(decodeSendUnitDataReply(REPLY, sizeof(REPLY), 0x11223344, 6), std::logic_error);
+
+  EIP_BYTE buf[sizeof(REPLY)];
+  memcpy(buf, REPLY, sizeof(REPLY));
+  buf[0] = 0x6F;
+  EXPECT_THROW(decodeSendUnitDataReply(buf, sizeof(buf), 0x11223344, 5), std::logic_error);
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_truncated)
+{
+  EXPECT_THROW(decodeSendUnitDataReply(REPLY, sizeof(REPLY) - 1, 0x11223344, 5),
+    std::length_error);
+}
+
+TEST_F(ConnectedMessagingTest, test_encode_send_rr_data)
+{
+  EIP_BYTE buf[128];
+  size_t size = encodeSendRRData(0x12345678, 0x0102030405060708ULL, 0x0E, Path(0x75, 1, 3),
+    NULL, buf, sizeof(buf));
+
+  EIP_BYTE expected[] = {
+    0x6F, 0x00, 0x18, 0x00, 0x78, 0x56, 0x34, 0x12,
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x07, 0x06, 0x05,
+    0x04, 0x03, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xB2, 0x00, 0x08, 0x00,
+    0x0E, 0x03, 0x20, 0x75, 0x24, 0x01, 0x30, 0x03,
+  };
+  ASSERT_EQ(sizeof(expected), size);
+  for (size_t i = 0; i < sizeof(expected); ++i)
+  {
+    EXPECT_EQ(expected[i], buf[i]) << "at byte " << i;
+  }
+}
+
+TEST_F(ConnectedMessagingTest, test_decode_send_rr_data_reply)
+{
+  EIP_BYTE buf[] = {
+    0x6F, 0x00, 0x16, 0x00, 0x78, 0x56, 0x34, 0x12,
+    0x00, 0x00, 0x00, 0x00, 0x08, 0x07, 0x06, 0x05,
+    0x04, 0x03, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xB2, 0x00, 0x06, 0x00,
+    0x8E, 0x00, 0x00, 0x00, 0xAA, 0x55,
+  };
+  uint64_t context = 0;
+  MessageRouterReply reply = decodeSendRRDataReply(buf, sizeof(buf), context);
+  EXPECT_EQ(0x0102030405060708ULL, context);
+  EXPECT_EQ(0x8E, reply.service);
+  EXPECT_EQ(0, reply.general_status);
+  ASSERT_EQ(2, reply.data.size());
+  EXPECT_EQ(0xAA, reply.data[0]);
+
+  // a SendUnitData reply is not a SendRRData reply
+  EXPECT_THROW(decodeSendRRDataReply(REPLY, sizeof(REPLY), context), std::logic_error);
+}
@@ -0,0 +1,108 @@
+/**
+Software License Agreement (BSD)
+
+\file      connection_supervisor_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "omron_os32c_driver/connection_supervisor.h"
+
+using namespace omron_os32c_driver;
+
+class ConnectionSupervisorTest : public :: testing :: Test
+{
+};
+
+TEST_F(ConnectionSupervisorTest, test_backoff_growth)
+{
+  Backoff backoff(0.1, 1, 0, 1);
+  EXPECT_DOUBLE_EQ(0.1, backoff.next());
+  EXPECT_DOUBLE_EQ(0.2, backoff.next());
+  EXPECT_DOUBLE_EQ(0.4, backoff.next());
+  EXPECT_DOUBLE_EQ(0.8, backoff.next());
+  EXPECT_DOUBLE_EQ(1, backoff.next());
+  EXPECT_DOUBLE_EQ(1, backoff.next());
+  backoff.reset();
+  EXPECT_DOUBLE_EQ(0.1, backoff.next());
+}
+
+TEST_F(ConnectionSupervisorTest, test_backoff_jitter)
+{
+  Backoff backoff(1, 1, 0.25, 1);
+  double min = 2, max = 0;
+  for (int i = 0; i < 1000; ++i)
+  {
+    double delay = backoff.next();
+    min = std::min(min, delay);
+    max = std::max(max, delay);
+  }
+  EXPECT_LE(0.75, min);
+  EXPECT_GE(1.25, max);
+  // jitter should actually spread the delays out
+  EXPECT_GT(0.8, min);
+  EXPECT_LT(1.2, max);
+}
+
+TEST_F(ConnectionSupervisorTest, test_backoff_invalid_args)
+{
+  EXPECT_THROW(Backoff(0, 1, 0), std::invalid_argument);
+  EXPECT_THROW(Backoff(1, 0.5, 0), std::invalid_argument);
+  EXPECT_THROW(Backoff(0.1, 1, -0.1), std::invalid_argument);
+  EXPECT_THROW(Backoff(0.1, 1, 1.5), std::invalid_argument);
+}
+
+TEST_F(ConnectionSupervisorTest, test_io_connection_params)
+{
+  boost::asio::io_service io_service;
+  ConnectionSupervisor supervisor(io_service, "localhost", [](const ScanView&) {});
+  EXPECT_TRUE(IOConnectionParams() == supervisor.getIOConnectionParams());
+
+  IOConnectionParams params;
+  params.t_to_o_rpi = 40000;
+  supervisor.setIOConnectionParams(params);
+  EXPECT_EQ(40000, supervisor.getIOConnectionParams().t_to_o_rpi);
+
+  // rejected before anything is sent, leaving the last good parameters
+  params.t_to_o_rpi = 1000;
+  EXPECT_THROW(supervisor.setIOConnectionParams(params), std::invalid_argument);
+  EXPECT_EQ(40000, supervisor.getIOConnectionParams().t_to_o_rpi);
+}
+
+TEST_F(ConnectionSupervisorTest, test_unreachable_host)
+{
+  boost::asio::io_service io_service;
+  // TEST-NET-1 is never routed
+  ConnectionSupervisor supervisor(io_service, "192.0.2.1", [](const ScanView&) {});
+  supervisor.setRequestTimeout(0.2);
+  EXPECT_THROW(supervisor.setRequestTimeout(0), std::invalid_argument);
+  EXPECT_EQ(0.2, supervisor.getRequestTimeout());
+
+  // a reconnection attempt gives up within the request timeout
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  EXPECT_EQ(ConnectionSupervisor::DISCONNECTED, supervisor.spinOnce(0.01));
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_LT(elapsed, 1.0);
+  EXPECT_FALSE(supervisor.isConnected());
+  EXPECT_FALSE(supervisor.getLastError().empty());
+}
@@ -0,0 +1,133 @@
+/**
+Software License Agreement (BSD)
+
+\file      decode_fuzz.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * libFuzzer target for the decoders of data received from the scanner. Each
+ * input is fed to the measurement report header, measurement report, range
+ * and reflectance measurement and measurement report config decoders, with
+ * and without length information, and to the IO packet decoder. Decoders may
+ * reject the input by throwing std::logic_error or returning an error status,
+ * but must never crash, overrun the input or accept more beams than the
+ * scanner has. Needs clang, e.g.:
+ *
+ *   cmake -DCMAKE_CXX_COMPILER=clang++ -DOS32C_BUILD_FUZZERS=ON ..
+ *   decode_fuzz -max_len=4096 corpus/
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdexcept>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "omron_os32c_driver/io_packet.h"
+#include "omron_os32c_driver/measurement_report.h"
+#include "omron_os32c_driver/measurement_report_config.h"
+#include "omron_os32c_driver/measurement_report_header.h"
+#include "omron_os32c_driver/range_and_reflectance_measurement.h"
+
+using boost::asio::buffer;
+using eip::serialization::BufferReader;
+using namespace omron_os32c_driver;
+
+static void check(bool condition)
+{
+  if (!condition)
+  {
+    abort();
+  }
+}
+
+static void checkBeams(const MeasurementReportHeader& header, size_t size)
+{
+  check(header.num_beams <= MeasurementReportHeader::MAX_BEAMS);
+  check(size == header.num_beams);
+}
+
+static void checkBeams(const MeasurementReport& report)
+{
+  checkBeams(report.header, report.measurement_data.size());
+}
+
+static void checkBeams(const RangeAndReflectanceMeasurement& rr)
+{
+  checkBeams(rr.header, rr.range_data.size());
+  checkBeams(rr.header, rr.reflectance_data.size());
+}
+
+static void checkBeams(const MeasurementReportHeader& header)
+{
+}
+
+static void checkBeams(const MeasurementReportConfig& config)
+{
+}
+
+template <typename T>
+static void fuzzDecoder(std::vector<uint8_t>& data)
+{
+  try
+  {
+    T t;
+    BufferReader reader(buffer(data));
+    t.deserialize(reader);
+    check(reader.getByteCount() <= data.size());
+    checkBeams(t);
+  }
+  catch (std::logic_error&)
+  {
+  }
+
+  try
+  {
+    T t;
+    BufferReader reader(buffer(data));
+    t.deserialize(reader, data.size());
+    check(reader.getByteCount() <= data.size());
+    checkBeams(t);
+  }
+  catch (std::logic_error&)
+  {
+  }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  // the decoders take a mutable buffer, so work on a copy
+  std::vector<uint8_t> input(data, data + size);
+
+  fuzzDecoder<MeasurementReportHeader>(input);
+  fuzzDecoder<MeasurementReport>(input);
+  fuzzDecoder<RangeAndReflectanceMeasurement>(input);
+  fuzzDecoder<MeasurementReportConfig>(input);
+
+  MeasurementReport report;
+  if (decodeMeasurementReport(size ? &input[0] : NULL, size, report) == DECODE_OK)
+  {
+    checkBeams(report);
+  }
+  return 0;
+}
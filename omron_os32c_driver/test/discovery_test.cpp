@@ -0,0 +1,220 @@
+/**
+Software License Agreement (BSD)
+
+\file      discovery_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <thread>
+
+#include "omron_os32c_driver/discovery.h"
+#include "omron_os32c_driver/realtime.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+
+using boost::asio::ip::udp;
+using namespace eip::serialization;
+using namespace omron_os32c_driver;
+
+static const unsigned short TEST_PORT = 24818;
+
+class DiscoveryTest : public :: testing :: Test
+{
+public:
+  DiscoveryTest() : responder(io_serv, udp::endpoint(udp::v4(), TEST_PORT))
+  {
+    identity.vendor_id = 47;
+    identity.device_type = 0x2B;
+    identity.product_code = 0x0102;
+    identity.revision_major = 2;
+    identity.revision_minor = 1;
+    identity.status = 0x0030;
+    identity.serial_number = 0x00C0FFEE;
+    identity.product_name = "OS32C-xxx-DM";
+    identity.state = 3;
+  }
+
+  /**
+   * Reply to the given number of ListIdentity requests as a scanner with the
+   * test identity would
+   */
+  void respond(int requests)
+  {
+    for (int i = 0; i < requests; ++i)
+    {
+      EIP_BYTE request[64];
+      udp::endpoint sender;
+      size_t n = responder.receive_from(boost::asio::buffer(request), sender);
+      if (n != 24 || request[0] != 0x63 || request[1] != 0x00)
+      {
+        continue;
+      }
+
+      EIP_BYTE reply[128] = { 0 };
+      BufferWriter writer(boost::asio::buffer(reply));
+      EIP_UINT command = 0x63, length = 6 + identity.getLength(), item_count = 1;
+      EIP_UINT item_type = 0x0C, item_length = identity.getLength();
+      writer.write(command);
+      writer.write(length);
+      writer.writeBytes(request + 4, 20);
+      writer.write(item_count);
+      writer.write(item_type);
+      writer.write(item_length);
+      identity.serialize(writer);
+      responder.send_to(boost::asio::buffer(reply, writer.getByteCount()), sender);
+    }
+  }
+
+protected:
+  boost::asio::io_service io_serv;
+  udp::socket responder;
+  CIPIdentity identity;
+};
+
+TEST_F(DiscoveryTest, test_identity_round_trip)
+{
+  identity.sin_addr = 0xC0A80101;
+  EIP_BYTE d[128];
+  BufferWriter writer(boost::asio::buffer(d));
+  identity.serialize(writer);
+  EXPECT_EQ(identity.getLength(), writer.getByteCount());
+  // socket address is big endian
+  EXPECT_EQ(0x00, d[2]);
+  EXPECT_EQ(0x02, d[3]);
+  EXPECT_EQ(0xAF, d[4]);
+  EXPECT_EQ(0x12, d[5]);
+  EXPECT_EQ(0xC0, d[6]);
+
+  CIPIdentity parsed;
+  BufferReader reader(boost::asio::buffer(d, writer.getByteCount()));
+  parsed.deserialize(reader);
+  EXPECT_EQ(writer.getByteCount(), reader.getByteCount());
+  EXPECT_EQ(2, parsed.sin_family);
+  EXPECT_EQ(44818, parsed.sin_port);
+  EXPECT_EQ(0xC0A80101, parsed.sin_addr);
+  EXPECT_EQ(47, parsed.vendor_id);
+  EXPECT_EQ(0x0102, parsed.product_code);
+  EXPECT_EQ(2, parsed.revision_major);
+  EXPECT_EQ(1, parsed.revision_minor);
+  EXPECT_EQ(0x00C0FFEE, parsed.serial_number);
+  EXPECT_EQ("OS32C-xxx-DM", parsed.product_name);
+  EXPECT_EQ(3, parsed.state);
+}
+
+TEST_F(DiscoveryTest, test_is_os32c)
+{
+  EXPECT_TRUE(identity.isOS32C());
+  identity.vendor_id = 1;
+  EXPECT_FALSE(identity.isOS32C());
+  identity.vendor_id = 47;
+  identity.product_name = "NX-ECC";
+  EXPECT_FALSE(identity.isOS32C());
+}
+
+TEST_F(DiscoveryTest, test_parse_targets)
+{
+  vector<string> targets = parseDiscoveryTargets("192.168.1.0/24");
+  ASSERT_EQ(254, targets.size());
+  EXPECT_EQ("192.168.1.1", targets[0]);
+  EXPECT_EQ("192.168.1.254", targets[253]);
+
+  targets = parseDiscoveryTargets("10.0.0.5,255.255.255.255,172.16.3.9/30");
+  ASSERT_EQ(4, targets.size());
+  EXPECT_EQ("10.0.0.5", targets[0]);
+  EXPECT_EQ("255.255.255.255", targets[1]);
+  EXPECT_EQ("172.16.3.9", targets[2]);
+  EXPECT_EQ("172.16.3.10", targets[3]);
+
+  targets = parseDiscoveryTargets("10.0.0.5/32");
+  ASSERT_EQ(1, targets.size());
+  EXPECT_EQ("10.0.0.5", targets[0]);
+
+  EXPECT_THROW(parseDiscoveryTargets(""), std::invalid_argument);
+  EXPECT_THROW(parseDiscoveryTargets("10.0.0"), std::invalid_argument);
+  EXPECT_THROW(parseDiscoveryTargets("10.0.0.0/8"), std::invalid_argument);
+  EXPECT_THROW(parseDiscoveryTargets("10.0.0.0/24x"), std::invalid_argument);
+}
+
+TEST_F(DiscoveryTest, test_parse_serial_number)
+{
+  EXPECT_EQ(12345678, parseSerialNumber("12345678"));
+  // serials past the range of a signed int
+  EXPECT_EQ(3000000000U, parseSerialNumber("3000000000"));
+  EXPECT_EQ(0xFFFFFFFFU, parseSerialNumber("4294967295"));
+  EXPECT_EQ(0x8BADF00DU, parseSerialNumber("0x8BADF00D"));
+  EXPECT_EQ(10, parseSerialNumber("010"));
+
+  EXPECT_THROW(parseSerialNumber(""), std::invalid_argument);
+  EXPECT_THROW(parseSerialNumber("4294967296"), std::invalid_argument);
+  EXPECT_THROW(parseSerialNumber("-1"), std::invalid_argument);
+  EXPECT_THROW(parseSerialNumber(" 12"), std::invalid_argument);
+  EXPECT_THROW(parseSerialNumber("12a"), std::invalid_argument);
+  EXPECT_THROW(parseSerialNumber("1.5"), std::invalid_argument);
+  EXPECT_THROW(parseSerialNumber("0x"), std::invalid_argument);
+}
+
+TEST_F(DiscoveryTest, test_discover)
+{
+  std::thread scanner(&DiscoveryTest::respond, this, 1);
+  vector<string> targets(1, "127.0.0.1");
+  vector<CIPIdentity> found = discoverScanners(targets, 0.2, TEST_PORT);
+  scanner.join();
+
+  ASSERT_EQ(1, found.size());
+  EXPECT_EQ("127.0.0.1", found[0].address);
+  EXPECT_EQ(0x00C0FFEE, found[0].serial_number);
+  EXPECT_EQ("OS32C-xxx-DM", found[0].product_name);
+}
+
+TEST_F(DiscoveryTest, test_discover_ignores_other_devices)
+{
+  identity.vendor_id = 1;
+  std::thread device(&DiscoveryTest::respond, this, 1);
+  vector<string> targets(1, "127.0.0.1");
+  vector<CIPIdentity> found = discoverScanners(targets, 0.1, TEST_PORT);
+  device.join();
+  EXPECT_EQ(0, found.size());
+}
+
+TEST_F(DiscoveryTest, test_find_by_serial_number)
+{
+  std::thread scanner(&DiscoveryTest::respond, this, 1);
+  vector<string> targets(1, "127.0.0.1");
+  uint64_t start = monotonicNanoseconds();
+  CIPIdentity found = findScannerBySerialNumber(0x00C0FFEE, targets, 5.0, TEST_PORT);
+  uint64_t elapsed = monotonicNanoseconds() - start;
+  scanner.join();
+
+  EXPECT_EQ("127.0.0.1", found.address);
+  // returns as soon as the scanner replies rather than waiting out the timeout
+  EXPECT_LT(elapsed, 1000000000ULL);
+}
+
+TEST_F(DiscoveryTest, test_find_by_serial_number_not_found)
+{
+  std::thread scanner(&DiscoveryTest::respond, this, 1);
+  vector<string> targets(1, "127.0.0.1");
+  EXPECT_THROW(findScannerBySerialNumber(1234, targets, 0.1, TEST_PORT), std::runtime_error);
+  scanner.join();
+}
@@ -0,0 +1,84 @@
+/**
+Software License Agreement (BSD)
+
+\file      fixed_vector_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/fixed_vector.h"
+#include "omron_os32c_driver/measurement_report.h"
+
+using namespace omron_os32c_driver;
+
+class FixedVectorTest : public :: testing :: Test
+{
+};
+
+TEST_F(FixedVectorTest, test_resize)
+{
+  FixedVector<int, 8> v;
+  EXPECT_TRUE(v.empty());
+  EXPECT_EQ(8, v.capacity());
+
+  v.resize(3);
+  ASSERT_EQ(3, v.size());
+  EXPECT_EQ(0, v[0]);
+  EXPECT_EQ(0, v[2]);
+  v[1] = 5;
+
+  // shrinking then growing again value initializes the new elements
+  v.resize(1);
+  v.resize(3);
+  EXPECT_EQ(0, v[1]);
+
+  v.resize(8);
+  EXPECT_EQ(8, v.end() - v.begin());
+  EXPECT_THROW(v.resize(9), std::length_error);
+  EXPECT_EQ(8, v.size());
+}
+
+TEST_F(FixedVectorTest, test_assign)
+{
+  FixedVector<int, 8> v;
+  v.assign(4, 7);
+  ASSERT_EQ(4, v.size());
+  for (FixedVector<int, 8>::const_iterator it = v.begin(); it != v.end(); ++it)
+  {
+    EXPECT_EQ(7, *it);
+  }
+  EXPECT_EQ(&v[0], v.data());
+  EXPECT_THROW(v.assign(9, 7), std::length_error);
+
+  v.clear();
+  EXPECT_TRUE(v.empty());
+}
+
+TEST_F(FixedVectorTest, test_beam_data)
+{
+  // beam data holds a full scan inline
+  MeasurementReport mr;
+  EXPECT_EQ(677, mr.measurement_data.capacity());
+  EXPECT_LE(677 * sizeof(EIP_UINT), sizeof(mr));
+  mr.measurement_data.resize(677);
+  EXPECT_THROW(mr.measurement_data.resize(678), std::length_error);
+}
@@ -0,0 +1,163 @@
+/**
+Software License Agreement (BSD)
+
+\file      forward_open_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include "omron_os32c_driver/forward_open.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+using namespace eip;
+using namespace eip::serialization;
+
+class ForwardOpenTest : public :: testing :: Test
+{
+
+};
+
+TEST_F(ForwardOpenTest, test_connection_params)
+{
+  EXPECT_EQ(0x48000002, LargeForwardOpenRequest::calcConnectionParams(2, false,
+    CONNECTION_PRIORITY_SCHEDULED, CONNECTION_TYPE_P2P, false));
+  EXPECT_EQ(0x28000584, LargeForwardOpenRequest::calcConnectionParams(0x584, false,
+    CONNECTION_PRIORITY_SCHEDULED, CONNECTION_TYPE_MULTICAST, false));
+  EXPECT_EQ(0x8200FFFF, LargeForwardOpenRequest::calcConnectionParams(0xFFFF, true,
+    CONNECTION_PRIORITY_LOW, CONNECTION_TYPE_NULL, true));
+}
+
+TEST_F(ForwardOpenTest, test_serialize_large_forward_open)
+{
+  LargeForwardOpenRequest req;
+  req.t_to_o_connection_id = 0x11223344;
+  req.connection_sn = 0x1234;
+  req.originator_vendor_id = 0x0001;
+  req.originator_sn = 0x89ABCDEF;
+  req.o_to_t_rpi = 0x00177FA0;
+  req.o_to_t_conn_params = 0x48000002;
+  req.t_to_o_rpi = 0x00013070;
+  req.t_to_o_conn_params = 0x28000584;
+  req.path = getAssemblyConnectionPath(0x01, 0xC7, 0x66);
+
+  EIP_BYTE d[] = {
+    0x06, 0x50, 0x00, 0x00, 0x00, 0x00, 0x44, 0x33,
+    0x22, 0x11, 0x34, 0x12, 0x01, 0x00, 0xEF, 0xCD,
+    0xAB, 0x89, 0x00, 0x00, 0x00, 0x00, 0xA0, 0x7F,
+    0x17, 0x00, 0x02, 0x00, 0x00, 0x48, 0x70, 0x30,
+    0x01, 0x00, 0x84, 0x05, 0x00, 0x28, 0x01, 0x04,
+    0x20, 0x04, 0x24, 0x01, 0x2C, 0xC7, 0x2C, 0x66,
+  };
+  EXPECT_EQ(sizeof(d), req.getLength());
+
+  EIP_BYTE out[64];
+  BufferWriter writer(buffer(out));
+  req.serialize(writer);
+  ASSERT_EQ(sizeof(d), writer.getByteCount());
+  for (size_t i = 0; i < sizeof(d); ++i)
+  {
+    EXPECT_EQ(d[i], out[i]) << "at byte " << i;
+  }
+
+  req.path.push_back(0);
+  BufferWriter odd_writer(buffer(out));
+  EXPECT_THROW(req.serialize(odd_writer), std::logic_error);
+}
+
+TEST_F(ForwardOpenTest, test_deserialize_reply)
+{
+  EIP_BYTE d[] = {
+    0x01, 0x00, 0x02, 0x00, 0x03, 0x00, 0x04, 0x00,
+    0x34, 0x12, 0x01, 0x00, 0xEF, 0xCD, 0xAB, 0x89,
+    0x40, 0x9C, 0x00, 0x00, 0x70, 0x30, 0x01, 0x00,
+    0x01, 0x00, 0xAA, 0xBB,
+  };
+  ForwardOpenReply reply;
+  BufferReader reader(buffer(d));
+  reply.deserialize(reader);
+  EXPECT_EQ(sizeof(d), reader.getByteCount());
+  EXPECT_EQ(0x00020001, reply.o_to_t_connection_id);
+  EXPECT_EQ(0x00040003, reply.t_to_o_connection_id);
+  EXPECT_EQ(0x1234, reply.connection_sn);
+  EXPECT_EQ(0x0001, reply.originator_vendor_id);
+  EXPECT_EQ(0x89ABCDEF, reply.originator_sn);
+  EXPECT_EQ(40000, reply.o_to_t_api);
+  EXPECT_EQ(0x00013070, reply.t_to_o_api);
+  ASSERT_EQ(2, reply.application_reply.size());
+  EXPECT_EQ(0xAA, reply.application_reply[0]);
+  EXPECT_EQ(sizeof(d), reply.getLength());
+
+  // and back again
+  EIP_BYTE out[32];
+  BufferWriter writer(buffer(out));
+  reply.serialize(writer);
+  ASSERT_EQ(sizeof(d), writer.getByteCount());
+  for (size_t i = 0; i < sizeof(d); ++i)
+  {
+    EXPECT_EQ(d[i], out[i]) << "at byte " << i;
+  }
+
+  BufferReader short_reader(buffer(d, 20));
+  EXPECT_THROW(reply.deserialize(short_reader), std::length_error);
+}
+
+TEST_F(ForwardOpenTest, test_serialize_forward_close)
+{
+  ForwardCloseRequest req;
+  req.connection_sn = 0x1234;
+  req.originator_vendor_id = 0x0001;
+  req.originator_sn = 0x89ABCDEF;
+  req.path = getAssemblyConnectionPath(0x01, 0x71, 0x66);
+
+  EIP_BYTE d[] = {
+    0x06, 0x50, 0x34, 0x12, 0x01, 0x00, 0xEF, 0xCD,
+    0xAB, 0x89, 0x04, 0x00, 0x20, 0x04, 0x24, 0x01,
+    0x2C, 0x71, 0x2C, 0x66,
+  };
+  EXPECT_EQ(sizeof(d), req.getLength());
+
+  EIP_BYTE out[32];
+  BufferWriter writer(buffer(out));
+  req.serialize(writer);
+  ASSERT_EQ(sizeof(d), writer.getByteCount());
+  for (size_t i = 0; i < sizeof(d); ++i)
+  {
+    EXPECT_EQ(d[i], out[i]) << "at byte " << i;
+  }
+}
+
+TEST_F(ForwardOpenTest, test_multicast_config)
+{
+  EIP_BYTE d[] = {
+    0x00, 0x00, 0x20, 0x00, 0x20, 0x01, 0xC0, 0xEF,
+  };
+  MulticastConfig config;
+  BufferReader reader(buffer(d));
+  config.deserialize(reader);
+  EXPECT_EQ(0, config.alloc_control);
+  EXPECT_EQ(32, config.num_mcast);
+  EXPECT_EQ("239.192.1.32", config.getStartAddress());
+}
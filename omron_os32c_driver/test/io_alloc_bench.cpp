@@ -0,0 +1,267 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_alloc_bench.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/**
+ * Counts heap allocations on the IO path. A local packet generator sends full
+ * 677 beam measurement reports over loopback at a configurable rate, and the
+ * receiver handles each the way the driver does, sending the keepalive every
+ * few scans. Compares the path used by the driver, which decodes into a
+ * caller owned report and encodes the keepalive into a per-connection buffer,
+ * with the legacy path, which went through the CPF classes of
+ * odva_ethernetip. Reports allocations per scan for each, e.g.:
+ *
+ *   io_alloc_bench --rate 40 --count 200
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <atomic>
+#include <new>
+#include <string>
+#include <boost/asio.hpp>
+#include <boost/make_shared.hpp>
+
+#include "odva_ethernetip/cpf_item.h"
+#include "odva_ethernetip/cpf_packet.h"
+#include "odva_ethernetip/sequenced_address_item.h"
+#include "odva_ethernetip/sequenced_data_item.h"
+#include "odva_ethernetip/socket/test_socket.h"
+#include "omron_os32c_driver/io_packet.h"
+#include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/udp_io_socket.h"
+
+using boost::make_shared;
+using eip::CPFItem;
+using eip::CPFPacket;
+using eip::SequencedAddressItem;
+using eip::SequencedDataItem;
+using eip::socket::TestSocket;
+using namespace omron_os32c_driver;
+
+// number of heap allocations made by any thread
+static std::atomic<uint64_t> allocations(0);
+
+void* operator new(size_t size)
+{
+  ++allocations;
+  void* p = malloc(size ? size : 1);
+  if (!p)
+  {
+    throw std::bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept
+{
+  free(p);
+}
+
+// full measurement report, with CPF framing
+static const size_t NUM_BEAMS = MeasurementReportHeader::MAX_BEAMS;
+static const size_t REPORT_SIZE = 56 + 2 * NUM_BEAMS;
+static const size_t PACKET_SIZE = 18 + 2 + REPORT_SIZE;
+
+// keepalive interval of the driver, in scans
+static const int KEEPALIVE_INTERVAL = 10;
+
+struct GeneratorArgs
+{
+  unsigned short port;
+  double rate;
+  uint32_t count;
+};
+
+static void buildPacket(EIP_BYTE* packet)
+{
+  memset(packet, 0, PACKET_SIZE);
+  EIP_UINT header[] = { 2, 0x8002, 8, 0x0004, 0x0002, 0, 0, 0x00B1,
+    static_cast<EIP_UINT>(2 + REPORT_SIZE) };
+  memcpy(packet, header, sizeof(header));
+  EIP_UINT num_beams = NUM_BEAMS;
+  memcpy(packet + 20 + 54, &num_beams, sizeof(num_beams));
+  for (size_t i = 0; i < NUM_BEAMS; ++i)
+  {
+    EIP_UINT range = 1000 + i;
+    memcpy(packet + 20 + 56 + 2 * i, &range, sizeof(range));
+  }
+}
+
+static void* generatorThread(void* arg)
+{
+  GeneratorArgs* args = static_cast<GeneratorArgs*>(arg);
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dest.sin_port = htons(args->port);
+
+  EIP_BYTE packet[PACKET_SIZE];
+  buildPacket(packet);
+  uint64_t period = 1e9 / args->rate;
+  uint64_t next = monotonicNanoseconds();
+  for (uint32_t i = 0; i < args->count; ++i)
+  {
+    next += period;
+    timespec ts;
+    ts.tv_sec = next / 1000000000ULL;
+    ts.tv_nsec = next % 1000000000ULL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+    sendto(sock, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+  }
+  ::close(sock);
+  return NULL;
+}
+
+/**
+ * Receive and decode the way the driver used to: a new report returned by
+ * value for each scan, and a keepalive built from CPF items on the heap.
+ */
+static void legacyScan(OS32C& os32c, const MeasurementReportConfig& mrc, EIP_UDINT sequence_num,
+  bool keepalive)
+{
+  MeasurementReport report = os32c.receiveMeasurementReportUDP();
+  if (keepalive)
+  {
+    CPFPacket pkt;
+    boost::shared_ptr<SequencedAddressItem> address =
+      make_shared<SequencedAddressItem>(0x00020004, sequence_num);
+    boost::shared_ptr<MeasurementReportConfig> data = make_shared<MeasurementReportConfig>();
+    *data = mrc;
+    pkt.getItems().push_back(CPFItem(0x8002, address));
+    pkt.getItems().push_back(CPFItem(0x00B1, data));
+    os32c.sendIOPacket(pkt);
+  }
+}
+
+/**
+ * Receive and decode the way the driver does now
+ */
+static void currentScan(OS32C& os32c, UDPIOSocket& io_socket, const MeasurementReportConfig& mrc,
+  EIP_UDINT sequence_num, bool keepalive, MeasurementReport& report, std::vector<EIP_BYTE>& buf)
+{
+  os32c.receiveMeasurementReportUDP(report);
+  if (keepalive)
+  {
+    size_t size = encodeMeasurementReportConfig(mrc, 0x00020004, sequence_num, &buf[0], buf.size());
+    io_socket.send(boost::asio::buffer(&buf[0], size));
+  }
+}
+
+static double run(bool legacy, GeneratorArgs gen)
+{
+  boost::asio::io_service io_service;
+  boost::shared_ptr<UDPIOSocket> io_socket(new UDPIOSocket(io_service, gen.port));
+  // keepalives go to a port nobody listens on
+  io_socket->open("127.0.0.1", "22299");
+  io_socket->setReceiveTimeout(1);
+  OS32C os32c(boost::shared_ptr<TestSocket>(new TestSocket()), io_socket);
+  MeasurementReportConfig mrc;
+  MeasurementReport report;
+  std::vector<EIP_BYTE> buf(256);
+
+  pthread_t generator;
+  pthread_create(&generator, NULL, generatorThread, &gen);
+
+  // let the first few scans warm up anything allocated once
+  uint64_t start_allocations = 0;
+  for (uint32_t i = 0; i < gen.count; ++i)
+  {
+    if (i == KEEPALIVE_INTERVAL)
+    {
+      start_allocations = allocations;
+    }
+    bool keepalive = (i % KEEPALIVE_INTERVAL) == 0;
+    if (legacy)
+    {
+      legacyScan(os32c, mrc, i, keepalive);
+    }
+    else
+    {
+      currentScan(os32c, *io_socket, mrc, i, keepalive, report, buf);
+    }
+  }
+  uint64_t steady_allocations = allocations - start_allocations;
+  pthread_join(generator, NULL);
+  return static_cast<double>(steady_allocations) / (gen.count - KEEPALIVE_INTERVAL);
+}
+
+static void usage()
+{
+  printf("Usage: io_alloc_bench [--rate SCANS_PER_S] [--count N] [--port PORT]\n");
+}
+
+int main(int argc, char *argv[])
+{
+  GeneratorArgs gen;
+  gen.port = 22221;
+  gen.rate = 40;
+  gen.count = 200;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--rate" && has_value)
+      gen.rate = atof(argv[++i]);
+    else if (arg == "--count" && has_value)
+      gen.count = atoi(argv[++i]);
+    else if (arg == "--port" && has_value)
+      gen.port = atoi(argv[++i]);
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+  if (gen.count <= KEEPALIVE_INTERVAL)
+  {
+    usage();
+    return 1;
+  }
+
+  try
+  {
+    printf("%u scans of %zu beams at %.0f scans/s, keepalive every %d scans\n",
+      gen.count, NUM_BEAMS, gen.rate, KEEPALIVE_INTERVAL);
+    printf("legacy path:  %.2f allocations per scan\n", run(true, gen));
+    printf("current path: %.2f allocations per scan\n", run(false, gen));
+  }
+  catch (std::exception& ex)
+  {
+    fprintf(stderr, "Error: %s\n", ex.what());
+    return 1;
+  }
+  return 0;
+}
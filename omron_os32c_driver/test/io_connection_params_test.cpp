@@ -0,0 +1,183 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_connection_params_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "omron_os32c_driver/io_connection_params.h"
+
+using namespace omron_os32c_driver;
+
+class IOConnectionParamsTest : public :: testing :: Test
+{
+};
+
+TEST_F(IOConnectionParamsTest, test_defaults)
+{
+  IOConnectionParams params;
+  EXPECT_NO_THROW(params.validate());
+  EXPECT_EQ(0x00177FA0, params.o_to_t_rpi);
+  EXPECT_EQ(0x00013070, params.t_to_o_rpi);
+  EXPECT_EQ(0x006E, params.o_to_t_buffer_size);
+  EXPECT_EQ(0x0584, params.t_to_o_buffer_size);
+  EXPECT_EQ(0x71, params.o_to_t_assembly_id);
+  EXPECT_EQ(0x66, params.t_to_o_assembly_id);
+
+  // the keepalive and timeout the driver used before they were derived
+  EXPECT_DOUBLE_EQ(0.77, params.getKeepaliveInterval());
+  EXPECT_DOUBLE_EQ(0.077936, params.getScanPeriod());
+  EXPECT_DOUBLE_EQ(4 * 0.077936, params.getIOTimeout());
+}
+
+TEST_F(IOConnectionParamsTest, test_derived_intervals)
+{
+  IOConnectionParams params;
+  params.t_to_o_rpi = 40000;
+  params.o_to_t_rpi = 4000000;
+  params.timeout_multiplier = 8;
+  EXPECT_DOUBLE_EQ(0.04, params.getScanPeriod());
+  EXPECT_DOUBLE_EQ(0.32, params.getIOTimeout());
+  EXPECT_DOUBLE_EQ(2, params.getKeepaliveInterval());
+
+  // follows the O->T RPI alone, whatever the scan period
+  params.o_to_t_rpi = params.t_to_o_rpi * 3;
+  EXPECT_DOUBLE_EQ(0.06, params.getKeepaliveInterval());
+}
+
+TEST_F(IOConnectionParamsTest, test_validate)
+{
+  IOConnectionParams params;
+  params.t_to_o_rpi = IOConnectionParams::MIN_T_TO_O_RPI;
+  EXPECT_NO_THROW(params.validate());
+  params.t_to_o_rpi = IOConnectionParams::MIN_T_TO_O_RPI - 1;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+
+  params = IOConnectionParams();
+  params.o_to_t_rpi = IOConnectionParams::MAX_RPI + 1;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+  params.o_to_t_rpi = params.t_to_o_rpi - 1;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+
+  params = IOConnectionParams();
+  params.o_to_t_buffer_size = 109;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+
+  params = IOConnectionParams();
+  params.t_to_o_buffer_size = IOConnectionParams::MAX_T_TO_O_BUFFER_SIZE + 1;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+  params.t_to_o_buffer_size = 55;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+
+  params = IOConnectionParams();
+  params.timeout_multiplier = 0;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+}
+
+TEST_F(IOConnectionParamsTest, test_fallback_params)
+{
+  IOConnectionParams defaults;
+  vector<IOConnectionParams> fallbacks = getFallbackParams(defaults);
+  ASSERT_EQ(1, fallbacks.size());
+  EXPECT_TRUE(defaults == fallbacks[0]);
+
+  // tighter timing falls back to the default timing, which is the defaults
+  IOConnectionParams fast;
+  fast.t_to_o_rpi = 40000;
+  fast.o_to_t_rpi = 4000000;
+  fallbacks = getFallbackParams(fast);
+  ASSERT_EQ(2, fallbacks.size());
+  EXPECT_TRUE(fast == fallbacks[0]);
+  EXPECT_TRUE(defaults == fallbacks[1]);
+
+  // other changes are kept with the default timing before giving them up too
+  fast.timeout_multiplier = 8;
+  fallbacks = getFallbackParams(fast);
+  ASSERT_EQ(3, fallbacks.size());
+  EXPECT_TRUE(fast == fallbacks[0]);
+  EXPECT_EQ(defaults.t_to_o_rpi, fallbacks[1].t_to_o_rpi);
+  EXPECT_EQ(defaults.o_to_t_rpi, fallbacks[1].o_to_t_rpi);
+  EXPECT_EQ(8, fallbacks[1].timeout_multiplier);
+  EXPECT_TRUE(defaults == fallbacks[2]);
+
+  // changes other than timing only have the defaults to fall back to
+  IOConnectionParams sized;
+  sized.t_to_o_buffer_size = 0x0400;
+  fallbacks = getFallbackParams(sized);
+  ASSERT_EQ(2, fallbacks.size());
+  EXPECT_TRUE(defaults == fallbacks[1]);
+}
+
+TEST_F(IOConnectionParamsTest, test_modes)
+{
+  IOConnectionParams params;
+  EXPECT_EQ(IO_CONNECTION_OWNER, params.mode);
+  EXPECT_FALSE(params.t_to_o_multicast);
+
+  // an input only connection may be point to point or multicast
+  params.setMode(IO_CONNECTION_INPUT_ONLY);
+  EXPECT_EQ(IOConnectionParams::INPUT_ONLY_HEARTBEAT_ID, params.o_to_t_assembly_id);
+  EXPECT_EQ(IOConnectionParams::HEARTBEAT_BUFFER_SIZE, params.o_to_t_buffer_size);
+  EXPECT_FALSE(params.t_to_o_multicast);
+  EXPECT_NO_THROW(params.validate());
+  params.o_to_t_buffer_size = 0x6E;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+
+  params.setMode(IO_CONNECTION_LISTEN_ONLY);
+  EXPECT_EQ(IOConnectionParams::LISTEN_ONLY_HEARTBEAT_ID, params.o_to_t_assembly_id);
+  EXPECT_TRUE(params.t_to_o_multicast);
+  EXPECT_NO_THROW(params.validate());
+  params.t_to_o_multicast = false;
+  EXPECT_THROW(params.validate(), std::invalid_argument);
+
+  // back to an owner, which keeps the multicast T->O for its listeners
+  params.t_to_o_multicast = true;
+  params.setMode(IO_CONNECTION_OWNER);
+  EXPECT_EQ(0x71, params.o_to_t_assembly_id);
+  EXPECT_EQ(0x6E, params.o_to_t_buffer_size);
+  EXPECT_TRUE(params.t_to_o_multicast);
+  EXPECT_NO_THROW(params.validate());
+}
+
+TEST_F(IOConnectionParamsTest, test_fallback_params_keep_mode)
+{
+  // a listen only connection never falls back to taking over the scanner
+  IOConnectionParams listener;
+  listener.setMode(IO_CONNECTION_LISTEN_ONLY);
+  listener.t_to_o_rpi = 40000;
+  vector<IOConnectionParams> fallbacks = getFallbackParams(listener);
+  ASSERT_EQ(2, fallbacks.size());
+  EXPECT_EQ(IO_CONNECTION_LISTEN_ONLY, fallbacks[1].mode);
+  EXPECT_TRUE(fallbacks[1].t_to_o_multicast);
+  EXPECT_EQ(IOConnectionParams().t_to_o_rpi, fallbacks[1].t_to_o_rpi);
+
+  // and a multicast owner does not cut off its listeners
+  IOConnectionParams owner;
+  owner.t_to_o_multicast = true;
+  owner.t_to_o_buffer_size = 0x0400;
+  fallbacks = getFallbackParams(owner);
+  ASSERT_EQ(2, fallbacks.size());
+  EXPECT_TRUE(fallbacks[1].t_to_o_multicast);
+  EXPECT_EQ(0x0584, fallbacks[1].t_to_o_buffer_size);
+}
@@ -0,0 +1,193 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_packet_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <vector>
+
+#include "odva_ethernetip/serialization/buffer_reader.h"
+#include "omron_os32c_driver/io_packet.h"
+
+using eip::serialization::BufferReader;
+using namespace omron_os32c_driver;
+
+// IO packet with a measurement report of 20 beams and scan count 0x00045376
+static EIP_BYTE io_packet[] = {
+    0x02, 0x00, 0x02, 0x80, 0x08, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0x15, 0x00, 0x00, 0x00, 0xB1, 0x00,
+    0x62, 0x00, 0xA1, 0x00, 0x76, 0x53, 0x04, 0x00,
+    0x64, 0x96, 0x00, 0x00, 0x18, 0xBE, 0x97, 0x8A,
+    0x19, 0xA7, 0x00, 0x00, 0x03, 0x00, 0x07, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x00, 0x00, 0x08, 0x07, 0x88, 0x33, 0xAE, 0x31,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x14, 0x00, 0x52, 0x08, 0x42, 0x08,
+    0x52, 0x08, 0x40, 0x08, 0x52, 0x08, 0x40, 0x08,
+    0x53, 0x08, 0x58, 0x08, 0x52, 0x08, 0x40, 0x08,
+    0x58, 0x08, 0x58, 0x08, 0x58, 0x08, 0x5E, 0x08,
+    0x67, 0x08, 0x5D, 0x08, 0x67, 0x08, 0x5E, 0x08,
+    0x5E, 0x08, 0x6F, 0x08,
+  };
+
+// offsets into the packet above
+static const size_t ITEM_TYPE_OFFSET = 14;
+static const size_t ITEM_LENGTH_OFFSET = 16;
+static const size_t NUM_BEAMS_OFFSET = 74;
+
+class IOPacketTest : public :: testing :: Test
+{
+public:
+  IOPacketTest() : packet(io_packet, io_packet + sizeof(io_packet))
+  {
+  }
+
+  DECODE_STATUS decode()
+  {
+    return decodeMeasurementReport(&packet[0], packet.size(), report);
+  }
+
+protected:
+  std::vector<EIP_BYTE> packet;
+  MeasurementReport report;
+};
+
+TEST_F(IOPacketTest, test_decode)
+{
+  ASSERT_EQ(DECODE_OK, decode());
+  EXPECT_EQ(0x00045376, report.header.scan_count);
+  EXPECT_EQ(20, report.header.num_beams);
+  ASSERT_EQ(20, report.measurement_data.size());
+  EXPECT_EQ(0x0852, report.measurement_data[0]);
+  EXPECT_EQ(0x0842, report.measurement_data[1]);
+  EXPECT_EQ(0x086F, report.measurement_data[19]);
+}
+
+TEST_F(IOPacketTest, test_truncated)
+{
+  // every truncation of the packet should be rejected, never overrun
+  for (size_t size = 0; size < packet.size(); ++size)
+  {
+    DECODE_STATUS status = decodeMeasurementReport(&packet[0], size, report);
+    EXPECT_NE(DECODE_OK, status) << "size " << size;
+  }
+  EXPECT_EQ(DECODE_TRUNCATED, decodeMeasurementReport(&packet[0], 40, report));
+}
+
+TEST_F(IOPacketTest, test_wrong_item_count)
+{
+  packet[0] = 3;
+  EXPECT_EQ(DECODE_WRONG_ITEM_COUNT, decode());
+}
+
+TEST_F(IOPacketTest, test_wrong_item_type)
+{
+  packet[ITEM_TYPE_OFFSET] = 0xB2;
+  EXPECT_EQ(DECODE_WRONG_ITEM_TYPE, decode());
+}
+
+TEST_F(IOPacketTest, test_too_many_beams)
+{
+  packet[NUM_BEAMS_OFFSET] = 0xA6;
+  packet[NUM_BEAMS_OFFSET + 1] = 0x02;
+  EXPECT_EQ(DECODE_TOO_MANY_BEAMS, decode());
+  packet[NUM_BEAMS_OFFSET] = 0xFF;
+  packet[NUM_BEAMS_OFFSET + 1] = 0xFF;
+  EXPECT_EQ(DECODE_TOO_MANY_BEAMS, decode());
+}
+
+TEST_F(IOPacketTest, test_length_mismatch)
+{
+  // more beams claimed than data sent
+  packet[NUM_BEAMS_OFFSET] = 21;
+  EXPECT_EQ(DECODE_LENGTH_MISMATCH, decode());
+
+  // item length shorter than the data
+  packet[NUM_BEAMS_OFFSET] = 20;
+  packet[ITEM_LENGTH_OFFSET] = 0x60;
+  EXPECT_EQ(DECODE_LENGTH_MISMATCH, decode());
+
+  // item length longer than the packet
+  packet[ITEM_LENGTH_OFFSET] = 0x64;
+  EXPECT_EQ(DECODE_TRUNCATED, decode());
+}
+
+TEST_F(IOPacketTest, test_status_strings)
+{
+  EXPECT_STREQ("OK", decodeStatusString(DECODE_OK));
+  EXPECT_STREQ("Number of beams does not match data received",
+    decodeStatusString(DECODE_LENGTH_MISMATCH));
+}
+
+TEST_F(IOPacketTest, test_encode_measurement_report_config)
+{
+  MeasurementReportConfig mrc;
+  mrc.sequence_num = 7;
+  mrc.range_report_format = 1;
+  mrc.reflectivity_report_format = 2;
+  mrc.beam_selection_mask[0] = 0xFF;
+  mrc.beam_selection_mask[87] = 0x0F;
+
+  EIP_BYTE d[256];
+  ASSERT_EQ(18 + 110, encodeMeasurementReportConfig(mrc, 0x00020004, 0x15, d, sizeof(d)));
+
+  EIP_BYTE expected_cpf[] = {
+    0x02, 0x00, 0x02, 0x80, 0x08, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0x15, 0x00, 0x00, 0x00, 0xB1, 0x00,
+    0x6E, 0x00,
+  };
+  for (size_t i = 0; i < sizeof(expected_cpf); ++i)
+  {
+    EXPECT_EQ(expected_cpf[i], d[i]) << "byte " << i;
+  }
+
+  MeasurementReportConfig decoded;
+  BufferReader reader(boost::asio::buffer(d + 18, 110));
+  decoded.deserialize(reader);
+  EXPECT_EQ(7, decoded.sequence_num);
+  EXPECT_EQ(1, decoded.range_report_format);
+  EXPECT_EQ(2, decoded.reflectivity_report_format);
+  EXPECT_EQ(0xFF, decoded.beam_selection_mask[0]);
+  EXPECT_EQ(0x0F, decoded.beam_selection_mask[87]);
+
+  EXPECT_THROW(encodeMeasurementReportConfig(mrc, 0x00020004, 0x15, d, 100), std::length_error);
+}
+
+TEST_F(IOPacketTest, test_encode_heartbeat)
+{
+  EIP_BYTE d[32];
+  EIP_BYTE expected[] = {
+    0x02, 0x00, 0x02, 0x80, 0x08, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0x15, 0x00, 0x00, 0x00, 0xB1, 0x00,
+    0x02, 0x00, 0x15, 0x00,
+  };
+  ASSERT_EQ(sizeof(expected), encodeHeartbeat(0x00020004, 0x15, d, sizeof(d)));
+  for (size_t i = 0; i < sizeof(expected); ++i)
+  {
+    EXPECT_EQ(expected[i], d[i]) << "byte " << i;
+  }
+
+  EXPECT_THROW(encodeHeartbeat(0x00020004, 0x15, d, 19), std::length_error);
+}
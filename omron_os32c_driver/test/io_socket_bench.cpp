@@ -0,0 +1,221 @@
+/**
+Software License Agreement (BSD)
+
+\file      io_socket_bench.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/**
+ * Shows the effect of the IO socket options on latency and drops. A local
+ * packet generator sends scan sized datagrams over loopback to a UDPIOSocket
+ * at a configurable rate, while the receiver spends a configurable time on
+ * each packet to simulate conversion and publishing. Reports the latency from
+ * send to receive, packets lost according to their sequence numbers, and
+ * the drops counted by the kernel, e.g.:
+ *
+ *   io_socket_bench --rate 2000 --work-us 600
+ *   io_socket_bench --rate 2000 --work-us 600 --rcvbuf 1048576
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <boost/asio.hpp>
+
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/udp_io_socket.h"
+
+using namespace omron_os32c_driver;
+
+// packet size of a full 677 beam measurement report, plus CPF framing
+static const size_t PACKET_SIZE = 1434;
+static const uint32_t END_MARKER = 0xFFFFFFFF;
+
+struct GeneratorArgs
+{
+  unsigned short port;
+  double rate;
+  uint32_t count;
+};
+
+struct PacketHeader
+{
+  uint32_t sequence;
+  uint64_t send_time;
+};
+
+static void* generatorThread(void* arg)
+{
+  GeneratorArgs* args = static_cast<GeneratorArgs*>(arg);
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dest.sin_port = htons(args->port);
+
+  unsigned char packet[PACKET_SIZE];
+  memset(packet, 0x34, sizeof(packet));
+  PacketHeader header;
+  uint64_t period = 1e9 / args->rate;
+  uint64_t next = monotonicNanoseconds();
+  for (uint32_t i = 0; i <= args->count + 10; ++i)
+  {
+    next += (i < args->count) ? period : 10000000;
+    timespec ts;
+    ts.tv_sec = next / 1000000000ULL;
+    ts.tv_nsec = next % 1000000000ULL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+    header.sequence = (i < args->count) ? i : END_MARKER;
+    header.send_time = monotonicNanoseconds();
+    memcpy(packet, &header, sizeof(header));
+    sendto(sock, packet, sizeof(packet), 0, reinterpret_cast<sockaddr*>(&dest), sizeof(dest));
+  }
+  ::close(sock);
+  return NULL;
+}
+
+static void usage()
+{
+  printf("Usage: io_socket_bench [--rate PPS] [--count N] [--work-us US] [--port PORT]\n"
+         "                       [--rcvbuf BYTES] [--busy-poll US] [--priority P] [--dscp D]\n");
+}
+
+int main(int argc, char *argv[])
+{
+  GeneratorArgs gen;
+  gen.port = 22220;
+  gen.rate = 1000;
+  gen.count = 5000;
+  int work_us = 0;
+  int rcvbuf = 0, busy_poll = 0, priority = -1, dscp = -1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--rate" && has_value)
+      gen.rate = atof(argv[++i]);
+    else if (arg == "--count" && has_value)
+      gen.count = atoi(argv[++i]);
+    else if (arg == "--work-us" && has_value)
+      work_us = atoi(argv[++i]);
+    else if (arg == "--port" && has_value)
+      gen.port = atoi(argv[++i]);
+    else if (arg == "--rcvbuf" && has_value)
+      rcvbuf = atoi(argv[++i]);
+    else if (arg == "--busy-poll" && has_value)
+      busy_poll = atoi(argv[++i]);
+    else if (arg == "--priority" && has_value)
+      priority = atoi(argv[++i]);
+    else if (arg == "--dscp" && has_value)
+      dscp = atoi(argv[++i]);
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+
+  boost::asio::io_service io_service;
+  UDPIOSocket io_socket(io_service, gen.port);
+  try
+  {
+    io_socket.enableDropCounting();
+    if (rcvbuf > 0)
+    {
+      printf("Receive buffer set to %d bytes\n", io_socket.setReceiveBufferSize(rcvbuf));
+    }
+    if (busy_poll > 0)
+    {
+      io_socket.setBusyPoll(busy_poll);
+    }
+    if (priority >= 0)
+    {
+      io_socket.setPriority(priority);
+    }
+    if (dscp >= 0)
+    {
+      io_socket.setDSCP(dscp);
+    }
+  }
+  catch (std::exception& ex)
+  {
+    fprintf(stderr, "Could not configure socket: %s\n", ex.what());
+    return 1;
+  }
+
+  pthread_t generator;
+  pthread_create(&generator, NULL, generatorThread, &gen);
+
+  std::vector<uint64_t> latencies;
+  latencies.reserve(gen.count);
+  unsigned char packet[PACKET_SIZE];
+  uint32_t received = 0;
+  while (true)
+  {
+    size_t n = io_socket.receive(boost::asio::buffer(packet));
+    uint64_t now = monotonicNanoseconds();
+    PacketHeader header;
+    if (n < sizeof(header))
+    {
+      continue;
+    }
+    memcpy(&header, packet, sizeof(header));
+    if (header.sequence == END_MARKER)
+    {
+      break;
+    }
+    ++received;
+    latencies.push_back(now - header.send_time);
+
+    // simulate conversion and publishing
+    uint64_t busy_until = now + work_us * 1000ULL;
+    while (monotonicNanoseconds() < busy_until)
+    {
+    }
+  }
+  pthread_join(generator, NULL);
+
+  if (latencies.empty())
+  {
+    printf("No packets received\n");
+    return 1;
+  }
+  std::sort(latencies.begin(), latencies.end());
+  printf("%u of %u packets received, %u lost, %u dropped by the kernel\n",
+    received, gen.count, gen.count - received, io_socket.getKernelDrops());
+  printf("latency: median %lu us, p99 %lu us, max %lu us\n",
+    static_cast<unsigned long>(latencies[latencies.size() / 2] / 1000),
+    static_cast<unsigned long>(latencies[latencies.size() * 99 / 100] / 1000),
+    static_cast<unsigned long>(latencies.back() / 1000));
+  return 0;
+}
@@ -0,0 +1,179 @@
+/**
+Software License Agreement (BSD)
+
+\file      laserscan_serialization_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <ros/serialization.h>
+
+#include "omron_os32c_driver/laserscan_serialization.h"
+#include "omron_os32c_driver/ros_conversions.h"
+
+using namespace omron_os32c_driver;
+namespace ser = ros::serialization;
+
+class LaserScanSerializationTest : public :: testing :: Test
+{
+protected:
+  virtual void SetUp()
+  {
+    ls.header.frame_id = "laser";
+    ls.header.seq = 42;
+    ls.header.stamp.sec = 1234;
+    ls.header.stamp.nsec = 5678;
+    ls.angle_max = 2.3596851486963333;
+    ls.angle_min = -2.3596851486963333;
+    ls.angle_increment = OS32C::ANGLE_INC;
+    ls.range_min = OS32C::DISTANCE_MIN;
+    ls.range_max = OS32C::DISTANCE_MAX;
+    raw.setStaticConfig(ls);
+  }
+
+  void fillHeader(MeasurementReportHeader& mrh, EIP_UINT num_beams)
+  {
+    mrh.scan_count = 0xDEADBEEF;
+    mrh.scan_rate = 38609;
+    mrh.scan_timestamp = 140420933;
+    mrh.scan_beam_period = 42898;
+    mrh.machine_state = 3;
+    mrh.machine_stop_reasons = 7;
+    mrh.range_report_format = RANGE_MEASURE_50M;
+    mrh.refletivity_report_format = REFLECTIVITY_MEASURE_TOT_4PS;
+    mrh.num_beams = num_beams;
+  }
+
+  // Serialize both messages and check that the results are identical
+  void expectSameWireFormat()
+  {
+    uint32_t ls_len = ser::serializationLength(ls);
+    uint32_t raw_len = ser::serializationLength(raw);
+    ASSERT_EQ(ls_len, raw_len);
+
+    std::vector<uint8_t> ls_buf(ls_len), raw_buf(raw_len);
+    ser::OStream ls_stream(&ls_buf[0], ls_len);
+    ser::serialize(ls_stream, ls);
+    ser::OStream raw_stream(&raw_buf[0], raw_len);
+    ser::serialize(raw_stream, raw);
+    EXPECT_EQ(0, raw_stream.getLength());
+    EXPECT_TRUE(ls_buf == raw_buf);
+  }
+
+  sensor_msgs::LaserScan ls;
+  RawLaserScan raw;
+};
+
+TEST_F(LaserScanSerializationTest, test_traits)
+{
+  namespace mt = ros::message_traits;
+  EXPECT_STREQ(mt::MD5Sum<sensor_msgs::LaserScan>::value(), mt::MD5Sum<RawLaserScan>::value());
+  EXPECT_STREQ(mt::DataType<sensor_msgs::LaserScan>::value(), mt::DataType<RawLaserScan>::value());
+  EXPECT_STREQ(mt::Definition<sensor_msgs::LaserScan>::value(), mt::Definition<RawLaserScan>::value());
+}
+
+TEST_F(LaserScanSerializationTest, test_measurement_report)
+{
+  MeasurementReport mr;
+  fillHeader(mr.header, 6);
+  mr.measurement_data.resize(6);
+  mr.measurement_data[0] = 1000;
+  mr.measurement_data[1] = 1253;
+  mr.measurement_data[2] = 1;
+  mr.measurement_data[3] = 48750;
+  mr.measurement_data[4] = 65535;
+  mr.measurement_data[5] = 50001;
+
+  convertToLaserScan(mr, &ls);
+  raw.setMeasurement(mr);
+  expectSameWireFormat();
+}
+
+TEST_F(LaserScanSerializationTest, test_range_and_reflectance)
+{
+  RangeAndReflectanceMeasurement rr;
+  fillHeader(rr.header, 4);
+  rr.range_data.resize(4);
+  rr.reflectance_data.resize(4);
+  rr.range_data[0] = 1000;
+  rr.range_data[1] = 1;
+  rr.range_data[2] = 65535;
+  rr.range_data[3] = 48135;
+  rr.reflectance_data[0] = 44000;
+  rr.reflectance_data[1] = 0;
+  rr.reflectance_data[2] = 65535;
+  rr.reflectance_data[3] = 1013;
+
+  convertToLaserScan(rr, &ls);
+  raw.setMeasurement(rr);
+  expectSameWireFormat();
+}
+
+TEST_F(LaserScanSerializationTest, test_calibrated_reflectivity)
+{
+  ReflectivityCalibration cal;
+  vector<double> ranges = { 1000, 50000 };
+  vector<double> tots = { 0, 50000 };
+  vector<double> values = { 0, 1, 0, 2 };
+  cal.setTable(ranges, tots, values);
+
+  RangeAndReflectanceMeasurement rr;
+  fillHeader(rr.header, 4);
+  rr.range_data.resize(4);
+  rr.reflectance_data.resize(4);
+  rr.range_data[0] = 1000;
+  rr.range_data[1] = 1;
+  rr.range_data[2] = 65535;
+  rr.range_data[3] = 25500;
+  rr.reflectance_data[0] = 25000;
+  rr.reflectance_data[1] = 20000;
+  rr.reflectance_data[2] = 20000;
+  rr.reflectance_data[3] = 50000;
+
+  convertToLaserScan(rr, &ls, &cal);
+  ASSERT_EQ(4, ls.intensities.size());
+  EXPECT_FLOAT_EQ(0.5, ls.intensities[0]);
+  EXPECT_EQ(0, ls.intensities[1]);
+  EXPECT_EQ(0, ls.intensities[2]);
+  EXPECT_FLOAT_EQ(1.5, ls.intensities[3]);
+
+  raw.setMeasurement(rr);
+  raw.calibration = &cal;
+  expectSameWireFormat();
+}
+
+TEST_F(LaserScanSerializationTest, test_empty)
+{
+  MeasurementReport mr;
+  fillHeader(mr.header, 0);
+  convertToLaserScan(mr, &ls);
+  raw.setMeasurement(mr);
+  expectSameWireFormat();
+}
+
+TEST_F(LaserScanSerializationTest, test_size_mismatch)
+{
+  MeasurementReport mr;
+  fillHeader(mr.header, 5);
+  mr.measurement_data.resize(4);
+  EXPECT_THROW(raw.setMeasurement(mr), std::invalid_argument);
+}
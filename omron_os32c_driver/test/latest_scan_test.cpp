@@ -0,0 +1,192 @@
+/**
+Software License Agreement (BSD)
+
+\file      latest_scan_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "omron_os32c_driver/latest_scan.h"
+
+using namespace omron_os32c_driver;
+
+class LatestScanTest : public :: testing :: Test
+{
+
+};
+
+TEST_F(LatestScanTest, test_empty)
+{
+  LatestMeasurementReport latest;
+  EXPECT_EQ(0, latest.getGeneration());
+  LatestMeasurementReport::Handle handle = latest.read();
+  EXPECT_FALSE(handle.valid());
+  EXPECT_EQ(0, handle.generation());
+}
+
+TEST_F(LatestScanTest, test_publish_and_read)
+{
+  LatestMeasurementReport latest;
+  MeasurementReport* slot = latest.beginWrite();
+  ASSERT_TRUE(slot != NULL);
+  slot->header.scan_count = 1234;
+  slot->measurement_data.assign(10, 0x0852);
+  latest.publish();
+  EXPECT_EQ(1, latest.getGeneration());
+
+  LatestMeasurementReport::Handle handle = latest.read();
+  ASSERT_TRUE(handle.valid());
+  EXPECT_EQ(1, handle.generation());
+  EXPECT_EQ(1234, handle->header.scan_count);
+  EXPECT_EQ(10, (*handle).measurement_data.size());
+
+  // handed over in place, without copying
+  EXPECT_EQ(slot, &*handle);
+}
+
+TEST_F(LatestScanTest, test_generations)
+{
+  LatestMeasurementReport latest;
+  for (EIP_UDINT i = 1; i <= 10; ++i)
+  {
+    MeasurementReport* slot = latest.beginWrite();
+    ASSERT_TRUE(slot != NULL);
+    slot->header.scan_count = i;
+    latest.publish();
+
+    LatestMeasurementReport::Handle handle = latest.read();
+    EXPECT_EQ(i, handle.generation());
+    EXPECT_EQ(i, handle->header.scan_count);
+    EXPECT_EQ(i, latest.getGeneration());
+  }
+}
+
+TEST_F(LatestScanTest, test_held_buffers_not_overwritten)
+{
+  LatestMeasurementReport latest;
+  latest.beginWrite()->header.scan_count = 1;
+  latest.publish();
+  LatestMeasurementReport::Handle first = latest.read();
+
+  latest.beginWrite()->header.scan_count = 2;
+  latest.publish();
+  LatestMeasurementReport::Handle second = latest.read();
+
+  latest.beginWrite()->header.scan_count = 3;
+  latest.publish();
+
+  // the latest is never written to and the other two are held, so there is
+  // nowhere to write
+  EXPECT_TRUE(latest.beginWrite() == NULL);
+  EXPECT_EQ(1, first->header.scan_count);
+  EXPECT_EQ(2, second->header.scan_count);
+
+  first.release();
+  MeasurementReport* slot = latest.beginWrite();
+  ASSERT_TRUE(slot != NULL);
+  slot->header.scan_count = 4;
+  latest.publish();
+  EXPECT_EQ(2, second->header.scan_count);
+  EXPECT_EQ(4, latest.read()->header.scan_count);
+}
+
+TEST_F(LatestScanTest, test_move_handle)
+{
+  LatestMeasurementReport latest;
+  latest.beginWrite()->header.scan_count = 1;
+  latest.publish();
+
+  LatestMeasurementReport::Handle handle;
+  EXPECT_FALSE(handle.valid());
+  handle = latest.read();
+  LatestMeasurementReport::Handle moved(std::move(handle));
+  EXPECT_FALSE(handle.valid());
+  EXPECT_TRUE(moved.valid());
+  EXPECT_EQ(1, moved->header.scan_count);
+}
+
+TEST_F(LatestScanTest, test_concurrent_readers)
+{
+  LatestMeasurementReport latest;
+  std::atomic<bool> done(false);
+  std::atomic<int> errors(0);
+
+  // each reader checks that every scan it sees is consistent and that
+  // generations never go backwards
+  std::vector<std::thread> readers;
+  for (int r = 0; r < 4; ++r)
+  {
+    readers.push_back(std::thread([&]()
+    {
+      uint64_t last_generation = 0;
+      while (!done)
+      {
+        LatestMeasurementReport::Handle handle = latest.read();
+        if (!handle.valid())
+        {
+          continue;
+        }
+        if (handle.generation() < last_generation)
+        {
+          ++errors;
+        }
+        last_generation = handle.generation();
+        EIP_UINT expected = handle->header.scan_count & 0xFFFF;
+        for (size_t i = 0; i < handle->measurement_data.size(); ++i)
+        {
+          if (handle->measurement_data[i] != expected)
+          {
+            ++errors;
+            break;
+          }
+        }
+      }
+    }));
+  }
+
+  int published = 0;
+  for (EIP_UDINT i = 1; i <= 20000; ++i)
+  {
+    MeasurementReport* slot = latest.beginWrite();
+    if (!slot)
+    {
+      continue;
+    }
+    slot->header.scan_count = i;
+    slot->measurement_data.assign(677, i & 0xFFFF);
+    latest.publish();
+    ++published;
+  }
+  done = true;
+  for (size_t r = 0; r < readers.size(); ++r)
+  {
+    readers[r].join();
+  }
+
+  EXPECT_EQ(0, errors);
+  EXPECT_LT(0, published);
+  EXPECT_EQ(published, latest.getGeneration());
+}
@@ -45,7 +45,7 @@ class MeasurementReportTest : public :: testing :: Test
 
 TEST_F(MeasurementReportTest, test_deserialize)
 {
-  EIP_BYTE d[56 + 2000];
+  EIP_BYTE d[56 + 2 * 677];
 
   // use a measurement report header to serialize the header data
   MeasurementReportHeader mrh;
@@ -65,12 +65,12 @@ TEST_F(MeasurementReportTest, test_deserialize)
   mrh.safety_config_checksum = 0x5AA5;
   mrh.range_report_format = 1;
   mrh.refletivity_report_format = 1;
-  mrh.num_beams = 1000;
+  mrh.num_beams = 677;
 
   BufferWriter writer(buffer(d));
   mrh.serialize(writer);
 
-  for (EIP_UINT i = 10000; i < 10000 + 1000; ++i) {
+  for (EIP_UINT i = 10000; i < 10000 + 677; ++i) {
     writer.write(i);
   }
 
@@ -97,9 +97,9 @@ TEST_F(MeasurementReportTest, test_deserialize)
   EXPECT_EQ(0x5AA5, mr.header.safety_config_checksum);
   EXPECT_EQ(1, mr.header.range_report_format);
   EXPECT_EQ(1, mr.header.refletivity_report_format);
-  EXPECT_EQ(1000, mr.header.num_beams);
+  EXPECT_EQ(677, mr.header.num_beams);
 
-  EXPECT_EQ(1000, mr.measurement_data.size());
+  EXPECT_EQ(677, mr.measurement_data.size());
   for (int i = 0; i < mr.measurement_data.size(); ++i)
   {
     EXPECT_EQ(i + 10000, mr.measurement_data[i]);
@@ -125,14 +125,14 @@ TEST_F(MeasurementReportTest, test_serialize)
   mr.header.safety_config_checksum = 0x5AA5;
   mr.header.range_report_format = 1;
   mr.header.refletivity_report_format = 1;
-  mr.header.num_beams = 1000;
+  mr.header.num_beams = 677;
 
-  mr.measurement_data.resize(1000);
-  for (int i = 0; i <  1000; ++i) {
+  mr.measurement_data.resize(677);
+  for (int i = 0; i <  677; ++i) {
     mr.measurement_data[i] = i + 30000;
   }
 
-  EIP_BYTE d[56 + 2000];
+  EIP_BYTE d[56 + 2 * 677];
   EXPECT_EQ(sizeof(d), mr.getLength());
   BufferWriter writer(buffer(d));
   mr.serialize(writer);
@@ -192,13 +192,47 @@ TEST_F(MeasurementReportTest, test_serialize)
   EXPECT_EQ(d[51], 0);
   EXPECT_EQ(d[52], 0);
   EXPECT_EQ(d[53], 0);
-  EXPECT_EQ(d[54], 0xE8);
-  EXPECT_EQ(d[55], 0x03);
+  EXPECT_EQ(d[54], 0xA5);
+  EXPECT_EQ(d[55], 0x02);
 
-  for (int i = 0; i < 1000; ++i)
+  for (int i = 0; i < 677; ++i)
   {
     EIP_UINT exp_value = i + 30000;
     EXPECT_EQ((exp_value) & 0x00FF, d[56 + i*2]);
     EXPECT_EQ((exp_value >> 8) & 0x00FF, d[56 + i*2 + 1]);
   }
 }
+
+TEST_F(MeasurementReportTest, test_deserialize_too_many_beams)
+{
+  EIP_BYTE d[56 + 2 * 678];
+  MeasurementReportHeader mrh;
+  mrh.num_beams = 678;
+  BufferWriter writer(buffer(d));
+  mrh.serialize(writer);
+
+  BufferReader reader(buffer(d));
+  MeasurementReport mr;
+  EXPECT_THROW(mr.deserialize(reader), std::length_error);
+  EXPECT_EQ(0, mr.measurement_data.size());
+
+  BufferReader reader2(buffer(d));
+  EXPECT_THROW(mr.deserialize(reader2, sizeof(d)), std::length_error);
+  EXPECT_EQ(0, mr.measurement_data.size());
+}
+
+TEST_F(MeasurementReportTest, test_deserialize_short_length)
+{
+  EIP_BYTE d[56 + 2 * 10];
+  MeasurementReportHeader mrh;
+  mrh.num_beams = 11;
+  BufferWriter writer(buffer(d));
+  mrh.serialize(writer);
+
+  // rejected on the length given, before anything is allocated or read
+  BufferReader reader(buffer(d));
+  MeasurementReport mr;
+  EXPECT_THROW(mr.deserialize(reader, sizeof(d)), std::length_error);
+  EXPECT_EQ(0, mr.measurement_data.size());
+  EXPECT_EQ(56, reader.getByteCount());
+}
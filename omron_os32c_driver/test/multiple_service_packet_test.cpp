@@ -0,0 +1,148 @@
+/**
+Software License Agreement (BSD)
+
+\file      multiple_service_packet_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+#include <boost/make_shared.hpp>
+
+#include "omron_os32c_driver/multiple_service_packet.h"
+#include "odva_ethernetip/serialization/serializable_buffer.h"
+#include "odva_ethernetip/serialization/serializable_primitive.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+#include "odva_ethernetip/serialization/buffer_reader.h"
+
+using boost::make_shared;
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+using namespace eip;
+using namespace eip::serialization;
+
+class MultipleServicePacketTest : public :: testing :: Test
+{
+
+};
+
+TEST_F(MultipleServicePacketTest, test_serialize_request)
+{
+  EIP_BYTE mask[] = { 0xFF, 0x0F };
+  MultipleServiceRequest req;
+  req.addRequest(0x10, Path(0x73, 1, 4), make_shared<SerializablePrimitive<EIP_UINT> >(1));
+  req.addRequest(0x10, Path(0x73, 1, 12), make_shared<SerializableBuffer>(buffer(mask)));
+  req.addRequest(0x0E, Path(0x73, 1, 5));
+  EXPECT_EQ(3, req.getRequestCount());
+
+  EIP_BYTE d[] = {
+    0x03, 0x00, 0x08, 0x00, 0x12, 0x00, 0x1C, 0x00,
+    0x10, 0x03, 0x20, 0x73, 0x24, 0x01, 0x30, 0x04,
+    0x01, 0x00,
+    0x10, 0x03, 0x20, 0x73, 0x24, 0x01, 0x30, 0x0C,
+    0xFF, 0x0F,
+    0x0E, 0x03, 0x20, 0x73, 0x24, 0x01, 0x30, 0x05,
+  };
+  EXPECT_EQ(sizeof(d), req.getLength());
+
+  EIP_BYTE out[64];
+  BufferWriter writer(buffer(out));
+  req.serialize(writer);
+  ASSERT_EQ(sizeof(d), writer.getByteCount());
+  for (size_t i = 0; i < sizeof(d); ++i)
+  {
+    EXPECT_EQ(d[i], out[i]) << "at byte " << i;
+  }
+}
+
+TEST_F(MultipleServicePacketTest, test_deserialize_response)
+{
+  EIP_BYTE d[] = {
+    0x03, 0x00, 0x08, 0x00, 0x0C, 0x00, 0x12, 0x00,
+    0x90, 0x00, 0x00, 0x00,
+    0x90, 0x00, 0x0E, 0x01, 0x34, 0x12,
+    0x8E, 0x00, 0x00, 0x00, 0x02, 0x00,
+  };
+
+  BufferReader reader(buffer(d));
+  MultipleServiceResponse resp;
+  resp.deserialize(reader, sizeof(d));
+  EXPECT_EQ(sizeof(d), reader.getByteCount());
+  EXPECT_EQ(sizeof(d), resp.getLength());
+  ASSERT_EQ(3, resp.replies.size());
+
+  EXPECT_EQ(0x90, resp.replies[0].service);
+  EXPECT_EQ(0, resp.replies[0].general_status);
+  EXPECT_EQ(0, resp.replies[0].additional_status.size());
+  EXPECT_EQ(0, resp.replies[0].data.size());
+
+  EXPECT_EQ(0x90, resp.replies[1].service);
+  EXPECT_EQ(0x0E, resp.replies[1].general_status);
+  ASSERT_EQ(1, resp.replies[1].additional_status.size());
+  EXPECT_EQ(0x1234, resp.replies[1].additional_status[0]);
+  EXPECT_EQ(0, resp.replies[1].data.size());
+
+  EXPECT_EQ(0x8E, resp.replies[2].service);
+  EXPECT_EQ(0, resp.replies[2].general_status);
+  EXPECT_EQ(2, resp.replies[2].getDataAs<EIP_UINT>());
+  EXPECT_THROW(resp.replies[2].getDataAs<EIP_UDINT>(), std::length_error);
+}
+
+TEST_F(MultipleServicePacketTest, test_serialize_response)
+{
+  EIP_BYTE d[] = {
+    0x02, 0x00, 0x06, 0x00, 0x0A, 0x00,
+    0x90, 0x00, 0x00, 0x00,
+    0x8E, 0x00, 0x00, 0x00, 0x01, 0x00,
+  };
+
+  BufferReader reader(buffer(d));
+  MultipleServiceResponse resp;
+  resp.deserialize(reader, sizeof(d));
+
+  EIP_BYTE out[sizeof(d)];
+  BufferWriter writer(buffer(out));
+  resp.serialize(writer);
+  ASSERT_EQ(sizeof(d), writer.getByteCount());
+  EXPECT_EQ(0, memcmp(d, out, sizeof(d)));
+}
+
+TEST_F(MultipleServicePacketTest, test_deserialize_invalid_offsets)
+{
+  EIP_BYTE d[] = {
+    0x02, 0x00, 0x0A, 0x00, 0x06, 0x00,
+    0x90, 0x00, 0x00, 0x00,
+    0x8E, 0x00, 0x00, 0x00, 0x01, 0x00,
+  };
+
+  BufferReader reader(buffer(d));
+  MultipleServiceResponse resp;
+  EXPECT_THROW(resp.deserialize(reader, sizeof(d)), std::logic_error);
+}
+
+TEST_F(MultipleServicePacketTest, test_deserialize_needs_length)
+{
+  EIP_BYTE d[] = { 0x00, 0x00 };
+  BufferReader reader(buffer(d));
+  MultipleServiceResponse resp;
+  EXPECT_THROW(resp.deserialize(reader), std::logic_error);
+}
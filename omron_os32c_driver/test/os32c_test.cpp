@@ -25,11 +25,15 @@ ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSI
 
 
 #include <gtest/gtest.h>
+#include <stdio.h>
+#include <unistd.h>
 #include <boost/make_shared.hpp>
 
 #include "omron_os32c_driver/os32c.h"
+#include "omron_os32c_driver/ros_conversions.h"
 #include "odva_ethernetip/socket/test_socket.h"
 #include "odva_ethernetip/rr_data_response.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
 #include "odva_ethernetip/serialization/serializable_buffer.h"
 #include "odva_ethernetip/serialization/serializable_primitive.h"
 
@@ -193,7 +197,7 @@ TEST_F(OS32CTest, test_calc_beam_invalid_args)
 
 TEST_F(OS32CTest, test_select_beams)
 {
-  char reg_resp_packet[] = {
+  EIP_BYTE reg_resp_packet[] = {
     0x65, 0x00, 0x04, 0x00, 0x05, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -212,7 +216,7 @@ TEST_F(OS32CTest, test_select_beams)
   memset(ts->tx_buffer, 0, sizeof(ts->tx_count));
 
   // response packet from OS32C docs
-  char resp_packet[] = {
+  EIP_BYTE resp_packet[] = {
     0x6F, 0x00, 0x14, 0x00, 0x05, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
     0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
@@ -408,7 +412,7 @@ TEST_F(OS32CTest, test_convert_to_laserscan)
   rr.reflectance_data[9] = 0;
 
   sensor_msgs::LaserScan ls;
-  OS32C::convertToLaserScan(rr, &ls);
+  convertToLaserScan(rr, &ls);
   EXPECT_FLOAT_EQ(42898E-9, ls.time_increment);
   EXPECT_FLOAT_EQ( 1.0  , ls.ranges[0]);
   EXPECT_FLOAT_EQ( 1.253, ls.ranges[1]);
@@ -433,9 +437,245 @@ TEST_F(OS32CTest, test_convert_to_laserscan)
 }
 
 
+TEST_F(OS32CTest, test_send_measurement_report_config_not_started)
+{
+  EXPECT_THROW(os32c.sendMeasurmentReportConfigUDP(), std::logic_error);
+}
+
+TEST_F(OS32CTest, test_send_keepalive_not_started)
+{
+  EXPECT_THROW(os32c.sendKeepaliveUDP(), std::logic_error);
+  // nothing to close
+  EXPECT_NO_THROW(os32c.stopUDPIO());
+}
+
+TEST_F(OS32CTest, test_start_udp_io_invalid_params)
+{
+  // every candidate is checked before the first Forward Open is sent
+  IOConnectionParams bad;
+  bad.t_to_o_buffer_size = 0x1000;
+  vector<IOConnectionParams> candidates(1);
+  candidates.push_back(bad);
+  EXPECT_THROW(os32c.startUDPIO(candidates), std::invalid_argument);
+  EXPECT_THROW(os32c.startUDPIO(bad), std::invalid_argument);
+  EXPECT_THROW(os32c.startUDPIO(vector<IOConnectionParams>()), std::invalid_argument);
+  EXPECT_THROW(os32c.sendMeasurmentReportConfigUDP(), std::logic_error);
+  EXPECT_TRUE(IOConnectionParams() == os32c.getIOConnectionParams());
+}
+
+// reply to a Get Attribute Single of the range format over a Class 3
+// connection with T->O ID 0x11223344, to the request with sequence count 5
+static EIP_BYTE CONNECTED_REPLY[] = {
+  0x70, 0x00, 0x1C, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+  0xA1, 0x00, 0x04, 0x00, 0x44, 0x33, 0x22, 0x11,
+  0xB1, 0x00, 0x08, 0x00, 0x05, 0x00, 0x8E, 0x00,
+  0x00, 0x00, 0x03, 0x00,
+};
+
+TEST_F(OS32CTest, test_connected_get_attribute)
+{
+  os32c.explicit_open_ = true;
+  os32c.explicit_o_to_t_id_ = 0xAABBCCDD;
+  os32c.explicit_t_to_o_id_ = 0x11223344;
+  os32c.explicit_sequence_ = 4;
+  ts->rx_buffer = buffer(CONNECTED_REPLY);
+
+  EXPECT_EQ(RANGE_MEASURE_16M_WZ1PZ, os32c.getRangeFormat());
+  EXPECT_TRUE(os32c.isExplicitConnectionOpen());
+
+  // SendUnitData of a Get Attribute Single on the connection
+  ASSERT_EQ(54, ts->tx_count);
+  EXPECT_EQ(0x70, (EIP_BYTE)ts->tx_buffer[0]);
+  EXPECT_EQ(0xDD, (EIP_BYTE)ts->tx_buffer[36]);
+  EXPECT_EQ(0x05, (EIP_BYTE)ts->tx_buffer[44]);
+  EXPECT_EQ(0x0E, (EIP_BYTE)ts->tx_buffer[46]);
+}
+
+TEST_F(OS32CTest, test_connected_reply_mismatch)
+{
+  os32c.explicit_open_ = true;
+  os32c.explicit_t_to_o_id_ = 0x11223344;
+  os32c.explicit_sequence_ = 5;
+  ts->rx_buffer = buffer(CONNECTED_REPLY);
+
+  // reply is to the previous request, so the connection is given up
+  EXPECT_THROW(os32c.getRangeFormat(), std::logic_error);
+  EXPECT_FALSE(os32c.isExplicitConnectionOpen());
+}
+
+TEST_F(OS32CTest, test_close_explicit_connection)
+{
+  os32c.explicit_open_ = true;
+  os32c.explicit_o_to_t_id_ = 0xAABBCCDD;
+  os32c.closeExplicitConnection();
+  EXPECT_FALSE(os32c.isExplicitConnectionOpen());
+
+  // closing again sends nothing
+  ts->tx_count = 0;
+  EXPECT_NO_THROW(os32c.closeExplicitConnection());
+  EXPECT_EQ(0, ts->tx_count);
+}
+
+TEST_F(OS32CTest, test_connected_rr_scan)
+{
+  os32c.explicit_open_ = true;
+  os32c.explicit_o_to_t_id_ = 0xAABBCCDD;
+  os32c.explicit_t_to_o_id_ = 0x11223344;
+  os32c.explicit_sequence_ = 4;
+
+  // matched by the sequence count of the connection rather than the sender context
+  EXPECT_EQ(5, os32c.sendRRScanRequest(77));
+  EXPECT_EQ(0x70, (EIP_BYTE)ts->tx_buffer[0]);
+  EXPECT_EQ(0xDD, (EIP_BYTE)ts->tx_buffer[36]);
+  EXPECT_EQ(0x05, (EIP_BYTE)ts->tx_buffer[44]);
+  EXPECT_EQ(0x0E, (EIP_BYTE)ts->tx_buffer[46]);
+
+  RangeAndReflectanceMeasurement sent;
+  sent.header.scan_count = 100;
+  sent.header.num_beams = 2;
+  sent.range_data.resize(2);
+  sent.reflectance_data.resize(2);
+  sent.range_data[1] = 1000;
+  sent.reflectance_data[1] = 2000;
+  EIP_UINT data_item_length = 2 + 4 + sent.getLength();
+  EIP_BYTE rx[256];
+  BufferWriter writer(buffer(rx));
+  writer.write((EIP_UINT)0x70);
+  writer.write((EIP_UINT)(16 + 4 + data_item_length));
+  for (int i = 0; i < 6; ++i)
+  {
+    writer.write((EIP_UDINT)0);
+  }
+  writer.write((EIP_UINT)0);
+  writer.write((EIP_UINT)2);
+  writer.write((EIP_UINT)0xA1);
+  writer.write((EIP_UINT)4);
+  writer.write((EIP_UDINT)0x11223344);
+  writer.write((EIP_UINT)0xB1);
+  writer.write(data_item_length);
+  writer.write((EIP_UINT)5);
+  writer.write((EIP_UDINT)0x8E);
+  sent.serialize(writer);
+  ts->rx_buffer = buffer(rx, writer.getByteCount());
+
+  uint64_t context = 0;
+  RangeAndReflectanceMeasurement rr;
+  EXPECT_TRUE(os32c.receiveRRScan(context, rr));
+  EXPECT_EQ(5, context);
+  EXPECT_EQ(100, rr.header.scan_count);
+  ASSERT_EQ(2, rr.range_data.size());
+  EXPECT_EQ(2000, rr.reflectance_data[1]);
+}
+
+/**
+ * Build the SendRRData reply of the Message Router to an unconnected
+ * Multiple Service Packet, with the given status and data
+ */
+static vector<EIP_BYTE> makeUnconnectedMultipleServiceReply(EIP_USINT status,
+  const vector<EIP_BYTE>& data)
+{
+  EIP_UINT data_item_length = 4 + data.size();
+  EIP_UINT length = 6 + 2 + 4 + 4 + data_item_length;
+  EIP_BYTE header[] = {
+    0x6F, 0x00, (EIP_BYTE)length, (EIP_BYTE)(length >> 8), 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x00, 0x00,
+    0xB2, 0x00, (EIP_BYTE)data_item_length, (EIP_BYTE)(data_item_length >> 8),
+    0x8A, 0x00, status, 0x00,
+  };
+  vector<EIP_BYTE> reply(header, header + sizeof(header));
+  reply.insert(reply.end(), data.begin(), data.end());
+  return reply;
+}
+
+TEST_F(OS32CTest, test_configure_without_multiple_service)
+{
+  vector<EIP_BYTE> reply = makeUnconnectedMultipleServiceReply(SERVICE_NOT_SUPPORTED,
+    vector<EIP_BYTE>());
+  ts->rx_buffer = buffer(reply);
+
+  // each setting is written on its own instead
+  EXPECT_EQ(3, os32c.configure(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS,
+    OS32C::ANGLE_MAX, OS32C::ANGLE_MIN));
+  EXPECT_EQ(0x6F, (EIP_BYTE)ts->tx_buffer[0]);
+  EXPECT_EQ(0x0A, (EIP_BYTE)ts->tx_buffer[40]);
+  EXPECT_FALSE(os32c.isMultipleServiceSupported());
+
+  // and no Multiple Service Packet is tried again
+  ts->tx_count = 0;
+  EXPECT_EQ(3, os32c.configure(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS,
+    OS32C::ANGLE_MAX, OS32C::ANGLE_MIN));
+  EXPECT_EQ(0, ts->tx_count);
+}
+
+TEST_F(OS32CTest, test_configure_rejected_setting_not_retried)
+{
+  // the scanner rejects reading the beam mask
+  MultipleServiceResponse resp;
+  resp.replies.resize(3);
+  for (int i = 0; i < 3; ++i)
+  {
+    resp.replies[i].service = 0x8E;
+    resp.replies[i].general_status = 0;
+  }
+  resp.replies[0].data.push_back(RANGE_MEASURE_50M);
+  resp.replies[0].data.push_back(0);
+  resp.replies[1].data.push_back(REFLECTIVITY_MEASURE_TOT_4PS);
+  resp.replies[1].data.push_back(0);
+  resp.replies[2].general_status = 0x0E;
+  vector<EIP_BYTE> data(resp.getLength());
+  BufferWriter writer(buffer(data));
+  resp.serialize(writer);
+  vector<EIP_BYTE> reply = makeUnconnectedMultipleServiceReply(EMBEDDED_SERVICE_ERROR, data);
+  ts->rx_buffer = buffer(reply);
+
+  EXPECT_THROW(os32c.configure(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS,
+    OS32C::ANGLE_MAX, OS32C::ANGLE_MIN), std::runtime_error);
+  EXPECT_TRUE(os32c.isMultipleServiceSupported());
+}
+
+TEST_F(OS32CTest, test_configure_trusts_cache)
+{
+  char name[] = "/tmp/os32c_config_cache_XXXXXX";
+  int fd = mkstemp(name);
+  ASSERT_NE(-1, fd);
+  close(fd);
+
+  // the cache holds the configuration wanted, with the checksums seen with it
+  ScannerConfig desired;
+  desired.range_format = RANGE_MEASURE_50M;
+  desired.reflectivity_format = REFLECTIVITY_MEASURE_TOT_4PS;
+  os32c.calcBeamMask(OS32C::ANGLE_MAX, OS32C::ANGLE_MIN, desired.beam_mask);
+  ConfigCache cache(name, "192.168.1.1");
+  cache.setApplied(desired);
+  MeasurementReportHeader header;
+  cache.checkChecksums(header);
+  ASSERT_TRUE(cache.matches(desired));
+
+  // so nothing is read back or written
+  ts->tx_count = 0;
+  EXPECT_EQ(0, os32c.configure(RANGE_MEASURE_50M, REFLECTIVITY_MEASURE_TOT_4PS,
+    OS32C::ANGLE_MAX, OS32C::ANGLE_MIN, &cache));
+  EXPECT_EQ(0, ts->tx_count);
+  EXPECT_TRUE(cache.isUnverified());
+
+  // until the first report shows the scanner came back with its defaults
+  header.range_report_format = RANGE_MEASURE_50M;
+  header.num_beams = 200;
+  EXPECT_TRUE(cache.checkChecksums(header));
+  EXPECT_FALSE(cache.matches(desired));
+  EXPECT_FALSE(cache.isUnverified());
+  unlink(name);
+}
+
 TEST_F(OS32CTest, test_receive_measurement_report)
 {
-  char io_packet[] = {
+  EIP_BYTE io_packet[] = {
     0x02, 0x00, 0x02, 0x80, 0x08, 0x00, 0x04, 0x00,
     0x02, 0x00, 0x15, 0x00, 0x00, 0x00, 0xB1, 0x00,
     0x62, 0x00, 0xA1, 0x00, 0x76, 0x53, 0x04, 0x00,
@@ -494,6 +734,20 @@ TEST_F(OS32CTest, test_receive_measurement_report)
   EXPECT_EQ(0x085E, data.measurement_data[17]);
   EXPECT_EQ(0x085E, data.measurement_data[18]);
   EXPECT_EQ(0x086F, data.measurement_data[19]);
+
+  // receiving into an existing report gives the same result
+  MeasurementReport report;
+  report.measurement_data.assign(677, 0);
+  os32c.receiveMeasurementReportUDP(report);
+  EXPECT_EQ(0x00045376, report.header.scan_count);
+  ASSERT_EQ(20, report.measurement_data.size());
+  for (size_t i = 0; i < report.measurement_data.size(); ++i)
+  {
+    EXPECT_EQ(data.measurement_data[i], report.measurement_data[i]);
+  }
+
+  io_packet[0] = 3;
+  EXPECT_THROW(os32c.receiveMeasurementReportUDP(report), std::logic_error);
 }
 
 
@@ -45,7 +45,7 @@ class RangeAndReflectanceMeasurementTest : public :: testing :: Test
 
 TEST_F(RangeAndReflectanceMeasurementTest, test_deserialize)
 {
-  EIP_BYTE d[56 + 4000];
+  EIP_BYTE d[56 + 4 * 677];
 
   // use a measurement report header to serialize the header data
   MeasurementReportHeader mrh;
@@ -65,16 +65,16 @@ TEST_F(RangeAndReflectanceMeasurementTest, test_deserialize)
   mrh.safety_config_checksum = 0x5AA5;
   mrh.range_report_format = 1;
   mrh.refletivity_report_format = 1;
-  mrh.num_beams = 1000;
+  mrh.num_beams = 677;
 
   BufferWriter writer(buffer(d));
   mrh.serialize(writer);
 
-  for (EIP_UINT i = 10000; i < 10000 + 1000; ++i) {
+  for (EIP_UINT i = 10000; i < 10000 + 677; ++i) {
     writer.write(i);
   }
 
-  for (EIP_UINT i = 20000; i < 20000 + 1000; ++i) {
+  for (EIP_UINT i = 20000; i < 20000 + 677; ++i) {
     writer.write(i);
   }
 
@@ -101,15 +101,15 @@ TEST_F(RangeAndReflectanceMeasurementTest, test_deserialize)
   EXPECT_EQ(0x5AA5, mr.header.safety_config_checksum);
   EXPECT_EQ(1, mr.header.range_report_format);
   EXPECT_EQ(1, mr.header.refletivity_report_format);
-  EXPECT_EQ(1000, mr.header.num_beams);
+  EXPECT_EQ(677, mr.header.num_beams);
 
-  EXPECT_EQ(1000, mr.range_data.size());
+  EXPECT_EQ(677, mr.range_data.size());
   for (int i = 0; i < mr.range_data.size(); ++i)
   {
     EXPECT_EQ(i + 10000, mr.range_data[i]);
   }
 
-  EXPECT_EQ(1000, mr.reflectance_data.size());
+  EXPECT_EQ(677, mr.reflectance_data.size());
   for (int i = 0; i < mr.reflectance_data.size(); ++i)
   {
     EXPECT_EQ(i + 20000, mr.reflectance_data[i]);
@@ -135,19 +135,19 @@ TEST_F(RangeAndReflectanceMeasurementTest, test_serialize)
   mr.header.safety_config_checksum = 0x5AA5;
   mr.header.range_report_format = 1;
   mr.header.refletivity_report_format = 1;
-  mr.header.num_beams = 1000;
+  mr.header.num_beams = 677;
 
-  mr.range_data.resize(1000);
-  for (int i = 0; i <  1000; ++i) {
+  mr.range_data.resize(677);
+  for (int i = 0; i <  677; ++i) {
     mr.range_data[i] = i + 30000;
   }
 
-  mr.reflectance_data.resize(1000);
-  for (int i = 0; i <  1000; ++i) {
+  mr.reflectance_data.resize(677);
+  for (int i = 0; i <  677; ++i) {
     mr.reflectance_data[i] = i + 40000;
   }
 
-  EIP_BYTE d[56 + 4000];
+  EIP_BYTE d[56 + 4 * 677];
   EXPECT_EQ(sizeof(d), mr.getLength());
   BufferWriter writer(buffer(d));
   mr.serialize(writer);
@@ -207,20 +207,51 @@ TEST_F(RangeAndReflectanceMeasurementTest, test_serialize)
   EXPECT_EQ(d[51], 0);
   EXPECT_EQ(d[52], 0);
   EXPECT_EQ(d[53], 0);
-  EXPECT_EQ(d[54], 0xE8);
-  EXPECT_EQ(d[55], 0x03);
+  EXPECT_EQ(d[54], 0xA5);
+  EXPECT_EQ(d[55], 0x02);
 
-  for (int i = 0; i < 1000; ++i)
+  for (int i = 0; i < 677; ++i)
   {
     EIP_UINT exp_value = i + 30000;
     EXPECT_EQ((exp_value) & 0x00FF, d[56 + i*2]);
     EXPECT_EQ((exp_value >> 8) & 0x00FF, d[56 + i*2 + 1]);
   }
 
-  for (int i = 0; i < 1000; ++i)
+  for (int i = 0; i < 677; ++i)
   {
     EIP_UINT exp_value = i + 40000;
-    EXPECT_EQ((exp_value) & 0x00FF, d[56 + 2000 + i*2]);
-    EXPECT_EQ((exp_value >> 8) & 0x00FF, d[56 + 2000 + i*2 + 1]);
+    EXPECT_EQ((exp_value) & 0x00FF, d[56 + 2 * 677 + i*2]);
+    EXPECT_EQ((exp_value >> 8) & 0x00FF, d[56 + 2 * 677 + i*2 + 1]);
   }
 }
+
+TEST_F(RangeAndReflectanceMeasurementTest, test_deserialize_too_many_beams)
+{
+  EIP_BYTE d[56 + 4 * 678];
+  MeasurementReportHeader mrh;
+  mrh.num_beams = 678;
+  BufferWriter writer(buffer(d));
+  mrh.serialize(writer);
+
+  BufferReader reader(buffer(d));
+  RangeAndReflectanceMeasurement mr;
+  EXPECT_THROW(mr.deserialize(reader), std::length_error);
+  EXPECT_EQ(0, mr.range_data.size());
+  EXPECT_EQ(0, mr.reflectance_data.size());
+}
+
+TEST_F(RangeAndReflectanceMeasurementTest, test_deserialize_short_length)
+{
+  // enough for 10 beams of range data, but not the reflectance data as well
+  EIP_BYTE d[56 + 2 * 10];
+  MeasurementReportHeader mrh;
+  mrh.num_beams = 10;
+  BufferWriter writer(buffer(d));
+  mrh.serialize(writer);
+
+  BufferReader reader(buffer(d));
+  RangeAndReflectanceMeasurement mr;
+  EXPECT_THROW(mr.deserialize(reader, sizeof(d)), std::length_error);
+  EXPECT_EQ(0, mr.range_data.size());
+  EXPECT_EQ(0, mr.reflectance_data.size());
+}
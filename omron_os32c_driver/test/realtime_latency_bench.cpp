@@ -0,0 +1,245 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime_latency_bench.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+/**
+ * Measures the worst case latency from a scan packet being sent to it having
+ * been received and converted, while the machine is loaded with CPU-bound
+ * stress threads. Packets are sent over loopback at the scanner's rate, so
+ * the result shows how long the receive thread waits to be scheduled. Run it
+ * once without and once with real-time settings to compare, e.g.:
+ *
+ *   realtime_latency_bench --stress 8 --duration 30
+ *   sudo realtime_latency_bench --stress 8 --duration 30 --priority 80 --cpus 1 --lock
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+#include "omron_os32c_driver/realtime.h"
+
+using namespace omron_os32c_driver;
+
+// packet size of a full 677 beam measurement report, plus CPF framing
+static const size_t PACKET_SIZE = 1434;
+static const int MAX_BEAMS = 677;
+
+static volatile bool running = true;
+
+struct SenderArgs
+{
+  int sock;
+  sockaddr_in dest;
+  uint64_t period_ns;
+};
+
+static void* stressThread(void*)
+{
+  volatile double x = 1.0;
+  while (running)
+  {
+    for (int i = 0; i < 100000; ++i)
+    {
+      x = x * 1.0000001 + 0.0000001;
+    }
+  }
+  return NULL;
+}
+
+static void* senderThread(void* arg)
+{
+  SenderArgs* args = static_cast<SenderArgs*>(arg);
+  unsigned char packet[PACKET_SIZE];
+  memset(packet, 0x12, sizeof(packet));
+  uint64_t next = monotonicNanoseconds();
+  while (running)
+  {
+    next += args->period_ns;
+    timespec ts;
+    ts.tv_sec = next / 1000000000ULL;
+    ts.tv_nsec = next % 1000000000ULL;
+    clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL);
+
+    uint64_t now = monotonicNanoseconds();
+    memcpy(packet, &now, sizeof(now));
+    sendto(args->sock, packet, sizeof(packet), 0,
+      reinterpret_cast<sockaddr*>(&args->dest), sizeof(args->dest));
+  }
+  return NULL;
+}
+
+static void usage()
+{
+  printf("Usage: realtime_latency_bench [--stress N] [--duration S] [--rate HZ]\n"
+         "                              [--priority P] [--cpus LIST] [--lock]\n");
+}
+
+int main(int argc, char *argv[])
+{
+  int stress_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  double duration = 10;
+  double rate = 25;
+  int priority = 0;
+  std::string cpus;
+  bool lock = false;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--stress" && has_value)
+      stress_threads = atoi(argv[++i]);
+    else if (arg == "--duration" && has_value)
+      duration = atof(argv[++i]);
+    else if (arg == "--rate" && has_value)
+      rate = atof(argv[++i]);
+    else if (arg == "--priority" && has_value)
+      priority = atoi(argv[++i]);
+    else if (arg == "--cpus" && has_value)
+      cpus = argv[++i];
+    else if (arg == "--lock")
+      lock = true;
+    else
+    {
+      usage();
+      return 1;
+    }
+  }
+
+  int rx = socket(AF_INET, SOCK_DGRAM, 0);
+  int tx = socket(AF_INET, SOCK_DGRAM, 0);
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  socklen_t addr_len = sizeof(addr);
+  if (rx < 0 || tx < 0 || bind(rx, reinterpret_cast<sockaddr*>(&addr), sizeof(addr))
+    || getsockname(rx, reinterpret_cast<sockaddr*>(&addr), &addr_len))
+  {
+    perror("Could not set up loopback sockets");
+    return 1;
+  }
+
+  // apply the real-time settings to this thread, which does the receiving
+  try
+  {
+    if (lock)
+    {
+      lockMemory();
+    }
+    if (!cpus.empty())
+    {
+      setCpuAffinity(parseCpuList(cpus));
+    }
+    if (priority > 0)
+    {
+      setRealtimePriority(priority);
+    }
+  }
+  catch (std::exception& ex)
+  {
+    fprintf(stderr, "Could not apply real-time settings: %s\n", ex.what());
+    return 1;
+  }
+
+  std::vector<float> ranges;
+  std::vector<uint64_t> samples;
+  samples.reserve(duration * rate + 1);
+  prefault(ranges, MAX_BEAMS);
+  prefaultStack();
+
+  std::vector<pthread_t> stress(stress_threads);
+  for (int i = 0; i < stress_threads; ++i)
+  {
+    pthread_create(&stress[i], NULL, stressThread, NULL);
+  }
+  SenderArgs sender_args;
+  sender_args.sock = tx;
+  sender_args.dest = addr;
+  sender_args.period_ns = 1000000000ULL / rate;
+  pthread_t sender;
+  pthread_create(&sender, NULL, senderThread, &sender_args);
+
+  printf("Measuring for %.0f s at %.1f Hz with %d stress threads, priority %d, cpus '%s', lock %s\n",
+    duration, rate, stress_threads, priority, cpus.c_str(), lock ? "on" : "off");
+
+  LatencyStats stats;
+  unsigned char packet[PACKET_SIZE];
+  uint64_t end = monotonicNanoseconds() + duration * 1e9;
+  while (monotonicNanoseconds() < end)
+  {
+    ssize_t n = recv(rx, packet, sizeof(packet), 0);
+    if (n != static_cast<ssize_t>(sizeof(packet)))
+    {
+      continue;
+    }
+
+    // stand-in for the conversion done by the driver
+    ranges.resize(MAX_BEAMS);
+    for (int i = 0; i < MAX_BEAMS; ++i)
+    {
+      uint16_t range;
+      memcpy(&range, packet + PACKET_SIZE - 2 * MAX_BEAMS + 2 * i, sizeof(range));
+      ranges[i] = range / 1000.0;
+    }
+
+    uint64_t sent;
+    memcpy(&sent, packet, sizeof(sent));
+    uint64_t latency = monotonicNanoseconds() - sent;
+    stats.add(latency);
+    samples.push_back(latency);
+  }
+
+  running = false;
+  pthread_join(sender, NULL);
+  for (int i = 0; i < stress_threads; ++i)
+  {
+    pthread_join(stress[i], NULL);
+  }
+
+  if (samples.empty())
+  {
+    printf("No packets received\n");
+    return 1;
+  }
+  std::sort(samples.begin(), samples.end());
+  printf("%lu scans: mean %lu us, p99 %lu us, p99.9 %lu us, max %lu us\n",
+    static_cast<unsigned long>(stats.getCount()),
+    static_cast<unsigned long>(stats.getMean() / 1000),
+    static_cast<unsigned long>(samples[samples.size() * 99 / 100] / 1000),
+    static_cast<unsigned long>(samples[samples.size() * 999 / 1000] / 1000),
+    static_cast<unsigned long>(stats.getMax() / 1000));
+  return 0;
+}
@@ -0,0 +1,104 @@
+/**
+Software License Agreement (BSD)
+
+\file      realtime_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/realtime.h"
+
+using namespace omron_os32c_driver;
+
+class RealtimeTest : public :: testing :: Test
+{
+
+};
+
+TEST_F(RealtimeTest, test_parse_cpu_list)
+{
+  vector<int> cpus = parseCpuList("3");
+  ASSERT_EQ(1, cpus.size());
+  EXPECT_EQ(3, cpus[0]);
+
+  cpus = parseCpuList("0,2-4, 7");
+  ASSERT_EQ(5, cpus.size());
+  EXPECT_EQ(0, cpus[0]);
+  EXPECT_EQ(2, cpus[1]);
+  EXPECT_EQ(3, cpus[2]);
+  EXPECT_EQ(4, cpus[3]);
+  EXPECT_EQ(7, cpus[4]);
+
+  EXPECT_EQ(0, parseCpuList("").size());
+}
+
+TEST_F(RealtimeTest, test_parse_cpu_list_invalid)
+{
+  EXPECT_THROW(parseCpuList("a"), std::invalid_argument);
+  EXPECT_THROW(parseCpuList("1,,2"), std::invalid_argument);
+  EXPECT_THROW(parseCpuList("4-2"), std::invalid_argument);
+  EXPECT_THROW(parseCpuList("1-"), std::invalid_argument);
+  EXPECT_THROW(parseCpuList("1+2"), std::invalid_argument);
+  EXPECT_THROW(parseCpuList("-1"), std::invalid_argument);
+}
+
+TEST_F(RealtimeTest, test_invalid_settings)
+{
+  EXPECT_THROW(setRealtimePriority(1000), std::invalid_argument);
+  EXPECT_THROW(setCpuAffinity(vector<int>()), std::invalid_argument);
+  EXPECT_THROW(setCpuAffinity(vector<int>(1, -1)), std::invalid_argument);
+}
+
+TEST_F(RealtimeTest, test_prefault)
+{
+  vector<uint16_t> v;
+  prefault(v, 677);
+  EXPECT_EQ(0, v.size());
+  EXPECT_LE(677, v.capacity());
+}
+
+TEST_F(RealtimeTest, test_latency_stats)
+{
+  LatencyStats stats;
+  EXPECT_EQ(0, stats.getCount());
+  EXPECT_EQ(0, stats.getMean());
+  EXPECT_EQ(0, stats.getMax());
+
+  stats.add(100);
+  stats.add(400);
+  stats.add(250);
+  EXPECT_EQ(3, stats.getCount());
+  EXPECT_EQ(250, stats.getMean());
+  EXPECT_EQ(400, stats.getMax());
+
+  stats.reset();
+  EXPECT_EQ(0, stats.getCount());
+  EXPECT_EQ(0, stats.getMax());
+}
+
+TEST_F(RealtimeTest, test_monotonic_clock)
+{
+  uint64_t a = monotonicNanoseconds();
+  uint64_t b = monotonicNanoseconds();
+  EXPECT_LE(a, b);
+}
@@ -0,0 +1,239 @@
+/**
+Software License Agreement (BSD)
+
+\file      reflectivity_calibration_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#include "omron_os32c_driver/reflectivity_calibration.h"
+
+using std::string;
+using namespace omron_os32c_driver;
+
+class ReflectivityCalibrationTest : public :: testing :: Test
+{
+protected:
+  virtual void SetUp()
+  {
+    char name[] = "/tmp/os32c_reflectivity_calibration_XXXXXX";
+    int fd = mkstemp(name);
+    ASSERT_NE(-1, fd);
+    close(fd);
+    path = name;
+  }
+
+  virtual void TearDown()
+  {
+    unlink(path.c_str());
+  }
+
+  /**
+   * Table of range (in m) times TOT (in thousands), which bilinear
+   * interpolation reproduces exactly
+   */
+  static vector<double> makeValues(const vector<double>& ranges, const vector<double>& tots)
+  {
+    vector<double> values;
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+      for (size_t j = 0; j < tots.size(); ++j)
+      {
+        values.push_back(ranges[i] / 1000 * tots[j] / 1000);
+      }
+    }
+    return values;
+  }
+
+  string path;
+};
+
+TEST_F(ReflectivityCalibrationTest, test_uniform_table)
+{
+  ReflectivityCalibration cal;
+  EXPECT_FALSE(cal.isLoaded());
+
+  vector<double> ranges = { 1000, 2000, 3000 };
+  vector<double> tots = { 1000, 2000 };
+  cal.setTable(ranges, tots, makeValues(ranges, tots));
+  EXPECT_TRUE(cal.isLoaded());
+  EXPECT_EQ(3, cal.getRangePoints());
+  EXPECT_EQ(2, cal.getTotPoints());
+
+  EXPECT_FLOAT_EQ(1, cal.calibrate(1000, 1000));
+  EXPECT_FLOAT_EQ(6, cal.calibrate(3000, 2000));
+  EXPECT_FLOAT_EQ(2.25, cal.calibrate(1500, 1500));
+  EXPECT_FLOAT_EQ(3.75, cal.calibrate(2500, 1500));
+}
+
+TEST_F(ReflectivityCalibrationTest, test_non_uniform_table)
+{
+  ReflectivityCalibration cal;
+  vector<double> ranges = { 1000, 2000, 4000 };
+  vector<double> tots = { 500, 1000, 3000 };
+  cal.setTable(ranges, tots, makeValues(ranges, tots));
+  EXPECT_EQ(3, cal.getRangePoints());
+  EXPECT_EQ(3, cal.getTotPoints());
+
+  EXPECT_FLOAT_EQ(4.5, cal.calibrate(3000, 1500));
+  EXPECT_FLOAT_EQ(0.75, cal.calibrate(1500, 500));
+  EXPECT_FLOAT_EQ(12, cal.calibrate(4000, 3000));
+}
+
+TEST_F(ReflectivityCalibrationTest, test_outside_table)
+{
+  ReflectivityCalibration cal;
+  vector<double> ranges = { 1000, 2000, 3000 };
+  vector<double> tots = { 1000, 2000 };
+  cal.setTable(ranges, tots, makeValues(ranges, tots));
+
+  // clamped to the edges
+  EXPECT_FLOAT_EQ(1, cal.calibrate(500, 0));
+  EXPECT_FLOAT_EQ(6, cal.calibrate(0xFFFE, 60000));
+  EXPECT_FLOAT_EQ(3, cal.calibrate(1500, 5000));
+
+  // no reflectivity without a valid return
+  EXPECT_EQ(0, cal.calibrate(0x0001, 1500));
+  EXPECT_EQ(0, cal.calibrate(0xFFFF, 1500));
+}
+
+TEST_F(ReflectivityCalibrationTest, test_scan)
+{
+  ReflectivityCalibration cal;
+  vector<double> ranges = { 1000, 2000, 3000 };
+  vector<double> tots = { 1000, 2000 };
+  cal.setTable(ranges, tots, makeValues(ranges, tots));
+
+  EIP_UINT scan_ranges[] = { 1000, 0xFFFF, 2500, 3000 };
+  EIP_UINT scan_tots[] = { 2000, 1000, 1500, 1000 };
+  float reflectivity[4];
+  cal.calibrate(scan_ranges, scan_tots, 4, reflectivity);
+  EXPECT_FLOAT_EQ(2, reflectivity[0]);
+  EXPECT_EQ(0, reflectivity[1]);
+  EXPECT_FLOAT_EQ(3.75, reflectivity[2]);
+  EXPECT_FLOAT_EQ(3, reflectivity[3]);
+}
+
+TEST_F(ReflectivityCalibrationTest, test_non_linear_table)
+{
+  // spacings that share no common step, and intervals far smaller than the
+  // cells the limit on their number allows
+  vector<double> ranges = { 0, 2, 3, 350, 1234, 7001, 50000 };
+  vector<double> tots = { 3, 4, 1000, 1001, 2503, 65535 };
+  vector<double> values;
+  for (size_t i = 0; i < ranges.size(); ++i)
+  {
+    for (size_t j = 0; j < tots.size(); ++j)
+    {
+      values.push_back(sqrt(ranges[i] + 1) * log(tots[j]) + (i % 2) * 40 - (j % 3) * 25);
+    }
+  }
+  ReflectivityCalibration cal;
+  cal.setTable(ranges, tots, values);
+  EXPECT_EQ(ranges.size(), cal.getRangePoints());
+  EXPECT_EQ(tots.size(), cal.getTotPoints());
+
+  // every value of the table is reproduced at its range and TOT
+  for (size_t i = 0; i < ranges.size(); ++i)
+  {
+    for (size_t j = 0; j < tots.size(); ++j)
+    {
+      EXPECT_FLOAT_EQ(values[i * tots.size() + j], cal.calibrate(ranges[i], tots[j]))
+        << "range " << ranges[i] << ", TOT " << tots[j];
+    }
+  }
+
+  // and midway between four, their mean
+  const double* near = &values[3 * tots.size() + 4];
+  const double* far = near + tots.size();
+  EXPECT_NEAR((near[0] + near[1] + far[0] + far[1]) / 4, cal.calibrate(792, 34019), 1e-3);
+}
+
+TEST_F(ReflectivityCalibrationTest, test_invalid_table)
+{
+  ReflectivityCalibration cal;
+  vector<double> ranges = { 1000, 2000 };
+  vector<double> tots = { 1000, 2000 };
+  vector<double> values = makeValues(ranges, tots);
+
+  EXPECT_THROW(cal.setTable(vector<double>(1, 1000), tots, values), std::invalid_argument);
+  EXPECT_THROW(cal.setTable(vector<double>(2, 1000), tots, values), std::invalid_argument);
+  EXPECT_THROW(cal.setTable(ranges, tots, vector<double>(3, 1)), std::invalid_argument);
+  EXPECT_FALSE(cal.isLoaded());
+}
+
+TEST_F(ReflectivityCalibrationTest, test_load)
+{
+  {
+    std::ofstream file(path.c_str());
+    file << "# reflectivity against white and black targets" << std::endl;
+    file << "ranges 1000 2000 3000  # mm" << std::endl;
+    file << "tot 1000 2000" << std::endl;
+    file << std::endl;
+    file << "row 1 2" << std::endl;
+    file << "row 2 4" << std::endl;
+    file << "row 3 6" << std::endl;
+  }
+
+  ReflectivityCalibration cal;
+  cal.load(path);
+  ASSERT_TRUE(cal.isLoaded());
+  EXPECT_FLOAT_EQ(2.25, cal.calibrate(1500, 1500));
+}
+
+TEST_F(ReflectivityCalibrationTest, test_load_malformed)
+{
+  ReflectivityCalibration cal;
+  EXPECT_THROW(cal.load(path + "_missing"), std::runtime_error);
+
+  {
+    std::ofstream file(path.c_str());
+    file << "ranges 1000 2000" << std::endl;
+    file << "tot 1000 2000" << std::endl;
+    file << "row 1 two" << std::endl;
+  }
+  EXPECT_THROW(cal.load(path), std::runtime_error);
+
+  {
+    std::ofstream file(path.c_str());
+    file << "ranges 1000 2000" << std::endl;
+    file << "tot 1000 2000" << std::endl;
+    file << "row 1 2 3" << std::endl;
+  }
+  EXPECT_THROW(cal.load(path), std::runtime_error);
+
+  {
+    std::ofstream file(path.c_str());
+    file << "ranges 1000 2000" << std::endl;
+    file << "tot 1000 2000" << std::endl;
+    file << "row 1 2" << std::endl;
+  }
+  // one row short
+  EXPECT_THROW(cal.load(path), std::invalid_argument);
+  EXPECT_FALSE(cal.isLoaded());
+}
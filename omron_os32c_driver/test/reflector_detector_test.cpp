@@ -0,0 +1,185 @@
+/**
+Software License Agreement (BSD)
+
+\file      reflector_detector_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "omron_os32c_driver/reflector_detector.h"
+
+using namespace omron_os32c_driver;
+
+class ReflectorDetectorTest : public :: testing :: Test
+{
+protected:
+  ReflectorDetectorTest() : ranges(BEAM_COUNT, 2000), reflectance(BEAM_COUNT, 1000)
+  {
+  }
+
+  vector<EIP_UINT> ranges;
+  vector<EIP_UINT> reflectance;
+  vector<Reflector> reflectors;
+};
+
+TEST_F(ReflectorDetectorTest, test_detect_reflector)
+{
+  // beam 338 is straight ahead
+  reflectance[337] = 4000;
+  reflectance[338] = 5000;
+  reflectance[339] = 4000;
+
+  ReflectorDetector detector;
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(1, reflectors.size());
+  EXPECT_EQ(337, reflectors[0].first_beam);
+  EXPECT_EQ(339, reflectors[0].last_beam);
+  EXPECT_NEAR(0, reflectors[0].bearing, 1e-9);
+  EXPECT_NEAR(2000, reflectors[0].range, 0.1);
+  EXPECT_NEAR(2000, reflectors[0].x, 0.1);
+  EXPECT_NEAR(0, reflectors[0].y, 1e-6);
+  // three beams wide
+  EXPECT_NEAR(3 * 2000 * BEAM_ANGLE_INC, reflectors[0].width, 0.1);
+  EXPECT_DOUBLE_EQ(10000, reflectors[0].intensity);
+
+  // the storage is reused and cleared each scan
+  reflectance[337] = reflectance[338] = reflectance[339] = 1000;
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  EXPECT_TRUE(reflectors.empty());
+}
+
+TEST_F(ReflectorDetectorTest, test_weighted_centroid)
+{
+  reflectance[338] = 4000;
+  reflectance[339] = 12000;
+
+  ReflectorDetector detector;
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(1, reflectors.size());
+  // three quarters of the way to the brighter beam, CW of straight ahead
+  EXPECT_NEAR(-0.75 * BEAM_ANGLE_INC, reflectors[0].bearing, 1e-6);
+}
+
+TEST_F(ReflectorDetectorTest, test_range_compensation)
+{
+  // a dim return far away is a reflector once compensated
+  ranges[100] = 8000;
+  reflectance[100] = 1000;
+  // while a bright return close by is not
+  ranges[500] = 500;
+  reflectance[500] = 4000;
+
+  ReflectorDetector detector;
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(1, reflectors.size());
+  EXPECT_EQ(100, reflectors[0].first_beam);
+  EXPECT_DOUBLE_EQ(8000, reflectors[0].intensity);
+
+  ReflectorDetectorParams params;
+  params.range_exponent = 0;
+  ReflectorDetector uncompensated(params);
+  uncompensated.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(1, reflectors.size());
+  EXPECT_EQ(500, reflectors[0].first_beam);
+}
+
+TEST_F(ReflectorDetectorTest, test_clusters_split)
+{
+  // a jump in range splits a run of bright beams
+  reflectance[200] = reflectance[201] = reflectance[202] = 5000;
+  ranges[202] = 2500;
+  // as does a noisy beam, or one with no return
+  reflectance[300] = reflectance[301] = reflectance[302] = 5000;
+  ranges[301] = 0x0001;
+  reflectance[400] = reflectance[401] = 5000;
+  ranges[401] = 0xFFFF;
+
+  ReflectorDetector detector;
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(5, reflectors.size());
+  EXPECT_EQ(200, reflectors[0].first_beam);
+  EXPECT_EQ(201, reflectors[0].last_beam);
+  EXPECT_EQ(202, reflectors[1].first_beam);
+  EXPECT_EQ(202, reflectors[1].last_beam);
+  EXPECT_EQ(300, reflectors[2].last_beam);
+  EXPECT_EQ(302, reflectors[3].first_beam);
+  EXPECT_EQ(400, reflectors[4].last_beam);
+
+  // a run to the end of the scan is closed too
+  reflectance[675] = reflectance[676] = 5000;
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(6, reflectors.size());
+  EXPECT_EQ(675, reflectors[5].first_beam);
+  EXPECT_EQ(676, reflectors[5].last_beam);
+}
+
+TEST_F(ReflectorDetectorTest, test_size_limits)
+{
+  reflectance[100] = 5000;
+  reflectance[200] = reflectance[201] = 5000;
+  for (int i = 300; i < 320; ++i)
+  {
+    reflectance[i] = 5000;
+  }
+
+  ReflectorDetectorParams params;
+  params.min_beams = 2;
+  params.max_width = 100;
+  ReflectorDetector detector(params);
+  detector.detect(&ranges[0], &reflectance[0], BEAM_COUNT, 0, &reflectors);
+  ASSERT_EQ(1, reflectors.size());
+  EXPECT_EQ(200, reflectors[0].first_beam);
+}
+
+TEST_F(ReflectorDetectorTest, test_partial_scan)
+{
+  // ten beams starting five CCW of straight ahead
+  reflectance[5] = 5000;
+
+  ReflectorDetector detector;
+  detector.detect(&ranges[0], &reflectance[0], 10, 333, &reflectors);
+  ASSERT_EQ(1, reflectors.size());
+  EXPECT_EQ(5, reflectors[0].first_beam);
+  EXPECT_NEAR(0, reflectors[0].bearing, 1e-9);
+
+  EXPECT_THROW(detector.detect(&ranges[0], &reflectance[0], 10, 668, &reflectors),
+    std::invalid_argument);
+  EXPECT_THROW(detector.detect(&ranges[0], &reflectance[0], 10, -1, &reflectors),
+    std::invalid_argument);
+}
+
+TEST_F(ReflectorDetectorTest, test_invalid_params)
+{
+  ReflectorDetectorParams params;
+  params.threshold = 0;
+  EXPECT_THROW(ReflectorDetector d(params), std::invalid_argument);
+  params = ReflectorDetectorParams();
+  params.reference_range = 0;
+  EXPECT_THROW(ReflectorDetector d(params), std::invalid_argument);
+  params = ReflectorDetectorParams();
+  params.max_range_step = -1;
+  EXPECT_THROW(ReflectorDetector d(params), std::invalid_argument);
+  params = ReflectorDetectorParams();
+  params.min_beams = 0;
+  EXPECT_THROW(ReflectorDetector d(params), std::invalid_argument);
+}
@@ -0,0 +1,229 @@
+/**
+Software License Agreement (BSD)
+
+\file      rr_scan_pipeline_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <boost/make_shared.hpp>
+#include <stdexcept>
+
+#include "omron_os32c_driver/rr_scan_pipeline.h"
+#include "odva_ethernetip/socket/test_socket.h"
+#include "odva_ethernetip/serialization/buffer_writer.h"
+
+using boost::make_shared;
+using namespace boost::asio;
+using namespace eip::socket;
+using namespace eip::serialization;
+using namespace omron_os32c_driver;
+
+/**
+ * Write the reply to a pipelined request for a scan with the given scan count,
+ * or an error reply if the status is not zero
+ * @return length of the reply
+ */
+static size_t writeReply(EIP_BYTE* buf, size_t size, uint64_t context, EIP_USINT status,
+  EIP_UDINT scan_count)
+{
+  RangeAndReflectanceMeasurement rr;
+  rr.header.scan_count = scan_count;
+  rr.header.num_beams = 3;
+  rr.range_data.resize(3);
+  rr.reflectance_data.resize(3);
+  for (int i = 0; i < 3; ++i)
+  {
+    rr.range_data[i] = 1000 + i;
+    rr.reflectance_data[i] = 2000 + i;
+  }
+  EIP_UINT data_length = 4 + (status ? 0 : rr.getLength());
+
+  BufferWriter writer(buffer(buf, size));
+  writer.write((EIP_UINT)0x6F);
+  writer.write((EIP_UINT)(16 + data_length));
+  writer.write((EIP_UDINT)0);
+  writer.write((EIP_UDINT)0);
+  writer.write((EIP_UDINT)context);
+  writer.write((EIP_UDINT)(context >> 32));
+  writer.write((EIP_UDINT)0);
+  writer.write((EIP_UDINT)0);
+  writer.write((EIP_UINT)0);
+  writer.write((EIP_UINT)2);
+  writer.write((EIP_UINT)0);
+  writer.write((EIP_UINT)0);
+  writer.write((EIP_UINT)0xB2);
+  writer.write(data_length);
+  writer.write((EIP_USINT)0x8E);
+  writer.write((EIP_USINT)0);
+  writer.write(status);
+  writer.write((EIP_USINT)0);
+  if (!status)
+  {
+    rr.serialize(writer);
+  }
+  return writer.getByteCount();
+}
+
+class RRScanPipelineTest : public :: testing :: Test
+{
+public:
+  RRScanPipelineTest() : ts(make_shared<TestSocket>()), os32c(ts, make_shared<TestSocket>()),
+    rx_size(0)
+  {
+  }
+
+protected:
+  void addReply(uint64_t context, EIP_USINT status, EIP_UDINT scan_count)
+  {
+    rx_size += writeReply(rx + rx_size, sizeof(rx) - rx_size, context, status, scan_count);
+    ts->rx_buffer = buffer(rx, rx_size);
+  }
+
+  shared_ptr<TestSocket> ts;
+  OS32C os32c;
+  EIP_BYTE rx[1024];
+  size_t rx_size;
+};
+
+TEST_F(RRScanPipelineTest, test_invalid_args)
+{
+  EXPECT_THROW(RRScanPipeline(os32c, 0, 10), std::invalid_argument);
+  EXPECT_THROW(RRScanPipeline(os32c, 4, -1), std::invalid_argument);
+  RRScanPipeline pipeline(os32c, 4, 0);
+  EXPECT_THROW(pipeline.setReceiveTimeout(0), std::invalid_argument);
+}
+
+TEST_F(RRScanPipelineTest, test_send_fills_window)
+{
+  RRScanPipeline pipeline(os32c, 3, 0);
+  EXPECT_EQ(3, pipeline.sendRequests(0));
+  EXPECT_EQ(0, pipeline.sendRequests(0));
+  EXPECT_EQ(3, pipeline.getOutstanding());
+
+  // SendRRData of a Get Attribute Single of the scan, with the sender context
+  ASSERT_EQ(48, ts->tx_count);
+  EXPECT_EQ(0x6F, (EIP_BYTE)ts->tx_buffer[0]);
+  EXPECT_EQ(3, (EIP_BYTE)ts->tx_buffer[12]);
+  EXPECT_EQ(0x0E, (EIP_BYTE)ts->tx_buffer[40]);
+  EXPECT_EQ(0x75, (EIP_BYTE)ts->tx_buffer[43]);
+}
+
+TEST_F(RRScanPipelineTest, test_send_rate)
+{
+  // 10 Hz
+  RRScanPipeline pipeline(os32c, 4, 10);
+  EXPECT_EQ(1, pipeline.sendRequests(1000000000));
+  EXPECT_EQ(1100000000, pipeline.getNextSendTime());
+  EXPECT_EQ(0, pipeline.sendRequests(1050000000));
+  EXPECT_EQ(1, pipeline.sendRequests(1100000000));
+
+  // a stall does not lead to a burst of requests
+  EXPECT_EQ(1, pipeline.sendRequests(2000000000));
+  EXPECT_EQ(2100000000, pipeline.getNextSendTime());
+}
+
+TEST_F(RRScanPipelineTest, test_receive_in_order)
+{
+  RRScanPipeline pipeline(os32c, 2, 0);
+  pipeline.sendRequests(0);
+
+  // both replies arrive in one read, the second request answered first
+  addReply(2, 0, 200);
+  addReply(1, 0, 100);
+
+  RangeAndReflectanceMeasurement rr;
+  pipeline.receiveScan(rr);
+  EXPECT_EQ(100, rr.header.scan_count);
+  ASSERT_EQ(3, rr.range_data.size());
+  EXPECT_EQ(1002, rr.range_data[2]);
+  EXPECT_EQ(2001, rr.reflectance_data[1]);
+  EXPECT_EQ(1, pipeline.getOutstanding());
+
+  pipeline.receiveScan(rr);
+  EXPECT_EQ(200, rr.header.scan_count);
+  EXPECT_EQ(0, pipeline.getOutstanding());
+  EXPECT_THROW(pipeline.receiveScan(rr), std::logic_error);
+}
+
+TEST_F(RRScanPipelineTest, test_stale_reply_dropped)
+{
+  RRScanPipeline pipeline(os32c, 1, 0);
+  pipeline.sendRequests(0);
+  addReply(7, 0, 700);
+  addReply(1, 0, 100);
+
+  RangeAndReflectanceMeasurement rr;
+  pipeline.receiveScan(rr);
+  EXPECT_EQ(100, rr.header.scan_count);
+  EXPECT_EQ(1, pipeline.getStaleReplies());
+}
+
+TEST_F(RRScanPipelineTest, test_rejected_request)
+{
+  RRScanPipeline pipeline(os32c, 2, 0);
+  pipeline.sendRequests(0);
+  addReply(1, 0x08, 0);
+  addReply(2, 0, 200);
+
+  RangeAndReflectanceMeasurement rr;
+  EXPECT_FALSE(pipeline.receiveScan(rr));
+  EXPECT_EQ(1, pipeline.getOutstanding());
+  EXPECT_TRUE(pipeline.receiveScan(rr));
+  EXPECT_EQ(200, rr.header.scan_count);
+}
+
+TEST_F(RRScanPipelineTest, test_malformed_reply)
+{
+  RRScanPipeline pipeline(os32c, 3, 0);
+  pipeline.sendRequests(0);
+  addReply(1, 0, 100);
+  addReply(2, 0, 200);
+  // item count of the first reply
+  rx[30] = 3;
+
+  // the whole window is given up, rather than waited for forever
+  RangeAndReflectanceMeasurement rr;
+  EXPECT_THROW(pipeline.receiveScan(rr), std::logic_error);
+  EXPECT_EQ(0, pipeline.getOutstanding());
+
+  // and refilled, with the reply to a dropped request stale
+  EXPECT_EQ(3, pipeline.sendRequests(0));
+  rx_size = 0;
+  addReply(4, 0, 400);
+  pipeline.receiveScan(rr);
+  EXPECT_EQ(400, rr.header.scan_count);
+  EXPECT_EQ(1, pipeline.getStaleReplies());
+  EXPECT_EQ(2, pipeline.getOutstanding());
+}
+
+TEST_F(RRScanPipelineTest, test_receive_timeout)
+{
+  RRScanPipeline pipeline(os32c, 2, 0);
+  pipeline.setReceiveTimeout(1e-9);
+  pipeline.sendRequests(0);
+  addReply(7, 0, 700);
+
+  // only stale replies until the deadline passes
+  RangeAndReflectanceMeasurement rr;
+  EXPECT_THROW(pipeline.receiveScan(rr), std::runtime_error);
+  EXPECT_EQ(0, pipeline.getOutstanding());
+}
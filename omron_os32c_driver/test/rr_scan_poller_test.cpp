@@ -0,0 +1,85 @@
+/**
+Software License Agreement (BSD)
+
+\file      rr_scan_poller_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <chrono>
+
+#include "omron_os32c_driver/rr_scan_poller.h"
+
+using namespace omron_os32c_driver;
+
+class RRScanPollerTest : public :: testing :: Test
+{
+};
+
+TEST_F(RRScanPollerTest, test_invalid_args)
+{
+  boost::asio::io_service io_service;
+  RRScanPoller poller(io_service, "localhost",
+    [](const RangeAndReflectanceMeasurement&, uint64_t) {});
+  EXPECT_THROW(poller.setPolling(10, 0), std::invalid_argument);
+  EXPECT_THROW(poller.setPolling(-1, 4), std::invalid_argument);
+  EXPECT_NO_THROW(poller.setPolling(0, 1));
+  EXPECT_THROW(poller.setRequestTimeout(0), std::invalid_argument);
+  EXPECT_THROW(poller.setBackoff(0, 1, 0), std::invalid_argument);
+}
+
+TEST_F(RRScanPollerTest, test_unreachable_host)
+{
+  boost::asio::io_service io_service;
+  int scans = 0;
+  // TEST-NET-1 is never routed
+  RRScanPoller poller(io_service, "192.0.2.1",
+    [&](const RangeAndReflectanceMeasurement&, uint64_t) { ++scans; });
+  poller.setRequestTimeout(0.2);
+  EXPECT_EQ(0.2, poller.getRequestTimeout());
+
+  // a reconnection attempt gives up within the request timeout
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  EXPECT_EQ(RRScanPoller::DISCONNECTED, poller.spinOnce(0.01));
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_LT(elapsed, 1.0);
+  EXPECT_FALSE(poller.isConnected());
+  EXPECT_FALSE(poller.getLastError().empty());
+  EXPECT_EQ(0, poller.getReconnects());
+
+  // the next attempt waits out the backoff, but no longer than the timeout
+  start = std::chrono::steady_clock::now();
+  EXPECT_EQ(RRScanPoller::DISCONNECTED, poller.spinOnce(0.01));
+  elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  EXPECT_LT(elapsed, 0.05);
+  EXPECT_EQ(0, scans);
+}
+
+TEST_F(RRScanPollerTest, test_unbound_io_socket)
+{
+  boost::asio::io_service io_service;
+  UDPIOSocket unbound(io_service);
+  char buf[16];
+  EXPECT_THROW(unbound.receive(boost::asio::buffer(buf)), std::runtime_error);
+  // polling holds no port, so it can run alongside a driver streaming UDP IO
+  EXPECT_NO_THROW(UDPIOSocket(io_service, 2222));
+  EXPECT_NO_THROW(unbound.close());
+}
@@ -0,0 +1,100 @@
+/**
+Software License Agreement (BSD)
+
+\file      safety_state_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+
+#include "omron_os32c_driver/safety_state.h"
+
+using namespace omron_os32c_driver;
+
+class SafetyStateTest : public :: testing :: Test
+{
+protected:
+  virtual void SetUp()
+  {
+    header.scan_count = 1;
+    header.machine_state = 3;
+    header.machine_stop_reasons = 0;
+    header.active_zone_set = 1;
+    header.zone_inputs = 0x01;
+    header.detection_zone_status = 0;
+    header.output_status = 0x07;
+    header.input_status = 0x03;
+  }
+
+  MeasurementReportHeader header;
+  SafetyStateMonitor monitor;
+};
+
+TEST_F(SafetyStateTest, test_first_scan_is_change)
+{
+  EXPECT_TRUE(monitor.update(header));
+  EXPECT_EQ(3, monitor.getState().machine_state);
+  EXPECT_EQ(0x07, monitor.getState().output_status);
+  EXPECT_EQ(0, monitor.getChanges());
+}
+
+TEST_F(SafetyStateTest, test_unchanged)
+{
+  monitor.update(header);
+  // scans differ in far more than their safety state
+  header.scan_count = 2;
+  header.scan_timestamp = 1234;
+  header.num_beams = 677;
+  EXPECT_FALSE(monitor.update(header));
+  EXPECT_EQ(0, monitor.getChanges());
+}
+
+TEST_F(SafetyStateTest, test_each_field_changes)
+{
+  monitor.update(header);
+
+  header.machine_state = 4;
+  EXPECT_TRUE(monitor.update(header));
+  header.machine_stop_reasons = 0x0010;
+  EXPECT_TRUE(monitor.update(header));
+  header.active_zone_set = 2;
+  EXPECT_TRUE(monitor.update(header));
+  header.zone_inputs = 0x02;
+  EXPECT_TRUE(monitor.update(header));
+  header.detection_zone_status = 0x01;
+  EXPECT_TRUE(monitor.update(header));
+  header.output_status = 0x04;
+  EXPECT_TRUE(monitor.update(header));
+  header.input_status = 0x01;
+  EXPECT_TRUE(monitor.update(header));
+  EXPECT_FALSE(monitor.update(header));
+
+  EXPECT_EQ(7, monitor.getChanges());
+  EXPECT_EQ(ScannerSafetyState(header), monitor.getState());
+}
+
+TEST_F(SafetyStateTest, test_reset)
+{
+  monitor.update(header);
+  monitor.reset();
+  EXPECT_TRUE(monitor.update(header));
+  EXPECT_EQ(0, monitor.getChanges());
+}
@@ -0,0 +1,206 @@
+/**
+Software License Agreement (BSD)
+
+\file      scan_stream_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <boost/bind.hpp>
+#include <boost/make_shared.hpp>
+#include <vector>
+
+#include "omron_os32c_driver/realtime.h"
+#include "omron_os32c_driver/scan_stream.h"
+#include "odva_ethernetip/socket/test_socket.h"
+
+using boost::make_shared;
+using namespace boost::asio;
+using namespace eip::socket;
+using namespace omron_os32c_driver;
+
+// IO packet with a measurement report of 20 beams and scan count 0x00045376
+static EIP_BYTE io_packet[] = {
+    0x02, 0x00, 0x02, 0x80, 0x08, 0x00, 0x04, 0x00,
+    0x02, 0x00, 0x15, 0x00, 0x00, 0x00, 0xB1, 0x00,
+    0x62, 0x00, 0xA1, 0x00, 0x76, 0x53, 0x04, 0x00,
+    0x64, 0x96, 0x00, 0x00, 0x18, 0xBE, 0x97, 0x8A,
+    0x19, 0xA7, 0x00, 0x00, 0x03, 0x00, 0x07, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00,
+    0x00, 0x00, 0x08, 0x07, 0x88, 0x33, 0xAE, 0x31,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x02, 0x00,
+    0x00, 0x00, 0x14, 0x00, 0x52, 0x08, 0x42, 0x08,
+    0x52, 0x08, 0x40, 0x08, 0x52, 0x08, 0x40, 0x08,
+    0x53, 0x08, 0x58, 0x08, 0x52, 0x08, 0x40, 0x08,
+    0x58, 0x08, 0x58, 0x08, 0x58, 0x08, 0x5E, 0x08,
+    0x67, 0x08, 0x5D, 0x08, 0x67, 0x08, 0x5E, 0x08,
+    0x5E, 0x08, 0x6F, 0x08,
+  };
+
+class ScanStreamTest : public :: testing :: Test
+{
+public:
+  ScanStreamTest() : ts(make_shared<TestSocket>()), ts_io(make_shared<TestSocket>()),
+    os32c(ts, ts_io), scans(0)
+  {
+    ts_io->rx_buffer = buffer(io_packet);
+  }
+
+  void onScan(const ScanView& scan)
+  {
+    ++scans;
+    scan_count = scan.header->scan_count;
+    ranges.assign(scan.ranges, scan.ranges + scan.num_beams);
+    start_angle = scan.start_angle;
+    angle_increment = scan.angle_increment;
+  }
+
+protected:
+  shared_ptr<TestSocket> ts;
+  shared_ptr<TestSocket> ts_io;
+  OS32C os32c;
+  int scans;
+  EIP_UDINT scan_count;
+  std::vector<EIP_UINT> ranges;
+  double start_angle;
+  double angle_increment;
+};
+
+TEST_F(ScanStreamTest, test_spin_once)
+{
+  ScanStream stream(os32c, boost::bind(&ScanStreamTest::onScan, this, _1));
+  stream.setKeepaliveInterval(1000);
+  stream.spinOnce();
+
+  EXPECT_EQ(1, scans);
+  EXPECT_EQ(0x00045376, scan_count);
+  ASSERT_EQ(20, ranges.size());
+  EXPECT_EQ(0x0852, ranges[0]);
+  EXPECT_EQ(0x0842, ranges[1]);
+  EXPECT_EQ(0x086F, ranges[19]);
+  EXPECT_DOUBLE_EQ(OS32C::ANGLE_MAX, start_angle);
+  EXPECT_DOUBLE_EQ(-OS32C::ANGLE_INC, angle_increment);
+  EXPECT_EQ(0, stream.getLostScans());
+}
+
+TEST_F(ScanStreamTest, test_scan_view_angles)
+{
+  ScanView view;
+  view.start_angle = OS32C::ANGLE_MAX;
+  view.angle_increment = -OS32C::ANGLE_INC;
+  EXPECT_DOUBLE_EQ(OS32C::calcBeamCentre(0), view.angle(0));
+  EXPECT_DOUBLE_EQ(OS32C::calcBeamCentre(338), view.angle(338));
+  EXPECT_DOUBLE_EQ(OS32C::calcBeamCentre(676), view.angle(676));
+}
+
+TEST_F(ScanStreamTest, test_lost_scans)
+{
+  ScanStream stream(os32c, boost::bind(&ScanStreamTest::onScan, this, _1));
+  stream.setKeepaliveInterval(1000);
+  stream.spinOnce();
+
+  // skip ahead three scans
+  EIP_BYTE packet[sizeof(io_packet)];
+  memcpy(packet, io_packet, sizeof(packet));
+  packet[20] += 4;
+  ts_io->rx_buffer = buffer(packet);
+  stream.spinOnce();
+
+  EXPECT_EQ(2, scans);
+  EXPECT_EQ(0x0004537A, scan_count);
+  EXPECT_EQ(3, stream.getLostScans());
+}
+
+TEST_F(ScanStreamTest, test_stop_from_callback)
+{
+  ScanStream* stream_ptr = NULL;
+  ScanStream stream(os32c, [&](const ScanView& scan)
+  {
+    if (++scans == 3)
+    {
+      stream_ptr->stop();
+    }
+  });
+  stream_ptr = &stream;
+  stream.setKeepaliveInterval(1000);
+  stream.run();
+  EXPECT_EQ(3, scans);
+}
+
+TEST_F(ScanStreamTest, test_invalid_keepalive_interval)
+{
+  ScanStream stream(os32c, boost::bind(&ScanStreamTest::onScan, this, _1));
+  EXPECT_THROW(stream.setKeepaliveInterval(0), std::invalid_argument);
+  EXPECT_THROW(stream.setKeepaliveInterval(-1), std::invalid_argument);
+}
+
+TEST_F(ScanStreamTest, test_keepalive_deadline)
+{
+  ScanStream stream(os32c, boost::bind(&ScanStreamTest::onScan, this, _1));
+  stream.setKeepaliveInterval(1000);
+  uint64_t due = stream.getNextKeepaliveTime();
+  EXPECT_LE(monotonicNanoseconds() + 999000000000ULL, due);
+
+  // nothing is sent before the deadline, however many scans arrive
+  stream.spinOnce();
+  stream.spinOnce();
+  EXPECT_EQ(2, scans);
+  EXPECT_FALSE(stream.sendKeepaliveIfDue(due - 1));
+  EXPECT_EQ(due, stream.getNextKeepaliveTime());
+
+  // at the deadline it is sent, which fails here as IO was never started
+  EXPECT_THROW(stream.sendKeepaliveIfDue(due), std::logic_error);
+}
+
+TEST_F(ScanStreamTest, test_set_scanner)
+{
+  ScanStream stream(boost::bind(&ScanStreamTest::onScan, this, _1));
+  EXPECT_THROW(stream.spinOnce(), std::logic_error);
+  EXPECT_EQ(0, scans);
+
+  stream.setScanner(os32c);
+  stream.setKeepaliveInterval(1000);
+  stream.spinOnce();
+  EXPECT_EQ(1, scans);
+  EXPECT_EQ(0x00045376, scan_count);
+}
+
+TEST_F(ScanStreamTest, test_malformed_packet)
+{
+  EIP_BYTE bad_packet[sizeof(io_packet)];
+  memcpy(bad_packet, io_packet, sizeof(io_packet));
+  bad_packet[0] = 3;
+  ts_io->rx_buffer = buffer(bad_packet);
+
+  ScanStream stream(os32c, boost::bind(&ScanStreamTest::onScan, this, _1));
+  EXPECT_FALSE(stream.spinOnce());
+  EXPECT_EQ(0, scans);
+  EXPECT_EQ(1, stream.getMalformedPackets());
+  EXPECT_EQ(DECODE_WRONG_ITEM_COUNT, stream.getLastDecodeStatus());
+
+  ts_io->rx_buffer = buffer(io_packet);
+  EXPECT_TRUE(stream.spinOnce());
+  EXPECT_EQ(1, scans);
+  EXPECT_EQ(1, stream.getMalformedPackets());
+}
@@ -0,0 +1,85 @@
+/**
+Software License Agreement (BSD)
+
+\file      sector_minima_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+#include "omron_os32c_driver/sector_minima.h"
+
+using namespace omron_os32c_driver;
+
+class SectorMinimaTest : public :: testing :: Test
+{
+
+};
+
+TEST_F(SectorMinimaTest, test_split_sectors)
+{
+  vector<BeamSector> sectors = splitSectors(677, 8);
+  ASSERT_EQ(8, sectors.size());
+  EXPECT_EQ(0, sectors[0].first_beam);
+  EXPECT_EQ(83, sectors[0].last_beam);
+  for (size_t i = 1; i < sectors.size(); ++i)
+  {
+    EXPECT_EQ(sectors[i - 1].last_beam + 1, sectors[i].first_beam);
+    int size = sectors[i].last_beam - sectors[i].first_beam + 1;
+    EXPECT_GE(size, 84);
+    EXPECT_LE(size, 85);
+  }
+  EXPECT_EQ(676, sectors[7].last_beam);
+
+  sectors = splitSectors(3, 3);
+  EXPECT_EQ(2, sectors[2].first_beam);
+  EXPECT_EQ(2, sectors[2].last_beam);
+
+  EXPECT_THROW(splitSectors(677, 0), std::invalid_argument);
+  EXPECT_THROW(splitSectors(3, 4), std::invalid_argument);
+}
+
+TEST_F(SectorMinimaTest, test_find_minima)
+{
+  EIP_UINT ranges[] = {
+    1200, 0x0001, 900, 0xFFFF,
+    0x0001, 0xFFFF, 0x0001, 0xFFFF,
+    3000, 2000, 2000, 0x0002,
+  };
+  vector<BeamSector> sectors = splitSectors(12, 3);
+  SectorMinimum minima[3];
+  findSectorMinima(ranges, sectors, minima);
+
+  // noisy beams are not the nearest return
+  EXPECT_EQ(900, minima[0].range);
+  EXPECT_EQ(2, minima[0].beam);
+  EXPECT_EQ(0xFFFF, minima[1].range);
+  EXPECT_EQ(-1, minima[1].beam);
+  EXPECT_EQ(2, minima[2].range);
+  EXPECT_EQ(11, minima[2].beam);
+
+  // the first beam of several at the same range
+  ranges[11] = 0xFFFF;
+  findSectorMinima(ranges, sectors, minima);
+  EXPECT_EQ(2000, minima[2].range);
+  EXPECT_EQ(9, minima[2].beam);
+}
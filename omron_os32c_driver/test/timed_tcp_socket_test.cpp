@@ -0,0 +1,130 @@
+/**
+Software License Agreement (BSD)
+
+\file      timed_tcp_socket_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include <boost/asio.hpp>
+
+#include "omron_os32c_driver/timed_tcp_socket.h"
+
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+
+class TimedTCPSocketTest : public :: testing :: Test
+{
+public:
+  TimedTCPSocketTest() : acceptor(io_serv, tcp::endpoint(ip::address_v4::loopback(), 0)),
+    peer(io_serv), sock(io_serv, 0.2)
+  {
+  }
+
+protected:
+  /// Connect to the acceptor and accept the connection as the peer
+  void connect()
+  {
+    std::ostringstream port;
+    port << acceptor.local_endpoint().port();
+    sock.open("127.0.0.1", port.str());
+    acceptor.accept(peer);
+  }
+
+  /// Seconds since the given time
+  static double since(std::chrono::steady_clock::time_point start)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  io_service io_serv;
+  tcp::acceptor acceptor;
+  tcp::socket peer;
+  TimedTCPSocket sock;
+};
+
+TEST_F(TimedTCPSocketTest, test_send_receive)
+{
+  connect();
+
+  char tx_data[] = { 0x65, 0x00, 0x04, 0x00 };
+  EXPECT_EQ(sizeof(tx_data), sock.send(buffer(tx_data)));
+  char peer_data[64];
+  ASSERT_EQ(sizeof(tx_data), peer.receive(buffer(peer_data)));
+  EXPECT_EQ(0x65, peer_data[0]);
+
+  write(peer, buffer(tx_data));
+  char rx_data[64];
+  ASSERT_EQ(sizeof(tx_data), sock.receive(buffer(rx_data)));
+  EXPECT_EQ(0x04, rx_data[2]);
+}
+
+TEST_F(TimedTCPSocketTest, test_local_address)
+{
+  EXPECT_THROW(sock.getLocalAddress(), std::runtime_error);
+  connect();
+  EXPECT_EQ("127.0.0.1", sock.getLocalAddress());
+}
+
+TEST_F(TimedTCPSocketTest, test_receive_timeout)
+{
+  connect();
+
+  // the scanner never replies
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  char rx_data[64];
+  EXPECT_THROW(sock.receive(buffer(rx_data)), std::runtime_error);
+  EXPECT_GE(since(start), 0.15);
+  EXPECT_LT(since(start), 1.0);
+}
+
+TEST_F(TimedTCPSocketTest, test_receive_closed)
+{
+  connect();
+  peer.close();
+
+  char rx_data[64];
+  EXPECT_THROW(sock.receive(buffer(rx_data)), std::runtime_error);
+}
+
+TEST_F(TimedTCPSocketTest, test_unreachable_host)
+{
+  // TEST-NET-1 is never routed, so connecting either fails or times out
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  EXPECT_THROW(sock.open("192.0.2.1", "44818"), std::runtime_error);
+  EXPECT_LT(since(start), 1.0);
+}
+
+TEST_F(TimedTCPSocketTest, test_connection_refused)
+{
+  std::ostringstream port;
+  port << acceptor.local_endpoint().port();
+  acceptor.close();
+  EXPECT_THROW(sock.open("127.0.0.1", port.str()), std::runtime_error);
+}
+
+TEST_F(TimedTCPSocketTest, test_invalid_timeout)
+{
+  EXPECT_THROW(TimedTCPSocket(io_serv, 0), std::invalid_argument);
+}
@@ -0,0 +1,121 @@
+/**
+Software License Agreement (BSD)
+
+\file      udp_io_socket_test.cpp
+\authors   Kareem Shehata <kareem@shehata.ca>
+\copyright Copyright (c) 2015, Clearpath Robotics, Inc., All rights reserved.
+
+Redistribution and use in source and binary forms, with or without modification, are permitted provided that
+the following conditions are met:
+ * Redistributions of source code must retain the above copyright notice, this list of conditions and the
+   following disclaimer.
+ * Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the
+   following disclaimer in the documentation and/or other materials provided with the distribution.
+ * Neither the name of Clearpath Robotics nor the names of its contributors may be used to endorse or promote
+   products derived from this software without specific prior written permission.
+
+THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR IMPLIED WAR-
+RANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR
+PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, IN-
+DIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include <gtest/gtest.h>
+#include <boost/asio.hpp>
+
+#include "omron_os32c_driver/udp_io_socket.h"
+
+using namespace boost::asio;
+using namespace omron_os32c_driver;
+
+class UDPIOSocketTest : public :: testing :: Test
+{
+public:
+  UDPIOSocketTest() : rx(io_serv, 22231), tx(io_serv, 22232) { }
+
+protected:
+  io_service io_serv;
+  UDPIOSocket rx;
+  UDPIOSocket tx;
+};
+
+TEST_F(UDPIOSocketTest, test_send_receive)
+{
+  tx.open("127.0.0.1", "22231");
+  rx.enableDropCounting();
+
+  char tx_data[] = { 0x02, 0x00, 0x02, 0x7F, 0x08, 0x00 };
+  EXPECT_EQ(sizeof(tx_data), tx.send(buffer(tx_data)));
+
+  char rx_data[64];
+  ASSERT_EQ(sizeof(tx_data), rx.receive(buffer(rx_data)));
+  for (size_t i = 0; i < sizeof(tx_data); ++i)
+  {
+    EXPECT_EQ(tx_data[i], rx_data[i]);
+  }
+  EXPECT_EQ(0, rx.getKernelDrops());
+}
+
+TEST_F(UDPIOSocketTest, test_kernel_drops)
+{
+  tx.open("127.0.0.1", "22231");
+  rx.enableDropCounting();
+  rx.setReceiveBufferSize(4096);
+
+  // overrun the receive buffer before reading anything
+  char tx_data[1400] = { 0 };
+  for (int i = 0; i < 100; ++i)
+  {
+    tx.send(buffer(tx_data));
+  }
+
+  // the drop count is reported with the first datagram queued after the drops
+  char rx_data[1500];
+  rx.receive(buffer(rx_data));
+  char marker[1] = { 1 };
+  tx.send(buffer(marker));
+  while (rx.receive(buffer(rx_data)) != sizeof(marker))
+  {
+  }
+  EXPECT_LT(0, rx.getKernelDrops());
+}
+
+TEST_F(UDPIOSocketTest, test_options)
+{
+  EXPECT_LE(65536, rx.setReceiveBufferSize(65536));
+  EXPECT_NO_THROW(rx.setPriority(4));
+  EXPECT_NO_THROW(rx.setDSCP(46));
+  EXPECT_THROW(rx.setDSCP(64), std::invalid_argument);
+  EXPECT_THROW(rx.setDSCP(-1), std::invalid_argument);
+  EXPECT_THROW(rx.joinMulticastGroup("192.168.1.1"), std::invalid_argument);
+  EXPECT_THROW(rx.joinMulticastGroup("not an address"), std::invalid_argument);
+  EXPECT_THROW(rx.joinMulticastGroup("239.192.1.1", "not an address"), std::invalid_argument);
+  EXPECT_NO_THROW(rx.joinMulticastGroup("239.192.1.1", "127.0.0.1"));
+}
+
+TEST_F(UDPIOSocketTest, test_receive_timeout)
+{
+  rx.setReceiveTimeout(0.05);
+  char rx_data[64];
+  EXPECT_THROW(rx.receive(buffer(rx_data)), std::runtime_error);
+  EXPECT_THROW(rx.setReceiveTimeout(-1), std::invalid_argument);
+}
+
+TEST_F(UDPIOSocketTest, test_wait_readable)
+{
+  EXPECT_FALSE(rx.waitReadable(0));
+  EXPECT_FALSE(rx.waitReadable(0.02));
+
+  tx.open("127.0.0.1", "22231");
+  char tx_data[] = { 0x02, 0x00, 0x02, 0x7F, 0x08, 0x00 };
+  tx.send(buffer(tx_data));
+  EXPECT_TRUE(rx.waitReadable(1));
+
+  char rx_data[64];
+  EXPECT_EQ(sizeof(tx_data), rx.receive(buffer(rx_data)));
+  EXPECT_FALSE(rx.waitReadable(0));
+}